@@ -149,6 +149,34 @@ void TurboParserWorker::LoadParserModel(const std::string &file_model) {
     << " sec." << endl;
 }
 
+void TurboParserWorker::LoadCascadeParserModel(const std::string &file_model) {
+  int time;
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  parser_pipe_->LoadCascadeModelByName(file_model);
+
+  gettimeofday(&end, NULL);
+  time = diff_ms(end, start);
+
+  LOG(INFO) << "Took " << static_cast<double>(time) / 1000.0
+    << " sec." << endl;
+}
+
+void TurboParserWorker::LoadTaggerModel(const std::string &file_model) {
+  int time;
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  parser_pipe_->LoadTaggerModelByName(file_model);
+
+  gettimeofday(&end, NULL);
+  time = diff_ms(end, start);
+
+  LOG(INFO) << "Took " << static_cast<double>(time) / 1000.0
+    << " sec." << endl;
+}
+
 void TurboParserWorker::Parse(const std::string &file_test,
                               const std::string &file_prediction) {
   parser_options_->SetTestFilePath(file_test);
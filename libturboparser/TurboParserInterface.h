@@ -20,6 +20,13 @@ public:
 
   void TagSentence(SequenceInstance *sentence);
 
+  // Profile of the instances processed so far (see the flag --profile).
+  void SetProfilingEnabled(bool enabled) {
+    tagger_pipe_->GetProfiler()->SetEnabled(enabled);
+  }
+  void GetProfile(Profiler *profile) { tagger_pipe_->GetProfile(profile); }
+  void ResetProfile() { tagger_pipe_->GetProfiler()->Reset(); }
+
 private:
   TaggerOptions *tagger_options_;
   TaggerPipe *tagger_pipe_;
@@ -37,6 +44,13 @@ public:
 
   void TagSentence(EntityInstance *sentence);
 
+  // Profile of the instances processed so far (see the flag --profile).
+  void SetProfilingEnabled(bool enabled) {
+    entity_pipe_->GetProfiler()->SetEnabled(enabled);
+  }
+  void GetProfile(Profiler *profile) { entity_pipe_->GetProfile(profile); }
+  void ResetProfile() { entity_pipe_->GetProfiler()->Reset(); }
+
 private:
   EntityOptions *entity_options_;
   EntityPipe *entity_pipe_;
@@ -49,11 +63,41 @@ public:
 
   void LoadParserModel(const std::string &file_model);
 
+  // Load a second parser model, to which sentences are escalated in a
+  // cascade (see the flag --file_cascade_model).
+  void LoadCascadeParserModel(const std::string &file_model);
+
+  // Load a tagger model, with which sentences are tagged before being
+  // parsed (see the flag --file_tagger_model).
+  void LoadTaggerModel(const std::string &file_model);
+
+  void LogCascadeStatistics() { parser_pipe_->LogCascadeStatistics(); }
+
+  // Statistics of the sentences decoded so far (see the flags
+  // --ad3_max_iterations and --decoding_time_budget_ms).
+  void LogDecodingStatistics() { parser_pipe_->LogDecodingStatistics(); }
+  const Histogram &GetDecodingTimeHistogram() {
+    return parser_pipe_->GetDependencyDecoder()->GetDecodingTimeHistogram();
+  }
+  const Histogram &GetAD3IterationsHistogram() {
+    return parser_pipe_->GetDependencyDecoder()->GetAD3IterationsHistogram();
+  }
+  void ResetDecodingStatistics() {
+    parser_pipe_->GetDependencyDecoder()->ResetDecodingStatistics();
+  }
+
   void Parse(const std::string &file_test,
              const std::string &file_prediction);
 
   void ParseSentence(DependencyInstance *sentence);
 
+  // Profile of the instances processed so far (see the flag --profile).
+  void SetProfilingEnabled(bool enabled) {
+    parser_pipe_->GetProfiler()->SetEnabled(enabled);
+  }
+  void GetProfile(Profiler *profile) { parser_pipe_->GetProfile(profile); }
+  void ResetProfile() { parser_pipe_->GetProfiler()->Reset(); }
+
 private:
   DependencyOptions *parser_options_;
   DependencyPipe *parser_pipe_;
@@ -71,6 +115,13 @@ public:
 
   void ParseSemanticDependenciesFromSentence(SemanticInstance *sentence);
 
+  // Profile of the instances processed so far (see the flag --profile).
+  void SetProfilingEnabled(bool enabled) {
+    semantic_pipe_->GetProfiler()->SetEnabled(enabled);
+  }
+  void GetProfile(Profiler *profile) { semantic_pipe_->GetProfile(profile); }
+  void ResetProfile() { semantic_pipe_->GetProfiler()->Reset(); }
+
 private:
   SemanticOptions *semantic_options_;
   SemanticPipe *semantic_pipe_;
@@ -88,6 +139,13 @@ public:
 
   void ResolveCoreferencesFromDocument(CoreferenceDocument *document);
 
+  // Profile of the instances processed so far (see the flag --profile).
+  void SetProfilingEnabled(bool enabled) {
+    coreference_pipe_->GetProfiler()->SetEnabled(enabled);
+  }
+  void GetProfile(Profiler *profile) { coreference_pipe_->GetProfile(profile); }
+  void ResetProfile() { coreference_pipe_->GetProfiler()->Reset(); }
+
 private:
   CoreferenceOptions *coreference_options_;
   CoreferencePipe *coreference_pipe_;
@@ -105,6 +163,15 @@ public:
 
   void TagSentence(MorphologicalInstance *sentence);
 
+  // Profile of the instances processed so far (see the flag --profile).
+  void SetProfilingEnabled(bool enabled) {
+    morphological_tagger_pipe_->GetProfiler()->SetEnabled(enabled);
+  }
+  void GetProfile(Profiler *profile) {
+    morphological_tagger_pipe_->GetProfile(profile);
+  }
+  void ResetProfile() { morphological_tagger_pipe_->GetProfiler()->Reset(); }
+
 private:
   MorphologicalOptions *morphological_tagger_options_;
   MorphologicalPipe *morphological_tagger_pipe_;
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Accuracy check of single-precision weights (--parameters_float). Runs a
+# model on a test file twice, with the weights in double and in single
+# precision, and compares the evaluation and the predictions of both runs.
+#
+# Usage: compare_float_weights.sh binary file_model file_test [options]
+# Example: compare_float_weights.sh TurboParser parser.model test.conll
+# Additional options are passed to the binary in both runs (for example,
+# --srl_file_format=sdp for the semantic parser).
+
+# Root folder where TurboParser is installed.
+root_folder="`cd $(dirname $0);cd ..;pwd`"
+export LD_LIBRARY_PATH="${LD_LIBRARY_PATH}:${root_folder}/deps/local/lib"
+
+# Set options.
+binary=$1
+file_model=$2
+file_test=$3
+shift 3
+
+# Set path folders.
+path_bin=${root_folder} # Folder containing the binaries.
+
+for parameters_float in false true
+do
+    echo ""
+    echo "Running with --parameters_float=${parameters_float}..."
+    ${path_bin}/${binary} \
+        --test \
+        --evaluate \
+        --file_model=${file_model} \
+        --file_test=${file_test} \
+        --file_prediction=${file_test}.pred.float-${parameters_float} \
+        --parameters_float=${parameters_float} \
+        "$@" \
+        --logtostderr 2>&1 | grep -i "accuracy\|precision\|recall\|F1\|took"
+done
+
+# Compare the predictions line by line.
+num_lines=`cat ${file_test}.pred.float-false | wc -l`
+num_different_lines=`diff ${file_test}.pred.float-false \
+    ${file_test}.pred.float-true | grep -c "^<"`
+echo ""
+echo "Lines with different predictions: ${num_different_lines} / ${num_lines}"
@@ -16,8 +16,6 @@ fi
 cd ${DIR}
 
 ${DIR}/create_conll_corpus_from_text.pl ${tmp_folder}/tmp.tokenized > ${tmp_folder}/tmp.conll
-${DIR}/create_tagging_corpus.sh ${tmp_folder}/tmp.conll # Creates tmp.conll.tagging.
-${DIR}/run_tagger.sh ${tmp_folder}/tmp.conll.tagging # Creates tmp.conll.tagging.pred.
-${DIR}/create_conll_predicted_tags_corpus.sh ${tmp_folder}/tmp.conll ${tmp_folder}/tmp.conll.tagging.pred # Creates tmp.conll.predpos
-${DIR}/run_parser.sh ${tmp_folder}/tmp.conll.predpos # Creates tmp.conll.predpos.pred.
-cat ${tmp_folder}/tmp.conll.predpos.pred
+# Tag and parse in a single pass.
+${DIR}/run_parser.sh ${tmp_folder}/tmp.conll ${DIR}/../models/english_proj/english_proj_tagger.model # Creates tmp.conll.pred.
+cat ${tmp_folder}/tmp.conll.pred
@@ -0,0 +1,127 @@
+#!/bin/bash
+
+# Benchmark of the test-time pipelines. Trains small models on the sample
+# data and runs TurboBench on them, writing one JSON file per model to the
+# results folder. Compare these files between releases to catch performance
+# regressions.
+#
+# Usage: run_benchmarks.sh [label] [semantic_model semantic_test]
+#                          [coreference_model coreference_test]
+# The semantic (SDP format) and coreference (CoNLL 2012 format) models and
+# test files are optional, since that data is not distributed with
+# TurboParser. Pass "" to skip the semantic parser.
+
+# Root folder where TurboParser is installed.
+root_folder="`cd $(dirname $0);cd ..;pwd`"
+export LD_LIBRARY_PATH="${LD_LIBRARY_PATH}:${root_folder}/deps/local/lib"
+
+# Set options.
+label=$1 # Example: "2.3.0". Stored in the JSON files.
+file_semantic_model=$2
+file_semantic_test=$3
+file_coreference_model=$4
+file_coreference_test=$5
+num_epochs=2 # Training epochs of the benchmark models.
+threads=1,2,4 # Thread counts to sweep.
+length_buckets=10,20,40 # Upper bounds of the sentence length buckets.
+repetitions=3 # Each run is repeated and the fastest is kept.
+train=true # Set to false to reuse previously trained models.
+
+# Set path folders.
+path_bin=${root_folder} # Folder containing the binaries.
+path_scripts=${root_folder}/scripts # Folder containing scripts.
+path_data=${root_folder}/data/sample # Folder with the data.
+path_models=${root_folder}/models/bench # Folder where models are stored.
+path_results=${root_folder}/results/bench # Folder for the results.
+
+# Create folders if they don't exist.
+mkdir -p ${path_models}
+mkdir -p ${path_results}
+
+file_train=${path_data}/sample_train.conll
+file_test=${path_data}/sample_test.conll
+
+# Create tagging corpus from CoNLL data if it does not yet exist.
+if [ ! -e "${file_train}.tagging" ]
+then
+    echo "Creating tagging corpus from CoNLL data."
+    ${path_scripts}/create_tagging_corpus.sh "${file_train}"
+    ${path_scripts}/create_tagging_corpus.sh "${file_test}"
+fi
+
+# Run the benchmark with the given task, model, test file and output suffix.
+# Additional arguments are passed to TurboBench.
+run_benchmark () {
+    task=$1
+    file_model=$2
+    file_test_benchmark=$3
+    suffix=$4
+    shift 4
+
+    echo ""
+    echo "Benchmarking ${suffix}..."
+    ${path_bin}/TurboBench \
+        --bench_task=${task} \
+        --bench_threads=${threads} \
+        --bench_length_buckets=${length_buckets} \
+        --bench_repetitions=${repetitions} \
+        --bench_label="${label}" \
+        --bench_output=${path_results}/${suffix}.json \
+        --file_model=${file_model} \
+        --file_test=${file_test_benchmark} \
+        "$@" \
+        --logtostderr
+}
+
+################################################
+# Train the models.
+################################################
+
+if $train
+then
+    for model_type in basic standard full
+    do
+        echo ""
+        echo "Training ${model_type} parser..."
+        ${path_bin}/TurboParser \
+            --train \
+            --train_epochs=${num_epochs} \
+            --file_model=${path_models}/parser_${model_type}.model \
+            --file_train=${file_train} \
+            --model_type=${model_type} \
+            --logtostderr
+    done
+
+    echo ""
+    echo "Training tagger..."
+    ${path_bin}/TurboTagger \
+        --train \
+        --train_epochs=${num_epochs} \
+        --file_model=${path_models}/tagger.model \
+        --file_train=${file_train}.tagging \
+        --logtostderr
+fi
+
+################################################
+# Run the benchmarks.
+################################################
+
+for model_type in basic standard full
+do
+    run_benchmark parser ${path_models}/parser_${model_type}.model \
+        ${file_test} parser_${model_type}
+done
+
+run_benchmark tagger ${path_models}/tagger.model ${file_test}.tagging tagger
+
+if [ "${file_semantic_model}" != "" ]
+then
+    run_benchmark semantic_parser ${file_semantic_model} \
+        ${file_semantic_test} semantic_parser --srl_file_format=sdp
+fi
+
+if [ "${file_coreference_model}" != "" ]
+then
+    run_benchmark coreference_resolver ${file_coreference_model} \
+        ${file_coreference_test} coreference_resolver
+fi
@@ -21,14 +21,17 @@ file_prediction=${file_test}.pred
 suffix=parser_pruned-${prune}_model-${model_type}
 file_model=${path_models}/${language}_${suffix}.model
 
-# Run the parser.
+# Run the parser. If a tagger model is given as second argument, the POS
+# tags of the test file are predicted with it before parsing.
 file_test=$1
 file_prediction=${file_test}.pred
+file_tagger_model=$2
 
 ${path_bin}/TurboParser \
     --test \
     --evaluate \
     --file_model=${file_model} \
+    --file_tagger_model=${file_tagger_model} \
     --file_test=${file_test} \
     --file_prediction=${file_prediction}
 
@@ -0,0 +1,165 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BENCHMARKPIPE_H_
+#define BENCHMARKPIPE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Pipe.h"
+#include "TimeUtils.h"
+
+using namespace std;
+
+// Stages of the test-time pipeline whose time is measured by the benchmark.
+enum {
+  BENCHMARK_STAGE_READ = 0,
+  BENCHMARK_STAGE_CONVERT,
+  BENCHMARK_STAGE_MAKE_PARTS,
+  BENCHMARK_STAGE_MAKE_FEATURES,
+  BENCHMARK_STAGE_COMPUTE_SCORES,
+  BENCHMARK_STAGE_DECODE,
+  BENCHMARK_STAGE_LABEL,
+  BENCHMARK_STAGE_WRITE,
+  NUM_BENCHMARK_STAGES
+};
+
+inline const char *GetBenchmarkStageName(int stage) {
+  static const char *stage_names[NUM_BENCHMARK_STAGES] = {
+    "read", "convert", "make_parts", "make_features", "compute_scores",
+    "decode", "label", "write"
+  };
+  return stage_names[stage];
+}
+
+// Time taken by one variant of a micro-benchmark (e.g. the optimized or the
+// naive version of a decoder, or one step of a computation) on a number of
+// items (sentences, documents, arcs...). The size is a parameter of the
+// micro-benchmark (e.g. the number of mentions in a document), or 0 if there
+// is none.
+// The max difference is the largest absolute difference between the outputs
+// of this variant and those of the first variant.
+struct MicroBenchmarkResult {
+  string name;
+  string variant;
+  int size;
+  int num_items;
+  double seconds;
+  double max_difference;
+};
+
+// Pipe that runs the test-time stages of PipeType one at a time (reading,
+// conversion to numeric format, parts, features, scores, decoding, labeling
+// and writing) and accumulates the time spent in each stage.
+// Note: stages that happen inside MakeParts (such as the pruner of the
+// dependency and semantic parsers) are counted in MakeParts. Cascade models
+// (--file_cascade_model) are not used by the benchmark.
+template <class PipeType> class BenchmarkPipe : public PipeType {
+public:
+  BenchmarkPipe(Options* options) : PipeType(options) {}
+  virtual ~BenchmarkPipe() {}
+
+  // Read all the instances of the test file. The time spent (in
+  // microseconds) is added to (*stage_times)[BENCHMARK_STAGE_READ].
+  void ReadInstances(vector<Instance*> *instances,
+                     vector<int64_t> *stage_times) {
+    timeval start, end;
+    this->reader_->Open(this->options_->GetTestFilePath());
+    gettimeofday(&start, NULL);
+    Instance *instance = this->reader_->GetNext();
+    while (instance) {
+      instances->push_back(instance);
+      instance = this->reader_->GetNext();
+    }
+    gettimeofday(&end, NULL);
+    this->reader_->Close();
+    (*stage_times)[BENCHMARK_STAGE_READ] += diff_us(end, start);
+  }
+
+  // Run all the stages on the instances with the given indices, writing the
+  // predictions to output_path. The time spent (in microseconds) in each
+  // stage is added to stage_times.
+  void RunInstances(const vector<Instance*> &instances,
+                    const vector<int> &indices,
+                    const string &output_path,
+                    vector<int64_t> *stage_times) {
+    Parts *parts = this->CreateParts();
+    Features *features = this->CreateFeatures();
+    vector<double> scores;
+    vector<double> gold_outputs;
+    vector<double> predicted_outputs;
+    timeval start, end;
+
+    this->writer_->Open(output_path);
+    for (int i = 0; i < indices.size(); ++i) {
+      Instance *instance = instances[indices[i]];
+
+      gettimeofday(&start, NULL);
+      Instance *formatted_instance = this->GetFormattedInstance(instance);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_CONVERT] += diff_us(end, start);
+
+      start = end;
+      this->MakeParts(formatted_instance, parts, &gold_outputs);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_MAKE_PARTS] += diff_us(end, start);
+
+      start = end;
+      this->Pipe::MakeFeatures(formatted_instance, parts, features);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_MAKE_FEATURES] += diff_us(end, start);
+
+      start = end;
+      this->ComputeScores(formatted_instance, parts, features, &scores);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_COMPUTE_SCORES] += diff_us(end, start);
+
+      start = end;
+      this->decoder_->Decode(formatted_instance, parts, scores,
+                             &predicted_outputs);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_DECODE] += diff_us(end, start);
+
+      start = end;
+      Instance *output_instance = instance->Copy();
+      this->LabelInstance(parts, predicted_outputs, output_instance);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_LABEL] += diff_us(end, start);
+
+      start = end;
+      this->writer_->Write(output_instance);
+      gettimeofday(&end, NULL);
+      (*stage_times)[BENCHMARK_STAGE_WRITE] += diff_us(end, start);
+
+      if (formatted_instance != instance) delete formatted_instance;
+      delete output_instance;
+    }
+    this->writer_->Close();
+
+    delete parts;
+    delete features;
+  }
+
+  // Run the micro-benchmarks of this task on the given instances. Override
+  // this function for tasks that have micro-benchmarks.
+  virtual void RunMicroBenchmarks(const vector<Instance*> &instances,
+                                  vector<MicroBenchmarkResult> *results) {}
+};
+
+#endif /* BENCHMARKPIPE_H_ */
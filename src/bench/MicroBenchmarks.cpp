@@ -0,0 +1,399 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <math.h>
+#include <algorithm>
+#include "MicroBenchmarks.h"
+
+// Returns the largest absolute difference between the entries of two
+// vectors of the same size.
+static double MaxAbsoluteDifference(const vector<double> &x,
+                                    const vector<double> &y) {
+  CHECK_EQ(x.size(), y.size());
+  double max_difference = 0.0;
+  for (int i = 0; i < x.size(); ++i) {
+    double difference = fabs(x[i] - y[i]);
+    if (difference > max_difference) max_difference = difference;
+  }
+  return max_difference;
+}
+
+static void AddMicroBenchmarkResult(const string &name,
+                                    const string &variant,
+                                    int size,
+                                    int num_items,
+                                    int64_t time_us,
+                                    double max_difference,
+                                    vector<MicroBenchmarkResult> *results) {
+  MicroBenchmarkResult result;
+  result.name = name;
+  result.variant = variant;
+  result.size = size;
+  result.num_items = num_items;
+  result.seconds = static_cast<double>(time_us) / 1000000.0;
+  result.max_difference = max_difference;
+  results->push_back(result);
+  LOG(INFO) << name << " (" << variant << ", size " << size << "): "
+            << num_items << " items in " << result.seconds << " sec.";
+}
+
+void DependencyBenchmarkPipe::RunMicroBenchmarks(
+    const vector<Instance*> &instances,
+    vector<MicroBenchmarkResult> *results) {
+  if (!GetDependencyOptions()->prune_basic()) {
+    LOG(INFO) << "The model has no pruner; skipping the pruner "
+              << "micro-benchmarks.";
+    return;
+  }
+
+  DependencyParts *parts = static_cast<DependencyParts*>(CreateParts());
+  DependencyFeatures *features =
+    static_cast<DependencyFeatures*>(CreateFeatures());
+  vector<double> light_scores;
+  vector<double> scores;
+  vector<double> predicted_outputs;
+  vector<double> naive_predicted_outputs;
+  int64_t light_scores_time = 0;
+  int64_t scores_time = 0;
+  int64_t decode_time = 0;
+  int64_t naive_decode_time = 0;
+  double max_score_difference = 0.0;
+  double max_output_difference = 0.0;
+  timeval start, end;
+
+  for (int i = 0; i < instances.size(); ++i) {
+    DependencyInstanceNumeric *sentence =
+      static_cast<DependencyInstanceNumeric*>(
+        GetFormattedInstance(instances[i]));
+    int sentence_length = sentence->size();
+
+    // Make the parts of the pruner (unlabeled arcs), as in MakeParts.
+    parts->Initialize();
+    MakePartsBasic(sentence, false, parts, NULL);
+    parts->BuildOffsets();
+    parts->BuildIndices(sentence_length, false);
+
+    gettimeofday(&start, NULL);
+    features->ComputeArcScoresLight(sentence, parts, pruner_parameters_,
+                                    &light_scores);
+    gettimeofday(&end, NULL);
+    light_scores_time += diff_us(end, start);
+
+    start = end;
+    MakeFeatures(sentence, parts, true, features);
+    ComputeScores(sentence, parts, features, true, &scores);
+    gettimeofday(&end, NULL);
+    scores_time += diff_us(end, start);
+
+    max_score_difference =
+      std::max(max_score_difference,
+               MaxAbsoluteDifference(light_scores, scores));
+
+    start = end;
+    GetDependencyDecoder()->DecodePruner(sentence, parts, scores,
+                                         &predicted_outputs, NULL);
+    gettimeofday(&end, NULL);
+    decode_time += diff_us(end, start);
+
+    start = end;
+    GetDependencyDecoder()->DecodePrunerNaive(sentence, parts, scores,
+                                              &naive_predicted_outputs);
+    gettimeofday(&end, NULL);
+    naive_decode_time += diff_us(end, start);
+
+    max_output_difference =
+      std::max(max_output_difference,
+               MaxAbsoluteDifference(predicted_outputs,
+                                     naive_predicted_outputs));
+
+    delete sentence;
+  }
+
+  delete parts;
+  delete features;
+
+  int num_sentences = instances.size();
+  AddMicroBenchmarkResult("pruner_scores", "optimized", 0, num_sentences,
+                          light_scores_time, 0.0, results);
+  AddMicroBenchmarkResult("pruner_scores", "naive", 0, num_sentences,
+                          scores_time, max_score_difference, results);
+  AddMicroBenchmarkResult("pruner_decode", "optimized", 0, num_sentences,
+                          decode_time, 0.0, results);
+  AddMicroBenchmarkResult("pruner_decode", "naive", 0, num_sentences,
+                          naive_decode_time, max_output_difference, results);
+}
+
+// Semantic decoder which exposes the arc-factored decoders, so that the
+// optimized and naive versions can be called directly.
+class SemanticBenchmarkDecoder : public SemanticDecoder {
+public:
+  SemanticBenchmarkDecoder(SemanticPipe *pipe) : SemanticDecoder(pipe, 1) {}
+  virtual ~SemanticBenchmarkDecoder() {}
+
+  using SemanticDecoder::DecodeBasic;
+  using SemanticDecoder::DecodeBasicNaive;
+  using SemanticDecoder::DecodeBasicMarginals;
+  using SemanticDecoder::DecodeBasicMarginalsNaive;
+};
+
+void SemanticBenchmarkPipe::RunMicroBenchmarks(
+    const vector<Instance*> &instances,
+    vector<MicroBenchmarkResult> *results) {
+  SemanticBenchmarkDecoder decoder(this);
+  Parts *parts = CreateParts();
+  Features *features = CreateFeatures();
+  vector<double> scores;
+  vector<double> gold_outputs;
+  vector<double> predicted_outputs;
+  vector<double> naive_predicted_outputs;
+  int64_t decode_time = 0;
+  int64_t naive_decode_time = 0;
+  int64_t marginals_time = 0;
+  int64_t naive_marginals_time = 0;
+  double max_decode_difference = 0.0;
+  double max_marginals_difference = 0.0;
+  timeval start, end;
+
+  for (int i = 0; i < instances.size(); ++i) {
+    Instance *instance = GetFormattedInstance(instances[i]);
+    MakeParts(instance, parts, &gold_outputs);
+    Pipe::MakeFeatures(instance, parts, features);
+    ComputeScores(instance, parts, features, &scores);
+    ScoreView score_view(scores);
+
+    double value, naive_value;
+    predicted_outputs.assign(parts->size(), 0.0);
+    gettimeofday(&start, NULL);
+    decoder.DecodeBasic(instance, parts, score_view, &predicted_outputs,
+                        &value);
+    gettimeofday(&end, NULL);
+    decode_time += diff_us(end, start);
+
+    naive_predicted_outputs.assign(parts->size(), 0.0);
+    gettimeofday(&start, NULL);
+    decoder.DecodeBasicNaive(instance, parts, score_view,
+                             &naive_predicted_outputs, &naive_value);
+    gettimeofday(&end, NULL);
+    naive_decode_time += diff_us(end, start);
+
+    max_decode_difference =
+      std::max(max_decode_difference,
+               MaxAbsoluteDifference(predicted_outputs,
+                                     naive_predicted_outputs));
+    max_decode_difference =
+      std::max(max_decode_difference, fabs(value - naive_value));
+
+    double log_partition_function, naive_log_partition_function;
+    double entropy, naive_entropy;
+    predicted_outputs.assign(parts->size(), 0.0);
+    gettimeofday(&start, NULL);
+    decoder.DecodeBasicMarginals(instance, parts, score_view,
+                                 &predicted_outputs, &log_partition_function,
+                                 &entropy);
+    gettimeofday(&end, NULL);
+    marginals_time += diff_us(end, start);
+
+    naive_predicted_outputs.assign(parts->size(), 0.0);
+    gettimeofday(&start, NULL);
+    decoder.DecodeBasicMarginalsNaive(instance, parts, score_view,
+                                      &naive_predicted_outputs,
+                                      &naive_log_partition_function,
+                                      &naive_entropy);
+    gettimeofday(&end, NULL);
+    naive_marginals_time += diff_us(end, start);
+
+    max_marginals_difference =
+      std::max(max_marginals_difference,
+               MaxAbsoluteDifference(predicted_outputs,
+                                     naive_predicted_outputs));
+    max_marginals_difference =
+      std::max(max_marginals_difference,
+               fabs(log_partition_function - naive_log_partition_function));
+    max_marginals_difference =
+      std::max(max_marginals_difference, fabs(entropy - naive_entropy));
+
+    if (instance != instances[i]) delete instance;
+  }
+
+  delete parts;
+  delete features;
+
+  int num_sentences = instances.size();
+  AddMicroBenchmarkResult("semantic_decode_basic", "optimized", 0,
+                          num_sentences, decode_time, 0.0, results);
+  AddMicroBenchmarkResult("semantic_decode_basic", "naive", 0,
+                          num_sentences, naive_decode_time,
+                          max_decode_difference, results);
+  AddMicroBenchmarkResult("semantic_decode_basic_marginals", "optimized", 0,
+                          num_sentences, marginals_time, 0.0, results);
+  AddMicroBenchmarkResult("semantic_decode_basic_marginals", "naive", 0,
+                          num_sentences, naive_marginals_time,
+                          max_marginals_difference, results);
+}
+
+void CoreferenceBenchmarkPipe::RunMicroBenchmarks(
+    const vector<Instance*> &instances,
+    vector<MicroBenchmarkResult> *results) {
+  CoreferenceParts *parts = static_cast<CoreferenceParts*>(CreateParts());
+  Features *features = CreateFeatures();
+  vector<double> scores;
+  int max_antecedents = GetCoreferenceOptions()->window_mentions();
+  timeval start, end;
+
+  for (int k = 0; k < mention_counts_.size(); ++k) {
+    int num_target_mentions = mention_counts_[k];
+    CoreferenceDocumentNumeric document;
+    document.BeginIncremental(false);
+
+    // Append sentences of the test documents until the document has enough
+    // mentions. Stop if a full pass over the documents adds no mentions.
+    bool added_mentions = true;
+    while (document.GetMentions().size() < num_target_mentions &&
+           added_mentions) {
+      int num_mentions_before = document.GetMentions().size();
+      for (int i = 0; i < instances.size(); ++i) {
+        CoreferenceDocument *source =
+          static_cast<CoreferenceDocument*>(instances[i]);
+        for (int j = 0; j < source->GetNumSentences(); ++j) {
+          if (document.GetMentions().size() >= num_target_mentions) break;
+          document.AddSentence(*GetCoreferenceDictionary(),
+                               source->GetSentence(j));
+        }
+      }
+      added_mentions = (document.GetMentions().size() > num_mentions_before);
+    }
+    if (!added_mentions) {
+      LOG(WARNING) << "The test documents have no mentions; skipping the "
+                   << "coreference micro-benchmarks.";
+      break;
+    }
+    int num_mentions = document.GetMentions().size();
+
+    gettimeofday(&start, NULL);
+    MakePartsStreaming(&document, 0, max_antecedents, parts);
+    gettimeofday(&end, NULL);
+    int64_t parts_time = diff_us(end, start);
+
+    start = end;
+    MakeFeatures(&document, parts, features);
+    gettimeofday(&end, NULL);
+    int64_t features_time = diff_us(end, start);
+
+    start = end;
+    ComputeScores(&document, parts, features, &scores);
+    gettimeofday(&end, NULL);
+    int64_t scores_time = diff_us(end, start);
+
+    int num_arcs = parts->size();
+    AddMicroBenchmarkResult("coreference_document", "make_parts",
+                            num_mentions, num_arcs, parts_time, 0.0, results);
+    AddMicroBenchmarkResult("coreference_document", "make_features",
+                            num_mentions, num_arcs, features_time, 0.0,
+                            results);
+    AddMicroBenchmarkResult("coreference_document", "compute_scores",
+                            num_mentions, num_arcs, scores_time, 0.0,
+                            results);
+  }
+
+  delete parts;
+  delete features;
+}
+
+// Returns the number of words whose gazetteer tags differ (as sets).
+static int NumDifferentGazetteerIds(const vector<vector<int> > &x,
+                                    const vector<vector<int> > &y) {
+  CHECK_EQ(x.size(), y.size());
+  int num_differences = 0;
+  for (int i = 0; i < x.size(); ++i) {
+    vector<int> x_ids = x[i];
+    vector<int> y_ids = y[i];
+    sort(x_ids.begin(), x_ids.end());
+    sort(y_ids.begin(), y_ids.end());
+    if (x_ids != y_ids) ++num_differences;
+  }
+  return num_differences;
+}
+
+void EntityBenchmarkPipe::RunMicroBenchmarks(
+    const vector<Instance*> &instances,
+    vector<MicroBenchmarkResult> *results) {
+  EntityDictionary *dictionary = GetEntityDictionary();
+  timeval start, end;
+
+  // Load the gazetteer of the model from a temporary file.
+  FILE *fs = tmpfile();
+  CHECK(fs != NULL) << "Could not create a temporary file.";
+  dictionary->SaveGazetteer(fs);
+  rewind(fs);
+  EntityDictionary loaded_dictionary(this);
+  gettimeofday(&start, NULL);
+  loaded_dictionary.LoadGazetteer(fs);
+  gettimeofday(&end, NULL);
+  fclose(fs);
+  AddMicroBenchmarkResult("gazetteer_load",
+                          loaded_dictionary.gazetteer_phrases() ?
+                          "phrases" : "words",
+                          loaded_dictionary.GetNumGazetteerWords(), 1,
+                          diff_us(end, start), 0.0, results);
+
+  // Read and build the gazetteer from a file.
+  EntityOptions *options = GetEntityOptions();
+  if (options->file_gazetteer() != "") {
+    EntityDictionary built_dictionary(this);
+    gettimeofday(&start, NULL);
+    built_dictionary.ReadGazetteerFiles();
+    gettimeofday(&end, NULL);
+    AddMicroBenchmarkResult("gazetteer_build",
+                            options->gazetteer_phrases() ? "phrases" : "words",
+                            built_dictionary.GetNumGazetteerWords(), 1,
+                            diff_us(end, start), 0.0, results);
+  }
+
+  // Compute the gazetteer tags of the test sentences. Each variant is timed
+  // over all the sentences, since a sentence takes about a microsecond.
+  int num_sentences = instances.size();
+  vector<vector<vector<int> > > gazetteer_ids(num_sentences);
+  vector<vector<vector<int> > > naive_gazetteer_ids(num_sentences);
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < num_sentences; ++i) {
+    EntityInstance *instance = static_cast<EntityInstance*>(instances[i]);
+    dictionary->GetSentenceGazetteerIds(instance, &gazetteer_ids[i]);
+  }
+  gettimeofday(&end, NULL);
+  int64_t match_time = diff_us(end, start);
+
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < num_sentences; ++i) {
+    EntityInstance *instance = static_cast<EntityInstance*>(instances[i]);
+    dictionary->GetSentenceGazetteerIdsNaive(instance,
+                                             &naive_gazetteer_ids[i]);
+  }
+  gettimeofday(&end, NULL);
+  int64_t naive_match_time = diff_us(end, start);
+
+  int num_different_words = 0;
+  for (int i = 0; i < num_sentences; ++i) {
+    num_different_words +=
+      NumDifferentGazetteerIds(gazetteer_ids[i], naive_gazetteer_ids[i]);
+  }
+
+  AddMicroBenchmarkResult("gazetteer_match", "optimized", 0, num_sentences,
+                          match_time, 0.0, results);
+  AddMicroBenchmarkResult("gazetteer_match", "naive", 0, num_sentences,
+                          naive_match_time, num_different_words, results);
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MICROBENCHMARKS_H_
+#define MICROBENCHMARKS_H_
+
+#include "BenchmarkPipe.h"
+#include "DependencyPipe.h"
+#include "SemanticPipe.h"
+#include "CoreferencePipe.h"
+#include "EntityPipe.h"
+
+// Dependency parser with a micro-benchmark of the pruner: arc scores
+// computed from cached per-word partial scores (ComputeArcScoresLight) vs.
+// full pruner features and scores, and DecodePruner vs. DecodePrunerNaive.
+// Note: DecodePrunerNaive keeps the top-scoring heads rather than the ones
+// with the largest marginals, so its outputs may differ from DecodePruner's.
+class DependencyBenchmarkPipe : public BenchmarkPipe<DependencyPipe> {
+public:
+  DependencyBenchmarkPipe(Options* options) :
+    BenchmarkPipe<DependencyPipe>(options) {}
+  virtual ~DependencyBenchmarkPipe() {}
+
+  void RunMicroBenchmarks(const vector<Instance*> &instances,
+                          vector<MicroBenchmarkResult> *results);
+};
+
+// Semantic parser with a micro-benchmark of the arc-factored decoders:
+// DecodeBasic vs. DecodeBasicNaive and DecodeBasicMarginals vs.
+// DecodeBasicMarginalsNaive, on the parts and scores of the loaded model.
+class SemanticBenchmarkPipe : public BenchmarkPipe<SemanticPipe> {
+public:
+  SemanticBenchmarkPipe(Options* options) :
+    BenchmarkPipe<SemanticPipe>(options) {}
+  virtual ~SemanticBenchmarkPipe() {}
+
+  void RunMicroBenchmarks(const vector<Instance*> &instances,
+                          vector<MicroBenchmarkResult> *results);
+};
+
+// Coreference resolver with a micro-benchmark of the construction of parts,
+// features and scores in documents with a given number of mentions. The
+// documents are built by appending the sentences of the test documents (as
+// many times as needed) to an incremental document. Each mention gets as
+// candidate antecedents the previous --coreference_window_mentions mentions,
+// so that the number of arcs grows linearly with the number of mentions.
+class CoreferenceBenchmarkPipe : public BenchmarkPipe<CoreferencePipe> {
+public:
+  CoreferenceBenchmarkPipe(Options* options) :
+    BenchmarkPipe<CoreferencePipe>(options) {}
+  virtual ~CoreferenceBenchmarkPipe() {}
+
+  // Set the numbers of mentions of the documents to benchmark.
+  void SetMentionCounts(const vector<int> &mention_counts) {
+    mention_counts_ = mention_counts;
+  }
+
+  void RunMicroBenchmarks(const vector<Instance*> &instances,
+                          vector<MicroBenchmarkResult> *results);
+
+protected:
+  vector<int> mention_counts_;
+};
+
+// Entity recognizer with a micro-benchmark of the gazetteer: the time to
+// load the gazetteer of the model, the time to read and build it from
+// --entity_file_gazetteer (if given), and the time to compute the gazetteer
+// tags of the test sentences with the trie automaton vs. matching the trie
+// at every position (GetSentenceGazetteerIdsNaive).
+class EntityBenchmarkPipe : public BenchmarkPipe<EntityPipe> {
+public:
+  EntityBenchmarkPipe(Options* options) :
+    BenchmarkPipe<EntityPipe>(options) {}
+  virtual ~EntityBenchmarkPipe() {}
+
+  void RunMicroBenchmarks(const vector<Instance*> &instances,
+                          vector<MicroBenchmarkResult> *results);
+};
+
+#endif /* MICROBENCHMARKS_H_ */
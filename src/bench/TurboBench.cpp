@@ -0,0 +1,472 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmark of the test-time pipelines. For a task and a trained model, it
+// measures the time spent in each stage (reading, conversion to numeric
+// format, parts, features, scores, decoding, labeling and writing) for
+// several numbers of threads and ranges of sentence lengths, runs the
+// micro-benchmarks of the task, and writes the results in JSON format, so
+// that they can be compared across releases.
+// Example:
+//   TurboBench --bench_task=parser --file_model=parser.model \
+//     --file_test=test.conll --bench_output=results.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+#include "Utils.h"
+#include "StringUtils.h"
+#include "MicroBenchmarks.h"
+#include "TaggerPipe.h"
+#include "EntityPipe.h"
+#include "MorphologicalPipe.h"
+
+using namespace std;
+
+DEFINE_string(bench_task, "parser",
+              "Task to benchmark: parser, semantic_parser, tagger, "
+              "entity_recognizer, morphological_tagger or "
+              "coreference_resolver. The model (--file_model) and test data "
+              "(--file_test) must be for this task.");
+DEFINE_string(bench_threads, "1,2,4",
+              "Comma-separated list of numbers of threads. Each thread runs "
+              "its own copy of the model on a share of the instances.");
+DEFINE_string(bench_length_buckets, "10,20,40",
+              "Comma-separated list of increasing upper bounds of instance "
+              "length (in words). Besides a run with all the instances, "
+              "there is one run per bucket, plus one for the instances "
+              "longer than the last bound.");
+DEFINE_int32(bench_repetitions, 3,
+             "Number of repetitions of each run. The fastest one is "
+             "reported.");
+DEFINE_bool(bench_micro, true,
+            "True for running the micro-benchmarks of the task (pruner for "
+            "the parser, arc-factored decoders for the semantic parser, "
+            "document features for the coreference resolver, gazetteer for "
+            "the entity recognizer).");
+DEFINE_string(bench_mention_counts, "100,500,2000",
+              "Comma-separated list of numbers of mentions of the documents "
+              "in the coreference micro-benchmark.");
+DEFINE_string(bench_output, "",
+              "File where the results are written in JSON format. If empty, "
+              "they are written to the standard output.");
+DEFINE_string(bench_label, "",
+              "Label stored with the results (e.g. the release or commit).");
+DEFINE_string(bench_schedule, "longest_first",
+              "Assignment of the instances to the threads: round_robin, or "
+              "longest_first (each instance, from the longest to the "
+              "shortest, goes to the thread with the least work so far, "
+              "measured as the sum of the squared lengths).");
+
+// Results of one run: all the instances within a range of lengths,
+// processed by a number of threads.
+struct BenchmarkRun {
+  int num_threads;
+  int min_length;
+  int max_length; // -1 if unbounded.
+  int num_instances;
+  int64_t num_tokens;
+  double wall_seconds;
+  // Time spent in each stage, summed over threads.
+  vector<double> stage_seconds;
+};
+
+// Arguments of a worker thread.
+template <class BenchmarkPipeType> struct BenchmarkWorker {
+  BenchmarkPipeType *pipe;
+  const vector<Instance*> *instances;
+  vector<int> indices;
+  string output_path;
+  vector<int64_t> stage_times;
+};
+
+template <class BenchmarkPipeType>
+static void RunBenchmarkWorker(BenchmarkWorker<BenchmarkPipeType> *worker) {
+  worker->pipe->RunInstances(*worker->instances, worker->indices,
+                             worker->output_path, &worker->stage_times);
+}
+
+static void ParseIntegerList(const string &str, vector<int> *values) {
+  vector<string> fields;
+  StringSplit(str, ",", &fields, true);
+  values->clear();
+  for (int i = 0; i < fields.size(); ++i) {
+    values->push_back(atoi(fields[i].c_str()));
+  }
+}
+
+// Number of words of an instance (or of all the sentences of a document).
+static int GetInstanceLength(Instance *instance) {
+  CoreferenceDocument *document = dynamic_cast<CoreferenceDocument*>(instance);
+  if (document) {
+    int length = 0;
+    for (int i = 0; i < document->GetNumSentences(); ++i) {
+      // Subtract 1 since there is an extra start symbol.
+      length += document->GetSentence(i)->size() - 1;
+    }
+    return length;
+  }
+  DependencyInstance *dependency_instance =
+    dynamic_cast<DependencyInstance*>(instance);
+  if (dependency_instance) return dependency_instance->size() - 1;
+  SequenceInstance *sequence_instance =
+    dynamic_cast<SequenceInstance*>(instance);
+  if (sequence_instance) return sequence_instance->size();
+  LOG(FATAL) << "Unknown instance type.";
+  return 0;
+}
+
+static string EscapeJsonString(const string &str) {
+  string escaped = "\"";
+  for (int i = 0; i < str.size(); ++i) {
+    if (str[i] == '"' || str[i] == '\\') escaped += '\\';
+    escaped += str[i];
+  }
+  escaped += "\"";
+  return escaped;
+}
+
+static void WriteBenchmarkResults(Options *options,
+                                  int num_instances,
+                                  int64_t num_tokens,
+                                  double read_seconds,
+                                  const vector<BenchmarkRun> &runs,
+                                  const vector<MicroBenchmarkResult> &micro,
+                                  ostream &os) {
+  os << "{" << endl;
+  os << "  \"label\": " << EscapeJsonString(FLAGS_bench_label) << "," << endl;
+  os << "  \"task\": " << EscapeJsonString(FLAGS_bench_task) << "," << endl;
+  os << "  \"model\": " << EscapeJsonString(options->GetModelFilePath())
+     << "," << endl;
+  os << "  \"test_file\": " << EscapeJsonString(options->GetTestFilePath())
+     << "," << endl;
+  os << "  \"repetitions\": " << FLAGS_bench_repetitions << "," << endl;
+  os << "  \"schedule\": " << EscapeJsonString(FLAGS_bench_schedule) << ","
+     << endl;
+  os << "  \"instances\": " << num_instances << "," << endl;
+  os << "  \"tokens\": " << num_tokens << "," << endl;
+  os << "  \"read\": {\"seconds\": " << read_seconds
+     << ", \"tokens_per_second\": "
+     << ((read_seconds > 0.0) ? num_tokens / read_seconds : 0.0)
+     << "}," << endl;
+
+  os << "  \"runs\": [" << endl;
+  for (int i = 0; i < runs.size(); ++i) {
+    const BenchmarkRun &run = runs[i];
+    os << "    {\"threads\": " << run.num_threads
+       << ", \"min_length\": " << run.min_length
+       << ", \"max_length\": ";
+    if (run.max_length < 0) {
+      os << "null";
+    } else {
+      os << run.max_length;
+    }
+    os << ", \"instances\": " << run.num_instances
+       << ", \"tokens\": " << run.num_tokens
+       << ", \"wall_seconds\": " << run.wall_seconds
+       << ", \"tokens_per_second\": "
+       << ((run.wall_seconds > 0.0) ? run.num_tokens / run.wall_seconds : 0.0)
+       << "," << endl;
+    os << "     \"stage_seconds\": {";
+    for (int stage = BENCHMARK_STAGE_CONVERT; stage < NUM_BENCHMARK_STAGES;
+         ++stage) {
+      if (stage > BENCHMARK_STAGE_CONVERT) os << ", ";
+      os << "\"" << GetBenchmarkStageName(stage) << "\": "
+         << run.stage_seconds[stage];
+    }
+    os << "}}" << ((i + 1 < runs.size()) ? "," : "") << endl;
+  }
+  os << "  ]," << endl;
+
+  os << "  \"micro\": [" << endl;
+  for (int i = 0; i < micro.size(); ++i) {
+    const MicroBenchmarkResult &result = micro[i];
+    os << "    {\"name\": " << EscapeJsonString(result.name)
+       << ", \"variant\": " << EscapeJsonString(result.variant)
+       << ", \"size\": " << result.size
+       << ", \"items\": " << result.num_items
+       << ", \"seconds\": " << result.seconds
+       << ", \"items_per_second\": "
+       << ((result.seconds > 0.0) ? result.num_items / result.seconds : 0.0)
+       << ", \"max_difference\": " << result.max_difference << "}"
+       << ((i + 1 < micro.size()) ? "," : "") << endl;
+  }
+  os << "  ]" << endl;
+  os << "}" << endl;
+}
+
+// Pass task-specific settings to the micro-benchmarks.
+static void ConfigureMicroBenchmarks(Pipe *pipe) {}
+
+static void ConfigureMicroBenchmarks(CoreferenceBenchmarkPipe *pipe) {
+  vector<int> mention_counts;
+  ParseIntegerList(FLAGS_bench_mention_counts, &mention_counts);
+  pipe->SetMentionCounts(mention_counts);
+}
+
+struct LongerInstanceComparator {
+  LongerInstanceComparator(const vector<int> *lengths) : lengths_(lengths) {}
+  bool operator()(int i, int j) const {
+    if ((*lengths_)[i] != (*lengths_)[j]) {
+      return (*lengths_)[i] > (*lengths_)[j];
+    }
+    return i < j;
+  }
+  const vector<int> *lengths_;
+};
+
+// Assign the instances with the given indices to a number of threads.
+// With --bench_schedule=longest_first, the instances are sorted by
+// decreasing length and each one goes to the thread with the least
+// estimated work (the decoding cost grows superlinearly with the length, so
+// we use the squared length), which avoids leaving a thread alone with the
+// longest sentences at the end of the run.
+static void ScheduleInstances(const vector<int> &lengths,
+                              const vector<int> &indices,
+                              int num_threads,
+                              vector<vector<int> > *thread_indices) {
+  thread_indices->assign(num_threads, vector<int>(0));
+  if (FLAGS_bench_schedule == "round_robin") {
+    for (int i = 0; i < indices.size(); ++i) {
+      (*thread_indices)[i % num_threads].push_back(indices[i]);
+    }
+    return;
+  }
+  CHECK_EQ(FLAGS_bench_schedule, "longest_first")
+    << "Unknown schedule: " << FLAGS_bench_schedule << ".";
+  vector<int> sorted_indices = indices;
+  sort(sorted_indices.begin(), sorted_indices.end(),
+       LongerInstanceComparator(&lengths));
+  vector<int64_t> loads(num_threads, 0);
+  for (int i = 0; i < sorted_indices.size(); ++i) {
+    int index = sorted_indices[i];
+    int best_thread = 0;
+    for (int t = 1; t < num_threads; ++t) {
+      if (loads[t] < loads[best_thread]) best_thread = t;
+    }
+    int64_t length = lengths[index];
+    loads[best_thread] += length * length;
+    (*thread_indices)[best_thread].push_back(index);
+  }
+  // Keep the input order within each thread.
+  for (int t = 0; t < num_threads; ++t) {
+    sort((*thread_indices)[t].begin(), (*thread_indices)[t].end());
+  }
+}
+
+// Run all the instances with indices in the given set with a number of
+// threads, each using its own pipe. Returns the best of
+// --bench_repetitions runs.
+template <class BenchmarkPipeType>
+static void RunBenchmark(const vector<BenchmarkPipeType*> &pipes,
+                         const vector<Instance*> &instances,
+                         const vector<int> &lengths,
+                         const vector<int> &indices,
+                         int num_threads,
+                         BenchmarkRun *run) {
+  run->num_threads = num_threads;
+  run->num_instances = indices.size();
+  run->wall_seconds = -1.0;
+  vector<vector<int> > thread_indices;
+  ScheduleInstances(lengths, indices, num_threads, &thread_indices);
+  for (int repetition = 0; repetition < FLAGS_bench_repetitions;
+       ++repetition) {
+    vector<BenchmarkWorker<BenchmarkPipeType> > workers(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      BenchmarkWorker<BenchmarkPipeType> *worker = &workers[t];
+      worker->pipe = pipes[t];
+      worker->instances = &instances;
+      worker->indices = thread_indices[t];
+      worker->stage_times.assign(NUM_BENCHMARK_STAGES, 0);
+      // Predictions are discarded unless --file_prediction is given.
+      const string &output_path = pipes[t]->GetOptions()->GetOutputFilePath();
+      if (output_path == "") {
+        worker->output_path = "/dev/null";
+      } else if (num_threads == 1) {
+        worker->output_path = output_path;
+      } else {
+        ostringstream ss;
+        ss << output_path << "." << t;
+        worker->output_path = ss.str();
+      }
+    }
+    timeval start, end;
+    gettimeofday(&start, NULL);
+    vector<std::thread> threads;
+    for (int t = 1; t < num_threads; ++t) {
+      threads.push_back(std::thread(RunBenchmarkWorker<BenchmarkPipeType>,
+                                    &workers[t]));
+    }
+    RunBenchmarkWorker<BenchmarkPipeType>(&workers[0]);
+    for (int t = 0; t < threads.size(); ++t) {
+      threads[t].join();
+    }
+    gettimeofday(&end, NULL);
+    double wall_seconds = static_cast<double>(diff_us(end, start)) / 1000000.0;
+
+    if (run->wall_seconds < 0.0 || wall_seconds < run->wall_seconds) {
+      run->wall_seconds = wall_seconds;
+      run->stage_seconds.assign(NUM_BENCHMARK_STAGES, 0.0);
+      for (int t = 0; t < num_threads; ++t) {
+        for (int stage = 0; stage < NUM_BENCHMARK_STAGES; ++stage) {
+          run->stage_seconds[stage] +=
+            static_cast<double>(workers[t].stage_times[stage]) / 1000000.0;
+        }
+      }
+    }
+  }
+}
+
+template <class OptionsType, class BenchmarkPipeType>
+static void RunBenchmarks() {
+  vector<int> thread_counts;
+  vector<int> length_bounds;
+  ParseIntegerList(FLAGS_bench_threads, &thread_counts);
+  ParseIntegerList(FLAGS_bench_length_buckets, &length_bounds);
+  CHECK_GT(FLAGS_bench_repetitions, 0);
+  int max_threads = 0;
+  for (int i = 0; i < thread_counts.size(); ++i) {
+    CHECK_GT(thread_counts[i], 0);
+    if (thread_counts[i] > max_threads) max_threads = thread_counts[i];
+  }
+  CHECK_GT(max_threads, 0) << "No number of threads in --bench_threads.";
+
+  // Load one copy of the model per thread.
+  vector<OptionsType*> options(max_threads);
+  vector<BenchmarkPipeType*> pipes(max_threads);
+  for (int t = 0; t < max_threads; ++t) {
+    options[t] = new OptionsType;
+    options[t]->Initialize();
+    pipes[t] = new BenchmarkPipeType(options[t]);
+    pipes[t]->Initialize();
+    pipes[t]->LoadModelFile();
+  }
+
+  vector<Instance*> instances;
+  vector<int64_t> read_times(NUM_BENCHMARK_STAGES, 0);
+  pipes[0]->ReadInstances(&instances, &read_times);
+  double read_seconds =
+    static_cast<double>(read_times[BENCHMARK_STAGE_READ]) / 1000000.0;
+  vector<int> lengths(instances.size());
+  int64_t num_tokens = 0;
+  for (int i = 0; i < instances.size(); ++i) {
+    lengths[i] = GetInstanceLength(instances[i]);
+    num_tokens += lengths[i];
+  }
+  LOG(INFO) << "Read " << instances.size() << " instances (" << num_tokens
+            << " tokens) in " << read_seconds << " sec.";
+
+  // Range of lengths of each bucket; the first one has all the instances.
+  vector<int> min_lengths(1, 0);
+  vector<int> max_lengths(1, -1);
+  for (int b = 0; b <= length_bounds.size(); ++b) {
+    min_lengths.push_back((b > 0) ? length_bounds[b - 1] + 1 : 0);
+    max_lengths.push_back((b < length_bounds.size()) ? length_bounds[b] : -1);
+  }
+
+  vector<BenchmarkRun> runs;
+  for (int i = 0; i < thread_counts.size(); ++i) {
+    for (int b = 0; b < min_lengths.size(); ++b) {
+      BenchmarkRun run;
+      run.min_length = min_lengths[b];
+      run.max_length = max_lengths[b];
+      run.num_tokens = 0;
+      vector<int> indices;
+      for (int j = 0; j < instances.size(); ++j) {
+        if (lengths[j] < run.min_length) continue;
+        if (run.max_length >= 0 && lengths[j] > run.max_length) continue;
+        indices.push_back(j);
+        run.num_tokens += lengths[j];
+      }
+      if (indices.empty()) continue;
+      RunBenchmark(pipes, instances, lengths, indices, thread_counts[i],
+                   &run);
+      LOG(INFO) << "Threads: " << run.num_threads
+                << ", lengths: " << run.min_length << "-" << run.max_length
+                << ", instances: " << run.num_instances
+                << ", time: " << run.wall_seconds << " sec., speed: "
+                << run.num_tokens / run.wall_seconds
+                << " tokens per second.";
+      runs.push_back(run);
+    }
+  }
+
+  vector<MicroBenchmarkResult> micro;
+  if (FLAGS_bench_micro) {
+    ConfigureMicroBenchmarks(pipes[0]);
+    pipes[0]->RunMicroBenchmarks(instances, &micro);
+  }
+
+  if (FLAGS_bench_output == "") {
+    WriteBenchmarkResults(options[0], instances.size(), num_tokens,
+                          read_seconds, runs, micro, cout);
+  } else {
+    ofstream os(FLAGS_bench_output.c_str());
+    CHECK(os.good()) << "Could not open " << FLAGS_bench_output << ".";
+    WriteBenchmarkResults(options[0], instances.size(), num_tokens,
+                          read_seconds, runs, micro, os);
+    os.close();
+  }
+
+  for (int i = 0; i < instances.size(); ++i) {
+    delete instances[i];
+  }
+  for (int t = 0; t < max_threads; ++t) {
+    delete pipes[t];
+    delete options[t];
+  }
+}
+
+int main(int argc, char** argv) {
+  // Initialize Google's logging library.
+  google::InitGoogleLogging(argv[0]);
+
+  // Parse command line flags.
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  // The pipes are always run at test time.
+  FLAGS_train = false;
+  FLAGS_test = true;
+
+  if (FLAGS_bench_task == "parser") {
+    RunBenchmarks<DependencyOptions, DependencyBenchmarkPipe>();
+  } else if (FLAGS_bench_task == "semantic_parser") {
+    RunBenchmarks<SemanticOptions, SemanticBenchmarkPipe>();
+  } else if (FLAGS_bench_task == "coreference_resolver") {
+    RunBenchmarks<CoreferenceOptions, CoreferenceBenchmarkPipe>();
+  } else if (FLAGS_bench_task == "tagger") {
+    RunBenchmarks<TaggerOptions, BenchmarkPipe<TaggerPipe> >();
+  } else if (FLAGS_bench_task == "entity_recognizer") {
+    RunBenchmarks<EntityOptions, EntityBenchmarkPipe>();
+  } else if (FLAGS_bench_task == "morphological_tagger") {
+    RunBenchmarks<MorphologicalOptions, BenchmarkPipe<MorphologicalPipe> >();
+  } else {
+    LOG(FATAL) << "Unknown task: " << FLAGS_bench_task << ".";
+  }
+
+  // Destroy allocated memory regarding line flags.
+  google::ShutDownCommandLineFlags();
+  google::ShutdownGoogleLogging();
+  return 0;
+}
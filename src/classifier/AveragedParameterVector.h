@@ -0,0 +1,125 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AVERAGEDPARAMETERVECTOR_H_
+#define AVERAGEDPARAMETERVECTOR_H_
+
+#include "SparseParameterVector.h"
+#include "SparseLabeledParameterVector.h"
+
+using namespace std;
+
+// The weight of a feature (up to a scale) and the running sum used to
+// average it (see Parameters::MakeGradientStep), stored side by side.
+struct AveragedWeight {
+  AveragedWeight() { value = 0.0; sum = 0.0; }
+  explicit AveragedWeight(double weight) { value = weight; sum = 0.0; }
+  double value;
+  double sum;
+};
+
+// The weight of an entry is its value; the running sum is left untouched.
+inline double GetWeightValue(const AveragedWeight &entry) {
+  return entry.value;
+}
+inline void SetWeightValue(double value, AveragedWeight *entry) {
+  entry->value = value;
+}
+
+// This class implements a sparse parameter vector for training with
+// averaging: each entry of the hash table holds the weight of a feature key
+// and its running sum, so that a gradient step looks up each key once,
+// instead of once in the weights and once in the averaged weights. The
+// weights are handled by SparseParameterVector, so that they are identical
+// to the ones of SparseParameterVectorDouble.
+class AveragedParameterVector : public SparseParameterVector<AveragedWeight> {
+public:
+  typedef ParameterMap<AveragedWeight>::type::iterator Iterator;
+
+  AveragedParameterVector() { Initialize(); }
+  virtual ~AveragedParameterVector() {}
+
+  // Increment the weight of this feature key by "value" and its running sum
+  // by "sum_value". Return false if the feature is not instantiated and
+  // cannot be inserted.
+  bool Add(uint64_t key, double value, double sum_value) {
+    Iterator iterator = FindOrInsert(key);
+    if (iterator == values_.end()) return false;
+    SetValue(iterator, GetValue(iterator) + value);
+    iterator->second.sum += sum_value;
+    return true;
+  }
+
+  // Add to each weight its running sum times sum_scale_factor, and reset the
+  // running sums.
+  void Average(double sum_scale_factor) {
+    for (Iterator iterator = values_.begin();
+         iterator != values_.end();
+         ++iterator) {
+      double value = iterator->second.sum * sum_scale_factor;
+      CHECK_EQ(value, value);
+      SetValue(iterator, GetValue(iterator) + value);
+      iterator->second.sum = 0.0;
+    }
+  }
+};
+
+// This class implements a sparse labeled parameter vector for training with
+// averaging, where the running sum of each label conjoined with a feature
+// key is stored next to its weight (see AveragedParameterVector).
+class AveragedLabeledParameterVector :
+  public SparseLabeledParameterVector<AveragedWeight> {
+public:
+  AveragedLabeledParameterVector() { Initialize(); }
+  virtual ~AveragedLabeledParameterVector() {}
+
+  // Increment the weight of this feature key conjoined with this label by
+  // "value", and its running sum by "sum_value". Return false if the feature
+  // is not instantiated and cannot be inserted.
+  bool Add(uint64_t key, int label, double value, double sum_value) {
+    Iterator iterator = FindOrInsert(key);
+    if (iterator == values_.end()) return false;
+    AddValue(iterator, label, value);
+    // Look up the entry after AddValue, which may have made the label
+    // weights dense.
+    iterator->second->GetMutableEntry(label)->sum += sum_value;
+    return true;
+  }
+
+  // Add to each weight its running sum times sum_scale_factor, and reset the
+  // running sums.
+  void Average(double sum_scale_factor) {
+    for (Iterator iterator = values_.begin();
+         iterator != values_.end();
+         ++iterator) {
+      LabelWeights<AveragedWeight> *label_weights = iterator->second;
+      int label;
+      double weight;
+      for (int k = 0; k < label_weights->Size(); ++k) {
+        label_weights->GetLabelWeightByPosition(k, &label, &weight);
+        AveragedWeight *entry = label_weights->GetMutableEntryByPosition(k);
+        double value = entry->sum * sum_scale_factor;
+        CHECK_EQ(value, value);
+        entry->sum = 0.0;
+        AddValue(iterator, label, value);
+      }
+    }
+  }
+};
+
+#endif /*AVERAGEDPARAMETERVECTOR_H_*/
@@ -21,6 +21,7 @@
 
 #include "Part.h"
 #include "Instance.h"
+#include "Profiler.h"
 #include <vector>
 
 using namespace std;
@@ -29,9 +30,13 @@ using namespace std;
 // this class and implement the pure virtual methods.
 class Decoder {
 public:
-  Decoder() {};
+  Decoder() { profiler_ = NULL; };
   virtual ~Decoder() {};
 
+  // Set the profiler of the pipe that owns this decoder, where decoder
+  // events (e.g. AD3 iterations) are counted.
+  void SetProfiler(Profiler *profiler) { profiler_ = profiler; }
+
   // Given an instance, a set of parts, and a score for each part, find the
   // most likely output (MAP decoding). This is used at test time, and when
   // training with perceptron.
@@ -39,6 +44,22 @@ public:
                       const vector<double> &scores,
                       vector<double> *predicted_output) = 0;
 
+  // Same as Decode, but the output is returned sparsely, as the indices of
+  // the parts which are in the predicted output ("active parts"), so that no
+  // vector with an entry per part needs to be filled. This is used at test
+  // time. The version implemented here calls Decode, and keeps the parts
+  // whose predicted output is at least 0.5; override it for decoders that
+  // can find the active parts directly.
+  virtual void DecodeSparse(Instance *instance, Parts *parts,
+                            const vector<double> &scores,
+                            vector<int> *active_parts) {
+    Decode(instance, parts, scores, &dense_output_);
+    active_parts->clear();
+    for (int r = 0; r < dense_output_.size(); ++r) {
+      if (dense_output_[r] >= 0.5) active_parts->push_back(r);
+    }
+  }
+
   // Given an instance, a set of parts, a score for each part, and the gold
   // output, find the output that maximizes a combination of the score and
   // a cost function with respect to the gold output (cost-augmented MAP
@@ -87,6 +108,53 @@ public:
                                vector<double> *predicted_output,
                                double *entropy,
                                double *loss) = 0;
+
+protected:
+  // Count a decoder event in the profiler (if any).
+  void IncrementProfilerCount(int counter, int64_t amount) {
+    if (profiler_) profiler_->Increment(counter, amount);
+  }
+
+  // True if memory should be recorded in the profiler (estimating it may
+  // take time, so check this first).
+  bool ProfilesMemory() const { return profiler_ && profiler_->enabled(); }
+
+  // Record the memory of a decoder structure in the profiler (if any).
+  void RecordProfilerMemory(int structure, int64_t num_bytes) {
+    if (profiler_) profiler_->RecordMemory(structure, num_bytes);
+  }
+
+  // Estimate the memory (in bytes) taken by an AD3 factor graph: the
+  // variables and factors, the links between them, and the copies of the
+  // potentials, posteriors, dual variables and MAPs kept by AD3 for each
+  // link and additional potential. This is a template so that decoders that
+  // do not use AD3 do not depend on it.
+  template<class FactorGraph>
+  static int64_t EstimateFactorGraphBytes(FactorGraph *factor_graph) {
+    int64_t num_bytes = 0;
+    int64_t num_links = 0;
+    for (int i = 0; i < factor_graph->GetNumVariables(); ++i) {
+      num_bytes += sizeof(*factor_graph->GetBinaryVariable(i));
+    }
+    for (int j = 0; j < factor_graph->GetNumFactors(); ++j) {
+      int degree = factor_graph->GetFactor(j)->Degree();
+      int num_additionals =
+        factor_graph->GetFactor(j)->GetAdditionalLogPotentials().size();
+      num_links += degree;
+      num_bytes += sizeof(*factor_graph->GetFactor(j)) +
+        degree * (sizeof(void*) + sizeof(bool) + sizeof(int) +
+                  2 * sizeof(double)) +
+        num_additionals * 3 * sizeof(double);
+    }
+    num_bytes += num_links * (sizeof(void*) + sizeof(int) +
+                              3 * sizeof(double));
+    return num_bytes;
+  }
+
+protected:
+  Profiler *profiler_; // Profiler of the pipe (not owned).
+  // Dense output used by DecodeSparse, reused across instances.
+  vector<double> dense_output_;
 };
 
 #endif /* DECODER_H_ */
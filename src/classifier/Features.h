@@ -21,6 +21,7 @@
 
 #include "Part.h"
 #include "Instance.h"
+#include "SerializationUtils.h"
 #ifdef _WIN32
 #include <stdint.h>
 #endif
@@ -52,6 +53,83 @@ public:
   // Get the binary features corresponding to the r-th part (mutable).
   virtual BinaryFeatures *GetMutablePartFeatures(int r) const = 0;
 
+  // Get the total number of binary features of the instance (used for
+  // profiling). Override this function in task-specific handlers.
+  virtual int64_t GetNumFeatures() const { return 0; }
+
+  // Estimate the memory (in bytes) taken by the binary features of the
+  // instance. Override this function in task-specific handlers.
+  virtual int64_t GetNumBytes() const { return 0; }
+
+  // Save/load the binary features of the instance to/from a binary file
+  // (used to spill the training cache to disk, see
+  // Pipe::CanSpillTrainingCache). Override these functions in task-specific
+  // handlers.
+  virtual void Save(FILE *fs) const {
+    CHECK(false) << "Saving features is not supported by this task.";
+  }
+  virtual void Load(FILE *fs) {
+    CHECK(false) << "Loading features is not supported by this task.";
+  }
+
+protected:
+  // Sum the number of features in a vector of feature vectors, some of which
+  // may be NULL.
+  static int64_t CountFeatures(const vector<BinaryFeatures*> &features) {
+    int64_t num_features = 0;
+    for (int i = 0; i < features.size(); ++i) {
+      if (features[i]) num_features += features[i]->size();
+    }
+    return num_features;
+  }
+
+  // Estimate the memory taken by a vector of feature vectors, some of which
+  // may be NULL.
+  static int64_t CountFeatureBytes(const vector<BinaryFeatures*> &features) {
+    int64_t num_bytes = features.capacity() * sizeof(BinaryFeatures*);
+    for (int i = 0; i < features.size(); ++i) {
+      if (!features[i]) continue;
+      num_bytes += sizeof(BinaryFeatures) +
+        features[i]->capacity() * sizeof(uint64_t);
+    }
+    return num_bytes;
+  }
+
+  // Save a vector of feature vectors, some of which may be NULL.
+  static void SaveFeatureVectors(FILE *fs,
+                                 const vector<BinaryFeatures*> &features) {
+    bool success = WriteInteger(fs, features.size());
+    CHECK(success);
+    for (int i = 0; i < features.size(); ++i) {
+      int length = features[i] ? features[i]->size() : -1;
+      success = WriteInteger(fs, length);
+      CHECK(success);
+      if (length <= 0) continue;
+      CHECK_EQ(fwrite(features[i]->data(), sizeof(uint64_t), length, fs),
+               static_cast<size_t>(length));
+    }
+  }
+
+  // Load a vector of feature vectors saved by SaveFeatureVectors. The
+  // vector must be empty.
+  static void LoadFeatureVectors(FILE *fs, vector<BinaryFeatures*> *features) {
+    CHECK_EQ(features->size(), 0);
+    int num_vectors;
+    bool success = ReadInteger(fs, &num_vectors);
+    CHECK(success);
+    features->resize(num_vectors, static_cast<BinaryFeatures*>(NULL));
+    for (int i = 0; i < num_vectors; ++i) {
+      int length;
+      success = ReadInteger(fs, &length);
+      CHECK(success);
+      if (length < 0) continue;
+      (*features)[i] = new BinaryFeatures(length);
+      if (length == 0) continue;
+      CHECK_EQ(fread((*features)[i]->data(), sizeof(uint64_t), length, fs),
+               static_cast<size_t>(length));
+    }
+  }
+
 protected:
   Pipe *pipe_; // The pipe that owns this feature handler.
 };
@@ -0,0 +1,298 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HASHEDPARAMETERVECTOR_H_
+#define HASHEDPARAMETERVECTOR_H_
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <glog/logging.h>
+#include "SerializationUtils.h"
+
+using namespace std;
+
+// Threshold for renormalizing the parameter vector.
+const double kHashedScaleFactorThreshold = 1e-9;
+// Number of weights converted at a time when saving/loading.
+const uint64_t kHashedBlockSize = 1 << 20;
+
+// This class implements a parameter vector with a fixed number of weights
+// (a power of two), stored in a dense array of type Real (float for the
+// weights, to save memory, and double for the running sums used to average
+// them, which grow large and would lose the small updates). Feature keys, and
+// feature keys conjoined with labels, are hashed into positions of the array
+// ("hashing trick"). Collisions are not resolved: features that hash to the
+// same position share their weight. In return, lookups are a single array
+// access, the memory footprint is fixed in advance, and the weights can be
+// saved and loaded as a single block.
+// As in SparseParameterVector, the weights are represented up to a scale
+// factor, and the squared norm is cached.
+// While training, a 32-bit fingerprint of the last key that updated each
+// position is optionally kept, so that the rate of colliding updates can be
+// measured.
+template<typename Real>
+class HashedParameterVector {
+public:
+  HashedParameterVector() { Clear(); };
+  virtual ~HashedParameterVector() {};
+
+  // Allocate 2^num_bits weights, all set to zero. If track_collisions is true,
+  // keep the fingerprints needed to count colliding updates.
+  void Initialize(int num_bits, bool track_collisions) {
+    CHECK_GT(num_bits, 0);
+    CHECK_LE(num_bits, 32);
+    num_bits_ = num_bits;
+    values_.assign(static_cast<uint64_t>(1) << num_bits, 0.0);
+    if (track_collisions) {
+      fingerprints_.assign(values_.size(), 0);
+    } else {
+      fingerprints_.clear();
+    }
+    scale_factor_ = 1.0;
+    squared_norm_ = 0.0;
+    num_nonzero_ = 0;
+    num_updates_ = 0;
+    num_colliding_updates_ = 0;
+  }
+
+  // Release all the weights. The vector must be initialized or loaded again
+  // before being used.
+  void Clear() {
+    num_bits_ = 0;
+    vector<Real>().swap(values_);
+    vector<uint32_t>().swap(fingerprints_);
+    scale_factor_ = 1.0;
+    squared_norm_ = 0.0;
+    num_nonzero_ = 0;
+    num_updates_ = 0;
+    num_colliding_updates_ = 0;
+  }
+
+  // Stop counting collisions and release the fingerprints.
+  void StopTrackingCollisions() {
+    vector<uint32_t>().swap(fingerprints_);
+  }
+
+  // Save/load the parameters to/from a file. The weights are always saved in
+  // single precision.
+  void Save(FILE *fs) const {
+    CHECK(!values_.empty()) << "Saving hashed parameters before initializing "
+                            << "them.";
+    bool success;
+    success = WriteInteger(fs, num_bits_);
+    CHECK(success);
+    success = WriteDouble(fs, scale_factor_);
+    CHECK(success);
+    success = WriteDouble(fs, squared_norm_);
+    CHECK(success);
+    // Convert the weights by blocks, to avoid copying the whole array.
+    vector<float> block;
+    for (uint64_t i = 0; i < values_.size(); i += kHashedBlockSize) {
+      uint64_t end = std::min(values_.size(), i + kHashedBlockSize);
+      block.assign(values_.begin() + i, values_.begin() + end);
+      CHECK_EQ(fwrite(&block[0], sizeof(float), block.size(), fs),
+               block.size());
+    }
+  }
+  void Load(FILE *fs) {
+    bool success;
+    int num_bits;
+    success = ReadInteger(fs, &num_bits);
+    CHECK(success);
+    Initialize(num_bits, false);
+    success = ReadDouble(fs, &scale_factor_);
+    CHECK(success);
+    success = ReadDouble(fs, &squared_norm_);
+    CHECK(success);
+    vector<float> block;
+    for (uint64_t i = 0; i < values_.size(); i += kHashedBlockSize) {
+      uint64_t end = std::min(values_.size(), i + kHashedBlockSize);
+      block.resize(end - i);
+      CHECK_EQ(fread(&block[0], sizeof(float), block.size(), fs),
+               block.size());
+      std::copy(block.begin(), block.end(), values_.begin() + i);
+    }
+    CountNonZero();
+  }
+
+  // Number of bits of the hash, and the corresponding number of weights.
+  int num_bits() const { return num_bits_; }
+  uint64_t NumBuckets() const { return values_.size(); }
+
+  // Get the number of non-zero weights.
+  uint64_t Size() const { return num_nonzero_; }
+
+  // Number of updates since initialization, and how many of them hit a
+  // position last updated by a different key (only if collisions are
+  // tracked).
+  int64_t num_updates() const { return num_updates_; }
+  int64_t num_colliding_updates() const { return num_colliding_updates_; }
+
+  // Memory (in bytes) taken by the weights and the fingerprints.
+  int64_t GetNumBytes() const {
+    return values_.capacity() * sizeof(Real) +
+      fingerprints_.capacity() * sizeof(uint32_t);
+  }
+
+  // Get the weight of a feature key.
+  double Get(uint64_t key) const {
+    return static_cast<double>(values_[GetPosition(HashKey(key))]) *
+      scale_factor_;
+  }
+
+  // Get the weights of a feature key conjoined with each of the labels.
+  void Get(uint64_t key, const vector<int> &labels,
+           vector<double> *weights) const {
+    uint64_t hash = HashKey(key);
+    weights->resize(labels.size());
+    for (int k = 0; k < labels.size(); ++k) {
+      uint64_t position = GetPosition(HashLabel(hash, labels[k]));
+      (*weights)[k] = static_cast<double>(values_[position]) * scale_factor_;
+    }
+  }
+
+  // Get the squared norm of the parameter vector.
+  double GetSquaredNorm() const { return squared_norm_; }
+
+  // Scale the parameter vector by a factor.
+  // w_k' = w_k * c_k
+  void Scale(double scale_factor) {
+    scale_factor_ *= scale_factor;
+    squared_norm_ *= scale_factor * scale_factor;
+    if (scale_factor_ > -kHashedScaleFactorThreshold &&
+        scale_factor_ < kHashedScaleFactorThreshold) {
+      Renormalize();
+    }
+  }
+
+  // Increment the weight of a feature key by an amount of "value".
+  // w'[id] = w[id] + val.
+  void Add(uint64_t key, double value) {
+    AddToHash(HashKey(key), value);
+  }
+
+  // Increment the weight of a feature key conjoined with a label by an amount
+  // of "value".
+  // w'[id] = w[id] + val.
+  void Add(uint64_t key, int label, double value) {
+    AddToHash(HashLabel(HashKey(key), label), value);
+  }
+
+  // Get the weight at a position of the array.
+  double GetValueAt(uint64_t position) const {
+    return static_cast<double>(values_[position]) * scale_factor_;
+  }
+
+  // Adds two parameter vectors with the same number of weights (possibly of
+  // another precision).
+  template<typename OtherReal>
+  void Add(const HashedParameterVector<OtherReal> &parameters) {
+    CHECK_EQ(num_bits_, parameters.num_bits());
+    squared_norm_ = 0.0;
+    for (uint64_t i = 0; i < values_.size(); ++i) {
+      double value = static_cast<double>(values_[i]) * scale_factor_ +
+        parameters.GetValueAt(i);
+      values_[i] = static_cast<Real>(value / scale_factor_);
+      squared_norm_ += value * value;
+    }
+    CountNonZero();
+  }
+
+protected:
+  // Mix the bits of a 64-bit key (finalizer of MurmurHash3). This is a
+  // bijection, so distinct keys only collide after the truncation to
+  // num_bits_ bits.
+  static uint64_t HashKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+  // Hash of a key (already hashed) conjoined with a label.
+  static uint64_t HashLabel(uint64_t hash, int label) {
+    return HashKey(hash + static_cast<uint64_t>(label) + 1);
+  }
+
+  // Position of a hash in the array (its top num_bits_ bits).
+  uint64_t GetPosition(uint64_t hash) const {
+    return hash >> (64 - num_bits_);
+  }
+
+  void AddToHash(uint64_t hash, double value) {
+    uint64_t position = GetPosition(hash);
+    if (!fingerprints_.empty()) {
+      // Use the low bits as fingerprint; zero marks an unused position.
+      uint32_t fingerprint = static_cast<uint32_t>(hash) | 1;
+      if (fingerprints_[position] != fingerprint) {
+        if (fingerprints_[position] != 0) ++num_colliding_updates_;
+        fingerprints_[position] = fingerprint;
+      }
+      ++num_updates_;
+    }
+    if (value == 0.0) return;
+    double current_value = static_cast<double>(values_[position]) *
+      scale_factor_;
+    double new_value = current_value + value;
+    squared_norm_ += new_value * new_value - current_value * current_value;
+    if (values_[position] != 0.0) --num_nonzero_;
+    // Might lose precision here.
+    values_[position] = static_cast<Real>(new_value / scale_factor_);
+    if (values_[position] != 0.0) ++num_nonzero_;
+
+    // This prevents numerical issues:
+    if (squared_norm_ < 0.0) squared_norm_ = 0.0;
+  }
+
+  // Renormalize the entire parameter array.
+  void Renormalize() {
+    LOG(INFO) << "Renormalizing the parameter array...";
+    for (uint64_t i = 0; i < values_.size(); ++i) {
+      values_[i] *= scale_factor_;
+    }
+    scale_factor_ = 1.0;
+    // Some weights may have underflowed to zero.
+    CountNonZero();
+  }
+
+  // Count the non-zero weights, scanning the whole array.
+  void CountNonZero() {
+    num_nonzero_ = 0;
+    for (uint64_t i = 0; i < values_.size(); ++i) {
+      if (values_[i] != 0.0) ++num_nonzero_;
+    }
+  }
+
+protected:
+  int num_bits_; // Number of bits of the hash.
+  vector<Real> values_; // Weight values, up to a scale.
+  vector<uint32_t> fingerprints_; // Last key that updated each position.
+  double scale_factor_; // The scale factor, such that w = values * scale.
+  double squared_norm_; // The squared norm of the parameter vector.
+  uint64_t num_nonzero_; // Number of non-zero weights.
+  int64_t num_updates_; // Number of updates (when tracking collisions).
+  int64_t num_colliding_updates_; // Updates that hit another key's position.
+};
+
+typedef HashedParameterVector<float> HashedParameterVectorFloat;
+typedef HashedParameterVector<double> HashedParameterVectorDouble;
+
+#endif /*HASHEDPARAMETERVECTOR_H_*/
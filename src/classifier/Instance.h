@@ -19,6 +19,9 @@
 #ifndef INSTANCE_H_
 #define INSTANCE_H_
 
+#include <stdio.h>
+#include <glog/logging.h>
+
 using namespace std;
 
 // Abstract class for the instance. Task-specific handlers should derive
@@ -29,6 +32,18 @@ public:
   virtual ~Instance() {};
 
   virtual Instance* Copy() = 0;
+
+  // Save/load an instance to/from a binary file (e.g. to train from a file
+  // of formatted instances, see --train_stream, or to test on a corpus
+  // converted by TurboCorpusConverter, which also stores the original
+  // instances). Override these functions for the instances of tasks that
+  // support it.
+  virtual void Save(FILE *fs) {
+    CHECK(false) << "Saving this instance is not implemented.";
+  }
+  virtual void Load(FILE *fs) {
+    CHECK(false) << "Loading this instance is not implemented.";
+  }
 };
 
 #endif /*INSTANCE_H_*/
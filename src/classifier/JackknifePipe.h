@@ -0,0 +1,192 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef JACKKNIFEPIPE_H_
+#define JACKKNIFEPIPE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Pipe.h"
+#include "MemoryReader.h"
+#include "TimeUtils.h"
+
+using namespace std;
+
+// Pipe that trains PipeType on instances held in memory rather than on the
+// training file (which is read by a MemoryReader<ReaderType>). The dictionary
+// is built from these instances, as it would be from the training file.
+template <class PipeType, class ReaderType>
+class JackknifePipe : public PipeType {
+public:
+  JackknifePipe(Options* options) : PipeType(options) {}
+  virtual ~JackknifePipe() {}
+
+  // Set the training instances, which are not owned by the pipe and must
+  // not be deleted before the end of training.
+  void SetTrainingInstances(const vector<Instance*> &instances) {
+    static_cast<MemoryReader<ReaderType>*>(this->reader_)->SetInstances(
+      instances);
+  }
+
+protected:
+  void CreateReader() { this->reader_ = new MemoryReader<ReaderType>; }
+};
+
+// Model trained in a jackknifing run: the model of a fold, which is trained
+// on the other folds and labels the instances of its fold, or the model
+// trained on the whole corpus (with no instances to label).
+template <class PipeType, class ReaderType>
+struct JackknifeJob {
+  JackknifePipe<PipeType, ReaderType> *pipe;
+  vector<Instance*> training_instances;
+  vector<Instance*> held_out_instances;
+  bool save_model;
+};
+
+// Train the models of the jobs, taking the next untrained one until all
+// have been trained. Each pipe is deleted once its job is done.
+template <class PipeType, class ReaderType>
+void RunJackknifeWorker(vector<JackknifeJob<PipeType, ReaderType> > *jobs,
+                        std::atomic<int> *next_job) {
+  while (true) {
+    int k = (*next_job)++;
+    if (k >= jobs->size()) break;
+    JackknifeJob<PipeType, ReaderType> *job = &(*jobs)[k];
+    job->pipe->SetTrainingInstances(job->training_instances);
+    job->pipe->Train();
+    if (job->save_model) job->pipe->SaveModelFile();
+    for (int i = 0; i < job->held_out_instances.size(); ++i) {
+      job->pipe->ClassifyInstance(job->held_out_instances[i]);
+    }
+    delete job->pipe;
+    job->pipe = NULL;
+  }
+}
+
+// Jackknifing (flag --jackknife_folds): read the training corpus once, split
+// it into consecutive folds of equal size (the last one may be smaller), as
+// scripts/split_corpus_jackknifing.py does, and label each fold with a model
+// trained on the other folds. The labeled corpus is written to the output
+// file of the options, in the order of the training corpus. If the options
+// have a model file, a model is also trained on the whole corpus and saved.
+// The models are trained concurrently by --jackknife_threads threads.
+template <class PipeType, class OptionsType, class ReaderType,
+          class WriterType>
+void RunJackknife(OptionsType *options) {
+  int num_folds = options->jackknife_folds();
+  CHECK_GT(num_folds, 1);
+  CHECK_NE(options->GetOutputFilePath(), "")
+    << "Jackknifing requires an output file (--file_prediction).";
+  CHECK_EQ(options->GetTrainingCorpusFilePath(), "")
+    << "Jackknifing requires the training file, not a training corpus.";
+
+  LOG(INFO) << "Reading training instances...";
+  vector<Instance*> instances;
+  ReaderType reader;
+  reader.Open(options->GetTrainingFilePath());
+  Instance *instance = reader.GetNext();
+  while (instance) {
+    instances.push_back(instance);
+    instance = reader.GetNext();
+  }
+  reader.Close();
+  int num_instances = instances.size();
+  int fold_size = (num_instances + num_folds - 1) / num_folds;
+  LOG(INFO) << "Number of instances: " << num_instances;
+  LOG(INFO) << "Number of folds: " << num_folds << " of " << fold_size
+            << " instances";
+
+  // The held-out instances are labeled in place, so each fold gets copies.
+  vector<Instance*> output_instances(num_instances);
+  for (int i = 0; i < num_instances; ++i) {
+    output_instances[i] = instances[i]->Copy();
+  }
+
+  vector<JackknifeJob<PipeType, ReaderType> > jobs;
+  vector<OptionsType*> job_options;
+  for (int k = 0; k <= num_folds; ++k) {
+    int start = min(k * fold_size, num_instances);
+    int end = min(start + fold_size, num_instances);
+    bool save_model = (k == num_folds);
+    if (save_model && options->GetModelFilePath() == "") continue;
+    if (!save_model && start == end) continue;
+    JackknifeJob<PipeType, ReaderType> job;
+    if (save_model) {
+      job.training_instances = instances;
+    } else {
+      job.training_instances.assign(instances.begin(),
+                                    instances.begin() + start);
+      job.training_instances.insert(job.training_instances.end(),
+                                    instances.begin() + end,
+                                    instances.end());
+      job.held_out_instances.assign(output_instances.begin() + start,
+                                    output_instances.begin() + end);
+    }
+    job.save_model = save_model;
+    // Each pipe has its own options; the held-out instances are not
+    // evaluated.
+    OptionsType *fold_options = new OptionsType(*options);
+    fold_options->SetEvaluate(false);
+    job_options.push_back(fold_options);
+    job.pipe = new JackknifePipe<PipeType, ReaderType>(fold_options);
+    job.pipe->Initialize();
+    jobs.push_back(job);
+  }
+
+  int num_threads = options->jackknife_threads();
+  if (num_threads <= 0 || num_threads > jobs.size()) {
+    num_threads = jobs.size();
+  }
+  LOG(INFO) << "Training " << jobs.size() << " models with " << num_threads
+            << " threads...";
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  std::atomic<int> next_job(0);
+  vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) {
+    threads.push_back(std::thread(RunJackknifeWorker<PipeType, ReaderType>,
+                                  &jobs, &next_job));
+  }
+  RunJackknifeWorker<PipeType, ReaderType>(&jobs, &next_job);
+  for (int t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+  }
+  gettimeofday(&end, NULL);
+  LOG(INFO) << "Training the models took "
+            << static_cast<double>(diff_ms(end, start)) / 1000.0 << " sec.";
+
+  WriterType writer;
+  writer.Open(options->GetOutputFilePath());
+  for (int i = 0; i < num_instances; ++i) {
+    writer.Write(output_instances[i]);
+  }
+  writer.Close();
+
+  for (int k = 0; k < job_options.size(); ++k) {
+    delete job_options[k];
+  }
+  for (int i = 0; i < num_instances; ++i) {
+    delete instances[i];
+    delete output_instances[i];
+  }
+}
+
+#endif /* JACKKNIFEPIPE_H_ */
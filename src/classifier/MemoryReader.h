@@ -0,0 +1,54 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MEMORYREADER_H_
+#define MEMORYREADER_H_
+
+#include <vector>
+#include "Reader.h"
+
+using namespace std;
+
+// Reader of instances held in memory (e.g. part of a corpus that has been
+// read once), which replaces the file reader of type ReaderType in a pipe.
+// The file path passed to Open is ignored. GetNext returns copies of the
+// instances, which are owned by the caller as with any other reader; the
+// instances themselves are not owned by the reader.
+template <class ReaderType> class MemoryReader : public ReaderType {
+public:
+  MemoryReader() { position_ = 0; }
+  virtual ~MemoryReader() {}
+
+  void SetInstances(const vector<Instance*> &instances) {
+    instances_ = instances;
+    position_ = 0;
+  }
+
+  void Open(const std::string &filepath) { position_ = 0; }
+  void Close() {}
+  Instance *GetNext() {
+    if (position_ >= instances_.size()) return NULL;
+    return instances_[position_++]->Copy();
+  }
+
+protected:
+  vector<Instance*> instances_;
+  int position_;
+};
+
+#endif /* MEMORYREADER_H_ */
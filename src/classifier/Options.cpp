@@ -24,7 +24,8 @@ using namespace std;
 DEFINE_string(file_train, "",
               "Path to the file containing the training data.");
 DEFINE_string(file_test, "",
-              "Path to the file containing the test data.");
+              "Path to the file containing the test data, or to a test "
+              "corpus created from it by TurboCorpusConverter.");
 DEFINE_string(file_model, "",
               "Path to the file containing the model.");
 DEFINE_string(file_prediction, "",
@@ -53,6 +54,106 @@ DEFINE_double(train_regularization_constant, 1e12,
               "Regularization parameter C.");
 DEFINE_int32(parameters_max_num_buckets, 50000000,
              "Maximum number of buckets in the hash table that stores the parameters.");
+DEFINE_int32(parameters_hash_bits, 0,
+             "If positive, store the weights in a dense array of "
+             "2^parameters_hash_bits floats, indexed by hashing the feature "
+             "keys (and labels), instead of in hash tables. Colliding "
+             "features share their weight. Only used for training; the "
+             "choice is saved with the model.");
+DEFINE_bool(parameters_float, false,
+            "If true, store the weights of the hash tables in single "
+            "precision. At training time, the weights are still learned in "
+            "double precision and converted when saving the model. At test "
+            "time, a model saved in double precision is converted when "
+            "loading it. Models saved in single precision are always loaded "
+            "in single precision.");
+DEFINE_bool(parameters_inline_averaging, true,
+            "If true, when training with averaging, keep the running sum "
+            "used to average each weight in the same hash table entry as "
+            "the weight, rather than in a second table of the same size. "
+            "The averaged weights are the same either way. Not used with "
+            "--parameters_hash_bits.");
+DEFINE_bool(train_cache_instances, false,
+            "True for keeping the parts (after pruning), gold outputs and "
+            "features of each training instance in memory after the first "
+            "epoch, so that later epochs only do scoring, decoding and "
+            "updates.");
+DEFINE_int32(train_cache_max_megabytes, 0,
+             "Memory budget for the training cache, in megabytes (0 for no "
+             "limit). Instances that do not fit are written to "
+             "--file_train_cache and read back in every epoch, for the tasks "
+             "that support it (dependency and semantic parsers); otherwise "
+             "they are processed from scratch in every epoch.");
+DEFINE_string(file_train_cache, "",
+              "Path to the temporary file holding the training instances "
+              "that do not fit in --train_cache_max_megabytes, which is "
+              "deleted at the end of training. If empty, the path of the "
+              "model file with the suffix .cache is used.");
+DEFINE_bool(train_prefetch_parts, false,
+            "True for making the parts (after pruning) and features of the "
+            "next training instance on a thread while training on the "
+            "current one (supported by the dependency and semantic "
+            "parsers). Ignored with --profile.");
+DEFINE_bool(train_stream, false,
+            "True for training without keeping the training instances in "
+            "memory: they are converted once to a binary file (see "
+            "--file_train_stream), which is read in chunks of "
+            "--train_stream_chunk_size instances in every epoch, the next "
+            "chunk being read on a thread while training on the current one "
+            "(supported by the dependency and semantic parsers, the "
+            "dependency labeler and the taggers).");
+DEFINE_string(file_train_stream, "",
+              "Path to the binary file of training instances written with "
+              "--train_stream, which is deleted at the end of training. If "
+              "empty, the path of the model file with the suffix .stream is "
+              "used.");
+DEFINE_int32(train_stream_chunk_size, 10000,
+             "Number of training instances in each chunk read with "
+             "--train_stream. At most two chunks are in memory at a time.");
+DEFINE_bool(train_stream_shuffle, false,
+            "True for shuffling the order of the chunks, and the order of the "
+            "instances within each chunk, in every epoch with "
+            "--train_stream. The shuffling is deterministic.");
+DEFINE_string(file_train_corpus, "",
+              "Path to a binary corpus of numeric training instances, "
+              "created from --file_train by TurboCorpusConverter. If given, "
+              "the dictionaries and the training instances are loaded from it "
+              "instead of reading and converting --file_train (with "
+              "--train_stream, the instances are read from it in chunks).");
+DEFINE_int32(batch_size, 1,
+             "Number of test instances read at a time. The instances of each "
+             "batch are decoded longest first (see --batch_bucket_width) and "
+             "written in the input order. If 1, instances are decoded in the "
+             "input order as they are read.");
+DEFINE_int32(batch_bucket_width, 0,
+             "Width of the length buckets used to schedule a batch (see "
+             "--batch_size): buckets are decoded from the longest to the "
+             "shortest, and the instances in a bucket in the input order. If "
+             "0, instances are sorted by decreasing length.");
+DEFINE_bool(profile, false,
+            "True for measuring the time spent in each stage of the pipe "
+            "(in nanoseconds), counting parts, features, weight lookups, "
+            "cache hits and decoder iterations, and estimating the peak "
+            "memory of the parts, features and factor graphs of an "
+            "instance, the training cache and the parameters. The peak "
+            "memory is also logged after each training epoch.");
+DEFINE_string(file_profile, "",
+              "Path to the file where the profile (see --profile) is written "
+              "in JSON format at the end of training or testing. If empty, "
+              "the profile is logged.");
+DEFINE_int32(jackknife_folds, 0,
+             "Number of folds for jackknifing at training time (supported by "
+             "the tagger and the morphological tagger). If greater than 1, "
+             "the training corpus is split into this number of consecutive "
+             "folds, each fold is tagged with a model trained on the other "
+             "folds, and the tagged corpus is written to --file_prediction "
+             "(as with scripts/split_corpus_jackknifing.py). The corpus is "
+             "read once and the models are trained concurrently. If "
+             "--file_model is given, a model trained on the whole corpus is "
+             "also saved. 0 for no jackknifing.");
+DEFINE_int32(jackknife_threads, 0,
+             "Number of threads training the models for jackknifing (see "
+             "--jackknife_folds). 0 for one thread per model.");
 
 void Options::Initialize() {
   file_train_ = FLAGS_file_train;
@@ -73,4 +174,27 @@ void Options::Initialize() {
   train_learning_rate_schedule_ = FLAGS_train_learning_rate_schedule;
   only_supported_features_ = FLAGS_only_supported_features;
   use_averaging_ = FLAGS_use_averaging;
+  train_cache_instances_ = FLAGS_train_cache_instances;
+  train_cache_max_megabytes_ = FLAGS_train_cache_max_megabytes;
+  file_train_cache_ = FLAGS_file_train_cache;
+  if (file_train_cache_ == "") file_train_cache_ = file_model_ + ".cache";
+  train_prefetch_parts_ = FLAGS_train_prefetch_parts;
+  train_stream_ = FLAGS_train_stream;
+  file_train_stream_ = FLAGS_file_train_stream;
+  if (train_stream_ && file_train_stream_ == "") {
+    file_train_stream_ = file_model_ + ".stream";
+  }
+  train_stream_chunk_size_ = FLAGS_train_stream_chunk_size;
+  CHECK_GE(train_stream_chunk_size_, 1);
+  train_stream_shuffle_ = FLAGS_train_stream_shuffle;
+  file_train_corpus_ = FLAGS_file_train_corpus;
+  batch_size_ = FLAGS_batch_size;
+  batch_bucket_width_ = FLAGS_batch_bucket_width;
+  CHECK_GE(batch_size_, 1);
+  CHECK_GE(batch_bucket_width_, 0);
+  profile_ = FLAGS_profile;
+  file_profile_ = FLAGS_file_profile;
+  jackknife_folds_ = FLAGS_jackknife_folds;
+  jackknife_threads_ = FLAGS_jackknife_threads;
+  parameters_float_ = FLAGS_parameters_float;
 }
@@ -36,8 +36,26 @@ DECLARE_int32(train_epochs);
 DECLARE_double(train_regularization_constant);
 DECLARE_double(train_initial_learning_rate);
 DECLARE_string(train_learning_rate_schedule);
+DECLARE_bool(train_cache_instances);
+DECLARE_int32(train_cache_max_megabytes);
+DECLARE_string(file_train_cache);
+DECLARE_bool(train_prefetch_parts);
+DECLARE_bool(train_stream);
+DECLARE_string(file_train_stream);
+DECLARE_int32(train_stream_chunk_size);
+DECLARE_bool(train_stream_shuffle);
+DECLARE_string(file_train_corpus);
+DECLARE_int32(batch_size);
+DECLARE_int32(batch_bucket_width);
+DECLARE_bool(profile);
+DECLARE_string(file_profile);
+DECLARE_int32(jackknife_folds);
+DECLARE_int32(jackknife_threads);
 
 DECLARE_int32(parameters_max_num_buckets);
+DECLARE_int32(parameters_hash_bits);
+DECLARE_bool(parameters_float);
+DECLARE_bool(parameters_inline_averaging);
 
 //1 to use new developments regarding performance optimizations
 #ifndef USE_N_OPTIMIZATIONS
@@ -47,7 +65,17 @@ DECLARE_int32(parameters_max_num_buckets);
 // General training/test options.
 class Options {
 public:
-  Options() {};
+  Options() {
+    train_prefetch_parts_ = false;
+    train_stream_ = false;
+    train_stream_chunk_size_ = 10000;
+    train_stream_shuffle_ = false;
+    batch_size_ = 1;
+    batch_bucket_width_ = 0;
+    profile_ = false;
+    jackknife_folds_ = 0;
+    jackknife_threads_ = 0;
+  };
   virtual ~Options() {};
 
   // Serialization functions.
@@ -74,6 +102,22 @@ public:
   }
   bool use_averaging() { return use_averaging_; }
   bool only_supported_features() { return only_supported_features_; }
+  bool train_cache_instances() { return train_cache_instances_; }
+  int train_cache_max_megabytes() { return train_cache_max_megabytes_; }
+  const std::string &GetTrainingCacheFilePath() { return file_train_cache_; }
+  bool train_prefetch_parts() { return train_prefetch_parts_; }
+  bool train_stream() { return train_stream_; }
+  const std::string &GetTrainingStreamFilePath() { return file_train_stream_; }
+  int train_stream_chunk_size() { return train_stream_chunk_size_; }
+  bool train_stream_shuffle() { return train_stream_shuffle_; }
+  const std::string &GetTrainingCorpusFilePath() { return file_train_corpus_; }
+  int batch_size() { return batch_size_; }
+  int batch_bucket_width() { return batch_bucket_width_; }
+  bool profile() { return profile_; }
+  const std::string &GetProfileFilePath() { return file_profile_; }
+  int jackknife_folds() { return jackknife_folds_; }
+  int jackknife_threads() { return jackknife_threads_; }
+  bool parameters_float() { return parameters_float_; }
   bool train() { return train_; }
   bool test() { return test_; }
   bool evaluate() { return evaluate_; }
@@ -91,6 +135,7 @@ public:
   void SetOutputFilePath(const std::string &file_prediction) {
     file_prediction_ = file_prediction;
   }
+  void SetEvaluate(bool evaluate) { evaluate_ = evaluate; }
 
 protected:
   std::string file_train_;
@@ -121,6 +166,48 @@ protected:
 
   bool only_supported_features_; // Use only supported features.
   bool use_averaging_; // Include a final averaging step during training.
+
+  // Cache the parts, gold outputs and features of the training instances
+  // across epochs, within a memory budget (0 for no limit), and file for
+  // the instances that do not fit.
+  bool train_cache_instances_;
+  int train_cache_max_megabytes_;
+  std::string file_train_cache_;
+
+  // Make the parts and features of the next training instance on a thread
+  // while training on the current one.
+  bool train_prefetch_parts_;
+
+  // Train from a binary file of instances read in chunks, instead of
+  // keeping the training instances in memory; path of the file, number of
+  // instances per chunk, and whether the chunks and instances are shuffled.
+  bool train_stream_;
+  std::string file_train_stream_;
+  int train_stream_chunk_size_;
+  bool train_stream_shuffle_;
+
+  // Binary corpus of numeric training instances (empty for reading the
+  // training file).
+  std::string file_train_corpus_;
+
+  // Number of test instances read and scheduled at a time, and width of the
+  // length buckets used to schedule them (0 to sort them by length).
+  int batch_size_;
+  int batch_bucket_width_;
+
+  // Profile the stages of the pipe, and write the profile in JSON format
+  // to a file (or log it if the path is empty).
+  bool profile_;
+  std::string file_profile_;
+
+  // Save the model weights in single precision, and load them (keeping them
+  // read-only) in single precision.
+  bool parameters_float_;
+
+  // Number of folds for jackknifing (0 for none) and number of threads
+  // training their models (0 for one per model).
+  int jackknife_folds_;
+  int jackknife_threads_;
 };
 
 #endif /*OPTIONS_H_*/
@@ -0,0 +1,501 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PARAMETERSTORAGE_H_
+#define PARAMETERSTORAGE_H_
+
+#include "Features.h"
+#include "Options.h"
+#include "SparseParameterVector.h"
+#include "SparseLabeledParameterVector.h"
+#include "HashedParameterVector.h"
+#include "AveragedParameterVector.h"
+
+// Written in place of the number of features to flag hashed parameters.
+const int kHashedParametersMarker = -1;
+// Written in place of the number of features to flag parameters saved in
+// single precision. It is followed by the number of features.
+const int kFloatParametersMarker = -2;
+
+// Abstract class for the storage of the weights of the model parameters
+// (see Parameters), for the "simple" features and for the features conjoined
+// with output labels. The storage is chosen when the parameters are
+// initialized or loaded. This interface only reads the weights (see
+// TrainableParameterStorage for the updates). The methods take whole feature
+// vectors, so that there is one virtual call per part rather than per
+// feature.
+class ParameterStorage {
+public:
+  ParameterStorage() {}
+  virtual ~ParameterStorage() {}
+
+  // Save the weights (the running sums are not saved), in single precision
+  // if single_precision is true.
+  virtual void Save(FILE *fs, bool single_precision) const = 0;
+
+  // Number of parameters, counting each feature conjoined with output labels
+  // as a single parameter.
+  virtual uint64_t Size() const = 0;
+
+  // Memory (in bytes) taken by the weights, and by the running sums kept
+  // apart from them.
+  virtual int64_t GetNumBytes() const = 0;
+  virtual int64_t GetAveragedNumBytes() const = 0;
+
+  // Checks if a feature (or a feature conjoined with labels) exists.
+  virtual bool Exists(uint64_t key) const = 0;
+  virtual bool ExistsLabeled(uint64_t key) const = 0;
+
+  // Get the weight of a "simple" feature, or of a feature conjoined with
+  // each of the labels (see Parameters::Get).
+  virtual double Get(uint64_t key) const = 0;
+  virtual bool Get(uint64_t key, const vector<int> &labels,
+                   vector<double> *label_scores) const = 0;
+
+  // Get the squared norm of the weights.
+  virtual double GetSquaredNorm() const = 0;
+
+  // Sum the weights of a set of "simple" features.
+  virtual double ComputeScore(const BinaryFeatures &features) const = 0;
+
+  // Add the scores of a set of features conjoined with labels to
+  // scores[label] (see Parameters::AddLabelScores).
+  virtual void AddLabelScores(const BinaryFeatures &features,
+                              const vector<int> &labels,
+                              int num_labels,
+                              double *scores) const = 0;
+};
+
+// Abstract class for a storage of weights that can be trained, with the
+// running sums used to average them.
+class TrainableParameterStorage : public ParameterStorage {
+public:
+  TrainableParameterStorage() {}
+  virtual ~TrainableParameterStorage() {}
+
+  // Lock/unlock the storage. If it is locked, no features can be added.
+  virtual void StopGrowth() = 0;
+  virtual void AllowGrowth() = 0;
+
+  // Scale the weights.
+  virtual void Scale(double scale_factor) = 0;
+
+  // Add -eta * gradient to the weights of a set of features (conjoined with
+  // a label), and iteration * eta * gradient to their running sums.
+  virtual void MakeGradientStep(const BinaryFeatures &features,
+                                double eta,
+                                int iteration,
+                                double gradient) = 0;
+  virtual void MakeLabelGradientStep(const BinaryFeatures &features,
+                                     double eta,
+                                     int iteration,
+                                     int label,
+                                     double gradient) = 0;
+
+  // Replace the weights by their averages after num_iterations (if
+  // averaging).
+  virtual void Finalize(int num_iterations) = 0;
+};
+
+// Weights in hash tables of features, of types WeightVector and
+// LabeledWeightVector, derived from Storage (ParameterStorage or
+// TrainableParameterStorage). This implements saving and the lookups; the
+// updates are implemented by the derived classes.
+template<typename Storage, typename WeightVector,
+         typename LabeledWeightVector>
+class SparseWeightStorage : public Storage {
+public:
+  SparseWeightStorage() {
+    weights_.Initialize();
+    labeled_weights_.Initialize();
+  }
+  virtual ~SparseWeightStorage() {}
+
+  void Save(FILE *fs, bool single_precision) const {
+    if (single_precision) {
+      bool success = WriteInteger(fs, kFloatParametersMarker);
+      CHECK(success);
+    }
+    weights_.Save(fs, single_precision);
+    labeled_weights_.Save(fs, single_precision);
+  }
+
+  uint64_t Size() const { return weights_.Size() + labeled_weights_.Size(); }
+  int64_t GetNumBytes() const {
+    return weights_.GetNumBytes() + labeled_weights_.GetNumBytes();
+  }
+  bool Exists(uint64_t key) const { return weights_.Exists(key); }
+  bool ExistsLabeled(uint64_t key) const {
+    return labeled_weights_.Exists(key);
+  }
+  double Get(uint64_t key) const { return weights_.Get(key); }
+  bool Get(uint64_t key, const vector<int> &labels,
+           vector<double> *label_scores) const {
+    return labeled_weights_.Get(key, labels, label_scores);
+  }
+  double GetSquaredNorm() const {
+    return weights_.GetSquaredNorm() + labeled_weights_.GetSquaredNorm();
+  }
+  double ComputeScore(const BinaryFeatures &features) const {
+    double score = 0.0;
+    for (int j = 0; j < features.size(); ++j) {
+      score += weights_.Get(features[j]);
+    }
+    return score;
+  }
+  void AddLabelScores(const BinaryFeatures &features,
+                      const vector<int> &labels,
+                      int num_labels,
+                      double *scores) const {
+    for (int j = 0; j < features.size(); ++j) {
+      labeled_weights_.AddAllValues(features[j], num_labels, scores);
+    }
+  }
+
+protected:
+  // Load the weights when the number of features has already been read.
+  void LoadWeights(FILE *fs, int length, bool single_precision) {
+    weights_.Load(fs, length, single_precision);
+    labeled_weights_.Load(fs, single_precision);
+  }
+
+protected:
+  WeightVector weights_;
+  LabeledWeightVector labeled_weights_;
+};
+
+// Weights in double precision, with the running sums in hash tables of the
+// same size (used with --parameters_inline_averaging=false).
+class SparseParameterStorage :
+  public SparseWeightStorage<TrainableParameterStorage,
+                             SparseParameterVectorDouble,
+                             SparseLabeledParameterVectorDouble> {
+public:
+  SparseParameterStorage(bool use_average) {
+    use_average_ = use_average;
+    if (use_average_) {
+      averaged_weights_.Initialize();
+      averaged_labeled_weights_.Initialize();
+    }
+  }
+  virtual ~SparseParameterStorage() {}
+
+  // Load the weights when the number of features has already been read.
+  void Load(FILE *fs, int length, bool single_precision) {
+    LoadWeights(fs, length, single_precision);
+  }
+
+  void StopGrowth() {
+    weights_.StopGrowth();
+    averaged_weights_.StopGrowth();
+    labeled_weights_.StopGrowth();
+    averaged_labeled_weights_.StopGrowth();
+  }
+  void AllowGrowth() {
+    weights_.AllowGrowth();
+    averaged_weights_.AllowGrowth();
+    labeled_weights_.AllowGrowth();
+    averaged_labeled_weights_.AllowGrowth();
+  }
+
+  int64_t GetAveragedNumBytes() const {
+    return averaged_weights_.GetNumBytes() +
+      averaged_labeled_weights_.GetNumBytes();
+  }
+
+  void Scale(double scale_factor) {
+    weights_.Scale(scale_factor);
+    labeled_weights_.Scale(scale_factor);
+  }
+
+  void MakeGradientStep(const BinaryFeatures &features,
+                        double eta,
+                        int iteration,
+                        double gradient) {
+    for (int j = 0; j < features.size(); ++j) {
+      weights_.Add(features[j], -eta * gradient);
+      if (use_average_) {
+        // perceptron/mira:
+        // T*u1 + (T-1)*u2 + ... u_T = T*(u1 + u2 + ...) - u2 - 2*u3 - (T-1)*u_T
+        // = T*w_T - u2 - 2*u3 - (T-1)*u_T
+        averaged_weights_.Add(features[j],
+                              static_cast<double>(iteration) * eta * gradient);
+      }
+    }
+  }
+
+  void MakeLabelGradientStep(const BinaryFeatures &features,
+                             double eta,
+                             int iteration,
+                             int label,
+                             double gradient) {
+    for (int j = 0; j < features.size(); ++j) {
+      labeled_weights_.Add(features[j], label, -eta * gradient);
+    }
+
+    if (use_average_) {
+      for (int j = 0; j < features.size(); ++j) {
+        averaged_labeled_weights_.Add(features[j], label,
+                                      static_cast<double>(iteration) * eta * gradient);
+      }
+    }
+  }
+
+  void Finalize(int num_iterations) {
+    if (!use_average_) return;
+    LOG(INFO) << "Averaging the weights...";
+
+    averaged_weights_.Scale(1.0 / static_cast<double>(num_iterations));
+    weights_.Add(averaged_weights_);
+
+    averaged_labeled_weights_.Scale(
+      1.0 / static_cast<double>(num_iterations));
+
+    labeled_weights_.Add(averaged_labeled_weights_);
+  }
+
+protected:
+  bool use_average_;
+  SparseParameterVectorDouble averaged_weights_;
+  SparseLabeledParameterVectorDouble averaged_labeled_weights_;
+};
+
+// Weights in single precision (loaded with --parameters_float, or from a
+// model saved with it). They are read-only: this storage can only be
+// created by loading a model, and it has no update methods.
+class FloatParameterStorage :
+  public SparseWeightStorage<ParameterStorage,
+                             SparseParameterVectorFloat,
+                             SparseLabeledParameterVectorFloat> {
+public:
+  virtual ~FloatParameterStorage() {}
+
+  // Load the weights when the number of features has already been read.
+  static FloatParameterStorage *Load(FILE *fs, int length,
+                                     bool single_precision) {
+    FloatParameterStorage *storage = new FloatParameterStorage;
+    storage->LoadWeights(fs, length, single_precision);
+    storage->weights_.StopGrowth();
+    storage->labeled_weights_.StopGrowth();
+    return storage;
+  }
+
+  // The weights are always saved in single precision.
+  void Save(FILE *fs, bool single_precision) const {
+    SparseWeightStorage<ParameterStorage,
+                        SparseParameterVectorFloat,
+                        SparseLabeledParameterVectorFloat>::Save(fs, true);
+  }
+
+  int64_t GetAveragedNumBytes() const { return 0; }
+
+protected:
+  FloatParameterStorage() {}
+};
+
+// Weights for training with averaging, with the running sums in the same
+// hash table entries as the weights (see AveragedParameterVector). They are
+// saved in the format of SparseParameterStorage.
+class AveragedParameterStorage :
+  public SparseWeightStorage<TrainableParameterStorage,
+                             AveragedParameterVector,
+                             AveragedLabeledParameterVector> {
+public:
+  AveragedParameterStorage() {}
+  virtual ~AveragedParameterStorage() {}
+
+  void StopGrowth() {
+    weights_.StopGrowth();
+    labeled_weights_.StopGrowth();
+  }
+  void AllowGrowth() {
+    weights_.AllowGrowth();
+    labeled_weights_.AllowGrowth();
+  }
+
+  // The running sums are counted with the weights.
+  int64_t GetAveragedNumBytes() const { return 0; }
+
+  void Scale(double scale_factor) {
+    weights_.Scale(scale_factor);
+    labeled_weights_.Scale(scale_factor);
+  }
+
+  void MakeGradientStep(const BinaryFeatures &features,
+                        double eta,
+                        int iteration,
+                        double gradient) {
+    for (int j = 0; j < features.size(); ++j) {
+      weights_.Add(features[j], -eta * gradient,
+                   static_cast<double>(iteration) * eta * gradient);
+    }
+  }
+
+  void MakeLabelGradientStep(const BinaryFeatures &features,
+                             double eta,
+                             int iteration,
+                             int label,
+                             double gradient) {
+    for (int j = 0; j < features.size(); ++j) {
+      labeled_weights_.Add(features[j], label, -eta * gradient,
+                           static_cast<double>(iteration) * eta * gradient);
+    }
+  }
+
+  void Finalize(int num_iterations) {
+    LOG(INFO) << "Averaging the weights...";
+    weights_.Average(1.0 / static_cast<double>(num_iterations));
+    labeled_weights_.Average(1.0 / static_cast<double>(num_iterations));
+  }
+};
+
+// Weights (labeled or not) in a single hashed array of 2^num_bits floats
+// (--parameters_hash_bits), with the running sums in another array of the
+// same size, of doubles. Every feature "exists".
+class HashedParameterStorage : public TrainableParameterStorage {
+public:
+  // Empty weights, to be loaded.
+  HashedParameterStorage() { use_average_ = false; }
+  // Allocate the weights for training.
+  HashedParameterStorage(int num_bits, bool use_average) {
+    use_average_ = use_average;
+    weights_.Initialize(num_bits, true);
+    if (use_average_) averaged_weights_.Initialize(num_bits, false);
+  }
+  virtual ~HashedParameterStorage() {}
+
+  // The hashed weights are always saved in single precision.
+  void Save(FILE *fs, bool single_precision) const {
+    bool success = WriteInteger(fs, kHashedParametersMarker);
+    CHECK(success);
+    weights_.Save(fs);
+  }
+
+  // Load the weights when the marker has already been read.
+  void Load(FILE *fs) {
+    weights_.Load(fs);
+    LOG(INFO) << "Loaded hashed parameters with 2^" << weights_.num_bits()
+              << " weights.";
+  }
+
+  // The hashed array has a fixed size.
+  void StopGrowth() {}
+  void AllowGrowth() {}
+
+  uint64_t Size() const { return weights_.Size(); }
+  int64_t GetNumBytes() const { return weights_.GetNumBytes(); }
+  int64_t GetAveragedNumBytes() const {
+    return averaged_weights_.GetNumBytes();
+  }
+  bool Exists(uint64_t key) const { return true; }
+  bool ExistsLabeled(uint64_t key) const { return true; }
+  double Get(uint64_t key) const { return weights_.Get(key); }
+  bool Get(uint64_t key, const vector<int> &labels,
+           vector<double> *label_scores) const {
+    weights_.Get(key, labels, label_scores);
+    return true;
+  }
+  double GetSquaredNorm() const { return weights_.GetSquaredNorm(); }
+  double ComputeScore(const BinaryFeatures &features) const {
+    double score = 0.0;
+    for (int j = 0; j < features.size(); ++j) {
+      score += weights_.Get(features[j]);
+    }
+    return score;
+  }
+  // Only the weights of the given labels are looked up.
+  void AddLabelScores(const BinaryFeatures &features,
+                      const vector<int> &labels,
+                      int num_labels,
+                      double *scores) const {
+    vector<double> label_scores(labels.size(), 0.0);
+    for (int j = 0; j < features.size(); ++j) {
+      weights_.Get(features[j], labels, &label_scores);
+      for (int k = 0; k < labels.size(); ++k) {
+        scores[labels[k]] += label_scores[k];
+      }
+    }
+  }
+
+  void Scale(double scale_factor) { weights_.Scale(scale_factor); }
+
+  void MakeGradientStep(const BinaryFeatures &features,
+                        double eta,
+                        int iteration,
+                        double gradient) {
+    for (int j = 0; j < features.size(); ++j) {
+      weights_.Add(features[j], -eta * gradient);
+      if (use_average_) {
+        averaged_weights_.Add(features[j],
+                              static_cast<double>(iteration) * eta *
+                              gradient);
+      }
+    }
+  }
+
+  void MakeLabelGradientStep(const BinaryFeatures &features,
+                             double eta,
+                             int iteration,
+                             int label,
+                             double gradient) {
+    for (int j = 0; j < features.size(); ++j) {
+      weights_.Add(features[j], label, -eta * gradient);
+      if (use_average_) {
+        averaged_weights_.Add(features[j], label,
+                              static_cast<double>(iteration) * eta *
+                              gradient);
+      }
+    }
+  }
+
+  void Finalize(int num_iterations) {
+    LogStatistics();
+    weights_.StopTrackingCollisions();
+    if (!use_average_) return;
+    LOG(INFO) << "Averaging the weights...";
+    averaged_weights_.Scale(1.0 / static_cast<double>(num_iterations));
+    weights_.Add(averaged_weights_);
+    averaged_weights_.Clear();
+  }
+
+  // Log the occupancy of the weights and the fraction of training updates
+  // that hit a position last updated by a different feature.
+  void LogStatistics() const {
+    uint64_t num_nonzero = weights_.Size();
+    LOG(INFO) << "Non-zero hashed weights: " << num_nonzero << " / "
+              << weights_.NumBuckets() << " ("
+              << 100.0 * static_cast<double>(num_nonzero) /
+                 static_cast<double>(weights_.NumBuckets()) << "%)";
+    if (weights_.num_updates() > 0) {
+      LOG(INFO) << "Colliding updates: "
+                << weights_.num_colliding_updates() << " / "
+                << weights_.num_updates() << " ("
+                << 100.0 * static_cast<double>(
+                     weights_.num_colliding_updates()) /
+                   static_cast<double>(weights_.num_updates()) << "%)";
+    }
+  }
+
+protected:
+  bool use_average_;
+  HashedParameterVectorFloat weights_;
+  // The running sums are kept in double precision.
+  HashedParameterVectorDouble averaged_weights_;
+};
+
+#endif /* PARAMETERSTORAGE_H_ */
@@ -20,14 +20,40 @@
 #include <iostream>
 #include <math.h>
 
-void Parameters::Save(FILE *fs) {
-  weights_.Save(fs);
-  labeled_weights_.Save(fs);
-}
-
-void Parameters::Load(FILE *fs) {
-  weights_.Load(fs);
-  labeled_weights_.Load(fs);
+void Parameters::Load(FILE *fs, bool single_precision) {
+  int length;
+  bool success = ReadInteger(fs, &length);
+  CHECK(success);
+  delete storage_;
+  storage_ = NULL;
+  trainable_storage_ = NULL;
+  use_hashing_ = (length == kHashedParametersMarker);
+  if (use_hashing_) {
+    HashedParameterStorage *storage = new HashedParameterStorage;
+    storage->Load(fs);
+    trainable_storage_ = storage;
+    storage_ = storage;
+  } else {
+    bool saved_single_precision = (length == kFloatParametersMarker);
+    if (saved_single_precision) {
+      success = ReadInteger(fs, &length);
+      CHECK(success);
+    }
+    CHECK_GE(length, 0);
+    // Models saved in single precision are always loaded in single
+    // precision; models saved in double precision are converted if
+    // single_precision is true.
+    if (saved_single_precision || single_precision) {
+      storage_ = FloatParameterStorage::Load(fs, length,
+                                             saved_single_precision);
+      LOG(INFO) << "Loaded parameters in single precision.";
+    } else {
+      SparseParameterStorage *storage = new SparseParameterStorage(false);
+      storage->Load(fs, length, false);
+      trainable_storage_ = storage;
+      storage_ = storage;
+    }
+  }
 
   LOG(INFO) << "Squared norm of the weight vector = " << GetSquaredNorm();
   LOG(INFO) << "Number of features = " << Size();
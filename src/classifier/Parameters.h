@@ -22,6 +22,8 @@
 #include "Features.h"
 #include "SparseParameterVector.h"
 #include "SparseLabeledParameterVector.h"
+#include "ParameterStorage.h"
+#include "Profiler.h"
 #include "Utils.h"
 
 #if USE_WEIGHT_CACHING == 1
@@ -107,11 +109,11 @@ public:
   }
   virtual ~FeatureVector() {};
   const SparseParameterVectorDouble &weights() { return weights_; }
-  const SparseLabeledParameterVector &labeled_weights() {
+  const SparseLabeledParameterVectorDouble &labeled_weights() {
     return labeled_weights_;
   }
   SparseParameterVectorDouble *mutable_weights() { return &weights_; }
-  SparseLabeledParameterVector *mutable_labeled_weights() {
+  SparseLabeledParameterVectorDouble *mutable_labeled_weights() {
     return &labeled_weights_;
   }
   double GetSquaredNorm() const {
@@ -120,64 +122,97 @@ public:
 
 protected:
   SparseParameterVectorDouble weights_;
-  SparseLabeledParameterVector labeled_weights_;
+  SparseLabeledParameterVectorDouble labeled_weights_;
 };
 
 // This class handles the model parameters.
 // It contains both "labeled" weights (for features that are conjoined with
-// output labels) and regular weights.
+// output labels) and regular weights, kept by a ParameterStorage chosen
+// when the parameters are initialized or loaded.
 // It allows averaging the parameters (as in averaged perceptron), which
-// requires keeping around another weight vector of the same size.
+// requires keeping a running sum for each weight. With
+// --parameters_inline_averaging (the default), the sums are stored in the
+// same hash table entries as the weights (see AveragedParameterStorage), so
+// that each update looks up a feature once; otherwise they are kept in
+// another weight vector of the same size (see SparseParameterStorage).
+// If --parameters_hash_bits is positive, all the weights (labeled or not) are
+// instead stored in a single hashed array (see HashedParameterStorage), and
+// the features are no longer required to be instantiated: every key
+// "exists".
+// Training always uses double precision. A model loaded in single precision
+// (see Options::parameters_float), or saved in it, keeps its weights in single
+// precision instead (see FloatParameterStorage); such weights are read-only.
 class Parameters {
 public:
   Parameters() {
     use_average_ = true;
+    use_hashing_ = false;
+    trainable_storage_ = new SparseParameterStorage(use_average_);
+    storage_ = trainable_storage_;
+    profiler_ = NULL;
   };
-  virtual ~Parameters() {};
+  virtual ~Parameters() { delete storage_; };
 
-  // Save/load the parameters.
-  void Save(FILE *fs);
-  void Load(FILE *fs);
+  // Set the profiler where the weight lookups are counted.
+  void SetProfiler(Profiler *profiler) { profiler_ = profiler; }
+
+  // Save/load the parameters. With single_precision, the weights are saved
+  // in single precision, and loaded (read-only) in single precision.
+  void Save(FILE *fs, bool single_precision) {
+    storage_->Save(fs, single_precision);
+  }
+  void Load(FILE *fs, bool single_precision);
 
   // Initialize the parameters.
   void Initialize(bool use_average) {
     use_average_ = use_average;
-    weights_.Initialize();
-    if (use_average_) averaged_weights_.Initialize();
-    labeled_weights_.Initialize();
-    if (use_average_) averaged_labeled_weights_.Initialize();
+    use_hashing_ = (FLAGS_parameters_hash_bits > 0);
+    delete storage_;
+    if (use_hashing_) {
+      LOG(INFO) << "Using hashed parameters with 2^"
+                << FLAGS_parameters_hash_bits << " weights.";
+      trainable_storage_ =
+        new HashedParameterStorage(FLAGS_parameters_hash_bits, use_average_);
+    } else if (use_average_ && FLAGS_parameters_inline_averaging) {
+      trainable_storage_ = new AveragedParameterStorage;
+    } else {
+      trainable_storage_ = new SparseParameterStorage(use_average_);
+    }
+    storage_ = trainable_storage_;
   }
 
   // Lock/unlock the parameter vector. A locked vector means that no features
   // can be added.
-  void StopGrowth() {
-    weights_.StopGrowth();
-    averaged_weights_.StopGrowth();
-    labeled_weights_.StopGrowth();
-    averaged_labeled_weights_.StopGrowth();
-  }
-  void AllowGrowth() {
-    weights_.AllowGrowth();
-    averaged_weights_.AllowGrowth();
-    labeled_weights_.AllowGrowth();
-    averaged_labeled_weights_.AllowGrowth();
-  }
+  void StopGrowth() { GetTrainableStorage()->StopGrowth(); }
+  void AllowGrowth() { GetTrainableStorage()->AllowGrowth(); }
 
   // Get the number of parameters.
   // NOTE: this counts the parameters of the features that are conjoined with
   // output labels as a single parameter.
-  int Size() const { return weights_.Size() + labeled_weights_.Size(); }
+  // With hashed parameters, this is the number of non-zero weights.
+  uint64_t Size() const { return storage_->Size(); }
+
+  // Estimate the memory (in bytes) taken by the weights, and by the running
+  // sums used to average them. These walk over all the labeled weights.
+  // Running sums kept inline with the weights are counted with the weights.
+  int64_t GetNumBytes() const { return storage_->GetNumBytes(); }
+  int64_t GetAveragedNumBytes() const {
+    return storage_->GetAveragedNumBytes();
+  }
+
+  // True if the weights are stored in a hashed array.
+  bool use_hashing() const { return use_hashing_; }
 
   // Checks if a feature exists.
-  bool Exists(uint64_t key) const { return weights_.Exists(key); }
+  bool Exists(uint64_t key) const { return storage_->Exists(key); }
 
   // Checks if a labeled feature exists.
   bool ExistsLabeled(uint64_t key) const {
-    return labeled_weights_.Exists(key);
+    return storage_->ExistsLabeled(key);
   }
 
   // Get the weight of a "simple" feature.
-  double Get(uint64_t key) const { return weights_.Get(key); }
+  double Get(uint64_t key) const { return storage_->Get(key); }
 
   // Get the weights of features conjoined with output labels.
   // The vector "labels" contains the labels that we want to conjoin with;
@@ -187,21 +222,18 @@ public:
   bool Get(uint64_t key,
            const vector<int> &labels,
            vector<double> *label_scores) const {
-    return labeled_weights_.Get(key, labels, label_scores);
+    return storage_->Get(key, labels, label_scores);
   }
 
   // Get the squared norm of the parameter vector.
-  double GetSquaredNorm() const {
-    return weights_.GetSquaredNorm() + labeled_weights_.GetSquaredNorm();
-  }
+  double GetSquaredNorm() const { return storage_->GetSquaredNorm(); }
 
   // Compute the score corresponding to a set of "simple" features.
   double ComputeScore(const BinaryFeatures &features) const {
-    double score = 0.0;
-    for (int j = 0; j < features.size(); ++j) {
-      score += Get(features[j]);
+    if (profiler_) {
+      profiler_->Increment(PROFILER_COUNTER_HASH_PROBES, features.size());
     }
-    return score;
+    return storage_->ComputeScore(features);
   }
 
   // Compute the scores corresponding to a set of features, conjoined with
@@ -213,6 +245,9 @@ public:
     scores->clear();
     scores->resize(labels.size(), 0.0);
     vector<double> label_scores(labels.size(), 0.0);
+    if (profiler_) {
+      profiler_->Increment(PROFILER_COUNTER_HASH_PROBES, features.size());
+    }
     for (int j = 0; j < features.size(); ++j) {
       if (!Get(features[j], labels, &label_scores)) continue;
       for (int k = 0; k < labels.size(); ++k) {
@@ -221,6 +256,22 @@ public:
     }
   }
 
+  // Add the scores of a set of features conjoined with each of the labels in
+  // "labels" to scores[label] (a dense vector indexed by label, with
+  // num_labels entries). With hash tables of labeled weights, this takes one
+  // lookup per feature, adding the weights of all the labels instantiated
+  // with the feature, so entries of other labels may change too; hashed
+  // weights are looked up for the given labels only.
+  void AddLabelScores(const BinaryFeatures &features,
+                      const vector<int> &labels,
+                      int num_labels,
+                      double *scores) const {
+    if (profiler_) {
+      profiler_->Increment(PROFILER_COUNTER_HASH_PROBES, features.size());
+    }
+    storage_->AddLabelScores(features, labels, num_labels, scores);
+  }
+
 #if USE_WEIGHT_CACHING == 1
   // Compute the scores corresponding to a set of features, conjoined with
   // output labels. The vector scores, provided as output, contains the score
@@ -250,9 +301,13 @@ public:
           reduced_labels.push_back(labels[k]);
           adjust_new_index_reduced_labels.push_back(k);
           caching_weights_.IncrementMisses();
+          if (profiler_) {
+            profiler_->Increment(PROFILER_COUNTER_CACHE_MISSES, 1);
+          }
         } else {
           (*scores)[k] += caching_value;
           caching_weights_.IncrementHits();
+          if (profiler_) profiler_->Increment(PROFILER_COUNTER_CACHE_HITS, 1);
         }
       }
       if (reduced_labels.size() == 0) continue;
@@ -270,8 +325,7 @@ public:
 
   // Scale the parameter vector by scale_factor.
   void Scale(double scale_factor) {
-    weights_.Scale(scale_factor);
-    labeled_weights_.Scale(scale_factor);
+    GetTrainableStorage()->Scale(scale_factor);
   }
 
   // Make a gradient step with a stepsize of eta, with respect to a vector
@@ -282,16 +336,8 @@ public:
                         double eta,
                         int iteration,
                         double gradient) {
-    for (int j = 0; j < features.size(); ++j) {
-      weights_.Add(features[j], -eta * gradient);
-      if (use_average_) {
-        // perceptron/mira:
-        // T*u1 + (T-1)*u2 + ... u_T = T*(u1 + u2 + ...) - u2 - 2*u3 - (T-1)*u_T
-        // = T*w_T - u2 - 2*u3 - (T-1)*u_T
-        averaged_weights_.Add(features[j],
-                              static_cast<double>(iteration) * eta * gradient);
-      }
-    }
+    GetTrainableStorage()->MakeGradientStep(features, eta, iteration,
+                                            gradient);
   }
 
   // Make a gradient step with a stepsize of eta, with respect to a vector
@@ -303,33 +349,15 @@ public:
                              int iteration,
                              int label,
                              double gradient) {
-    for (int j = 0; j < features.size(); ++j) {
-      labeled_weights_.Add(features[j], label, -eta * gradient);
-    }
-
-    if (use_average_) {
-      for (int j = 0; j < features.size(); ++j) {
-        averaged_labeled_weights_.Add(features[j], label,
-                                      static_cast<double>(iteration) * eta * gradient);
-      }
-    }
+    GetTrainableStorage()->MakeLabelGradientStep(features, eta, iteration,
+                                                 label, gradient);
   }
 
   // Finalize training, after a total of num_iterations. This is a no-op unless
   // we are averaging the parameter vector, in which case the averaged
   // parameters are finally computed and replace the original parameters.
   void Finalize(int num_iterations) {
-    if (use_average_) {
-      LOG(INFO) << "Averaging the weights...";
-
-      averaged_weights_.Scale(1.0 / static_cast<double>(num_iterations));
-      weights_.Add(averaged_weights_);
-
-      averaged_labeled_weights_.Scale(
-        1.0 / static_cast<double>(num_iterations));
-
-      labeled_weights_.Add(averaged_labeled_weights_);
-    }
+    GetTrainableStorage()->Finalize(num_iterations);
   }
 
 #if USE_WEIGHT_CACHING == 1
@@ -338,17 +366,29 @@ public:
   int GetCachingWeightsSize()   const { return caching_weights_.GetSize(); };
 #endif
 
+protected:
+  // Storage of the weights, for the updates. Fails if the weights are
+  // read-only.
+  TrainableParameterStorage *GetTrainableStorage() {
+    CHECK(trainable_storage_ != NULL)
+      << "Parameters in single precision are read-only.";
+    return trainable_storage_;
+  }
+
 protected:
   // Average the parameters as in averaged perceptron.
   bool use_average_;
 
-  // Weights and averaged weights for the "simple" features.
-  SparseParameterVectorDouble weights_;
-  SparseParameterVectorDouble averaged_weights_;
+  // Store the weights in a hashed array rather than in hash tables.
+  bool use_hashing_;
+
+  // Storage of the weights and of the running sums, and the same storage if
+  // it can be trained (NULL if the weights are read-only).
+  ParameterStorage *storage_;
+  TrainableParameterStorage *trainable_storage_;
 
-  // Weights and averaged weights for the "labeled" features.
-  SparseLabeledParameterVector labeled_weights_;
-  SparseLabeledParameterVector averaged_labeled_weights_;
+  // Profiler of the pipe that owns these parameters (not owned).
+  Profiler *profiler_;
 
 public:
 #if USE_WEIGHT_CACHING == 1
@@ -19,6 +19,8 @@
 #ifndef PART_H_
 #define PART_H_
 
+#include <stdint.h>
+#include <stdio.h>
 #include <vector>
 #include <glog/logging.h>
 
@@ -33,6 +35,15 @@ public:
 
 public:
   virtual int type() = 0;
+
+  // Save/load the fields of the part to/from a binary file (see
+  // Parts::Save). Override these functions in task-specific parts.
+  virtual void Save(FILE *fs) {
+    CHECK(false) << "Saving parts is not supported by this task.";
+  }
+  virtual void Load(FILE *fs) {
+    CHECK(false) << "Loading parts is not supported by this task.";
+  }
 };
 
 // A vector of parts.
@@ -48,6 +59,25 @@ public:
     }
     clear();
   }
+
+  // Estimate the memory (in bytes) taken by the parts. The default assumes
+  // a pointer and a part with a few integer fields per part; override this
+  // function to account for task-specific indices.
+  virtual int64_t GetNumBytes() const {
+    return capacity() * sizeof(Part*) +
+      size() * (sizeof(Part) + 4 * sizeof(int));
+  }
+
+  // Save/load the parts, with their offsets and indices, to/from a binary
+  // file (used to spill the training cache to disk, see
+  // Pipe::CanSpillTrainingCache). Override these functions in task-specific
+  // parts.
+  virtual void Save(FILE *fs) {
+    CHECK(false) << "Saving parts is not supported by this task.";
+  }
+  virtual void Load(FILE *fs) {
+    CHECK(false) << "Loading parts is not supported by this task.";
+  }
 };
 
 #endif /* PART_H_ */
@@ -17,10 +17,82 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Pipe.h"
+#include "SerializationUtils.h"
 #include "Utils.h"
 #include <math.h>
+#include <algorithm>
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <thread>
+
+// Header of a training or test corpus: check value, format version,
+// fingerprint and size in bytes of the corpus options and dictionaries
+// (which follow the header in a training corpus; a test corpus uses the
+// ones of the model), number of instances, and offset of the index with the
+// offset of each instance (at the end of the file).
+const uint64_t kTrainingCorpusCheck = 4231987650;
+const uint64_t kTestCorpusCheck = 4231987651;
+const uint64_t kCorpusVersion = 2;
+
+struct CorpusHeader {
+  uint64_t fingerprint;
+  uint64_t dictionaries_size;
+  uint64_t num_instances;
+  uint64_t index_offset;
+};
+
+static void WriteCorpusHeader(FILE *fs, uint64_t check,
+                              const CorpusHeader &header) {
+  bool success;
+  success = WriteUINT64(fs, check);
+  CHECK(success);
+  success = WriteUINT64(fs, kCorpusVersion);
+  CHECK(success);
+  success = WriteUINT64(fs, header.fingerprint);
+  CHECK(success);
+  success = WriteUINT64(fs, header.dictionaries_size);
+  CHECK(success);
+  success = WriteUINT64(fs, header.num_instances);
+  CHECK(success);
+  success = WriteUINT64(fs, header.index_offset);
+  CHECK(success);
+}
+
+static void ReadCorpusHeader(FILE *fs, uint64_t check, CorpusHeader *header) {
+  bool success;
+  uint64_t file_check;
+  uint64_t version;
+  success = ReadUINT64(fs, &file_check);
+  CHECK(success);
+  CHECK_EQ(file_check, check) << "This is not a "
+    << (check == kTrainingCorpusCheck ? "training" : "test") << " corpus.";
+  success = ReadUINT64(fs, &version);
+  CHECK(success);
+  CHECK_EQ(version, kCorpusVersion)
+    << "The corpus was created by another version and must be converted "
+    << "again.";
+  success = ReadUINT64(fs, &header->fingerprint);
+  CHECK(success);
+  success = ReadUINT64(fs, &header->dictionaries_size);
+  CHECK(success);
+  success = ReadUINT64(fs, &header->num_instances);
+  CHECK(success);
+  success = ReadUINT64(fs, &header->index_offset);
+  CHECK(success);
+}
+
+// Fingerprint of the saved corpus options and dictionaries (64-bit FNV-1a
+// hash of their bytes).
+static uint64_t ComputeCorpusFingerprint(
+    const vector<unsigned char> &bytes) {
+  uint64_t fingerprint = 14695981039346656037ULL;
+  for (int i = 0; i < bytes.size(); ++i) {
+    fingerprint ^= bytes[i];
+    fingerprint *= 1099511628211ULL;
+  }
+  return fingerprint;
+}
 
 Pipe::Pipe(Options* options) {
   options_ = options;
@@ -29,6 +101,15 @@ Pipe::Pipe(Options* options) {
   writer_ = NULL;
   decoder_ = NULL;
   parameters_ = NULL;
+  training_cache_size_ = 0;
+  training_cache_file_ = NULL;
+  training_stream_temporary_ = false;
+  num_training_stream_instances_ = 0;
+  training_stream_file_ = NULL;
+  training_stream_epoch_ = 0;
+  training_stream_position_ = 0;
+  test_corpus_file_ = NULL;
+  num_test_corpus_instances_ = 0;
 }
 
 Pipe::~Pipe() {
@@ -38,6 +119,8 @@ Pipe::~Pipe() {
   delete decoder_;
   delete parameters_;
   DeleteInstances();
+  DeleteTrainingCache();
+  DeleteTrainingStream();
 }
 
 void Pipe::Initialize() {
@@ -45,7 +128,9 @@ void Pipe::Initialize() {
   CreateReader();
   CreateWriter();
   CreateDecoder();
-  parameters_ = new Parameters;
+  profiler_.SetEnabled(options_->profile());
+  decoder_->SetProfiler(&profiler_);
+  SetParameters(new Parameters);
 }
 
 void Pipe::SaveModelByName(const std::string &model_name) {
@@ -65,13 +150,13 @@ void Pipe::LoadModelByName(const std::string &model_name) {
 void Pipe::SaveModel(FILE* fs) {
   options_->Save(fs);
   dictionary_->Save(fs);
-  parameters_->Save(fs);
+  parameters_->Save(fs, options_->parameters_float());
 }
 
 void Pipe::LoadModel(FILE* fs) {
   options_->Load(fs);
   dictionary_->Load(fs);
-  parameters_->Load(fs);
+  parameters_->Load(fs, options_->parameters_float());
 }
 
 // TODO: Implement ComputeScores as follows:
@@ -142,8 +227,11 @@ void Pipe::RemoveUnsupportedFeatures(Instance *instance, Parts *parts,
 }
 
 void Pipe::Train() {
-  PreprocessData();
-  CreateInstances();
+  ReadTrainingData();
+  TrainInstances();
+}
+
+void Pipe::TrainInstances() {
   parameters_->Initialize(options_->use_averaging());
 
   if (options_->only_supported_features()) MakeSupportedParameters();
@@ -152,7 +240,80 @@ void Pipe::Train() {
     TrainEpoch(i);
   }
 
-  parameters_->Finalize(options_->GetNumEpochs() * instances_.size());
+  parameters_->Finalize(options_->GetNumEpochs() *
+                        GetNumTrainingInstances());
+  DeleteTrainingCache();
+  WriteProfile();
+}
+
+void Pipe::WriteProfile() {
+  if (!profiler_.enabled()) return;
+  Profiler profile;
+  GetProfile(&profile);
+  const string &file_profile = options_->GetProfileFilePath();
+  if (file_profile == "") {
+    LOG(INFO) << "Profile: " << profile.ToJson();
+    return;
+  }
+  FILE *fs = fopen(file_profile.c_str(), "w");
+  CHECK(fs) << "Could not open profile file for writing: " << file_profile;
+  fprintf(fs, "%s\n", profile.ToJson().c_str());
+  fclose(fs);
+}
+
+void Pipe::ProfileParameters() {
+  if (!profiler_.enabled()) return;
+  profiler_.RecordMemory(PROFILER_MEMORY_PARAMETERS,
+                         parameters_->GetNumBytes());
+  profiler_.RecordMemory(PROFILER_MEMORY_AVERAGED_PARAMETERS,
+                         parameters_->GetAveragedNumBytes());
+}
+
+void Pipe::DeleteTrainingCache() {
+  for (int i = 0; i < cached_parts_.size(); ++i) {
+    delete cached_parts_[i];
+    delete cached_features_[i];
+  }
+  cached_parts_.clear();
+  cached_features_.clear();
+  cached_gold_outputs_.clear();
+  training_cache_size_ = 0;
+  if (training_cache_file_) {
+    fclose(training_cache_file_);
+    training_cache_file_ = NULL;
+    remove(options_->GetTrainingCacheFilePath().c_str());
+  }
+  cached_offsets_.clear();
+}
+
+void Pipe::SaveCachedInstance(Parts *parts, Features *features,
+                              const vector<double> &gold_outputs) {
+  parts->Save(training_cache_file_);
+  features->Save(training_cache_file_);
+  bool success = WriteInteger(training_cache_file_, gold_outputs.size());
+  CHECK(success);
+  if (!gold_outputs.empty()) {
+    CHECK_EQ(fwrite(&gold_outputs[0], sizeof(double), gold_outputs.size(),
+                    training_cache_file_),
+             gold_outputs.size());
+  }
+}
+
+void Pipe::LoadCachedInstance(int64_t offset, Parts *parts,
+                              Features *features,
+                              vector<double> *gold_outputs) {
+  fseek(training_cache_file_, offset, SEEK_SET);
+  parts->Load(training_cache_file_);
+  features->Load(training_cache_file_);
+  int num_gold_outputs;
+  bool success = ReadInteger(training_cache_file_, &num_gold_outputs);
+  CHECK(success);
+  gold_outputs->resize(num_gold_outputs);
+  if (!gold_outputs->empty()) {
+    CHECK_EQ(fread(&(*gold_outputs)[0], sizeof(double), gold_outputs->size(),
+                   training_cache_file_),
+             gold_outputs->size());
+  }
 }
 
 void Pipe::CreateInstances() {
@@ -163,10 +324,16 @@ void Pipe::CreateInstances() {
 
   reader_->Open(options_->GetTrainingFilePath());
   DeleteInstances();
+  int64_t start_read = profiler_.StartTimer();
   Instance *instance = reader_->GetNext();
+  profiler_.StopTimer(PROFILER_TIMER_READ, start_read);
   while (instance) {
+    int64_t start_convert = profiler_.StartTimer();
     AddInstance(instance);
+    profiler_.StopTimer(PROFILER_TIMER_CONVERT, start_convert);
+    start_read = profiler_.StartTimer();
     instance = reader_->GetNext();
+    profiler_.StopTimer(PROFILER_TIMER_READ, start_read);
   }
   reader_->Close();
 
@@ -176,17 +343,402 @@ void Pipe::CreateInstances() {
   LOG(INFO) << "Time: " << diff_ms(end, start);
 }
 
+void Pipe::CreateTrainingStream() {
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  CheckBinaryCorpusSupport();
+  DeleteInstances();
+  DeleteTrainingStream();
+  training_stream_path_ = options_->GetTrainingStreamFilePath();
+  training_stream_temporary_ = true;
+  LOG(INFO) << "Creating training stream " << training_stream_path_ << "...";
+
+  FILE *fs = fopen(training_stream_path_.c_str(), "wb");
+  CHECK(fs) << "Could not open training stream file for writing: "
+            << training_stream_path_;
+  int chunk_size = options_->train_stream_chunk_size();
+  num_training_stream_instances_ = 0;
+  reader_->Open(options_->GetTrainingFilePath());
+  Instance *instance = reader_->GetNext();
+  while (instance) {
+    if (num_training_stream_instances_ % chunk_size == 0) {
+      training_stream_offsets_.push_back(ftell(fs));
+    }
+    Instance *formatted_instance = GetFormattedInstance(instance);
+    formatted_instance->Save(fs);
+    if (instance != formatted_instance) delete instance;
+    delete formatted_instance;
+    ++num_training_stream_instances_;
+    instance = reader_->GetNext();
+  }
+  reader_->Close();
+  fclose(fs);
+
+  LOG(INFO) << "Number of instances: " << num_training_stream_instances_
+            << " (" << training_stream_offsets_.size() << " chunks)";
+
+  gettimeofday(&end, NULL);
+  LOG(INFO) << "Time: " << diff_ms(end, start);
+}
+
+void Pipe::DeleteTrainingStream() {
+  if (training_stream_path_ == "") return;
+  if (training_stream_temporary_) remove(training_stream_path_.c_str());
+  training_stream_path_ = "";
+  training_stream_temporary_ = false;
+  training_stream_offsets_.clear();
+  num_training_stream_instances_ = 0;
+}
+
+void Pipe::StartTrainingStream(int epoch) {
+  training_stream_file_ = fopen(training_stream_path_.c_str(), "rb");
+  CHECK(training_stream_file_)
+    << "Could not open training stream file for reading: "
+    << training_stream_path_;
+  int num_chunks = training_stream_offsets_.size();
+  training_stream_epoch_ = epoch;
+  training_stream_order_.resize(num_chunks);
+  for (int c = 0; c < num_chunks; ++c) {
+    training_stream_order_[c] = c;
+  }
+  if (options_->train_stream_shuffle()) {
+    std::mt19937 generator(epoch);
+    std::shuffle(training_stream_order_.begin(), training_stream_order_.end(),
+                 generator);
+  }
+  training_stream_position_ = 0;
+  if (num_chunks > 0) {
+    training_stream_thread_ = std::thread(&Pipe::ReadTrainingChunk, this,
+                                          training_stream_order_[0],
+                                          &training_stream_chunk_,
+                                          &training_stream_chunk_ids_);
+  }
+}
+
+void Pipe::NextTrainingChunk(vector<Instance*> *instances) {
+  for (int i = 0; i < instances->size(); ++i) {
+    delete (*instances)[i];
+  }
+  instances->clear();
+  CHECK(training_stream_thread_.joinable());
+  training_stream_thread_.join();
+  instances->swap(training_stream_chunk_);
+  training_stream_ids_.swap(training_stream_chunk_ids_);
+  ++training_stream_position_;
+  if (training_stream_position_ < training_stream_order_.size()) {
+    training_stream_thread_ =
+      std::thread(&Pipe::ReadTrainingChunk, this,
+                  training_stream_order_[training_stream_position_],
+                  &training_stream_chunk_, &training_stream_chunk_ids_);
+  }
+}
+
+void Pipe::EndTrainingStream(vector<Instance*> *instances) {
+  for (int i = 0; i < instances->size(); ++i) {
+    delete (*instances)[i];
+  }
+  instances->clear();
+  CHECK(!training_stream_thread_.joinable());
+  fclose(training_stream_file_);
+  training_stream_file_ = NULL;
+}
+
+void Pipe::ReadTrainingChunk(int chunk, vector<Instance*> *instances,
+                             vector<int> *ids) {
+  int chunk_size = options_->train_stream_chunk_size();
+  int first_id = chunk * chunk_size;
+  int num_instances = num_training_stream_instances_ - first_id;
+  if (num_instances > chunk_size) num_instances = chunk_size;
+  fseek(training_stream_file_, training_stream_offsets_[chunk], SEEK_SET);
+  vector<Instance*> chunk_instances(num_instances);
+  ids->resize(num_instances);
+  for (int i = 0; i < num_instances; ++i) {
+    chunk_instances[i] = CreateFormattedInstance();
+    chunk_instances[i]->Load(training_stream_file_);
+    (*ids)[i] = first_id + i;
+  }
+  if (options_->train_stream_shuffle()) {
+    std::mt19937 generator(training_stream_epoch_ *
+                           training_stream_offsets_.size() + chunk);
+    std::shuffle(ids->begin(), ids->end(), generator);
+  }
+  instances->resize(num_instances);
+  for (int i = 0; i < num_instances; ++i) {
+    (*instances)[i] = chunk_instances[(*ids)[i] - first_id];
+  }
+}
+
+void Pipe::CreateTrainingCorpus() {
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  const string &file_corpus = options_->GetTrainingCorpusFilePath();
+  CHECK_NE(file_corpus, "") << "No training corpus was given.";
+  CheckBinaryCorpusSupport();
+  PreprocessData();
+
+  vector<unsigned char> dictionaries;
+  SaveCorpusDictionaries(&dictionaries);
+
+  LOG(INFO) << "Creating training corpus " << file_corpus << "...";
+  FILE *fs = fopen(file_corpus.c_str(), "wb");
+  CHECK(fs) << "Could not open training corpus file for writing: "
+            << file_corpus;
+  // The header is written again at the end, when the number of instances
+  // and the offset of the index are known.
+  CorpusHeader header;
+  header.fingerprint = ComputeCorpusFingerprint(dictionaries);
+  header.dictionaries_size = dictionaries.size();
+  header.num_instances = 0;
+  header.index_offset = 0;
+  WriteCorpusHeader(fs, kTrainingCorpusCheck, header);
+  if (!dictionaries.empty()) {
+    CHECK_EQ(fwrite(&dictionaries[0], sizeof(unsigned char),
+                    dictionaries.size(), fs),
+             dictionaries.size());
+  }
+
+  vector<int64_t> offsets;
+  reader_->Open(options_->GetTrainingFilePath());
+  Instance *instance = reader_->GetNext();
+  while (instance) {
+    offsets.push_back(ftell(fs));
+    Instance *formatted_instance = GetFormattedInstance(instance);
+    formatted_instance->Save(fs);
+    if (instance != formatted_instance) delete instance;
+    delete formatted_instance;
+    instance = reader_->GetNext();
+  }
+  reader_->Close();
+
+  header.num_instances = offsets.size();
+  header.index_offset = ftell(fs);
+  for (int i = 0; i < offsets.size(); ++i) {
+    bool success = WriteUINT64(fs, offsets[i]);
+    CHECK(success);
+  }
+  fseek(fs, 0, SEEK_SET);
+  WriteCorpusHeader(fs, kTrainingCorpusCheck, header);
+  fclose(fs);
+
+  LOG(INFO) << "Number of instances: " << header.num_instances;
+  LOG(INFO) << "Corpus fingerprint: " << std::hex << header.fingerprint
+            << std::dec;
+
+  gettimeofday(&end, NULL);
+  LOG(INFO) << "Time: " << diff_ms(end, start);
+}
+
+void Pipe::CreateTestCorpus(const std::string &file_corpus) {
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  CheckBinaryCorpusSupport();
+  // The dictionaries are the ones of the model, so they are not stored.
+  vector<unsigned char> dictionaries;
+  SaveCorpusDictionaries(&dictionaries);
+
+  LOG(INFO) << "Creating test corpus " << file_corpus << "...";
+  FILE *fs = fopen(file_corpus.c_str(), "wb");
+  CHECK(fs) << "Could not open test corpus file for writing: "
+            << file_corpus;
+  CorpusHeader header;
+  header.fingerprint = ComputeCorpusFingerprint(dictionaries);
+  header.dictionaries_size = 0;
+  header.num_instances = 0;
+  header.index_offset = 0;
+  WriteCorpusHeader(fs, kTestCorpusCheck, header);
+
+  // The instance is saved after formatting it, which may change it (e.g.
+  // the parser replaces the POS tags by the ones of its tagger model).
+  vector<int64_t> offsets;
+  reader_->Open(options_->GetTestFilePath());
+  Instance *instance = reader_->GetNext();
+  while (instance) {
+    offsets.push_back(ftell(fs));
+    Instance *formatted_instance = GetFormattedInstance(instance);
+    instance->Save(fs);
+    formatted_instance->Save(fs);
+    if (instance != formatted_instance) delete instance;
+    delete formatted_instance;
+    instance = reader_->GetNext();
+  }
+  reader_->Close();
+
+  header.num_instances = offsets.size();
+  header.index_offset = ftell(fs);
+  for (int i = 0; i < offsets.size(); ++i) {
+    bool success = WriteUINT64(fs, offsets[i]);
+    CHECK(success);
+  }
+  fseek(fs, 0, SEEK_SET);
+  WriteCorpusHeader(fs, kTestCorpusCheck, header);
+  fclose(fs);
+
+  LOG(INFO) << "Number of instances: " << header.num_instances;
+  LOG(INFO) << "Corpus fingerprint: " << std::hex << header.fingerprint
+            << std::dec;
+
+  gettimeofday(&end, NULL);
+  LOG(INFO) << "Time: " << diff_ms(end, start);
+}
+
+bool Pipe::IsTestCorpus(const std::string &file_path) {
+  FILE *fs = fopen(file_path.c_str(), "rb");
+  if (!fs) return false;
+  uint64_t check;
+  bool success = ReadUINT64(fs, &check);
+  fclose(fs);
+  return success && check == kTestCorpusCheck;
+}
+
+void Pipe::OpenTestCorpus(const std::string &file_corpus) {
+  CheckBinaryCorpusSupport();
+  LOG(INFO) << "Reading test corpus " << file_corpus << "...";
+  test_corpus_file_ = fopen(file_corpus.c_str(), "rb");
+  CHECK(test_corpus_file_) << "Could not open test corpus file for reading: "
+                           << file_corpus;
+  CorpusHeader header;
+  ReadCorpusHeader(test_corpus_file_, kTestCorpusCheck, &header);
+  vector<unsigned char> dictionaries;
+  SaveCorpusDictionaries(&dictionaries);
+  CHECK_EQ(ComputeCorpusFingerprint(dictionaries), header.fingerprint)
+    << "The test corpus was converted with another model (or other corpus "
+    << "options) and must be converted again with this model.";
+  num_test_corpus_instances_ = header.num_instances;
+}
+
+bool Pipe::ReadTestCorpusInstance(Instance **instance,
+                                  Instance **formatted_instance) {
+  if (num_test_corpus_instances_ == 0) return false;
+  *instance = CreateInstance();
+  (*instance)->Load(test_corpus_file_);
+  *formatted_instance = CreateFormattedInstance();
+  (*formatted_instance)->Load(test_corpus_file_);
+  --num_test_corpus_instances_;
+  return true;
+}
+
+void Pipe::SaveCorpusDictionaries(vector<unsigned char> *bytes) {
+  // Save the corpus options and the dictionaries to a temporary file.
+  FILE *fs = tmpfile();
+  CHECK(fs) << "Could not create a temporary file.";
+  SaveCorpusOptions(fs);
+  SaveDictionaries(fs);
+  bytes->resize(ftell(fs));
+  rewind(fs);
+  if (!bytes->empty()) {
+    CHECK_EQ(fread(&(*bytes)[0], sizeof(unsigned char), bytes->size(), fs),
+             bytes->size());
+  }
+  fclose(fs);
+}
+
+void Pipe::LoadTrainingCorpus() {
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  CheckBinaryCorpusSupport();
+  const string &file_corpus = options_->GetTrainingCorpusFilePath();
+  LOG(INFO) << "Loading training corpus " << file_corpus << "...";
+  FILE *fs = fopen(file_corpus.c_str(), "rb");
+  CHECK(fs) << "Could not open training corpus file for reading: "
+            << file_corpus;
+  CorpusHeader header;
+  ReadCorpusHeader(fs, kTrainingCorpusCheck, &header);
+
+  // Check the fingerprint of the corpus options and the dictionaries before
+  // loading them.
+  int64_t dictionaries_offset = ftell(fs);
+  vector<unsigned char> dictionaries(header.dictionaries_size);
+  if (!dictionaries.empty()) {
+    CHECK_EQ(fread(&dictionaries[0], sizeof(unsigned char),
+                   dictionaries.size(), fs),
+             dictionaries.size()) << "The training corpus is truncated.";
+  }
+  CHECK_EQ(ComputeCorpusFingerprint(dictionaries), header.fingerprint)
+    << "The options and dictionaries of the training corpus are corrupted.";
+  LOG(INFO) << "Corpus fingerprint: " << std::hex << header.fingerprint
+            << std::dec;
+  dictionaries.clear();
+  fseek(fs, dictionaries_offset, SEEK_SET);
+  LoadCorpusOptions(fs);
+  LoadDictionaries(fs);
+  CHECK_EQ(ftell(fs),
+           static_cast<int64_t>(dictionaries_offset +
+                                header.dictionaries_size))
+    << "The training corpus was not created for this task.";
+
+  vector<int64_t> offsets(header.num_instances);
+  fseek(fs, header.index_offset, SEEK_SET);
+  for (int i = 0; i < offsets.size(); ++i) {
+    uint64_t offset;
+    bool success = ReadUINT64(fs, &offset);
+    CHECK(success) << "The training corpus is truncated.";
+    offsets[i] = offset;
+  }
+
+  DeleteInstances();
+  DeleteTrainingStream();
+  if (options_->train_stream()) {
+    // Read the instances in chunks from the corpus in every epoch.
+    training_stream_path_ = file_corpus;
+    training_stream_temporary_ = false;
+    num_training_stream_instances_ = offsets.size();
+    int chunk_size = options_->train_stream_chunk_size();
+    for (int i = 0; i < offsets.size(); i += chunk_size) {
+      training_stream_offsets_.push_back(offsets[i]);
+    }
+    LOG(INFO) << "Number of instances: " << num_training_stream_instances_
+              << " (" << training_stream_offsets_.size() << " chunks)";
+  } else {
+    int64_t start_read = profiler_.StartTimer();
+    if (!offsets.empty()) fseek(fs, offsets[0], SEEK_SET);
+    for (int i = 0; i < offsets.size(); ++i) {
+      Instance *instance = CreateFormattedInstance();
+      instance->Load(fs);
+      instances_.push_back(instance);
+    }
+    profiler_.StopTimer(PROFILER_TIMER_READ, start_read);
+    LOG(INFO) << "Number of instances: " << instances_.size();
+  }
+  fclose(fs);
+
+  gettimeofday(&end, NULL);
+  LOG(INFO) << "Time: " << diff_ms(end, start);
+}
+
 void Pipe::MakeSupportedParameters() {
   Parts *parts = CreateParts();
   Features *features = CreateFeatures();
   vector<double> gold_outputs;
 
   LOG(INFO) << "Building supported feature set...";
+  if (parameters_->use_hashing()) {
+    LOG(WARNING) << "Hashed parameters do not keep track of the supported "
+                 << "features; all features will be used.";
+  }
 
   dictionary_->StopGrowth();
   parameters_->AllowGrowth();
-  for (int i = 0; i < instances_.size(); i++) {
-    Instance *instance = instances_[i];
+  // With --train_stream, the instances are read in chunks: instances holds
+  // the ones of the current chunk, whose positions are
+  // [chunk_begin, chunk_end).
+  bool stream = (training_stream_path_ != "");
+  vector<Instance*> chunk_instances;
+  const vector<Instance*> *instances = stream ? &chunk_instances : &instances_;
+  int num_instances = GetNumTrainingInstances();
+  int chunk_begin = 0;
+  int chunk_end = stream ? 0 : num_instances;
+  if (stream) StartTrainingStream(0);
+  for (int i = 0; i < num_instances; i++) {
+    if (i == chunk_end) {
+      NextTrainingChunk(&chunk_instances);
+      chunk_begin = i;
+      chunk_end = i + chunk_instances.size();
+    }
+    Instance *instance = (*instances)[i - chunk_begin];
     MakeParts(instance, parts, &gold_outputs);
     vector<bool> selected_parts(gold_outputs.size(), false);
     for (int r = 0; r < gold_outputs.size(); ++r) {
@@ -197,6 +749,7 @@ void Pipe::MakeSupportedParameters() {
     MakeSelectedFeatures(instance, parts, selected_parts, features);
     TouchParameters(parts, features, selected_parts);
   }
+  if (stream) EndTrainingStream(&chunk_instances);
 
   delete parts;
   delete features;
@@ -205,23 +758,61 @@ void Pipe::MakeSupportedParameters() {
   LOG(INFO) << "Number of Features: " << parameters_->Size();
 }
 
+void Pipe::MakeTrainingParts(Instance *instance, Parts *parts,
+                             Features *features,
+                             vector<double> *gold_outputs) {
+  int64_t start_stage = profiler_.StartTimer();
+  MakeParts(instance, parts, gold_outputs);
+  profiler_.StopTimer(PROFILER_TIMER_MAKE_PARTS, start_stage);
+  ProfileParts(parts);
+
+  start_stage = profiler_.StartTimer();
+  MakeFeatures(instance, parts, features);
+  profiler_.StopTimer(PROFILER_TIMER_MAKE_FEATURES, start_stage);
+  ProfileFeatures(features);
+}
+
 void Pipe::TrainEpoch(int epoch) {
   Instance *instance;
-  Parts *parts = CreateParts();
-  Features *features = CreateFeatures();
+  // If prefetching, the parts and features of the next instance are made by
+  // a thread while training on the current one, so there are two slots for
+  // them, used by the even and the odd instances.
+  bool prefetch = options_->train_prefetch_parts() && CanPrefetchParts();
+  if (prefetch && profiler_.enabled()) {
+    // The profiler can only be updated by one thread.
+    if (epoch == 0) {
+      LOG(WARNING) << "Ignoring --train_prefetch_parts with --profile.";
+    }
+    prefetch = false;
+  }
+  int num_slots = prefetch ? 2 : 1;
+  std::thread prefetch_thread;
+  // Parts and features for the instances that are not in the training cache.
+  vector<Parts*> uncached_parts(num_slots);
+  vector<Features*> uncached_features(num_slots);
+  for (int k = 0; k < num_slots; ++k) {
+    uncached_parts[k] = CreateParts();
+    uncached_features[k] = CreateFeatures();
+  }
+  // Parts, features and gold outputs in each slot (the uncached ones, or
+  // new ones for an instance to be cached).
+  vector<Parts*> slot_parts(num_slots);
+  vector<Features*> slot_features(num_slots);
+  vector<vector<double> > slot_gold_outputs(num_slots);
   vector<double> scores;
   vector<double> gold_outputs;
   vector<double> predicted_outputs;
   double total_cost = 0.0;
   double total_loss = 0.0;
   double eta;
-  int num_instances = instances_.size();
+  int num_instances = GetNumTrainingInstances();
   double lambda = 1.0 / (options_->GetRegularizationConstant() *
                          (static_cast<double>(num_instances)));
   timeval start, end;
   gettimeofday(&start, NULL);
-  int time_decoding = 0;
-  int time_scores = 0;
+  // Time spent in scoring and decoding, in nanoseconds.
+  int64_t time_decoding = 0;
+  int64_t time_scores = 0;
   int num_mistakes = 0;
 
   if (epoch == 0) {
@@ -232,25 +823,130 @@ void Pipe::TrainEpoch(int epoch) {
   LOG(INFO) << " Iteration #" << epoch + 1;
 
   dictionary_->StopGrowth();
+  profiler_.ResetEpochMemory();
+
+  bool use_cache = options_->train_cache_instances();
+  int64_t max_cache_size =
+    static_cast<int64_t>(options_->train_cache_max_megabytes()) * 1024 * 1024;
+  bool cache_full = false;
+  // Write the instances that do not fit in memory to the cache file.
+  bool spill = use_cache && max_cache_size > 0 && CanSpillTrainingCache();
+  if (use_cache && epoch == 0) {
+    DeleteTrainingCache();
+    cached_parts_.assign(num_instances, NULL);
+    cached_features_.assign(num_instances, NULL);
+    cached_gold_outputs_.resize(num_instances);
+    cached_offsets_.assign(num_instances, -1);
+    if (spill) {
+      const string &file_cache = options_->GetTrainingCacheFilePath();
+      training_cache_file_ = fopen(file_cache.c_str(), "w+b");
+      CHECK(training_cache_file_)
+        << "Could not open training cache file for writing: " << file_cache;
+    }
+  }
 
-  for (int i = 0; i < instances_.size(); i++) {
+  // With --train_stream, the instances are read in chunks: instances holds
+  // the ones of the current chunk, whose positions in the epoch are
+  // [chunk_begin, chunk_end), and training_stream_ids_ their positions in
+  // the stream, which index the training cache.
+  bool stream = (training_stream_path_ != "");
+  vector<Instance*> chunk_instances;
+  const vector<Instance*> *instances = stream ? &chunk_instances : &instances_;
+  int chunk_begin = 0;
+  int chunk_end = stream ? 0 : num_instances;
+  if (stream) StartTrainingStream(epoch);
+
+  for (int i = 0; i < num_instances; i++) {
+    if (i == chunk_end) {
+      NextTrainingChunk(&chunk_instances);
+      chunk_begin = i;
+      chunk_end = i + chunk_instances.size();
+    }
     int t = num_instances * epoch + i;
-    instance = instances_[i];
-    MakeParts(instance, parts, &gold_outputs);
-    MakeFeatures(instance, parts, features);
+    instance = (*instances)[i - chunk_begin];
+    int id = stream ? training_stream_ids_[i - chunk_begin] : i;
+    int slot = i % num_slots;
+    Parts *parts;
+    Features *features;
+    if (use_cache && cached_parts_[id]) {
+      // Reuse the parts and features computed in the first epoch.
+      parts = cached_parts_[id];
+      features = cached_features_[id];
+      gold_outputs = cached_gold_outputs_[id];
+    } else if (use_cache && cached_offsets_[id] >= 0) {
+      // Read the parts and features written in the first epoch.
+      parts = uncached_parts[slot];
+      features = uncached_features[slot];
+      LoadCachedInstance(cached_offsets_[id], parts, features, &gold_outputs);
+    } else {
+      bool cache_instance = use_cache && epoch == 0 && !cache_full;
+      if (prefetch_thread.joinable()) {
+        // The parts and features were made while training on the previous
+        // instance.
+        prefetch_thread.join();
+      } else {
+        slot_parts[slot] = cache_instance ? CreateParts() :
+          uncached_parts[slot];
+        slot_features[slot] = cache_instance ? CreateFeatures() :
+          uncached_features[slot];
+        MakeTrainingParts(instance, slot_parts[slot], slot_features[slot],
+                          &slot_gold_outputs[slot]);
+      }
+      parts = slot_parts[slot];
+      features = slot_features[slot];
+      gold_outputs.swap(slot_gold_outputs[slot]);
+
+      // If using only supported features, must remove the unsupported ones.
+      // This is necessary not to mess up the computation of the squared norm
+      // of the feature difference vector in MIRA.
+      if (options_->only_supported_features()) {
+        RemoveUnsupportedFeatures(instance, parts, features);
+      }
 
-    // If using only supported features, must remove the unsupported ones.
-    // This is necessary not to mess up the computation of the squared norm
-    // of the feature difference vector in MIRA.
-    if (options_->only_supported_features()) {
-      RemoveUnsupportedFeatures(instance, parts, features);
+      if (cache_instance) {
+        cached_parts_[id] = parts;
+        cached_features_[id] = features;
+        cached_gold_outputs_[id] = gold_outputs;
+        training_cache_size_ += GetTrainingCacheSize(parts, features) +
+          gold_outputs.size() * sizeof(double);
+        if (max_cache_size > 0 && training_cache_size_ >= max_cache_size) {
+          LOG(INFO) << "Training cache is full after " << i + 1
+            << " instances.";
+          cache_full = true;
+        }
+      } else if (spill && epoch == 0) {
+        cached_offsets_[id] = ftell(training_cache_file_);
+        SaveCachedInstance(parts, features, gold_outputs);
+      }
+    }
+
+    // Start making the parts and features of the next instance (if it is in
+    // the current chunk), unless they are in the training cache.
+    int next = i + 1;
+    int next_id = 0;
+    if (next < chunk_end) {
+      next_id = stream ? training_stream_ids_[next - chunk_begin] : next;
+    }
+    if (prefetch && next < chunk_end &&
+        !(use_cache && (cached_parts_[next_id] ||
+                        cached_offsets_[next_id] >= 0))) {
+      int next_slot = next % num_slots;
+      bool cache_instance = use_cache && epoch == 0 && !cache_full;
+      slot_parts[next_slot] = cache_instance ? CreateParts() :
+        uncached_parts[next_slot];
+      slot_features[next_slot] = cache_instance ? CreateFeatures() :
+        uncached_features[next_slot];
+      prefetch_thread = std::thread(&Pipe::MakeTrainingParts, this,
+                                    (*instances)[next - chunk_begin],
+                                    slot_parts[next_slot],
+                                    slot_features[next_slot],
+                                    &slot_gold_outputs[next_slot]);
     }
 
-    timeval start_scores, end_scores;
-    gettimeofday(&start_scores, NULL);
+    profiler_.Increment(PROFILER_COUNTER_INSTANCES, 1);
+    int64_t start_scores = Profiler::GetTimeNanoseconds();
     ComputeScores(instance, parts, features, &scores);
-    gettimeofday(&end_scores, NULL);
-    time_scores += diff_ms(end_scores, start_scores);
+    time_scores += Profiler::GetTimeNanoseconds() - start_scores;
 
     // This is a no-op by default. But it's convenient to have it here to build
     // latent-variable structured classifiers (e.g. for coreference resolution).
@@ -259,11 +955,9 @@ void Pipe::TrainEpoch(int epoch) {
 
     if (options_->GetTrainingAlgorithm() == "perceptron" ||
         options_->GetTrainingAlgorithm() == "mira") {
-      timeval start_decoding, end_decoding;
-      gettimeofday(&start_decoding, NULL);
+      int64_t start_decoding = Profiler::GetTimeNanoseconds();
       decoder_->Decode(instance, parts, scores, &predicted_outputs);
-      gettimeofday(&end_decoding, NULL);
-      time_decoding += diff_ms(end_decoding, start_decoding);
+      time_decoding += Profiler::GetTimeNanoseconds() - start_decoding;
 
       if (options_->GetTrainingAlgorithm() == "perceptron") {
         for (int r = 0; r < parts->size(); ++r) {
@@ -276,8 +970,10 @@ void Pipe::TrainEpoch(int epoch) {
         CHECK(false) << "Plain mira is not implemented yet.";
       }
 
+      int64_t start_gradient = profiler_.StartTimer();
       MakeGradientStep(parts, features, eta, t, gold_outputs,
                        predicted_outputs);
+      profiler_.StopTimer(PROFILER_TIMER_GRADIENT, start_gradient);
     } else if (options_->GetTrainingAlgorithm() == "svm_mira" ||
                options_->GetTrainingAlgorithm() == "crf_mira" ||
                options_->GetTrainingAlgorithm() == "crf_margin_mira" ||
@@ -285,8 +981,7 @@ void Pipe::TrainEpoch(int epoch) {
                options_->GetTrainingAlgorithm() == "crf_sgd" ||
                options_->GetTrainingAlgorithm() == "crf_margin_sgd") {
       double loss;
-      timeval start_decoding, end_decoding;
-      gettimeofday(&start_decoding, NULL);
+      int64_t start_decoding = Profiler::GetTimeNanoseconds();
       if (options_->GetTrainingAlgorithm() == "svm_mira" ||
           options_->GetTrainingAlgorithm() == "svm_sgd") {
         // Do cost-augmented inference.
@@ -310,8 +1005,7 @@ void Pipe::TrainEpoch(int epoch) {
                                   &predicted_outputs, &entropy, &loss);
         CHECK_GE(entropy, 0.0);
       }
-      gettimeofday(&end_decoding, NULL);
-      time_decoding += diff_ms(end_decoding, start_decoding);
+      time_decoding += Profiler::GetTimeNanoseconds() - start_decoding;
 
       loss -= inner_loss;
       if (loss < 0.0) {
@@ -364,8 +1058,10 @@ void Pipe::TrainEpoch(int epoch) {
         parameters_->Scale(decay);
       }
 
+      int64_t start_gradient = profiler_.StartTimer();
       MakeGradientStep(parts, features, eta, t, gold_outputs,
                        predicted_outputs);
+      profiler_.StopTimer(PROFILER_TIMER_GRADIENT, start_gradient);
     } else {
       CHECK(false) << "Unknown algorithm: " << options_->GetTrainingAlgorithm();
     }
@@ -376,14 +1072,41 @@ void Pipe::TrainEpoch(int epoch) {
     lambda * static_cast<double>(num_instances) *
     parameters_->GetSquaredNorm() / 2.0;
 
-  delete parts;
-  delete features;
+  for (int k = 0; k < num_slots; ++k) {
+    delete uncached_parts[k];
+    delete uncached_features[k];
+  }
+  if (stream) EndTrainingStream(&chunk_instances);
 
   gettimeofday(&end, NULL);
   LOG(INFO) << "Time: " << diff_ms(end, start);
-  LOG(INFO) << "Time to score: " << time_scores;
-  LOG(INFO) << "Time to decode: " << time_decoding;
+  if (use_cache && epoch == 0) {
+    int num_cached = 0;
+    for (int i = 0; i < num_instances; ++i) {
+      if (cached_parts_[i]) ++num_cached;
+    }
+    LOG(INFO) << "Training cache: " << num_cached << " instances, "
+      << training_cache_size_ / (1024 * 1024) << " MB (estimated).";
+    if (spill) {
+      LOG(INFO) << "Training cache file: " << num_instances - num_cached
+        << " instances, " << ftell(training_cache_file_) / (1024 * 1024)
+        << " MB.";
+    }
+  }
+  profiler_.AddTime(PROFILER_TIMER_COMPUTE_SCORES, time_scores);
+  profiler_.AddTime(PROFILER_TIMER_DECODE, time_decoding);
+  LOG(INFO) << "Time to score: " << static_cast<double>(time_scores) / 1e6;
+  LOG(INFO) << "Time to decode: " << static_cast<double>(time_decoding) / 1e6;
   LOG(INFO) << "Number of Features: " << parameters_->Size();
+  if (profiler_.enabled()) {
+    // The training cache only grows in the first epoch.
+    profiler_.RecordMemory(PROFILER_MEMORY_TRAINING_CACHE,
+                           training_cache_size_);
+    ProfileParameters();
+    LOG(INFO) << "Peak memory (MB): " << profiler_.EpochMemoryToString();
+  }
+  LOG(INFO) << "Peak RSS: "
+    << Profiler::GetPeakResidentSetSize() / (1024 * 1024) << " MB";
   if (options_->GetTrainingAlgorithm() == "perceptron" ||
       options_->GetTrainingAlgorithm() == "mira") {
     LOG(INFO) << "Number of mistakes: " << num_mistakes;
@@ -396,54 +1119,156 @@ void Pipe::TrainEpoch(int epoch) {
     << "Squared norm: " << parameters_->GetSquaredNorm() << endl;
 }
 
+// Comparison of scheduled instances: longest bucket first, then input order.
+struct ScheduledInstanceComparator {
+  bool operator()(const pair<int, int> &a, const pair<int, int> &b) const {
+    if (a.first != b.first) return a.first > b.first;
+    return a.second < b.second;
+  }
+};
+
+void Pipe::ScheduleBatch(const vector<Instance*> &formatted_instances,
+                         vector<int> *order) {
+  int bucket_width = options_->batch_bucket_width();
+  // Pairs (bucket, position in the batch).
+  vector<pair<int, int> > buckets(formatted_instances.size());
+  for (int i = 0; i < formatted_instances.size(); ++i) {
+    int length = GetInstanceLength(formatted_instances[i]);
+    buckets[i].first = (bucket_width > 0) ? length / bucket_width : length;
+    buckets[i].second = i;
+  }
+  sort(buckets.begin(), buckets.end(), ScheduledInstanceComparator());
+  order->resize(buckets.size());
+  for (int k = 0; k < buckets.size(); ++k) {
+    (*order)[k] = buckets[k].second;
+  }
+}
+
 void Pipe::Run() {
   Parts *parts = CreateParts();
   Features *features = CreateFeatures();
   vector<double> scores;
   vector<double> gold_outputs;
   vector<double> predicted_outputs;
+  // Indices of the predicted parts, if the outputs are sparse.
+  vector<int> active_parts;
+  bool sparse_outputs = UsesSparseOutputs();
 
   timeval start, end;
   gettimeofday(&start, NULL);
 
   if (options_->evaluate()) BeginEvaluation();
-
-  reader_->Open(options_->GetTestFilePath());
+  ProfileParameters();
+
+  // The test data is either text, read by the reader, or a test corpus with
+  // the instances already formatted.
+  bool test_corpus = IsTestCorpus(options_->GetTestFilePath());
+  if (test_corpus) {
+    OpenTestCorpus(options_->GetTestFilePath());
+  } else {
+    reader_->Open(options_->GetTestFilePath());
+  }
   writer_->Open(options_->GetOutputFilePath());
 
+  // Instances are read in batches of --batch_size instances. Each batch is
+  // decoded longest first, so that the buffers allocated for the longest
+  // instance are reused by the others, and then written in the input order.
+  int batch_size = options_->batch_size();
+  vector<Instance*> instances;
+  vector<Instance*> formatted_instances;
+  vector<Instance*> output_instances;
+  vector<int> order;
   int num_instances = 0;
-  Instance *instance = reader_->GetNext();
-  while (instance) {
-    Instance *formatted_instance = GetFormattedInstance(instance);
+  bool end_of_file = false;
+  while (!end_of_file) {
+    instances.clear();
+    formatted_instances.clear();
+    while (instances.size() < batch_size) {
+      int64_t start_stage = profiler_.StartTimer();
+      Instance *instance = NULL;
+      Instance *formatted_instance = NULL;
+      if (test_corpus) {
+        ReadTestCorpusInstance(&instance, &formatted_instance);
+      } else {
+        instance = reader_->GetNext();
+      }
+      profiler_.StopTimer(PROFILER_TIMER_READ, start_stage);
+      if (!instance) {
+        end_of_file = true;
+        break;
+      }
+      profiler_.Increment(PROFILER_COUNTER_INSTANCES, 1);
+      if (!formatted_instance) {
+        start_stage = profiler_.StartTimer();
+        formatted_instance = GetFormattedInstance(instance);
+        profiler_.StopTimer(PROFILER_TIMER_CONVERT, start_stage);
+      }
+      instances.push_back(instance);
+      formatted_instances.push_back(formatted_instance);
+    }
+    if (instances.empty()) break;
+
+    if (instances.size() > 1) {
+      ScheduleBatch(formatted_instances, &order);
+    } else {
+      order.assign(1, 0);
+    }
 
-    MakeParts(formatted_instance, parts, &gold_outputs);
-    MakeFeatures(formatted_instance, parts, features);
-    ComputeScores(formatted_instance, parts, features, &scores);
-    decoder_->Decode(formatted_instance, parts, scores, &predicted_outputs);
+    output_instances.assign(instances.size(), NULL);
+    for (int k = 0; k < order.size(); ++k) {
+      int i = order[k];
+      Instance *instance = instances[i];
+      Instance *formatted_instance = formatted_instances[i];
 
-    Instance *output_instance = instance->Copy();
-    LabelInstance(parts, predicted_outputs, output_instance);
+      DecodeInstance(instance, formatted_instance, parts, features, &scores,
+                     &gold_outputs, &predicted_outputs,
+                     sparse_outputs ? &active_parts : NULL);
 
-    if (options_->evaluate()) {
-      EvaluateInstance(instance, output_instance,
-                       parts, gold_outputs, predicted_outputs);
-    }
+      int64_t start_stage = profiler_.StartTimer();
+      Instance *output_instance = instance->Copy();
+      if (sparse_outputs) {
+        LabelInstanceSparse(parts, active_parts, output_instance);
+      } else {
+        LabelInstance(parts, predicted_outputs, output_instance);
+      }
+      profiler_.StopTimer(PROFILER_TIMER_LABEL, start_stage);
 
-    writer_->Write(output_instance);
+      if (options_->evaluate()) {
+        if (sparse_outputs) {
+          EvaluateInstanceSparse(instance, output_instance,
+                                 parts, gold_outputs, active_parts);
+        } else {
+          EvaluateInstance(instance, output_instance,
+                           parts, gold_outputs, predicted_outputs);
+        }
+      }
+      output_instances[i] = output_instance;
+    }
 
-    if (formatted_instance != instance) delete formatted_instance;
-    delete output_instance;
-    delete instance;
+    for (int i = 0; i < instances.size(); ++i) {
+      int64_t start_stage = profiler_.StartTimer();
+      writer_->Write(output_instances[i]);
+      profiler_.StopTimer(PROFILER_TIMER_WRITE, start_stage);
 
-    instance = reader_->GetNext();
-    ++num_instances;
+      if (formatted_instances[i] != instances[i]) {
+        delete formatted_instances[i];
+      }
+      delete output_instances[i];
+      delete instances[i];
+      ++num_instances;
+    }
   }
 
   delete parts;
   delete features;
 
   writer_->Close();
-  reader_->Close();
+  if (test_corpus) {
+    fclose(test_corpus_file_);
+    test_corpus_file_ = NULL;
+  } else {
+    reader_->Close();
+  }
 
   gettimeofday(&end, NULL);
   LOG(INFO) << "Number of instances: " << num_instances;
@@ -456,6 +1281,7 @@ void Pipe::Run() {
 #endif
 
   if (options_->evaluate()) EndEvaluation();
+  WriteProfile();
 }
 
 void Pipe::ClassifyInstance(Instance *instance) {
@@ -464,26 +1290,42 @@ void Pipe::ClassifyInstance(Instance *instance) {
   std::vector<double> scores;
   std::vector<double> gold_outputs;
   std::vector<double> predicted_outputs;
+  std::vector<int> active_parts;
+  bool sparse_outputs = UsesSparseOutputs();
 
+  profiler_.Increment(PROFILER_COUNTER_INSTANCES, 1);
+  int64_t start_stage = profiler_.StartTimer();
   Instance *formatted_instance = GetFormattedInstance(instance);
+  profiler_.StopTimer(PROFILER_TIMER_CONVERT, start_stage);
 
-  // Create parts for this instance.
-  MakeParts(formatted_instance, parts, &gold_outputs);
-  // Create features for the parts of this instance.
-  MakeFeatures(formatted_instance, parts, features);
-  // Compute scores based on the features and parts of this instance.
-  ComputeScores(formatted_instance, parts, features, &scores);
-  // Decode, a.k.a., obtain output prediction.
-  decoder_->Decode(formatted_instance, parts, scores, &predicted_outputs);
+  // Create parts and features for this instance, compute their scores and
+  // decode, a.k.a., obtain output prediction.
+  DecodeInstance(instance, formatted_instance, parts, features, &scores,
+                 &gold_outputs, &predicted_outputs,
+                 sparse_outputs ? &active_parts : NULL);
   // Obtain labels.
-  LabelInstance(parts, predicted_outputs, instance);
+  start_stage = profiler_.StartTimer();
+  if (sparse_outputs) {
+    LabelInstanceSparse(parts, active_parts, instance);
+  } else {
+    LabelInstance(parts, predicted_outputs, instance);
+  }
+  profiler_.StopTimer(PROFILER_TIMER_LABEL, start_stage);
   // Compare with gold standard if 'evaluate' was an execution flag.
   if (options_->evaluate()) {
-    EvaluateInstance(instance,
-                     ((Instance*)NULL),
-                     parts,
-                     gold_outputs,
-                     predicted_outputs);
+    if (sparse_outputs) {
+      EvaluateInstanceSparse(instance,
+                             ((Instance*)NULL),
+                             parts,
+                             gold_outputs,
+                             active_parts);
+    } else {
+      EvaluateInstance(instance,
+                       ((Instance*)NULL),
+                       parts,
+                       gold_outputs,
+                       predicted_outputs);
+    }
   }
 
   if (formatted_instance != instance) delete formatted_instance;
@@ -28,6 +28,8 @@
 #include "Decoder.h"
 #include "Parameters.h"
 #include "AlgUtils.h"
+#include "Profiler.h"
+#include <thread>
 
 // Abstract class for the structured classifier mainframe.
 // It requires parts, features, a dictionary, a reader and writer, and
@@ -53,11 +55,85 @@ public:
 
   // Get/Set parameters.
   Parameters *GetParameters() { return parameters_; }
-  void SetParameters(Parameters *parameters) { parameters_ = parameters; }
+  void SetParameters(Parameters *parameters) {
+    parameters_ = parameters;
+    if (parameters_) parameters_->SetProfiler(&profiler_);
+  }
+
+  // Get the profiler, which holds the time spent in each stage and the
+  // event counters of this pipe (enabled with the flag --profile).
+  Profiler *GetProfiler() { return &profiler_; }
+
+  // Get the timers and counters of this pipe and of the pipes it uses
+  // (e.g. a cascade model).
+  void GetProfile(Profiler *profile) {
+    profile->Reset();
+    CollectProfile(profile);
+  }
 
-  // Train the classifier.
+  // Train the classifier. This reads the training data (see
+  // ReadTrainingData) and trains on it (see TrainInstances).
   void Train();
 
+  // Build the dictionaries and create the training instances from the
+  // training file (in memory, or in a binary file with --train_stream), or
+  // load them from a training corpus (--file_train_corpus).
+  void ReadTrainingData() {
+    if (options_->GetTrainingCorpusFilePath() != "") {
+      LoadTrainingCorpus();
+      return;
+    }
+    PreprocessData();
+    if (options_->train_stream()) {
+      CreateTrainingStream();
+    } else {
+      CreateInstances();
+    }
+  }
+
+  // Build the dictionaries from the training file and write them, with the
+  // training instances in numeric format, to a binary training corpus
+  // (--file_train_corpus). Training from the corpus skips reading the
+  // training file, building the dictionaries and converting the instances.
+  void CreateTrainingCorpus();
+
+  // Convert the test data (--file_test) to a binary test corpus, which
+  // stores each instance and its formatted instance, with the fingerprint
+  // of the corpus options and dictionaries of the loaded model. Run reads
+  // the corpus when it is given in --file_test, after checking that it was
+  // converted with the same model, instead of reading and formatting the
+  // test data.
+  void CreateTestCorpus(const std::string &file_corpus);
+
+  // Train the classifier on the training instances, which must have been
+  // created by ReadTrainingData or shared by another pipe (see
+  // ShareTrainingData).
+  void TrainInstances();
+
+  // Use the dictionaries and the training instances of another pipe of the
+  // same task (e.g. to train a pruner on the data read by the main model)
+  // instead of reading the training data again. The other pipe keeps
+  // owning them: call ReleaseTrainingData before deleting this pipe.
+  // Override these functions to share task-specific dictionaries.
+  virtual void ShareTrainingData(Pipe *pipe) {
+    delete dictionary_;
+    dictionary_ = pipe->dictionary_;
+    DeleteInstances();
+    instances_ = pipe->instances_;
+    DeleteTrainingStream();
+    training_stream_path_ = pipe->training_stream_path_;
+    training_stream_temporary_ = false;
+    training_stream_offsets_ = pipe->training_stream_offsets_;
+    num_training_stream_instances_ = pipe->num_training_stream_instances_;
+  }
+  virtual void ReleaseTrainingData() {
+    dictionary_ = NULL;
+    instances_.clear();
+    training_stream_path_ = "";
+    training_stream_offsets_.clear();
+    num_training_stream_instances_ = 0;
+  }
+
   // Run a previously trained classifier on new data.
   void Run();
 
@@ -79,6 +155,17 @@ protected:
   virtual void SaveModel(FILE* fs);
   virtual void LoadModel(FILE* fs);
 
+  // Save/load the dictionaries (e.g. to/from a training corpus). Override
+  // these functions to include the task-specific dictionaries.
+  virtual void SaveDictionaries(FILE *fs) { dictionary_->Save(fs); }
+  virtual void LoadDictionaries(FILE *fs) { dictionary_->Load(fs); }
+
+  // Save/load the task options that affect the dictionaries or the numeric
+  // instances of a training corpus but are not saved with the dictionaries.
+  // Loading checks that they match the current options.
+  virtual void SaveCorpusOptions(FILE *fs) {}
+  virtual void LoadCorpusOptions(FILE *fs) {}
+
   // Create/add/delete instances.
   void DeleteInstances() {
     for (int i = 0; i < instances_.size(); ++i) {
@@ -101,9 +188,107 @@ protected:
     return instance;
   }
 
+  // Length of a formatted instance (e.g. the number of words of a
+  // sentence), used to schedule the instances of a batch at test time (see
+  // --batch_size). Override this function for task-specific lengths; by
+  // default all instances have length 0, so batches are decoded in the input
+  // order.
+  virtual int GetInstanceLength(Instance *formatted_instance) { return 0; }
+
+  // Compute the order in which the instances of a batch are decoded: longest
+  // first, grouping lengths in buckets of --batch_bucket_width, and in the
+  // input order within a bucket.
+  void ScheduleBatch(const vector<Instance*> &formatted_instances,
+                     vector<int> *order);
+
   // Create a vector of instances by reading the training data.
   void CreateInstances();
 
+  // Number of training instances (in memory or in the training stream).
+  int GetNumTrainingInstances() {
+    if (training_stream_path_ != "") return num_training_stream_instances_;
+    return instances_.size();
+  }
+
+  // True if the instances of this task can be saved to and loaded from
+  // binary files (--train_stream, --file_train_corpus and test corpora).
+  // Override this function, with CreateFormattedInstance (and
+  // CreateInstance for test corpora), for tasks that support it.
+  virtual bool SupportsBinaryCorpus() { return false; }
+
+  // Create an empty formatted instance, to be loaded from a binary file
+  // (see Instance::Load). Override this function for tasks that support
+  // training from a binary file of instances (--train_stream and
+  // --file_train_corpus).
+  virtual Instance *CreateFormattedInstance() {
+    CHECK(false) << "This task does not support binary files of training "
+                 << "instances (--train_stream, --file_train_corpus).";
+    return NULL;
+  }
+
+  // Create an empty instance (as returned by the reader), to be loaded from
+  // a test corpus. Override this function for tasks that support testing on
+  // a test corpus.
+  virtual Instance *CreateInstance() {
+    CHECK(false) << "This task does not support test corpora.";
+    return NULL;
+  }
+
+  // Check that the task supports binary corpora, failing with a clear
+  // message otherwise.
+  void CheckBinaryCorpusSupport() {
+    CHECK(SupportsBinaryCorpus())
+      << "This task does not support binary corpora (TurboCorpusConverter, "
+      << "--file_train_corpus, --train_stream, or a test corpus in "
+      << "--file_test).";
+  }
+
+  // True if a file is a test corpus (see CreateTestCorpus).
+  static bool IsTestCorpus(const std::string &file_path);
+
+  // Open a test corpus for reading, checking that it was converted with
+  // the loaded model.
+  void OpenTestCorpus(const std::string &file_corpus);
+
+  // Read the next instance and formatted instance of the test corpus.
+  // Return false at the end of the corpus.
+  bool ReadTestCorpusInstance(Instance **instance,
+                              Instance **formatted_instance);
+
+  // Save the corpus options and the dictionaries to a buffer, whose
+  // fingerprint ties a corpus to them.
+  void SaveCorpusDictionaries(vector<unsigned char> *bytes);
+
+  // Load the dictionaries and the training instances from a training
+  // corpus. With --train_stream, the corpus is used as the training stream.
+  void LoadTrainingCorpus();
+
+  // Convert the training data to a binary file of formatted instances
+  // (the training stream), recording the offset of each chunk.
+  void CreateTrainingStream();
+
+  // Delete the training stream file (unless it is a training corpus or it
+  // was released, see ReleaseTrainingData).
+  void DeleteTrainingStream();
+
+  // Start reading the chunks of the training stream in an epoch, in a
+  // shuffled order with --train_stream_shuffle.
+  void StartTrainingStream(int epoch);
+
+  // Get the next chunk of the training stream, deleting the instances of
+  // the previous chunk, and start reading the following one on a thread.
+  // The positions of its instances in the stream are kept in
+  // training_stream_ids_.
+  void NextTrainingChunk(vector<Instance*> *instances);
+
+  // Delete the instances of the last chunk and close the training stream.
+  void EndTrainingStream(vector<Instance*> *instances);
+
+  // Read a chunk of the training stream and the positions of its instances
+  // in the stream (called on a thread).
+  void ReadTrainingChunk(int chunk, vector<Instance*> *instances,
+                         vector<int> *ids);
+
   // Construct the vector of parts for a particular instance.
   // Eventually, obtain the binary vector of gold outputs (one entry per part)
   // if this information is available.
@@ -138,6 +323,82 @@ protected:
                              Features *features,
                              vector<double> *scores);
 
+  // Make the parts, features and scores of a formatted instance and decode
+  // it, at test time. The original instance is also provided. If
+  // active_parts is not NULL, the output is decoded sparsely into it (see
+  // Decoder::DecodeSparse), and predicted_outputs is not filled. Override
+  // this method to change how each instance is decoded (e.g. to combine
+  // several models).
+  virtual void DecodeInstance(Instance *instance,
+                              Instance *formatted_instance,
+                              Parts *parts,
+                              Features *features,
+                              vector<double> *scores,
+                              vector<double> *gold_outputs,
+                              vector<double> *predicted_outputs,
+                              vector<int> *active_parts) {
+    int64_t start = profiler_.StartTimer();
+    MakeParts(formatted_instance, parts, gold_outputs);
+    profiler_.StopTimer(PROFILER_TIMER_MAKE_PARTS, start);
+    ProfileParts(parts);
+
+    start = profiler_.StartTimer();
+    MakeFeatures(formatted_instance, parts, features);
+    profiler_.StopTimer(PROFILER_TIMER_MAKE_FEATURES, start);
+    ProfileFeatures(features);
+
+    start = profiler_.StartTimer();
+    ComputeScores(formatted_instance, parts, features, scores);
+    profiler_.StopTimer(PROFILER_TIMER_COMPUTE_SCORES, start);
+
+    start = profiler_.StartTimer();
+    if (active_parts) {
+      decoder_->DecodeSparse(formatted_instance, parts, *scores,
+                             active_parts);
+    } else {
+      decoder_->Decode(formatted_instance, parts, *scores, predicted_outputs);
+    }
+    profiler_.StopTimer(PROFILER_TIMER_DECODE, start);
+  }
+
+  // True if the test instances are decoded sparsely, into the indices of the
+  // active parts (see Decoder::DecodeSparse), which are then passed to
+  // LabelInstanceSparse and EvaluateInstanceSparse. This requires the parts
+  // read by LabelInstance and EvaluateInstance to have integral outputs at
+  // test time.
+  virtual bool UsesSparseOutputs() { return false; }
+
+  // Count the parts and features of an instance, and their memory, in the
+  // profiler.
+  void ProfileParts(Parts *parts) {
+    if (profiler_.enabled()) {
+      profiler_.Increment(PROFILER_COUNTER_PARTS, parts->size());
+      profiler_.RecordMemory(PROFILER_MEMORY_PARTS, parts->GetNumBytes());
+    }
+  }
+  void ProfileFeatures(Features *features) {
+    if (profiler_.enabled()) {
+      profiler_.Increment(PROFILER_COUNTER_FEATURES,
+                          features->GetNumFeatures());
+      profiler_.RecordMemory(PROFILER_MEMORY_FEATURES,
+                             features->GetNumBytes());
+    }
+  }
+
+  // Record the memory of the parameters in the profiler. This walks over
+  // all the weights, so it is done once per epoch.
+  void ProfileParameters();
+
+  // Add the timers and counters of this pipe to a profile. Override this
+  // function to include the profilers of other pipes used by this one (e.g.
+  // a cascade model).
+  virtual void CollectProfile(Profiler *profile) { profile->Add(profiler_); }
+
+  // Write the profile in JSON format to the file given by --file_profile,
+  // or log it if no file was given. This is a no-op if profiling is
+  // disabled.
+  void WriteProfile();
+
   // Perform a gradient step with stepsize eta. The iteration number is
   // provided as input since it may be necessary to keep track of the averaged
   // weights. The gold output and the predicted output are also provided.
@@ -208,6 +469,19 @@ protected:
   virtual void LabelInstance(Parts *parts, const vector<double> &output,
                              Instance *instance) = 0;
 
+  // Same as LabelInstance, with the output given by the indices of the
+  // active parts. The version implemented here expands them into a dense
+  // output; override it to read them directly.
+  virtual void LabelInstanceSparse(Parts *parts,
+                                   const vector<int> &active_parts,
+                                   Instance *instance) {
+    vector<double> output(parts->size(), 0.0);
+    for (int k = 0; k < active_parts.size(); ++k) {
+      output[active_parts[k]] = 1.0;
+    }
+    LabelInstance(parts, output, instance);
+  }
+
   // Preprocess an instance before training begins. Override this function for
   // task-specific instance preprocessing.
   virtual void PreprocessInstance(Instance* instance) {};
@@ -225,6 +499,40 @@ protected:
   // Run one epoch of training.
   void TrainEpoch(int epoch);
 
+  // Make the parts, gold outputs and features of a training instance.
+  void MakeTrainingParts(Instance *instance, Parts *parts, Features *features,
+                         vector<double> *gold_outputs);
+
+  // True if the parts and features of a training instance can be made on a
+  // thread while the model is trained on the previous instance (see
+  // --train_prefetch_parts), i.e., if MakeParts and MakeFeatures do not
+  // depend on the parameters being trained and only modify their
+  // arguments. Override this function for tasks that satisfy this.
+  virtual bool CanPrefetchParts() { return false; }
+
+  // True if the parts and features of a training instance can be saved to
+  // and loaded from a file (see Parts::Save and Features::Save), so that the
+  // instances that do not fit in the training cache are written to
+  // --file_train_cache in the first epoch and read back in the following
+  // ones. Override this function for tasks that support it.
+  virtual bool CanSpillTrainingCache() { return false; }
+
+  // Write/read the parts, features and gold outputs of a training instance
+  // to/from the file of the training cache.
+  void SaveCachedInstance(Parts *parts, Features *features,
+                          const vector<double> &gold_outputs);
+  void LoadCachedInstance(int64_t offset, Parts *parts, Features *features,
+                          vector<double> *gold_outputs);
+
+  // Delete the parts and features in the training cache, and its file.
+  void DeleteTrainingCache();
+
+  // Estimate the memory (in bytes) taken by the parts and features of an
+  // instance in the training cache.
+  virtual int64_t GetTrainingCacheSize(Parts *parts, Features *features) {
+    return parts->GetNumBytes() + features->GetNumBytes();
+  }
+
   // Start all the evaluation counters for evaluating the classifier,
   // evaluate each instance, and plot evaluation information at the end.
   // This is done at test time when the flag --evaluate is activated.
@@ -244,6 +552,20 @@ protected:
       ++num_total_parts_;
     }
   }
+  // Same as EvaluateInstance, with the predicted output given by the indices
+  // of the active parts (see LabelInstanceSparse).
+  virtual void EvaluateInstanceSparse(Instance *instance,
+                                      Instance *output_instance,
+                                      Parts *parts,
+                                      const vector<double> &gold_outputs,
+                                      const vector<int> &active_parts) {
+    vector<double> predicted_outputs(parts->size(), 0.0);
+    for (int k = 0; k < active_parts.size(); ++k) {
+      predicted_outputs[active_parts[k]] = 1.0;
+    }
+    EvaluateInstance(instance, output_instance, parts, gold_outputs,
+                     predicted_outputs);
+  }
   virtual void EndEvaluation() {
     LOG(INFO) << "Accuracy (parts): " <<
       static_cast<double>(num_total_parts_ - num_mistakes_) /
@@ -258,6 +580,45 @@ protected:
   Decoder *decoder_; // Decoder for this classification task.
   Parameters *parameters_; // Parameter vector.
   vector<Instance*> instances_; // Set of instances.
+  Profiler profiler_; // Stage timers and event counters (--profile).
+
+  // Training cache (flag --train_cache_instances): parts, gold outputs and
+  // features of each training instance, computed in the first epoch and
+  // reused in the following ones, indexed by the position of the instance
+  // in the training data. Instances that did not fit in memory have NULL
+  // entries; if the task supports it, they are kept in a file, at the
+  // given offsets (-1 for the instances that are not in the file).
+  vector<Parts*> cached_parts_;
+  vector<Features*> cached_features_;
+  vector<vector<double> > cached_gold_outputs_;
+  int64_t training_cache_size_;
+  FILE *training_cache_file_;
+  vector<int64_t> cached_offsets_;
+
+  // Training stream (flag --train_stream): path of the binary file with the
+  // formatted training instances (empty if they are in memory), whether it
+  // is a temporary file (false for a training corpus), offset of each chunk
+  // in the file, and number of instances. In an epoch, the chunks are read
+  // by a thread one chunk ahead: order of the chunks, position of the chunk
+  // being read, its instances and their positions in the stream, and the
+  // positions of the instances of the current chunk.
+  string training_stream_path_;
+  bool training_stream_temporary_;
+  vector<int64_t> training_stream_offsets_;
+  int num_training_stream_instances_;
+  FILE *training_stream_file_;
+  int training_stream_epoch_;
+  vector<int> training_stream_order_;
+  int training_stream_position_;
+  vector<Instance*> training_stream_chunk_;
+  vector<int> training_stream_chunk_ids_;
+  vector<int> training_stream_ids_;
+  std::thread training_stream_thread_;
+
+  // Test corpus read by Run (NULL if the test data is read by the reader),
+  // and number of instances left to read.
+  FILE *test_corpus_file_;
+  int num_test_corpus_instances_;
 
   // Number of mistakes and number of total parts at test time (used for
   // evaluation purposes).
@@ -0,0 +1,66 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SCOREVIEW_H_
+#define SCOREVIEW_H_
+
+#include <vector>
+#include <glog/logging.h>
+
+using namespace std;
+
+// Read-only view of the vector of part scores, in which the scores of a few
+// contiguous blocks of parts (e.g. the arcs) can be replaced by overlays.
+// Decoders that need to modify some scores (e.g. adding the best label score
+// to each arc) use this instead of copying the full score vector, which is
+// expensive when there are many higher-order parts.
+// A view can be implicitly constructed from a score vector, in which case it
+// has no overlays.
+class ScoreView {
+public:
+  ScoreView(const vector<double> &scores) : scores_(&scores) {}
+  virtual ~ScoreView() {}
+
+  // Replace the scores of parts offset, ..., offset + overlay->size() - 1
+  // by the entries of overlay. The overlay is not copied, and must not
+  // overlap other overlays.
+  void AddOverlay(int offset, const vector<double> *overlay) {
+    if (overlay->empty()) return;
+    CHECK_GE(offset, 0);
+    CHECK_LE(offset + overlay->size(), scores_->size());
+    overlay_offsets_.push_back(offset);
+    overlays_.push_back(overlay);
+  }
+
+  double operator[](int r) const {
+    for (int i = 0; i < overlays_.size(); ++i) {
+      int k = r - overlay_offsets_[i];
+      if (k >= 0 && k < overlays_[i]->size()) return (*overlays_[i])[k];
+    }
+    return (*scores_)[r];
+  }
+
+  int size() const { return scores_->size(); }
+
+protected:
+  const vector<double> *scores_;
+  vector<int> overlay_offsets_;
+  vector<const vector<double>*> overlays_;
+};
+
+#endif /* SCOREVIEW_H_ */
@@ -26,7 +26,9 @@
 #else
 #include <unordered_map>
 #endif
+#include <algorithm>
 #include "SerializationUtils.h"
+#include "SparseParameterVector.h"
 
 using namespace std;
 
@@ -40,6 +42,9 @@ const int kNumMaxSparseLabels = 5;
 // class for sparse label sets, and another for dense label sets.
 // When training, features that get conjoined with more than kNumMaxSparseLabels
 // use the dense variant, while the others use the sparse variant.
+// The weights are stored in entries of type Real (see GetWeightValue), but are
+// always read and written as doubles.
+template<typename Real>
 class LabelWeights {
 public:
   LabelWeights() {};
@@ -51,6 +56,9 @@ public:
   // Number of allocated labels.
   virtual int Size() const = 0;
 
+  // Memory (in bytes) taken by the label weights.
+  virtual int64_t GetNumBytes() const = 0;
+
   // Get/set/add weight to a labeled feature.
   virtual double GetWeight(int label) const = 0;
   virtual void SetWeight(int label, double weight) = 0;
@@ -64,21 +72,36 @@ public:
   virtual void GetLabelWeightByPosition(int position, int *label,
                                         double *weight) const = 0;
   virtual void SetWeightByPosition(int position, double weight) = 0;
+
+  // Get the entry of a label (NULL if the label is not allocated), or the
+  // entry at a position.
+  virtual Real *GetMutableEntry(int label) = 0;
+  virtual Real *GetMutableEntryByPosition(int position) = 0;
+
+  // Add the weights of all the labels smaller than num_labels, multiplied by
+  // scale_factor, to scores[label].
+  virtual void AddScaledWeights(double scale_factor, int num_labels,
+                                double *scores) const = 0;
 };
 
 // Sparse implementation of LabelWeights.
-class SparseLabelWeights : public LabelWeights {
+template<typename Real>
+class SparseLabelWeights : public LabelWeights<Real> {
 public:
   SparseLabelWeights() {};
   virtual ~SparseLabelWeights() {};
 
   bool IsSparse() const { return true; }
   int Size() const { return label_weights_.size(); }
+  int64_t GetNumBytes() const {
+    return sizeof(*this) +
+      label_weights_.capacity() * sizeof(std::pair<int, Real>);
+  }
 
   double GetWeight(int label) const {
     for (int k = 0; k < label_weights_.size(); ++k) {
       if (label == label_weights_[k].first) {
-        return label_weights_[k].second;
+        return GetWeightValue(label_weights_[k].second);
       }
     }
     return 0.0;
@@ -86,20 +109,21 @@ public:
   void SetWeight(int label, double weight) {
     for (int k = 0; k < label_weights_.size(); ++k) {
       if (label == label_weights_[k].first) {
-        label_weights_[k].second = weight;
+        SetWeightValue(weight, &label_weights_[k].second);
         return;
       }
     }
-    label_weights_.push_back(std::pair<int, double>(label, weight));
+    label_weights_.push_back(std::pair<int, Real>(label, Real(weight)));
   }
   void AddWeight(int label, double weight) {
     for (int k = 0; k < label_weights_.size(); ++k) {
       if (label == label_weights_[k].first) {
-        label_weights_[k].second += weight;
+        Real *entry = &label_weights_[k].second;
+        SetWeightValue(GetWeightValue(*entry) + weight, entry);
         return;
       }
     }
-    label_weights_.push_back(std::pair<int, double>(label, weight));
+    label_weights_.push_back(std::pair<int, Real>(label, Real(weight)));
   }
   // Sets new weight, normalize it and returns previous value of
   // label_weights_[k].second, with k such that label == label_weights_[k].first.
@@ -108,12 +132,13 @@ public:
     double previous_value;
     for (int k = 0; k < label_weights_.size(); ++k) {
       if (label == label_weights_[k].first) {
-        previous_value = label_weights_[k].second * scale_factor;
-        label_weights_[k].second = weight;
+        previous_value = GetWeightValue(label_weights_[k].second) *
+          scale_factor;
+        SetWeightValue(weight, &label_weights_[k].second);
         return previous_value;
       }
     }
-    label_weights_.push_back(std::pair<int, double>(label, weight));
+    label_weights_.push_back(std::pair<int, Real>(label, Real(weight)));
     return 0.0;
   }
   // Add weight value to current weight, normalize it and
@@ -124,76 +149,106 @@ public:
     double previous_value;
     for (int k = 0; k < label_weights_.size(); ++k) {
       if (label == label_weights_[k].first) {
-        previous_value = label_weights_[k].second * scale_factor;
-        label_weights_[k].second += weight;
+        Real *entry = &label_weights_[k].second;
+        previous_value = GetWeightValue(*entry) * scale_factor;
+        SetWeightValue(GetWeightValue(*entry) + weight, entry);
         return previous_value;
       }
     }
-    label_weights_.push_back(std::pair<int, double>(label, weight));
+    label_weights_.push_back(std::pair<int, Real>(label, Real(weight)));
     return 0.0;
   }
 
   void GetLabelWeightByPosition(int position, int *label,
                                 double *weight) const {
     *label = label_weights_[position].first;
-    *weight = label_weights_[position].second;
+    *weight = GetWeightValue(label_weights_[position].second);
     CHECK_GE(*label, 0);
   }
 
   void SetWeightByPosition(int position, double weight) {
-    label_weights_[position].second = weight;
+    SetWeightValue(weight, &label_weights_[position].second);
+  }
+
+  Real *GetMutableEntry(int label) {
+    for (int k = 0; k < label_weights_.size(); ++k) {
+      if (label == label_weights_[k].first) {
+        return &label_weights_[k].second;
+      }
+    }
+    return NULL;
+  }
+  Real *GetMutableEntryByPosition(int position) {
+    return &label_weights_[position].second;
+  }
+
+  void AddScaledWeights(double scale_factor, int num_labels,
+                        double *scores) const {
+    for (int k = 0; k < label_weights_.size(); ++k) {
+      int label = label_weights_[k].first;
+      if (label >= num_labels) continue;
+      scores[label] += GetWeightValue(label_weights_[k].second) * scale_factor;
+    }
   }
 
 protected:
-  std::vector<std::pair<int, double> > label_weights_;
+  std::vector<std::pair<int, Real> > label_weights_;
 };
 
 // Dense implementation of LabelWeights.
-class DenseLabelWeights : public LabelWeights {
+template<typename Real>
+class DenseLabelWeights : public LabelWeights<Real> {
 public:
   DenseLabelWeights() {};
-  DenseLabelWeights(LabelWeights *label_weights) {
+  DenseLabelWeights(LabelWeights<Real> *label_weights) {
     CHECK(label_weights->IsSparse());
     for (int k = 0; k < label_weights->Size(); ++k) {
       int label;
       double weight;
       label_weights->GetLabelWeightByPosition(k, &label, &weight);
       CHECK_GE(label, 0);
-      SetWeight(label, weight);
+      if (label >= weights_.size()) {
+        weights_.resize(label + 1, Real(0.0));
+      }
+      // Copy the whole entry (e.g. with its running sum).
+      weights_[label] = *label_weights->GetMutableEntryByPosition(k);
     }
   }
   virtual ~DenseLabelWeights() {};
 
   bool IsSparse() const { return false; }
   int Size() const { return weights_.size(); }
+  int64_t GetNumBytes() const {
+    return sizeof(*this) + weights_.capacity() * sizeof(Real);
+  }
 
   double GetWeight(int label) const {
     if (label >= weights_.size()) return 0.0;
-    return weights_[label];
+    return GetWeightValue(weights_[label]);
   }
   void SetWeight(int label, double weight) {
     CHECK_GE(label, 0);
     if (label >= weights_.size()) {
-      weights_.resize(label + 1, 0.0);
+      weights_.resize(label + 1, Real(0.0));
     }
-    weights_[label] = weight;
+    SetWeightValue(weight, &weights_[label]);
   }
   void AddWeight(int label, double weight) {
     CHECK_GE(label, 0);
     if (label >= weights_.size()) {
-      weights_.resize(label + 1, 0.0);
+      weights_.resize(label + 1, Real(0.0));
     }
-    weights_[label] += weight;
+    SetWeightValue(GetWeightValue(weights_[label]) + weight, &weights_[label]);
   }
   // Sets new weight, normalize it and returns previous value of weights_[label].
   double SetWeightAndNormalize(int label, double value, double scaling_factor) {
     CHECK_GE(label, 0);
     if (label >= weights_.size()) {
-      weights_.resize(label + 1, 0.0);
+      weights_.resize(label + 1, Real(0.0));
     }
     double weight = value / scaling_factor;
-    double previous_value = weights_[label] * scaling_factor;
-    weights_[label] = weight;
+    double previous_value = GetWeightValue(weights_[label]) * scaling_factor;
+    SetWeightValue(weight, &weights_[label]);
     return previous_value;
   }
   // Add weight value to current weight,
@@ -201,11 +256,11 @@ public:
   double AddWeightAndNormalize(int label, double value, double scaling_factor) {
     CHECK_GE(label, 0);
     if (label >= weights_.size()) {
-      weights_.resize(label + 1, 0.0);
+      weights_.resize(label + 1, Real(0.0));
     }
     double weight = value / scaling_factor;
-    double previous_value = weights_[label] * scaling_factor;
-    weights_[label] += weight;
+    double previous_value = GetWeightValue(weights_[label]) * scaling_factor;
+    SetWeightValue(GetWeightValue(weights_[label]) + weight, &weights_[label]);
     return previous_value;
   }
 
@@ -213,25 +268,44 @@ public:
                                 double *weight) const {
     CHECK_GE(position, 0);
     *label = position;
-    *weight = weights_[position];
+    *weight = GetWeightValue(weights_[position]);
   }
 
   void SetWeightByPosition(int position, double weight) {
-    weights_[position] = weight;
+    SetWeightValue(weight, &weights_[position]);
+  }
+
+  Real *GetMutableEntry(int label) {
+    if (label >= weights_.size()) return NULL;
+    return &weights_[label];
+  }
+  Real *GetMutableEntryByPosition(int position) {
+    return &weights_[position];
+  }
+
+  void AddScaledWeights(double scale_factor, int num_labels,
+                        double *scores) const {
+    int size = std::min(num_labels, static_cast<int>(weights_.size()));
+    for (int label = 0; label < size; ++label) {
+      scores[label] += GetWeightValue(weights_[label]) * scale_factor;
+    }
   }
 
 protected:
-  vector<double> weights_;
+  vector<Real> weights_;
 };
 
 // A labeled parameter map maps from feature keys ("labeled" features) to
 // LabelWeights, which contain the weights of several labels conjoined with
 // that feature.
+template<typename Real>
+struct LabeledParameterMap {
 #ifdef USE_CUSTOMIZED_HASH_TABLE
-typedef HashTable<uint64_t, LabelWeights*> LabeledParameterMap;
+  typedef HashTable<uint64_t, LabelWeights<Real>*> type;
 #else
-typedef std::unordered_map <uint64_t, LabelWeights*> LabeledParameterMap;
+  typedef std::unordered_map<uint64_t, LabelWeights<Real>*> type;
 #endif
+};
 
 // This class implements a sparse parameter vector, which contains weights for
 // the labels conjoined with each feature key. For fast lookup, this is
@@ -243,8 +317,13 @@ typedef std::unordered_map <uint64_t, LabelWeights*> LabeledParameterMap;
 // This way we can scale the weight vector in constant time (this operation is
 // necessary in some training algorithms such as SGD), and manipulating a few
 // elements is still fast. Plus, we can obtain the norm in constant time.
+template<typename Real>
 class SparseLabeledParameterVector {
 public:
+  typedef typename LabeledParameterMap<Real>::type::iterator Iterator;
+  typedef typename LabeledParameterMap<Real>::type::const_iterator
+    ConstIterator;
+
   SparseLabeledParameterVector() { growth_stopped_ = false; }
   virtual ~SparseLabeledParameterVector() { Clear(); }
 
@@ -256,7 +335,7 @@ public:
 
   // Clear the parameter vector.
   void Clear() {
-    for (LabeledParameterMap::iterator iterator = values_.begin();
+    for (Iterator iterator = values_.begin();
     iterator != values_.end();
       ++iterator) {
       delete iterator->second;
@@ -265,16 +344,21 @@ public:
   }
 
   // Save/load the parameters to/from a file.
-  void Save(FILE *fs) const {
+  void Save(FILE *fs) const { Save(fs, false); }
+  void Load(FILE *fs) { Load(fs, false); }
+
+  // Save/load the parameters, with the values in single precision if
+  // single_precision is true (regardless of the type Real).
+  void Save(FILE *fs, bool single_precision) const {
     bool success;
     success = WriteInteger(fs, Size());
     CHECK(success);
-    for (LabeledParameterMap::const_iterator iterator = values_.begin();
+    for (ConstIterator iterator = values_.begin();
     iterator != values_.end();
       ++iterator) {
       success = WriteUINT64(fs, iterator->first);
       CHECK(success);
-      const LabelWeights *label_weights = iterator->second;
+      const LabelWeights<Real> *label_weights = iterator->second;
       int length = label_weights->Size();
       success = WriteInteger(fs, length);
       CHECK(success);
@@ -285,12 +369,16 @@ public:
         CHECK_GE(label, 0);
         success = WriteInteger(fs, label);
         CHECK(success);
-        success = WriteDouble(fs, value);
+        if (single_precision) {
+          success = WriteFloat(fs, static_cast<float>(value));
+        } else {
+          success = WriteDouble(fs, value);
+        }
         CHECK(success);
       }
     }
   }
-  void Load(FILE *fs) {
+  void Load(FILE *fs, bool single_precision) {
     bool success;
     int num_features;
 
@@ -309,7 +397,13 @@ public:
       for (int k = 0; k < length; ++k) {
         success = ReadInteger(fs, &label);
         CHECK(success);
-        success = ReadDouble(fs, &value);
+        if (single_precision) {
+          float float_value;
+          success = ReadFloat(fs, &float_value);
+          value = static_cast<double>(float_value);
+        } else {
+          success = ReadDouble(fs, &value);
+        }
         CHECK(success);
         Set(key, label, value);
       }
@@ -321,10 +415,10 @@ public:
     int num_sparse = 0;
     int num_total = 0;
     int num_labels_sparse = 0;
-    for (LabeledParameterMap::iterator iterator = values_.begin();
+    for (Iterator iterator = values_.begin();
     iterator != values_.end();
       ++iterator) {
-      LabelWeights *label_weights = iterator->second;
+      LabelWeights<Real> *label_weights = iterator->second;
       if (label_weights->IsSparse()) {
         ++num_sparse;
         int length = label_weights->Size();
@@ -350,9 +444,25 @@ public:
   // This is the number of parameters up to different labels.
   int Size() const { return values_.size(); }
 
+  // Estimate the memory (in bytes) taken by the hash table (a pointer per
+  // bucket, and a node with the key, a pointer to the label weights and a
+  // pointer per feature) and by the label weights. This walks over all the
+  // features.
+  int64_t GetNumBytes() const {
+    int64_t num_bytes = values_.bucket_count() * sizeof(void*) +
+      values_.size() * (sizeof(pair<uint64_t, LabelWeights<Real>*>) +
+                        sizeof(void*));
+    for (ConstIterator iterator = values_.begin();
+         iterator != values_.end();
+         ++iterator) {
+      num_bytes += iterator->second->GetNumBytes();
+    }
+    return num_bytes;
+  }
+
   // True if this feature key is already instantiated.
   bool Exists(uint64_t key) const {
-    LabeledParameterMap::const_iterator iterator = values_.find(key);
+    ConstIterator iterator = values_.find(key);
     if (iterator == values_.end()) return false;
     return true;
   }
@@ -361,7 +471,7 @@ public:
   // found, in which case weights becomes empty.
   bool Get(uint64_t key, const vector<int> &labels,
            vector<double> *weights) const {
-    LabeledParameterMap::const_iterator iterator = values_.find(key);
+    ConstIterator iterator = values_.find(key);
     if (iterator == values_.end()) {
       weights->clear();
       return false;
@@ -370,6 +480,15 @@ public:
     return true;
   }
 
+  // Add the weights of all the labels (smaller than num_labels) conjoined
+  // with a feature key to values[label]. Returns false if no key was found.
+  bool AddAllValues(uint64_t key, int num_labels, double *values) const {
+    ConstIterator iterator = values_.find(key);
+    if (iterator == values_.end()) return false;
+    iterator->second->AddScaledWeights(scale_factor_, num_labels, values);
+    return true;
+  }
+
   // Get squared norm of the parameter vector.
   double GetSquaredNorm() const { return squared_norm_; }
 
@@ -386,7 +505,7 @@ public:
   // w'[id] = val
   bool Set(uint64_t key, int label, double value) {
     CHECK_GE(label, 0);
-    LabeledParameterMap::iterator iterator = FindOrInsert(key);
+    Iterator iterator = FindOrInsert(key);
     if (iterator != values_.end()) {
       SetValue(iterator, label, value);
       return true;
@@ -400,7 +519,7 @@ public:
   // Return false if the feature is not instantiated and cannot be inserted.
   // w'[id] = w[id] + val
   bool Add(uint64_t key, int label, double value) {
-    LabeledParameterMap::iterator iterator = FindOrInsert(key);
+    Iterator iterator = FindOrInsert(key);
     if (iterator != values_.end()) {
       AddValue(iterator, label, value);
       return true;
@@ -415,7 +534,7 @@ public:
   // w'[id] = w[id] + val
   void Add(uint64_t key, const vector<int> &labels,
            const vector<double> &values) {
-    LabeledParameterMap::iterator iterator = FindOrInsert(key);
+    Iterator iterator = FindOrInsert(key);
     for (int k = 0; k < labels.size(); ++k) {
       AddValue(iterator, labels[k], values[k]);
     }
@@ -435,12 +554,12 @@ public:
   // of several features.
   // NOTE: Silently bypasses the ones that could not be inserted, if any.
   void Add(const SparseLabeledParameterVector &parameters) {
-    for (LabeledParameterMap::const_iterator iterator =
+    for (ConstIterator iterator =
          parameters.values_.begin();
          iterator != parameters.values_.end();
          ++iterator) {
       uint64_t key = iterator->first;
-      LabelWeights *label_weights = iterator->second;
+      LabelWeights<Real> *label_weights = iterator->second;
       int label;
       double value;
       for (int k = 0; k < label_weights->Size(); ++k) {
@@ -455,11 +574,11 @@ public:
 
 protected:
   // Get the weights for the specified labels.
-  void GetValues(LabeledParameterMap::const_iterator iterator,
+  void GetValues(ConstIterator iterator,
                  const vector<int> &labels,
                  vector<double> *values) const {
     values->resize(labels.size());
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     for (int i = 0; i < labels.size(); ++i) {
       (*values)[i] = label_weights->GetWeight(labels[i]) * scale_factor_;
     }
@@ -468,28 +587,28 @@ protected:
   // Get the weight for the specified label.
   // Two versions of this function: one using a const_iterator,
   // another using an iterator.
-  double GetValue(LabeledParameterMap::const_iterator iterator,
+  double GetValue(ConstIterator iterator,
                   int label) const {
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     return label_weights->GetWeight(label) * scale_factor_;
   }
-  double GetValue(LabeledParameterMap::iterator iterator,
+  double GetValue(Iterator iterator,
                   int label) const {
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     return label_weights->GetWeight(label) * scale_factor_;
   }
 
   // Set the weight for the specified label.
-  void SetValue(LabeledParameterMap::iterator iterator, int label,
+  void SetValue(Iterator iterator, int label,
                 double value) {
 #if USE_N_OPTIMIZATIONS==0
     // TODO: Make this more efficient, avoiding two lookups in LabelWeights.
     double current_value = GetValue(iterator, label);
     squared_norm_ += value * value - current_value * current_value;
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     label_weights->SetWeight(label, value / scale_factor_);
 #else
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     double previous_value = label_weights->SetWeightAndNormalize(label,
                                                                  value,
                                                                  scale_factor_);
@@ -500,8 +619,8 @@ protected:
     // label weights.
     if (label_weights->Size() > kNumMaxSparseLabels &&
         label_weights->IsSparse()) {
-      DenseLabelWeights *dense_label_weights =
-        new DenseLabelWeights(label_weights);
+      DenseLabelWeights<Real> *dense_label_weights =
+        new DenseLabelWeights<Real>(label_weights);
       delete label_weights;
       iterator->second = dense_label_weights;
     }
@@ -511,21 +630,21 @@ protected:
   }
 
   // Add weight for the specified label.
-  void AddValue(LabeledParameterMap::iterator iterator, int label,
+  void AddValue(Iterator iterator, int label,
                 double value) {
 #if USE_N_OPTIMIZATIONS==0
     // TODO: Make this more efficient, avoiding two lookups in LabelWeights.
     double current_value = GetValue(iterator, label);
     value += current_value;
     squared_norm_ += value * value - current_value * current_value;
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     if (!label_weights)
-      label_weights = new SparseLabelWeights;
+      label_weights = new SparseLabelWeights<Real>;
     label_weights->SetWeight(label, value / scale_factor_);
 #else
-    LabelWeights *label_weights = iterator->second;
+    LabelWeights<Real> *label_weights = iterator->second;
     if (!label_weights)
-      label_weights = new SparseLabelWeights;
+      label_weights = new SparseLabelWeights<Real>;
     double previous_value = label_weights->AddWeightAndNormalize(label,
                                                                  value,
                                                                  scale_factor_);
@@ -542,8 +661,8 @@ protected:
   // label weights.
     if (label_weights->Size() > kNumMaxSparseLabels &&
         label_weights->IsSparse()) {
-      DenseLabelWeights *dense_label_weights =
-        new DenseLabelWeights(label_weights);
+      DenseLabelWeights<Real> *dense_label_weights =
+        new DenseLabelWeights<Real>(label_weights);
       delete label_weights;
       iterator->second = dense_label_weights;
     }
@@ -553,12 +672,12 @@ protected:
   }
 
   // Find a key, or insert it in case it does not exist.
-  LabeledParameterMap::iterator FindOrInsert(uint64_t key) {
-    LabeledParameterMap::iterator iterator = values_.find(key);
+  Iterator FindOrInsert(uint64_t key) {
+    Iterator iterator = values_.find(key);
     if (iterator != values_.end() || growth_stopped()) return iterator;
-    LabelWeights *label_weights = new SparseLabelWeights;
-    pair<LabeledParameterMap::iterator, bool> result =
-      values_.insert(pair<uint64_t, LabelWeights*>(key, label_weights));
+    LabelWeights<Real> *label_weights = new SparseLabelWeights<Real>;
+    pair<Iterator, bool> result =
+      values_.insert(pair<uint64_t, LabelWeights<Real>*>(key, label_weights));
     CHECK(result.second);
     return result.first;
   }
@@ -574,10 +693,10 @@ protected:
   // Renormalize the entire parameter map (an expensive operation).
   void Renormalize() {
     LOG(INFO) << "Renormalizing the parameter map...";
-    for (LabeledParameterMap::iterator iterator = values_.begin();
+    for (Iterator iterator = values_.begin();
     iterator != values_.end();
       ++iterator) {
-      LabelWeights *label_weights = iterator->second;
+      LabelWeights<Real> *label_weights = iterator->second;
       int label;
       double value;
       for (int k = 0; k < label_weights->Size(); ++k) {
@@ -589,10 +708,15 @@ protected:
   }
 
 protected:
-  LabeledParameterMap values_; // Weight values, up to a scale.
+  // Weight values, up to a scale.
+  typename LabeledParameterMap<Real>::type values_;
   double scale_factor_; // The scale factor, such that w = values * scale.
   double squared_norm_; // The squared norm of the parameter vector.
   bool growth_stopped_; // True if parameters are locked.
 };
 
+typedef SparseLabeledParameterVector<double>
+  SparseLabeledParameterVectorDouble;
+typedef SparseLabeledParameterVector<float> SparseLabeledParameterVectorFloat;
+
 #endif /*SPARSELABELEDPARAMETERVECTOR_H_*/
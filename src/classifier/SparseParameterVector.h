@@ -71,6 +71,18 @@ struct ParameterMap {
 // A threshold beyond which we need to renormalize the parameter vector.
 const double kScaleFactorThreshold = 1e-9;
 
+// Get/set the weight stored in an entry of a parameter map. The entries are
+// plain numbers of type Real; other types of entries (e.g. AveragedWeight,
+// which also holds a running sum) overload these functions.
+template<typename Real>
+inline double GetWeightValue(const Real &entry) {
+  return static_cast<double>(entry);
+}
+template<typename Real>
+inline void SetWeightValue(double value, Real *entry) {
+  *entry = static_cast<Real>(value);
+}
+
 // This class implements a sparse parameter vector, which contains a weight for
 // each feature key. For fast lookup, this is implemented using an hash table.
 // We represent a weight vector as a triple
@@ -93,7 +105,18 @@ public:
   bool growth_stopped() const { return growth_stopped_; }
 
   // Save/load the parameters to/from a file.
-  void Save(FILE *fs) const {
+  void Save(FILE *fs) const { Save(fs, false); }
+  void Load(FILE *fs) {
+    bool success;
+    int length;
+    success = ReadInteger(fs, &length);
+    CHECK(success);
+    Load(fs, length, false);
+  }
+
+  // Save the parameters, writing the values in single precision if
+  // single_precision is true (regardless of the type Real).
+  void Save(FILE *fs, bool single_precision) const {
     bool success;
     success = WriteInteger(fs, Size());
     CHECK(success);
@@ -104,24 +127,34 @@ public:
       success = WriteUINT64(fs, iterator->first);
       CHECK(success);
       double value = GetValue(iterator);
-      success = WriteDouble(fs, value);
+      if (single_precision) {
+        success = WriteFloat(fs, static_cast<float>(value));
+      } else {
+        success = WriteDouble(fs, value);
+      }
       CHECK(success);
     }
   }
-  void Load(FILE *fs) {
+
+  // Load the parameters when the number of features has already been read.
+  // The values are in single precision if single_precision is true.
+  void Load(FILE *fs, int length, bool single_precision) {
     Initialize();
 
     bool success;
-    int length;
-    success = ReadInteger(fs, &length);
-    CHECK(success);
     //values_.rehash(length); // This is the number of buckets.
     for (int i = 0; i < length; ++i) {
       uint64_t key;
       double value;
       success = ReadUINT64(fs, &key);
       CHECK(success);
-      success = ReadDouble(fs, &value);
+      if (single_precision) {
+        float float_value;
+        success = ReadFloat(fs, &float_value);
+        value = static_cast<double>(float_value);
+      } else {
+        success = ReadDouble(fs, &value);
+      }
       CHECK(success);
       Set(key, value);
     }
@@ -136,6 +169,13 @@ public:
   // Get the number of instantiated features.
   int Size() const { return values_.size(); }
 
+  // Estimate the memory (in bytes) taken by the hash table: a pointer per
+  // bucket, and a node with the key, the value and a pointer per feature.
+  int64_t GetNumBytes() const {
+    return values_.bucket_count() * sizeof(void*) +
+      values_.size() * (sizeof(pair<uint64_t, Real>) + sizeof(void*));
+  }
+
   // True if this feature key is already instantiated.
   bool Exists(uint64_t key) const {
     typename ParameterMap<Real>::type::const_iterator iterator =
@@ -169,7 +209,7 @@ public:
     double current_value = GetValue(iterator);
     squared_norm_ += value * value - current_value * current_value;
     // Might lose precision here.
-    iterator->second = static_cast<Real>(value / scale_factor_);
+    SetWeightValue(value / scale_factor_, &iterator->second);
 
     // This prevents numerical issues:
     if (squared_norm_ < 0.0) squared_norm_ = 0.0;
@@ -179,13 +219,13 @@ public:
   // iterator.
   double GetValue(typename ParameterMap<Real>::type::const_iterator
                   iterator) const {
-    return static_cast<double>(iterator->second) * scale_factor_;
+    return GetWeightValue(iterator->second) * scale_factor_;
   }
 
   // Get the parameter value of a feature pointed by an iterator.
   double GetValue(typename ParameterMap<Real>::type::iterator
                   iterator) const {
-    return static_cast<double>(iterator->second) * scale_factor_;
+    return GetWeightValue(iterator->second) * scale_factor_;
   }
 
   // Obtain the iterator pointing to a feature key. If the key does not exist
@@ -196,7 +236,7 @@ public:
     if (iterator != values_.end() || growth_stopped()) return iterator;
     values_.PrepareForResize();
     pair<typename ParameterMap<Real>::type::iterator, bool> result =
-      values_.insert(pair<uint64_t, Real>(key, 0.0));
+      values_.insert(pair<uint64_t, Real>(key, Real(0.0)));
     CHECK(result.second);
     return result.first;
   }
@@ -220,7 +260,7 @@ public:
   bool Add(uint64_t key, double value) {
     typename ParameterMap<Real>::type::iterator iterator = FindOrInsert(key);
     if (iterator != values_.end()) {
-      SetValue(iterator, iterator->second * scale_factor_ + value);
+      SetValue(iterator, GetValue(iterator) + value);
       return true;
     } else {
       return false;
@@ -267,7 +307,8 @@ protected:
     for (typename ParameterMap<Real>::type::iterator iterator = values_.begin();
     iterator != values_.end();
       ++iterator) {
-      iterator->second *= scale_factor_;
+      SetWeightValue(GetWeightValue(iterator->second) * scale_factor_,
+                     &iterator->second);
     }
     scale_factor_ = 1.0;
   }
@@ -61,6 +61,13 @@ public:
     return NULL;
   }
 
+  int64_t GetNumFeatures() const {
+    return CountFeatures(input_features_nodes_);
+  }
+  int64_t GetNumBytes() const {
+    return CountFeatureBytes(input_features_nodes_);
+  }
+
   const BinaryFeatures &GetNodeFeatures(int i) const {
     return *(input_features_nodes_[i]);
   }
@@ -73,6 +73,12 @@ protected:
     return instance_numeric;
   }
 
+  // Number of constituents of a tree.
+  int GetInstanceLength(Instance *formatted_instance) {
+    return static_cast<ConstituencyLabelerInstanceNumeric*>(
+      formatted_instance)->GetNumConstituents();
+  }
+
 protected:
   void SaveModel(FILE* fs);
   void LoadModel(FILE* fs);
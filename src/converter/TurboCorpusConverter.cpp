@@ -0,0 +1,187 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+// Conversion of a training file to a binary training corpus, which stores
+// the dictionaries built from the training data and the training instances
+// in numeric format (word, lemma, tag and feature ids, gold heads and
+// labels, semantic predicates and arguments, etc.), with a fingerprint of
+// the dictionaries. Training with --file_train_corpus loads the corpus
+// instead of reading the text, building the dictionaries and converting the
+// instances again. The task flags that affect the dictionaries or the
+// numeric instances (e.g. --form_cutoff, --prefix_length or
+// --srl_use_predicate_senses) must be given here. They are stored in the
+// corpus: the dictionaries overwrite the flags they save (e.g.
+// --prefix_length), and training checks that the other ones (e.g.
+// --srl_use_predicate_senses or --entity_tagging_scheme) match.
+// Example:
+//   TurboCorpusConverter --convert_task=parser --file_train=train.conll \
+//     --file_train_corpus=train.corpus
+//   TurboParser --train --file_train_corpus=train.corpus \
+//     --file_model=parser.model
+// With --file_test_corpus, the test data is converted instead, with the
+// dictionaries of a trained model: the corpus stores each instance and its
+// numeric instance, with the fingerprint of the model's dictionaries. It is
+// given to the tagger or parser in --file_test, which checks that it was
+// converted with the same model. The parser's tagger model (if any) must
+// be given here, since the POS tags are predicted at conversion time.
+// Example:
+//   TurboCorpusConverter --convert_task=parser --file_model=parser.model \
+//     --file_test=test.conll --file_test_corpus=test.corpus
+//   TurboParser --test --file_model=parser.model --file_test=test.corpus \
+//     --file_prediction=test.pred
+// Coreference documents and constituency trees cannot be converted.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+#include "Utils.h"
+#include "DependencyPipe.h"
+#include "SemanticPipe.h"
+#include "TaggerPipe.h"
+#include "EntityPipe.h"
+#include "MorphologicalPipe.h"
+
+using namespace std;
+
+DEFINE_string(convert_task, "parser",
+              "Task of the training corpus: parser, semantic_parser, tagger, "
+              "entity_recognizer or morphological_tagger. The dependency "
+              "labeler uses the same dictionaries and instances as the "
+              "parser, so it can be trained with a parser corpus.");
+DEFINE_string(file_test_corpus, "",
+              "Path to the test corpus to create from --file_test with the "
+              "dictionaries of the model in --file_model. If empty, the "
+              "training corpus is created.");
+
+// Load the models used to format the test instances.
+static void LoadTestModels(Pipe *pipe) { pipe->LoadModelFile(); }
+static void LoadTestModels(DependencyPipe *pipe) {
+  pipe->LoadModelFile();
+  if (pipe->GetDependencyOptions()->GetTaggerModelFilePath() != "") {
+    pipe->LoadTaggerModelFile();
+  }
+}
+
+// Build a pipe of the task and write its training corpus.
+template <class OptionsType, class PipeType> void ConvertCorpus() {
+  int time;
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  OptionsType *options = new OptionsType;
+  options->Initialize();
+  CHECK_NE(options->GetTrainingFilePath(), "")
+    << "No training file was given (--file_train).";
+  CHECK_NE(options->GetTrainingCorpusFilePath(), "")
+    << "No training corpus was given (--file_train_corpus).";
+
+  PipeType *pipe = new PipeType(options);
+  pipe->Initialize();
+  pipe->CreateTrainingCorpus();
+  delete pipe;
+  delete options;
+
+  gettimeofday(&end, NULL);
+  time = diff_ms(end, start);
+  LOG(INFO) << "Conversion took " << static_cast<double>(time) / 1000.0
+            << " sec." << endl;
+}
+
+// Load a model of the task and write the test corpus of the test data.
+template <class OptionsType, class PipeType> void ConvertTestCorpus() {
+  int time;
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  OptionsType *options = new OptionsType;
+  options->Initialize();
+  CHECK_NE(options->GetTestFilePath(), "")
+    << "No test file was given (--file_test).";
+  CHECK_NE(options->GetModelFilePath(), "")
+    << "No model was given (--file_model).";
+
+  PipeType *pipe = new PipeType(options);
+  pipe->Initialize();
+  LoadTestModels(pipe);
+  pipe->CreateTestCorpus(FLAGS_file_test_corpus);
+  delete pipe;
+  delete options;
+
+  gettimeofday(&end, NULL);
+  time = diff_ms(end, start);
+  LOG(INFO) << "Conversion took " << static_cast<double>(time) / 1000.0
+            << " sec." << endl;
+}
+
+int main(int argc, char** argv) {
+  // Initialize Google's logging library.
+  google::InitGoogleLogging(argv[0]);
+
+  // Parse command line flags.
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (FLAGS_convert_task == "coreference_resolver" ||
+      FLAGS_convert_task == "constituency_labeler") {
+    LOG(FATAL) << "The " << FLAGS_convert_task << " task cannot be "
+               << "converted: coreference documents and constituency trees "
+               << "have no binary format.";
+  }
+
+  if (FLAGS_file_test_corpus != "") {
+    // The test instances are formatted with the dictionaries of the model.
+    FLAGS_train = false;
+    FLAGS_test = true;
+    if (FLAGS_convert_task == "parser") {
+      ConvertTestCorpus<DependencyOptions, DependencyPipe>();
+    } else if (FLAGS_convert_task == "semantic_parser") {
+      ConvertTestCorpus<SemanticOptions, SemanticPipe>();
+    } else if (FLAGS_convert_task == "tagger") {
+      ConvertTestCorpus<TaggerOptions, TaggerPipe>();
+    } else if (FLAGS_convert_task == "entity_recognizer") {
+      ConvertTestCorpus<EntityOptions, EntityPipe>();
+    } else if (FLAGS_convert_task == "morphological_tagger") {
+      ConvertTestCorpus<MorphologicalOptions, MorphologicalPipe>();
+    } else {
+      LOG(FATAL) << "Unknown task: " << FLAGS_convert_task << ".";
+    }
+  } else {
+    // The dictionaries are built as for training.
+    FLAGS_train = true;
+    FLAGS_test = false;
+    if (FLAGS_convert_task == "parser") {
+      ConvertCorpus<DependencyOptions, DependencyPipe>();
+    } else if (FLAGS_convert_task == "semantic_parser") {
+      ConvertCorpus<SemanticOptions, SemanticPipe>();
+    } else if (FLAGS_convert_task == "tagger") {
+      ConvertCorpus<TaggerOptions, TaggerPipe>();
+    } else if (FLAGS_convert_task == "entity_recognizer") {
+      ConvertCorpus<EntityOptions, EntityPipe>();
+    } else if (FLAGS_convert_task == "morphological_tagger") {
+      ConvertCorpus<MorphologicalOptions, MorphologicalPipe>();
+    } else {
+      LOG(FATAL) << "Unknown task: " << FLAGS_convert_task << ".";
+    }
+  }
+
+  // Destroy allocated memory regarding line flags.
+  google::ShutDownCommandLineFlags();
+  google::ShutdownGoogleLogging();
+  return 0;
+}
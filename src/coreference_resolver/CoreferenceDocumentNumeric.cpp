@@ -94,29 +94,9 @@ void CoreferenceDocumentNumeric::Initialize(
       // Set head and phrase string IDs.
       CoreferenceSentence *sentence_instance =
         instance->GetSentence(sentence_index);
-
-      std::string speaker;
-      mentions[j]->GetSpeaker(sentence_instance, &speaker);
-      int speaker_id = mention_speakers.Insert(speaker);
-      mentions[j]->set_speaker_id(speaker_id);
-
-      std::string phrase_string;
-      mentions[j]->GetPhraseString(sentence_instance, &phrase_string);
-      int phrase_string_id = mention_phrase_strings.Insert(phrase_string);
-      mentions[j]->set_phrase_string_id(phrase_string_id);
-
-      std::string head_string;
-      mentions[j]->GetHeadString(sentence_instance, &head_string);
-      int head_string_id = mention_head_strings.Insert(head_string);
-      mentions[j]->set_head_string_id(head_string_id);
-
-      std::vector<int> all_word_string_ids;
-      for (int k = mentions[j]->start(); k <= mentions[j]->end(); ++k) {
-        const std::string &word_string = sentence_instance->GetForm(k);
-        int word_string_id = mention_word_strings.Insert(word_string);
-        all_word_string_ids.push_back(word_string_id);
-      }
-      mentions[j]->set_all_word_string_ids(all_word_string_ids);
+      SetMentionStringIds(sentence_instance, mentions[j], &mention_speakers,
+                          &mention_phrase_strings, &mention_head_strings,
+                          &mention_word_strings);
     }
   }
 
@@ -132,6 +112,82 @@ void CoreferenceDocumentNumeric::Initialize(
   // GenerateMentions()?
 }
 
+void CoreferenceDocumentNumeric::BeginIncremental(bool conversation) {
+  Clear();
+  conversation_ = conversation;
+  mention_speakers_.clear();
+  mention_head_strings_.clear();
+  mention_phrase_strings_.clear();
+  mention_word_strings_.clear();
+}
+
+void CoreferenceDocumentNumeric::AddSentence(
+  const CoreferenceDictionary &dictionary,
+  CoreferenceSentence *instance) {
+  std::map<std::string, int> span_names;
+  CoreferenceSentenceNumeric *sentence = new CoreferenceSentenceNumeric;
+  sentence->Initialize(dictionary, instance, false, &span_names);
+  int sentence_index = sentence_offset_ + sentences_.size();
+  sentences_.push_back(sentence);
+
+  // Note: mentions are owned by CoreferenceSentenceNumeric.
+  const vector<Mention*> &mentions = sentence->GetMentions();
+  for (int j = 0; j < mentions.size(); ++j) {
+    mentions[j]->set_offset(num_words_);
+    mentions[j]->set_sentence_index(sentence_index);
+    SetMentionStringIds(instance, mentions[j], &mention_speakers_,
+                        &mention_phrase_strings_, &mention_head_strings_,
+                        &mention_word_strings_);
+  }
+  mentions_.insert(mentions_.end(), mentions.begin(), mentions.end());
+
+  // Subtract 1 since there is an extra start symbol.
+  num_words_ += sentence->size() - 1;
+  sentence_cumulative_lengths_.push_back(num_words_);
+}
+
+void CoreferenceDocumentNumeric::RemoveFirstSentence() {
+  CHECK_GT(sentences_.size(), 0);
+  CoreferenceSentenceNumeric *sentence = sentences_[0];
+  int num_mentions = sentence->GetMentions().size();
+  CHECK_LE(num_mentions, mentions_.size());
+  mentions_.erase(mentions_.begin(), mentions_.begin() + num_mentions);
+  sentences_.erase(sentences_.begin());
+  delete sentence;
+  ++sentence_offset_;
+}
+
+void CoreferenceDocumentNumeric::SetMentionStringIds(
+  CoreferenceSentence *sentence_instance,
+  Mention *mention,
+  Alphabet *mention_speakers,
+  Alphabet *mention_phrase_strings,
+  Alphabet *mention_head_strings,
+  Alphabet *mention_word_strings) {
+  std::string speaker;
+  mention->GetSpeaker(sentence_instance, &speaker);
+  int speaker_id = mention_speakers->Insert(speaker);
+  mention->set_speaker_id(speaker_id);
+
+  std::string phrase_string;
+  mention->GetPhraseString(sentence_instance, &phrase_string);
+  int phrase_string_id = mention_phrase_strings->Insert(phrase_string);
+  mention->set_phrase_string_id(phrase_string_id);
+
+  std::string head_string;
+  mention->GetHeadString(sentence_instance, &head_string);
+  int head_string_id = mention_head_strings->Insert(head_string);
+  mention->set_head_string_id(head_string_id);
+
+  std::vector<int> all_word_string_ids;
+  for (int k = mention->start(); k <= mention->end(); ++k) {
+    const std::string &word_string = sentence_instance->GetForm(k);
+    int word_string_id = mention_word_strings->Insert(word_string);
+    all_word_string_ids.push_back(word_string_id);
+  }
+  mention->set_all_word_string_ids(all_word_string_ids);
+}
+
 void CoreferenceDocumentNumeric::ComputeEntityClusters() {
   entity_clusters_.clear();
   for (int j = 0; j < mentions_.size(); ++j) {
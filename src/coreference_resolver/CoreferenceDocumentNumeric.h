@@ -25,7 +25,11 @@
 
 class CoreferenceDocumentNumeric : public Instance {
 public:
-  CoreferenceDocumentNumeric() { conversation_ = false; };
+  CoreferenceDocumentNumeric() {
+    conversation_ = false;
+    sentence_offset_ = 0;
+    num_words_ = 0;
+  };
   virtual ~CoreferenceDocumentNumeric() { Clear(); };
 
   Instance* Copy() {
@@ -43,12 +47,26 @@ public:
     mentions_.clear();
     entity_clusters_.clear();
     DeleteAllSentences();
+    sentence_offset_ = 0;
+    num_words_ = 0;
   }
 
   void Initialize(const CoreferenceDictionary &dictionary,
                   CoreferenceDocument *instance,
                   bool add_gold_mentions);
 
+  // Incremental (streaming) interface. Sentences are appended one at a time
+  // and dropped from the front once they fall out of the active window.
+  // Mentions keep their absolute sentence index, so GetSentence() still works
+  // with it; mention indices are relative to the first active sentence.
+  // The cumulative sentence lengths are kept for all the sentences added so
+  // far, so the word positions are still at document level.
+  // No gold mentions or entity clusters are kept in this mode.
+  void BeginIncremental(bool conversation);
+  void AddSentence(const CoreferenceDictionary &dictionary,
+                   CoreferenceSentence *instance);
+  void RemoveFirstSentence();
+
   // True if document is a conversation.
   bool is_conversation() { return conversation_; }
 
@@ -59,7 +77,9 @@ public:
   int GetNumWords() { return sentence_cumulative_lengths_.back(); }
 
   // Returns the i-th sentence.
-  CoreferenceSentenceNumeric *GetSentence(int i) { return sentences_[i]; }
+  CoreferenceSentenceNumeric *GetSentence(int i) {
+    return sentences_[i - sentence_offset_];
+  }
 
   // Returns the mentions.
   const std::vector<Mention*> &GetMentions() { return mentions_; }
@@ -114,6 +134,15 @@ protected:
 
   void ComputeEntityClusters();
 
+  // Set speaker, phrase, head and word string ids of a mention, using the
+  // given alphabets to map strings to document-level ids.
+  void SetMentionStringIds(CoreferenceSentence *sentence_instance,
+                           Mention *mention,
+                           Alphabet *mention_speakers,
+                           Alphabet *mention_phrase_strings,
+                           Alphabet *mention_head_strings,
+                           Alphabet *mention_word_strings);
+
   void ComputeGlobalWordPositions(CoreferenceDocument* instance);
 
 private:
@@ -123,6 +152,15 @@ private:
   std::vector<NumericSpan*> coreference_spans_;
   std::vector<Mention*> mentions_;
   std::vector<std::vector<int> > entity_clusters_;
+  // Index of the first sentence in sentences_ (non-zero in incremental mode).
+  int sentence_offset_;
+  // Number of words added so far (incremental mode).
+  int num_words_;
+  // Document-level string alphabets (incremental mode).
+  Alphabet mention_speakers_;
+  Alphabet mention_head_strings_;
+  Alphabet mention_phrase_strings_;
+  Alphabet mention_word_strings_;
 };
 
 #endif /* COREFERENCEDOCUMENTNUMERIC_H_ */
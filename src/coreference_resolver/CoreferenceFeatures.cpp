@@ -21,569 +21,649 @@
 #include "CoreferencePart.h"
 #include "CoreferenceFeatureTemplates.h"
 
-void CoreferenceFeatures::AddArcFeatures(CoreferenceDocumentNumeric* document,
-                                         int r,
-                                         int parent_mention,
-                                         int child_mention) {
-  CoreferenceOptions *options = static_cast<class CoreferencePipe*>(pipe_)->
-    GetCoreferenceOptions();
-
-  CHECK(!input_features_[r]);
-  BinaryFeatures *features = new BinaryFeatures;
-  input_features_[r] = features;
-
-  bool use_gender_number_features = true;
-  bool use_ancestry_features = true;
-  bool use_contained_features = true;
-  bool use_nested_feature = true;
-  bool use_speaker_feature = true;
-
+static const bool kUseGenderNumberFeatures = true;
+static const bool kUseAncestryFeatures = true;
+static const bool kUseContainedFeatures = true;
+static const bool kUseNestedFeature = true;
+static const bool kUseSpeakerFeature = true;
+
+// Maximum number of features depending on pairwise properties (distances,
+// string matches, nesting, speakers).
+static const int kNumPairwiseFeatures = 30;
+
+// Flags of arcs departing from the root (non-anaphoric mentions) and of arcs
+// linking two mentions.
+static const uint8_t kRootArcFlags = CoreferenceFeatureTemplateParts::ARC;
+static const uint8_t kMentionArcFlags =
+  CoreferenceFeatureTemplateParts::ARC | (0x1 << 4);
+
+void CoreferenceFeatures::ComputeMentionFeatures(
+  CoreferenceDocumentNumeric *document) {
   const vector<Mention*> &mentions = document->GetMentions();
-  Mention *parent = (parent_mention >= 0) ? mentions[parent_mention] : NULL;
-  Mention *child = mentions[child_mention];
-  int sentence_distance = (parent) ?
-    child->sentence_index() - parent->sentence_index() : -1;
-  int mention_distance = (parent) ? child_mention - parent_mention : -1;
-
-  bool nested = false;
-  if (parent && child->sentence_index() == parent->sentence_index() &&
-      (child->LiesInsideSpan(*parent) || parent->LiesInsideSpan(*child))) {
-    nested = true;
+  mention_ids_.resize(mentions.size());
+  child_blocks_.resize(mentions.size());
+  parent_blocks_.resize(mentions.size());
+  for (int j = 0; j < mentions.size(); ++j) {
+    ComputeMentionFeatureIds(document, mentions[j], &mention_ids_[j]);
+    child_blocks_[j].clear();
+    AddChildFeatures(mention_ids_[j], kMentionArcFlags, &child_blocks_[j]);
+    parent_blocks_[j].clear();
+    AddParentFeatures(mention_ids_[j], kMentionArcFlags, &parent_blocks_[j]);
   }
-  uint8_t nested_flag = 0x0;
-  if (nested) nested_flag = 0x1;
-
-  bool same_speaker = true;
-  if (parent && child->speaker_id() != parent->speaker_id()) {
-    same_speaker = false;
-  }
-  bool conversation = document->is_conversation();
-  uint8_t speaker_flag = 0x0;
-  if (conversation) speaker_flag |= 0x1;
-  if (!same_speaker) speaker_flag |= 0x1 << 1;
+}
 
+void CoreferenceFeatures::ComputeMentionFeatureIds(
+  CoreferenceDocumentNumeric *document,
+  Mention *mention,
+  MentionFeatureIds *ids) {
   int num_bits = 0;
 
-  // Child "canonical pronoun" types.
-  uint16_t CtID = 0x0;
+  // "Canonical pronoun" type.
   // Two bits for the type.
-  num_bits = 0;
-  CtID = child->type() << num_bits;
+  ids->tID = mention->type() << num_bits;
   num_bits += 2;
   // If pronoun, 12=4+4+4 bits for the pronoun person, number, and gender.
-  if (child->pronoun()) {
-    CtID |= child->pronoun()->person_flag() << num_bits;
+  if (mention->pronoun()) {
+    ids->tID |= mention->pronoun()->person_flag() << num_bits;
     num_bits += 4;
-    CtID |= child->pronoun()->number_flag() << num_bits;
+    ids->tID |= mention->pronoun()->number_flag() << num_bits;
     num_bits += 4;
-    CtID |= child->pronoun()->gender_flag() << num_bits;
+    ids->tID |= mention->pronoun()->gender_flag() << num_bits;
     num_bits += 4;
   }
   CHECK_LT(num_bits, 16);
+  ids->pronominal = (mention->type() == MentionType::PRONOMINAL);
 
-  // Parent "canonical pronoun" types.
-  uint16_t PtID = 0x0;
-  // Two bits for the type.
-  num_bits = 0;
-  if (parent) {
-    PtID = parent->type() << num_bits;
-    num_bits += 2;
-    // If pronoun, 12=4+4+4 bits for the pronoun person, number, and gender.
-    if (parent->pronoun()) {
-      PtID |= parent->pronoun()->person_flag() << num_bits;
-      num_bits += 4;
-      PtID |= parent->pronoun()->number_flag() << num_bits;
-      num_bits += 4;
-      PtID |= parent->pronoun()->gender_flag() << num_bits;
-      num_bits += 4;
-    }
-    CHECK_LT(num_bits, 16);
-  }
-
-  uint16_t CWID, PWID; // Child and parent head words.
-  uint16_t CfWID, PfWID; // Child and parent first words.
-  uint16_t ClWID, PlWID; // Child and parent last words.
-  uint16_t CpWID, PpWID; // Child and parent preceding words.
-  uint16_t CnWID, PnWID; // Child and parent next words.
-
-  uint8_t CPID, PPID; // Child and parent head tags.
-  uint8_t CfPID, PfPID; // Child and parent first tags.
-  uint8_t ClPID, PlPID; // Child and parent last tags.
-  uint8_t CpPID, PpPID; // Child and parent preceding tags.
-  uint8_t CnPID, PnPID; // Child and parent next tags.
-
-  uint16_t CA1ID, PA1ID; // Child and parent unigram ancestry.
-  uint16_t CA2ID, PA2ID; // Child and parent bigram ancestry.
-
-  CoreferenceSentenceNumeric *child_sentence =
-    document->GetSentence(child->sentence_index());
-  CoreferenceSentenceNumeric *parent_sentence = (parent) ?
-    document->GetSentence(parent->sentence_index()) : NULL;
+  CoreferenceSentenceNumeric *sentence =
+    document->GetSentence(mention->sentence_index());
 
   // Use POS tags for now (instead of word forms).
-  CWID = child_sentence->GetFormId(child->head_index());
-  CfWID = child_sentence->GetFormId(child->start());
-  ClWID = child_sentence->GetFormId(child->end());
-  CpWID = (child->start() > 0) ?
-    child_sentence->GetFormId(child->start() - 1) : TOKEN_START;
-  CnWID = (child->end() < child_sentence->size() - 1) ?
-    child_sentence->GetFormId(child->end() + 1) : TOKEN_STOP;
-
-  CPID = child_sentence->GetPosId(child->head_index());
-  CfPID = child_sentence->GetPosId(child->start());
-  ClPID = child_sentence->GetPosId(child->end());
-  CpPID = (child->start() > 0) ?
-    child_sentence->GetPosId(child->start() - 1) : TOKEN_START;
-  CnPID = (child->end() < child_sentence->size() - 1) ?
-    child_sentence->GetPosId(child->end() + 1) : TOKEN_STOP;
-
-  if (parent) {
-    PWID = parent_sentence->GetFormId(parent->head_index());
-    PfWID = parent_sentence->GetFormId(parent->start());
-    PlWID = parent_sentence->GetFormId(parent->end());
-    PpWID = (parent->start() > 0) ?
-      parent_sentence->GetFormId(parent->start() - 1) : TOKEN_START;
-    PnWID = (parent->end() < parent_sentence->size() - 1) ?
-      parent_sentence->GetFormId(parent->end() + 1) : TOKEN_STOP;
-
-    PPID = parent_sentence->GetPosId(parent->head_index());
-    PfPID = parent_sentence->GetPosId(parent->start());
-    PlPID = parent_sentence->GetPosId(parent->end());
-    PpPID = (parent->start() > 0) ?
-      parent_sentence->GetPosId(parent->start() - 1) : TOKEN_START;
-    PnPID = (parent->end() < parent_sentence->size() - 1) ?
-      parent_sentence->GetPosId(parent->end() + 1) : TOKEN_STOP;
-  }
-
-  CA1ID = child->unigram_ancestry();
-  CA2ID = child->bigram_ancestry();
-  PA1ID = parent ? parent->unigram_ancestry() : 0xffff;
-  PA2ID = parent ? parent->bigram_ancestry() : 0xffff;
-
-  uint8_t parent_gender_code = 0xff;
-  uint8_t parent_number_code = 0xff;
-  if (parent) {
-    CHECK_LT(parent->gender(), 0xff);
-    parent_gender_code = parent->gender();
-    CHECK_LT(parent->number(), 0xff);
-    parent_number_code = parent->number();
-  }
+  ids->WID = sentence->GetFormId(mention->head_index());
+  ids->fWID = sentence->GetFormId(mention->start());
+  ids->lWID = sentence->GetFormId(mention->end());
+  ids->pWID = (mention->start() > 0) ?
+    sentence->GetFormId(mention->start() - 1) : TOKEN_START;
+  ids->nWID = (mention->end() < sentence->size() - 1) ?
+    sentence->GetFormId(mention->end() + 1) : TOKEN_STOP;
+
+  ids->PID = sentence->GetPosId(mention->head_index());
+  ids->fPID = sentence->GetPosId(mention->start());
+  ids->lPID = sentence->GetPosId(mention->end());
+  ids->pPID = (mention->start() > 0) ?
+    sentence->GetPosId(mention->start() - 1) : TOKEN_START;
+  ids->nPID = (mention->end() < sentence->size() - 1) ?
+    sentence->GetPosId(mention->end() + 1) : TOKEN_STOP;
+
+  ids->A1ID = mention->unigram_ancestry();
+  ids->A2ID = mention->bigram_ancestry();
+
+  CHECK_LT(mention->gender(), 0xff);
+  ids->gender_code = mention->gender();
+  CHECK_LT(mention->number(), 0xff);
+  ids->number_code = mention->number();
 
   int length_threshold = 20;
-  uint8_t child_length_code = 0xff;
-  int child_length = child->GetLength();
-  if (child_length > length_threshold) {
-    child_length_code = length_threshold;
+  int length = mention->GetLength();
+  if (length > length_threshold) {
+    ids->length_code = length_threshold;
   } else {
-    child_length_code = child_length;
-  }
-  uint8_t parent_length_code = 0xff;
-  if (parent) {
-    int parent_length = parent->GetLength();
-    if (parent_length > length_threshold) {
-      parent_length_code = length_threshold;
-    } else {
-      parent_length_code = parent_length;
-    }
-  }
-
-  uint8_t mention_distance_code = 0xff;
-  int mention_distance_threshold = 10;
-  if (parent) {
-    if (mention_distance > mention_distance_threshold) {
-      mention_distance_code = mention_distance_threshold;
-    } else {
-      mention_distance_code = mention_distance;
-    }
-  }
-
-  uint8_t sentence_distance_code = 0xff;
-  int sentence_distance_threshold = 10;
-  if (parent) {
-    if (sentence_distance > sentence_distance_threshold) {
-      sentence_distance_code = sentence_distance_threshold;
-    } else {
-      sentence_distance_code = sentence_distance;
-    }
+    ids->length_code = length;
   }
+}
 
-  uint8_t exact_match_code =
-    (parent && (parent->phrase_string_id() == child->phrase_string_id())) ?
-    0x1 : 0x0;
-  uint8_t head_match_code =
-    (parent && (parent->head_string_id() == child->head_string_id())) ?
-    0x1 : 0x0;
-
-  uint8_t child_contained_code =
-    (parent && (parent->ContainsMentionString(*child))) ? 0x1 : 0x0;
-  uint8_t child_head_contained_code =
-    (parent && (parent->ContainsMentionHead(*child))) ? 0x1 : 0x0;
-  uint8_t parent_contained_code =
-    (parent && (child->ContainsMentionString(*parent))) ? 0x1 : 0x0;
-  uint8_t parent_head_contained_code =
-    (parent && (child->ContainsMentionHead(*parent))) ? 0x1 : 0x0;
-
+void CoreferenceFeatures::AddChildFeatures(const MentionFeatureIds &c,
+                                           uint8_t flags,
+                                           BinaryFeatures *features) {
   uint64_t fkey;
-  uint8_t flags = 0x0;
-
-  flags |= CoreferenceFeatureTemplateParts::ARC; // At most 4 bits here.
-  if (parent) {
-    flags |= (0x1 << 4); // A bit indicating if the mention is non-anaphoric.
-  }
-
-  // Maximum is 255 feature templates.
-  CHECK_LT(CoreferenceFeatureTemplateArc::COUNT, 256);
 
   // Child length.
   fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Cl, flags,
-                               child_length_code);
+                               c.length_code);
   AddFeature(fkey, features);
   fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Cl_Ct, flags,
-                                CtID, child_length_code);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Cl_Ct_Pt, flags,
-                                 CtID, PtID, child_length_code);
+                                c.tID, c.length_code);
   AddFeature(fkey, features);
 
-  // Parent length.
-  if (parent) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pl, flags,
-                                 parent_length_code);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pl_Ct, flags,
-                                  CtID, parent_length_code);
+  // Child mention head word.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CW, flags,
+                                 c.WID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pl_Ct_Pt, flags,
-                                   CtID, PtID, parent_length_code);
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CW_Ct, flags,
+                                  c.WID, c.tID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention head word.
-  if (child->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CW, flags,
-                                 CWID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CW_Ct, flags,
-                                  CWID, CtID);
+  // Child mention first word.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CfW, flags,
+                                 c.fWID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CW_Ct_Pt, flags,
-                                   CWID, CtID, PtID);
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CfW_Ct, flags,
+                                  c.fWID, c.tID);
     AddFeature(fkey, features);
   }
-  if (parent && parent->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PW, flags,
-                                 PWID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PW_Ct, flags,
-                                  PWID, CtID);
+
+  // Child mention last word.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::ClW, flags,
+                                 c.lWID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PW_Ct_Pt, flags,
-                                   PWID, CtID, PtID);
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::ClW_Ct, flags,
+                                  c.lWID, c.tID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention first word.
-  if (child->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CfW, flags,
-                                 CfWID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CfW_Ct, flags,
-                                  CfWID, CtID);
+  // Child mention preceding word.
+  fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CpW, flags,
+                               c.pWID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CpW_Ct, flags,
+                                c.pWID, c.tID);
+  AddFeature(fkey, features);
+
+  // Child mention next word.
+  fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CnW, flags,
+                               c.nWID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CnW_Ct, flags,
+                                c.nWID, c.tID);
+  AddFeature(fkey, features);
+
+  // Child mention head tag.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CP, flags,
+                                 c.PID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CfW_Ct_Pt, flags,
-                                   CfWID, CtID, PtID);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CP_Ct, flags,
+                                  c.tID, c.PID);
     AddFeature(fkey, features);
   }
-  if (parent && parent->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PfW, flags,
-                                 PfWID);
+
+  // Child mention first tag.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CfP, flags,
+                                 c.fPID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PfW_Ct, flags,
-                                  PfWID, CtID);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CfP_Ct, flags,
+                                  c.tID, c.fPID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PfW_Ct_Pt, flags,
-                                   PfWID, CtID, PtID);
+  }
+
+  // Child mention last tag.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::ClP, flags,
+                                 c.lPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::ClP_Ct, flags,
+                                  c.tID, c.lPID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention last word.
-  if (child->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::ClW, flags,
-                                 ClWID);
+  // Child mention preceding tag.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CpP, flags,
+                               c.pPID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CpP_Ct, flags,
+                                c.tID, c.pPID);
+  AddFeature(fkey, features);
+
+  // Child mention next tag.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CnP, flags,
+                               c.nPID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CnP_Ct, flags,
+                                c.tID, c.nPID);
+  AddFeature(fkey, features);
+
+  if (kUseAncestryFeatures) {
+    // Child unigram and bigram ancestry.
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CA1, flags,
+                                 c.A1ID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::ClW_Ct, flags,
-                                  ClWID, CtID);
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CA1_Ct, flags,
+                                  c.A1ID, c.tID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::ClW_Ct_Pt, flags,
-                                   ClWID, CtID, PtID);
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CA2, flags,
+                                 c.A2ID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CA2_Ct, flags,
+                                  c.A2ID, c.tID);
     AddFeature(fkey, features);
   }
-  if (parent && parent->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PlW, flags,
-                                 PlWID);
+}
+
+void CoreferenceFeatures::AddChildParentTypeFeatures(
+  const MentionFeatureIds &c,
+  uint16_t PtID,
+  uint8_t flags,
+  BinaryFeatures *features) {
+  uint64_t fkey;
+
+  // Child length.
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Cl_Ct_Pt, flags,
+                                 c.tID, PtID, c.length_code);
+  AddFeature(fkey, features);
+
+  // Child mention head word.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CW_Ct_Pt, flags,
+                                   c.WID, c.tID, PtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PlW_Ct, flags,
-                                  PlWID, CtID);
+  }
+
+  // Child mention first word.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CfW_Ct_Pt, flags,
+                                   c.fWID, c.tID, PtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PlW_Ct_Pt, flags,
-                                   PlWID, CtID, PtID);
+  }
+
+  // Child mention last word.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::ClW_Ct_Pt, flags,
+                                   c.lWID, c.tID, PtID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention preceding word.
-  fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CpW, flags,
-                               CpWID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CpW_Ct, flags,
-                                CpWID, CtID);
-  AddFeature(fkey, features);
+  // Child mention preceding word.
   fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CpW_Ct_Pt, flags,
-                                 CpWID, CtID, PtID);
+                                 c.pWID, c.tID, PtID);
   AddFeature(fkey, features);
-  if (parent) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PpW, flags,
-                                 PpWID);
+
+  // Child mention next word.
+  fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CnW_Ct_Pt, flags,
+                                 c.nWID, c.tID, PtID);
+  AddFeature(fkey, features);
+
+  // Child mention head tag.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CP_Ct_Pt, flags,
+                                   c.tID, PtID, c.PID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PpW_Ct, flags,
-                                  PpWID, CtID);
+  }
+
+  // Child mention first tag.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CfP_Ct_Pt, flags,
+                                   c.tID, PtID, c.fPID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PpW_Ct_Pt, flags,
-                                   PpWID, CtID, PtID);
+  }
+
+  // Child mention last tag.
+  if (!c.pronominal) {
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::ClP_Ct_Pt, flags,
+                                   c.tID, PtID, c.lPID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention next word.
-  fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CnW, flags,
-                               CnWID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CnW_Ct, flags,
-                                CnWID, CtID);
+  // Child mention preceding tag.
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CpP_Ct_Pt, flags,
+                                 c.tID, PtID, c.pPID);
   AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CnW_Ct_Pt, flags,
-                                 CnWID, CtID, PtID);
+
+  // Child mention next tag.
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CnP_Ct_Pt, flags,
+                                 c.tID, PtID, c.nPID);
   AddFeature(fkey, features);
-  if (parent) {
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PnW, flags,
-                                 PnWID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PnW_Ct, flags,
-                                  PnWID, CtID);
+
+  if (kUseAncestryFeatures) {
+    // Child unigram and bigram ancestry.
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CA1_Ct_Pt, flags,
+                                   c.A1ID, c.tID, PtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PnW_Ct_Pt, flags,
-                                   PnWID, CtID, PtID);
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CA2_Ct_Pt, flags,
+                                   c.A2ID, c.tID, PtID);
     AddFeature(fkey, features);
   }
+}
 
-  // Parent/child mention head tag.
-  if (child->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CP, flags,
-                                 CPID);
+void CoreferenceFeatures::AddParentFeatures(const MentionFeatureIds &p,
+                                            uint8_t flags,
+                                            BinaryFeatures *features) {
+  uint64_t fkey;
+
+  // Parent length.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pl, flags,
+                               p.length_code);
+  AddFeature(fkey, features);
+
+  // Parent mention head word.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PW, flags,
+                                 p.WID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CP_Ct, flags,
-                                  CtID, CPID);
+  }
+
+  // Parent mention first word.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PfW, flags,
+                                 p.fWID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CP_Ct_Pt, flags,
-                                   CtID, PtID, CPID);
+  }
+
+  // Parent mention last word.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PlW, flags,
+                                 p.lWID);
     AddFeature(fkey, features);
   }
-  if (parent && parent->type() != MentionType::PRONOMINAL) {
+
+  // Parent mention preceding word.
+  fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PpW, flags,
+                               p.pWID);
+  AddFeature(fkey, features);
+
+  // Parent mention next word.
+  fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PnW, flags,
+                               p.nWID);
+  AddFeature(fkey, features);
+
+  // Parent mention head tag.
+  if (!p.pronominal) {
     fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PP, flags,
-                                 PPID);
+                                 p.PID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PP_Ct, flags,
-                                  CtID, PPID);
+  }
+
+  // Parent mention first tag.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PfP, flags,
+                                 p.fPID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PP_Ct_Pt, flags,
-                                   CtID, PtID, PPID);
+  }
+
+  // Parent mention last tag.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PlP, flags,
+                                 p.lPID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention first tag.
-  if (child->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CfP, flags,
-                                 CfPID);
+  // Parent mention preceding tag.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PpP, flags,
+                               p.pPID);
+  AddFeature(fkey, features);
+
+  // Parent mention next tag.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PnP, flags,
+                               p.nPID);
+  AddFeature(fkey, features);
+
+  if (kUseGenderNumberFeatures) {
+    // Parent gender and number.
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pg, flags,
+                                 p.gender_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CfP_Ct, flags,
-                                  CtID, CfPID);
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pn, flags,
+                                 p.number_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CfP_Ct_Pt, flags,
-                                   CtID, PtID, CfPID);
+  }
+
+  if (kUseAncestryFeatures) {
+    // Parent unigram and bigram ancestry.
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PA1, flags,
+                                 p.A1ID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PA2, flags,
+                                 p.A2ID);
     AddFeature(fkey, features);
   }
-  if (parent && parent->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PfP, flags,
-                                 PfPID);
+}
+
+void CoreferenceFeatures::AddParentChildTypeFeatures(
+  const MentionFeatureIds &p,
+  uint16_t CtID,
+  uint8_t flags,
+  BinaryFeatures *features) {
+  uint64_t fkey;
+  uint16_t PtID = p.tID;
+
+  // Parent length.
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pl_Ct, flags,
+                                CtID, p.length_code);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pl_Ct_Pt, flags,
+                                 CtID, PtID, p.length_code);
+  AddFeature(fkey, features);
+
+  // Parent mention head word.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PW_Ct, flags,
+                                  p.WID, CtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PfP_Ct, flags,
-                                  CtID, PfPID);
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PW_Ct_Pt, flags,
+                                   p.WID, CtID, PtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PfP_Ct_Pt, flags,
-                                   CtID, PtID, PfPID);
+  }
+
+  // Parent mention first word.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PfW_Ct, flags,
+                                  p.fWID, CtID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PfW_Ct_Pt, flags,
+                                   p.fWID, CtID, PtID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention last tag.
-  if (child->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::ClP, flags,
-                                 ClPID);
+  // Parent mention last word.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PlW_Ct, flags,
+                                  p.lWID, CtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::ClP_Ct, flags,
-                                  CtID, ClPID);
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PlW_Ct_Pt, flags,
+                                   p.lWID, CtID, PtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::ClP_Ct_Pt, flags,
-                                   CtID, PtID, ClPID);
+  }
+
+  // Parent mention preceding word.
+  fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PpW_Ct, flags,
+                                p.pWID, CtID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PpW_Ct_Pt, flags,
+                                 p.pWID, CtID, PtID);
+  AddFeature(fkey, features);
+
+  // Parent mention next word.
+  fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PnW_Ct, flags,
+                                p.nWID, CtID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PnW_Ct_Pt, flags,
+                                 p.nWID, CtID, PtID);
+  AddFeature(fkey, features);
+
+  // Parent mention head tag.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PP_Ct, flags,
+                                  CtID, p.PID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PP_Ct_Pt, flags,
+                                   CtID, PtID, p.PID);
     AddFeature(fkey, features);
   }
-  if (parent && parent->type() != MentionType::PRONOMINAL) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PlP, flags,
-                                 PlPID);
+
+  // Parent mention first tag.
+  if (!p.pronominal) {
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PfP_Ct, flags,
+                                  CtID, p.fPID);
     AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PfP_Ct_Pt, flags,
+                                   CtID, PtID, p.fPID);
+    AddFeature(fkey, features);
+  }
+
+  // Parent mention last tag.
+  if (!p.pronominal) {
     fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PlP_Ct, flags,
-                                  CtID, PlPID);
+                                  CtID, p.lPID);
     AddFeature(fkey, features);
     fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PlP_Ct_Pt, flags,
-                                   CtID, PtID, PlPID);
+                                   CtID, PtID, p.lPID);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention preceding tag.
-  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CpP, flags,
-                               CpPID);
+  // Parent mention preceding tag.
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PpP_Ct, flags,
+                                CtID, p.pPID);
   AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CpP_Ct, flags,
-                                CtID, CpPID);
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PpP_Ct_Pt, flags,
+                                 CtID, PtID, p.pPID);
   AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CpP_Ct_Pt, flags,
-                                 CtID, PtID, CpPID);
+
+  // Parent mention next tag.
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PnP_Ct, flags,
+                                CtID, p.nPID);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PnP_Ct_Pt, flags,
+                                 CtID, PtID, p.nPID);
   AddFeature(fkey, features);
-  if (parent) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PpP, flags,
-                                 PpPID);
+
+  if (kUseGenderNumberFeatures) {
+    // Parent gender and number.
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pg_Ct, flags,
+                                  CtID, p.gender_code);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pg_Ct_Pt, flags,
+                                   CtID, PtID, p.gender_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PpP_Ct, flags,
-                                  CtID, PpPID);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pn_Ct, flags,
+                                  CtID, p.number_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PpP_Ct_Pt, flags,
-                                   CtID, PtID, PpPID);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pn_Ct_Pt, flags,
+                                   CtID, PtID, p.number_code);
     AddFeature(fkey, features);
   }
 
-  // Parent/child mention next tag.
-  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::CnP, flags,
-                               CnPID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::CnP_Ct, flags,
-                                CtID, CnPID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::CnP_Ct_Pt, flags,
-                                 CtID, PtID, CnPID);
-  AddFeature(fkey, features);
-  if (parent) {
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::PnP, flags,
-                                 PnPID);
+  if (kUseAncestryFeatures) {
+    // Parent unigram and bigram ancestry.
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PA1_Ct, flags,
+                                  p.A1ID, CtID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PA1_Ct_Pt, flags,
+                                   p.A1ID, CtID, PtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::PnP_Ct, flags,
-                                  CtID, PnPID);
+    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PA2_Ct, flags,
+                                  p.A2ID, CtID);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::PnP_Ct_Pt, flags,
-                                   CtID, PtID, PnPID);
+    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PA2_Ct_Pt, flags,
+                                   p.A2ID, CtID, PtID);
     AddFeature(fkey, features);
+    // TODO(atm): implement joint child/parent ancestry.
   }
+}
 
-  if (use_gender_number_features) {
-    // Parent gender.
-    if (parent) {
-      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pg, flags,
-                                   parent_gender_code);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pg_Ct, flags,
-                                    CtID, parent_gender_code);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pg_Ct_Pt, flags,
-                                     CtID, PtID, parent_gender_code);
-      AddFeature(fkey, features);
-    }
+void CoreferenceFeatures::AddArcFeatures(CoreferenceDocumentNumeric* document,
+                                         int r,
+                                         int parent_mention,
+                                         int child_mention) {
+  CHECK(!input_features_[r]);
+  BinaryFeatures *features = new BinaryFeatures;
+  input_features_[r] = features;
 
-    // Parent number.
-    if (parent) {
-      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pn, flags,
-                                   parent_number_code);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pn_Ct, flags,
-                                    CtID, parent_number_code);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pn_Ct_Pt, flags,
-                                     CtID, PtID, parent_number_code);
-      AddFeature(fkey, features);
-    }
+  // Maximum is 255 feature templates.
+  CHECK_LT(CoreferenceFeatureTemplateArc::COUNT, 256);
+
+  // Mention properties were precomputed once per document by
+  // ComputeMentionFeatures(); here we only combine them.
+  CHECK_LT(child_mention, mention_ids_.size());
+  const MentionFeatureIds &c = mention_ids_[child_mention];
+  const MentionFeatureIds *p = (parent_mention >= 0) ?
+    &mention_ids_[parent_mention] : NULL;
+
+  if (!p) {
+    // Arc departing from the root: child features only.
+    features->reserve(2 * child_blocks_[child_mention].size());
+    AddChildFeatures(c, kRootArcFlags, features);
+    AddChildParentTypeFeatures(c, 0x0, kRootArcFlags, features);
+    return;
+  }
+
+  const BinaryFeatures &child_block = child_blocks_[child_mention];
+  const BinaryFeatures &parent_block = parent_blocks_[parent_mention];
+  features->reserve(2 * child_block.size() + 3 * parent_block.size() +
+                    kNumPairwiseFeatures);
+  features->insert(features->end(), child_block.begin(), child_block.end());
+  features->insert(features->end(), parent_block.begin(), parent_block.end());
+
+  uint8_t flags = kMentionArcFlags;
+  uint16_t CtID = c.tID;
+  uint16_t PtID = p->tID;
+  AddChildParentTypeFeatures(c, PtID, flags, features);
+  AddParentChildTypeFeatures(*p, CtID, flags, features);
+
+  // Pairwise properties.
+  const vector<Mention*> &mentions = document->GetMentions();
+  Mention *parent = mentions[parent_mention];
+  Mention *child = mentions[child_mention];
+  int sentence_distance = child->sentence_index() - parent->sentence_index();
+  int mention_distance = child_mention - parent_mention;
+
+  bool nested = false;
+  if (child->sentence_index() == parent->sentence_index() &&
+      (child->LiesInsideSpan(*parent) || parent->LiesInsideSpan(*child))) {
+    nested = true;
   }
+  uint8_t nested_flag = 0x0;
+  if (nested) nested_flag = 0x1;
 
-  if (use_ancestry_features) {
-    // Child unigram ancestry.
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CA1, flags,
-                                 CA1ID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CA1_Ct, flags,
-                                  CA1ID, CtID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CA1_Ct_Pt, flags,
-                                   CA1ID, CtID, PtID);
-    AddFeature(fkey, features);
-    if (parent) {
-      // Parent unigram ancestry.
-      fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PA1, flags,
-                                   PA1ID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PA1_Ct, flags,
-                                    PA1ID, CtID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PA1_Ct_Pt, flags,
-                                     PA1ID, CtID, PtID);
-      AddFeature(fkey, features);
-    }
+  bool same_speaker = (child->speaker_id() == parent->speaker_id());
+  bool conversation = document->is_conversation();
+  uint8_t speaker_flag = 0x0;
+  if (conversation) speaker_flag |= 0x1;
+  if (!same_speaker) speaker_flag |= 0x1 << 1;
 
-    // Child bigram ancestry.
-    fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::CA2, flags,
-                                 CA2ID);
+  uint8_t mention_distance_code = 0xff;
+  int mention_distance_threshold = 10;
+  if (mention_distance > mention_distance_threshold) {
+    mention_distance_code = mention_distance_threshold;
+  } else {
+    mention_distance_code = mention_distance;
+  }
+
+  uint8_t sentence_distance_code = 0xff;
+  int sentence_distance_threshold = 10;
+  if (sentence_distance > sentence_distance_threshold) {
+    sentence_distance_code = sentence_distance_threshold;
+  } else {
+    sentence_distance_code = sentence_distance;
+  }
+
+  // Head and phrase strings are interned per document, so these are integer
+  // compares.
+  uint8_t exact_match_code =
+    (parent->phrase_string_id() == child->phrase_string_id()) ? 0x1 : 0x0;
+  uint8_t head_match_code =
+    (parent->head_string_id() == child->head_string_id()) ? 0x1 : 0x0;
+
+  uint8_t child_contained_code = 0x0;
+  uint8_t child_head_contained_code = 0x0;
+  uint8_t parent_contained_code = 0x0;
+  uint8_t parent_head_contained_code = 0x0;
+  if (kUseContainedFeatures && !c.pronominal) {
+    if (parent->ContainsMentionString(*child)) child_contained_code = 0x1;
+    if (parent->ContainsMentionHead(*child)) child_head_contained_code = 0x1;
+    if (child->ContainsMentionString(*parent)) parent_contained_code = 0x1;
+    if (child->ContainsMentionHead(*parent)) parent_head_contained_code = 0x1;
+  }
+
+  uint64_t fkey;
+
+  if (kUseNestedFeature) {
+    // True if mentions are nested.
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::nest, flags,
+                                 nested_flag);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::CA2_Ct, flags,
-                                  CA2ID, CtID);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::nest_Ct, flags,
+                                  CtID, nested_flag);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::CA2_Ct_Pt, flags,
-                                   CA2ID, CtID, PtID);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::nest_Ct_Pt, flags,
+                                   CtID, PtID, nested_flag);
     AddFeature(fkey, features);
-    if (parent) {
-      // Parent bigram ancestry.
-      fkey = encoder_.CreateFKey_W(CoreferenceFeatureTemplateArc::PA2, flags,
-                                   PA2ID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WW(CoreferenceFeatureTemplateArc::PA2_Ct, flags,
-                                    PA2ID, CtID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWW(CoreferenceFeatureTemplateArc::PA2_Ct_Pt, flags,
-                                     PA2ID, CtID, PtID);
-      AddFeature(fkey, features);
-    }
-    // TODO(atm): implement joint child/parent ancestry.
   }
 
-  if (use_nested_feature) {
-    if (parent) {
-      // True if mentions are nested.
-      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::nest, flags,
-                                   nested_flag);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::nest_Ct, flags,
-                                    CtID, nested_flag);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::nest_Ct_Pt, flags,
-                                     CtID, PtID, nested_flag);
-      AddFeature(fkey, features);
-    }
-  }
-
-  if (use_speaker_feature) {
-    if (parent && parent->type() == MentionType::PRONOMINAL) {
+  if (kUseSpeakerFeature) {
+    if (p->pronominal) {
       // Speaker code (different speaker + document type).
       fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::speak, flags,
                                    speaker_flag);
@@ -597,97 +677,95 @@ void CoreferenceFeatures::AddArcFeatures(CoreferenceDocumentNumeric* document,
     }
   }
 
-  if (parent) {
-    // Mention distance.
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::md, flags,
-                                 mention_distance_code);
+  // Mention distance.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::md, flags,
+                               mention_distance_code);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::md_Ct, flags,
+                                CtID, mention_distance_code);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::md_Ct_Pt, flags,
+                                 CtID, PtID, mention_distance_code);
+  AddFeature(fkey, features);
+
+  // Sentence distance.
+  fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::sd, flags,
+                               sentence_distance_code);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::sd_Ct, flags,
+                                CtID, sentence_distance_code);
+  AddFeature(fkey, features);
+  fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::sd_Ct_Pt, flags,
+                                 CtID, PtID, sentence_distance_code);
+  AddFeature(fkey, features);
+
+  if (!c.pronominal) {
+    // Head match.
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::hm, flags,
+                                 head_match_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::md_Ct, flags,
-                                  CtID, mention_distance_code);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::hm_Ct, flags,
+                                  CtID, head_match_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::md_Ct_Pt, flags,
-                                   CtID, PtID, mention_distance_code);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::hm_Ct_Pt, flags,
+                                   CtID, PtID, head_match_code);
     AddFeature(fkey, features);
 
-    // Sentence distance.
-    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::sd, flags,
-                                 sentence_distance_code);
+    // Exact match.
+    fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::em, flags,
+                                 exact_match_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::sd_Ct, flags,
-                                  CtID, sentence_distance_code);
+    fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::em_Ct, flags,
+                                  CtID, exact_match_code);
     AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::sd_Ct_Pt, flags,
-                                   CtID, PtID, sentence_distance_code);
+    fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::em_Ct_Pt, flags,
+                                   CtID, PtID, exact_match_code);
     AddFeature(fkey, features);
 
-    if (child->type() != MentionType::PRONOMINAL) {
-      // Head match.
-      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::hm, flags,
-                                   head_match_code);
+    if (kUseContainedFeatures) {
+      // Child head contained.
+      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Chc, flags,
+                                   child_head_contained_code);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Chc_Ct, flags,
+                                    CtID, child_head_contained_code);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Chc_Ct_Pt, flags,
+                                     CtID, PtID, child_head_contained_code);
+      AddFeature(fkey, features);
+
+      // Parent head contained.
+      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Phc, flags,
+                                   parent_head_contained_code);
       AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::hm_Ct, flags,
-                                    CtID, head_match_code);
+      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Phc_Ct, flags,
+                                    CtID, parent_head_contained_code);
       AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::hm_Ct_Pt, flags,
-                                     CtID, PtID, head_match_code);
+      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Phc_Ct_Pt, flags,
+                                     CtID, PtID, parent_head_contained_code);
       AddFeature(fkey, features);
 
-      // Exact match.
-      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::em, flags,
-                                   exact_match_code);
+      // Exact child contained.
+      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Cec, flags,
+                                   child_contained_code);
       AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::em_Ct, flags,
-                                    CtID, exact_match_code);
+      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Cec_Ct, flags,
+                                    CtID, child_contained_code);
       AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::em_Ct_Pt, flags,
-                                     CtID, PtID, exact_match_code);
+      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Cec_Ct_Pt, flags,
+                                     CtID, PtID, child_contained_code);
       AddFeature(fkey, features);
 
-      if (use_contained_features) {
-        // Child head contained.
-        fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Chc, flags,
-                                     child_head_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Chc_Ct, flags,
-                                      CtID, child_head_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Chc_Ct_Pt, flags,
-                                       CtID, PtID, child_head_contained_code);
-        AddFeature(fkey, features);
-
-        // Parent head contained.
-        fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Phc, flags,
-                                     parent_head_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Phc_Ct, flags,
-                                      CtID, parent_head_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Phc_Ct_Pt, flags,
-                                       CtID, PtID, parent_head_contained_code);
-        AddFeature(fkey, features);
-
-        // Exact child contained.
-        fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Cec, flags,
-                                     child_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Cec_Ct, flags,
-                                      CtID, child_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Cec_Ct_Pt, flags,
-                                       CtID, PtID, child_contained_code);
-        AddFeature(fkey, features);
-
-        // Exact parent contained.
-        fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pec, flags,
-                                     parent_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pec_Ct, flags,
-                                      CtID, parent_contained_code);
-        AddFeature(fkey, features);
-        fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pec_Ct_Pt, flags,
-                                       CtID, PtID, parent_contained_code);
-        AddFeature(fkey, features);
-      }
+      // Exact parent contained.
+      fkey = encoder_.CreateFKey_P(CoreferenceFeatureTemplateArc::Pec, flags,
+                                   parent_contained_code);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_WP(CoreferenceFeatureTemplateArc::Pec_Ct, flags,
+                                    CtID, parent_contained_code);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_WWP(CoreferenceFeatureTemplateArc::Pec_Ct_Pt, flags,
+                                     CtID, PtID, parent_contained_code);
+      AddFeature(fkey, features);
     }
   }
 }
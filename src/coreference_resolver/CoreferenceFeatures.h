@@ -25,6 +25,19 @@
 
 class CoreferenceOptions;
 
+// Properties of a single mention used by the arc features (type, words and
+// tags around the mention, ancestry, gender/number and length codes).
+struct MentionFeatureIds {
+  uint16_t tID; // "Canonical pronoun" type.
+  uint16_t WID, fWID, lWID, pWID, nWID; // Head, first, last, prev, next words.
+  uint8_t PID, fPID, lPID, pPID, nPID; // Head, first, last, prev, next tags.
+  uint16_t A1ID, A2ID; // Unigram and bigram ancestry.
+  uint8_t gender_code;
+  uint8_t number_code;
+  uint8_t length_code;
+  bool pronominal;
+};
+
 class CoreferenceFeatures : public Features {
 public:
   CoreferenceFeatures() {};
@@ -40,6 +53,9 @@ public:
       input_features_[r] = NULL;
     }
     input_features_.clear();
+    mention_ids_.clear();
+    child_blocks_.clear();
+    parent_blocks_.clear();
   }
 
   void Initialize(Instance *instance, Parts *parts) {
@@ -63,7 +79,15 @@ public:
     return input_features_[r];
   };
 
+  int64_t GetNumFeatures() const { return CountFeatures(input_features_); }
+  int64_t GetNumBytes() const { return CountFeatureBytes(input_features_); }
+
 public:
+  // Precompute the properties of each mention in the document, along with the
+  // features that only depend on the child or only on the parent of an arc.
+  // Must be called after Initialize() and before AddArcFeatures().
+  void ComputeMentionFeatures(CoreferenceDocumentNumeric *document);
+
   void AddArcFeatures(CoreferenceDocumentNumeric *document,
                       int r,
                       int parent_mention,
@@ -73,8 +97,33 @@ public:
     features->push_back(fkey);
   }
 
+protected:
+  void ComputeMentionFeatureIds(CoreferenceDocumentNumeric *document,
+                                Mention *mention,
+                                MentionFeatureIds *ids);
+
+  // Features of the child mention alone.
+  void AddChildFeatures(const MentionFeatureIds &c, uint8_t flags,
+                        BinaryFeatures *features);
+
+  // Features of the child mention conjoined with the parent type.
+  void AddChildParentTypeFeatures(const MentionFeatureIds &c, uint16_t PtID,
+                                  uint8_t flags, BinaryFeatures *features);
+
+  // Features of the parent mention alone.
+  void AddParentFeatures(const MentionFeatureIds &p, uint8_t flags,
+                         BinaryFeatures *features);
+
+  // Features of the parent mention conjoined with the child type.
+  void AddParentChildTypeFeatures(const MentionFeatureIds &p, uint16_t CtID,
+                                  uint8_t flags, BinaryFeatures *features);
+
 protected:
   vector<BinaryFeatures*> input_features_; // Vector of input features.
+  // Per-mention properties and feature blocks, computed once per document.
+  vector<MentionFeatureIds> mention_ids_;
+  vector<BinaryFeatures> child_blocks_;
+  vector<BinaryFeatures> parent_blocks_;
   FeatureEncoder encoder_; // Encoder that converts features into a codeword.
 };
 
@@ -54,6 +54,19 @@ DEFINE_double(false_new_cost, 3.0, "Cost of predicting new cluster when it "
 DEFINE_double(false_wrong_link_cost, 1.0, "Cost of predicting an antecedent "
               "which is not coreferent (but assuming it is actually "
               "anaphoric.");
+DEFINE_bool(coreference_streaming, false,
+            "If true, resolve coreferences incrementally at test time: "
+            "sentences are fed one at a time and mentions are only linked to "
+            "antecedents in a bounded window (see "
+            "--coreference_window_sentences and "
+            "--coreference_window_mentions). Sentences are written as soon as "
+            "they leave the window, so memory does not grow with the "
+            "document size. Cannot be used with --evaluate.");
+DEFINE_int32(coreference_window_sentences, 20,
+             "Maximum number of active sentences in streaming mode.");
+DEFINE_int32(coreference_window_mentions, 200,
+             "Maximum number of candidate antecedents for a mention in "
+             "streaming mode.");
 
 // Save current option flags to the model file.
 void CoreferenceOptions::Save(FILE* fs) {
@@ -136,4 +149,7 @@ void CoreferenceOptions::Initialize() {
   false_anaphor_cost_ = FLAGS_false_anaphor_cost;
   false_new_cost_ = FLAGS_false_new_cost;
   false_wrong_link_cost_ = FLAGS_false_wrong_link_cost;
+  streaming_ = FLAGS_coreference_streaming;
+  window_sentences_ = FLAGS_coreference_window_sentences;
+  window_mentions_ = FLAGS_coreference_window_mentions;
 }
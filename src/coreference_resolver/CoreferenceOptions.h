@@ -55,6 +55,9 @@ public:
   double false_anaphor_cost() { return false_anaphor_cost_; }
   double false_new_cost() { return false_new_cost_; }
   double false_wrong_link_cost() { return false_wrong_link_cost_; }
+  bool streaming() { return streaming_; }
+  int window_sentences() { return window_sentences_; }
+  int window_mentions() { return window_mentions_; }
 
 protected:
   std::string file_mention_tags_;
@@ -68,6 +71,11 @@ protected:
   double false_anaphor_cost_;
   double false_new_cost_;
   double false_wrong_link_cost_;
+  // Streaming mode: sentences are resolved left-to-right against a bounded
+  // window of active sentences/mentions, instead of whole documents.
+  bool streaming_;
+  int window_sentences_;
+  int window_mentions_;
 };
 
 #endif // COREFERENCE_OPTIONS_H_
@@ -21,6 +21,7 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <deque>
 
 // Define the current model version and the oldest back-compatible version.
 // The format is AAAA.BBBB.CCCC, e.g., 2 0003 0000 means "2.3.0".
@@ -228,6 +229,26 @@ void CoreferencePipe::MakeParts(Instance *instance,
   coreference_parts->SetMentions(mentions);
 }
 
+void CoreferencePipe::MakePartsStreaming(
+  CoreferenceDocumentNumeric *document,
+  int first_mention,
+  int max_antecedents,
+  CoreferenceParts *coreference_parts) {
+  coreference_parts->Initialize();
+  const std::vector<Mention*> &mentions = document->GetMentions();
+  for (int j = first_mention; j < mentions.size(); ++j) {
+    // Arc departing from the artificial root (non-anaphoric mention).
+    Part *part = coreference_parts->CreatePartArc(-1, j);
+    coreference_parts->push_back(part);
+    for (int k = std::max(0, j - max_antecedents); k < j; ++k) {
+      part = coreference_parts->CreatePartArc(k, j);
+      coreference_parts->push_back(part);
+    }
+  }
+  coreference_parts->BuildIndices(mentions.size());
+  coreference_parts->SetMentions(mentions);
+}
+
 void CoreferencePipe::MakeSelectedFeatures(
   Instance *instance,
   Parts *parts,
@@ -242,6 +263,7 @@ void CoreferencePipe::MakeSelectedFeatures(
   const std::vector<Mention*> &mentions = document->GetMentions();
 
   coreference_features->Initialize(instance, parts);
+  coreference_features->ComputeMentionFeatures(document);
 
   // Build features for coreference arcs.
   for (int r = 0; r < coreference_parts->size(); ++r) {
@@ -309,3 +331,147 @@ void CoreferencePipe::LabelInstance(Parts *parts,
   LOG(INFO) << "Predicted " << num_entities << " entities for " << mentions.size()
     << " mentions.";
 }
+
+void CoreferencePipe::RunStreaming() {
+  CoreferenceOptions *options = GetCoreferenceOptions();
+  CHECK(!options->train()) << "Streaming mode is only available at test time.";
+  // The gold coreference spans are discarded as the sentences are read, so
+  // there is nothing to evaluate against.
+  CHECK(!options->evaluate())
+    << "Evaluation is not available in streaming mode "
+    << "(--coreference_streaming).";
+  CHECK(!IsTestCorpus(options_->GetTestFilePath()))
+    << "Coreference documents cannot be read from a test corpus.";
+  int max_sentences = options->window_sentences();
+  int max_antecedents = options->window_mentions();
+  CHECK_GT(max_sentences, 0);
+  CHECK_GT(max_antecedents, 0);
+
+  CoreferenceParts *parts = static_cast<CoreferenceParts*>(CreateParts());
+  Features *features = CreateFeatures();
+  std::vector<double> scores;
+
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  CoreferenceReader *reader = GetCoreferenceReader();
+  CoreferenceWriter *writer = static_cast<CoreferenceWriter*>(writer_);
+  reader->Open(options_->GetTestFilePath());
+  writer->Open(options_->GetOutputFilePath());
+
+  int num_instances = 0;
+  std::string name;
+  int part_number;
+  while (reader->BeginDocument(&name, &part_number)) {
+    // Use an empty document to determine if this is a conversation.
+    CoreferenceDocument header;
+    header.Initialize(name, part_number,
+                      std::vector<CoreferenceSentence*>(0));
+    CoreferenceDocumentNumeric document;
+    document.BeginIncremental(header.is_conversation());
+    writer->BeginDocument(name, part_number);
+
+    // Active sentences with their number of mentions, and the predicted
+    // entity of each active mention. Entity sizes are kept for the whole
+    // document to tell singletons apart.
+    std::deque<CoreferenceSentence*> sentences;
+    std::deque<int> sentence_num_mentions;
+    std::deque<int> mention_entities;
+    std::vector<int> entity_sizes;
+    int num_mentions = 0;
+
+    CoreferenceSentence *sentence = reader->GetNextSentence();
+    while (true) {
+      if (sentence) {
+        int first_mention = document.GetMentions().size();
+        document.AddSentence(*GetCoreferenceDictionary(), sentence);
+        sentence->ClearCoreferenceSpans();
+        sentences.push_back(sentence);
+
+        MakePartsStreaming(&document, first_mention, max_antecedents, parts);
+        MakeFeatures(&document, parts, features);
+        Pipe::ComputeScores(&document, parts, features, &scores);
+
+        // Pick the best antecedent for each new mention.
+        int num_active_mentions = document.GetMentions().size();
+        for (int j = first_mention; j < num_active_mentions; ++j) {
+          const std::vector<int> &arcs = parts->FindArcParts(j);
+          int best = -1;
+          for (int k = 0; k < arcs.size(); ++k) {
+            if (best < 0 || scores[arcs[k]] > scores[best]) best = arcs[k];
+          }
+          CHECK_GE(best, 0);
+          int i = static_cast<CoreferencePartArc*>((*parts)[best])->
+            parent_mention();
+          int entity;
+          if (i < 0) {
+            // Non-anaphoric mention; create a new entity.
+            entity = entity_sizes.size();
+            entity_sizes.push_back(1);
+          } else {
+            entity = mention_entities[i];
+            ++entity_sizes[entity];
+          }
+          mention_entities.push_back(entity);
+        }
+        sentence_num_mentions.push_back(num_active_mentions - first_mention);
+        num_mentions += num_active_mentions - first_mention;
+      }
+
+      // Evict sentences that fell out of the window (or all of them, at the
+      // end of the document). A sentence is also evicted early when none of
+      // its mentions can be an antecedent anymore.
+      while (!sentences.empty()) {
+        int num_first = sentence_num_mentions.front();
+        int num_sentences = sentences.size();
+        int num_active_mentions = mention_entities.size();
+        bool evict = !sentence || num_sentences > max_sentences ||
+          (num_sentences > 1 &&
+           num_active_mentions - num_first >= max_antecedents);
+        if (!evict) break;
+
+        CoreferenceSentence *first_sentence = sentences.front();
+        const std::vector<Mention*> &mentions = document.GetMentions();
+        for (int j = 0; j < num_first; ++j) {
+          int entity = mention_entities[j];
+          if (entity_sizes[entity] <= 1) continue;
+          // Not a singleton cluster; add coreference span.
+          std::ostringstream ss;
+          ss << entity;
+          NamedSpan span(mentions[j]->start(), mentions[j]->end(), ss.str());
+          first_sentence->AddCoreferenceSpan(span);
+        }
+        writer->WriteSentence(first_sentence);
+        delete first_sentence;
+        sentences.pop_front();
+        sentence_num_mentions.pop_front();
+        mention_entities.erase(mention_entities.begin(),
+                               mention_entities.begin() + num_first);
+        document.RemoveFirstSentence();
+      }
+
+      if (!sentence) break;
+      sentence = reader->GetNextSentence();
+    }
+
+    writer->EndDocument();
+
+    int num_entities = 0;
+    for (int k = 0; k < entity_sizes.size(); ++k) {
+      if (entity_sizes[k] > 1) ++num_entities;
+    }
+    LOG(INFO) << "Predicted " << num_entities << " entities for "
+      << num_mentions << " mentions.";
+    ++num_instances;
+  }
+
+  delete parts;
+  delete features;
+
+  writer->Close();
+  reader->Close();
+
+  gettimeofday(&end, NULL);
+  LOG(INFO) << "Number of instances: " << num_instances;
+  LOG(INFO) << "Time: " << diff_ms(end, start);
+}
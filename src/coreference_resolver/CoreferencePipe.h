@@ -62,6 +62,11 @@ public:
     return static_cast<DependencyDictionary*>(dependency_dictionary_);
   };
 
+  // Resolve coreference in a single left-to-right pass over each document,
+  // keeping only a bounded window of sentences and mentions in memory.
+  // Each new mention is linked greedily to its best antecedent in the window.
+  void RunStreaming();
+
 protected:
   void CreateDictionary() {
     dictionary_ = new CoreferenceDictionary(this);
@@ -100,6 +105,13 @@ protected:
     return instance_numeric;
   }
 
+  // Number of candidate mentions of a document (the number of parts grows
+  // with it).
+  int GetInstanceLength(Instance *formatted_instance) {
+    return static_cast<CoreferenceDocumentNumeric*>(formatted_instance)->
+      GetMentions().size();
+  }
+
 protected:
   void SaveModel(FILE* fs);
   void LoadModel(FILE* fs);
@@ -107,6 +119,13 @@ protected:
   void MakeParts(Instance *instance, Parts *parts,
                  std::vector<double> *gold_outputs);
 
+  // Create the parts for the mentions starting at first_mention, with
+  // candidate antecedents among the previous max_antecedents mentions.
+  void MakePartsStreaming(CoreferenceDocumentNumeric *document,
+                          int first_mention,
+                          int max_antecedents,
+                          CoreferenceParts *coreference_parts);
+
   void MakeSelectedFeatures(Instance *instance, Parts *parts,
                             const std::vector<bool> &selected_parts,
                             Features *features);
@@ -23,6 +23,86 @@
 #include <iostream>
 #include <sstream>
 
+void CoreferenceReader::ParseDocumentHeader(const std::string &line,
+                                            std::string *name,
+                                            int *part_number) {
+  // Extract name.
+  size_t start = line.find("(");
+  size_t end = line.find(")");
+  CHECK_NE(start, std::string::npos);
+  CHECK_NE(end, std::string::npos);
+  CHECK_LT(start, end);
+  CHECK_LT(end + 1, line.size());
+  CHECK_EQ(line[end + 1], ';');
+  *name = line.substr(start + 1, end - start - 1); // Document id.
+  // Extract part number.
+  start = line.find("part ");
+  CHECK_NE(start, std::string::npos);
+  start += 5;
+  end = line.find_first_not_of("0123456789", start);
+  if (end == std::string::npos) end = line.length();
+  CHECK_LT(start, end);
+  std::string part_name = line.substr(start, end - start);
+  std::stringstream ss(part_name);
+  *part_number = 0;
+  ss >> *part_number; // Document part number.
+}
+
+bool CoreferenceReader::ReadLine(std::string *line) {
+  if (has_pending_line_) {
+    *line = pending_line_;
+    has_pending_line_ = false;
+    return true;
+  }
+  if (is_.eof()) return false;
+  getline(is_, *line);
+  return true;
+}
+
+bool CoreferenceReader::BeginDocument(std::string *name, int *part_number) {
+  std::string line;
+  if (!is_.is_open()) return false;
+  document_ended_ = false;
+  while (ReadLine(&line)) {
+    // E.g. "#begin document (nw/wsj/02/wsj_0242); part 000"
+    if (0 == line.substr(0, 6).compare("#begin")) {
+      ParseDocumentHeader(line, name, part_number);
+      return true;
+    }
+  }
+  return false;
+}
+
+CoreferenceSentence *CoreferenceReader::GetNextSentence() {
+  std::vector<std::vector<std::string> > sentence_fields;
+  std::string line;
+  if (document_ended_) return NULL;
+  while (ReadLine(&line)) {
+    if (0 == line.substr(0, 4).compare("#end")) {
+      // End of document.
+      document_ended_ = true;
+      break;
+    }
+    if (0 == line.substr(0, 6).compare("#begin")) {
+      // Missing "#end document": leave the header of the next document.
+      PutBackLine(line);
+      document_ended_ = true;
+      break;
+    }
+    if (line.length() == 0) {
+      // End of sentence (skip blank lines between sentences).
+      if (sentence_fields.size() > 0) break;
+      continue;
+    }
+    if (0 == line.substr(0, 1).compare("#")) continue;
+    std::vector<std::string> fields;
+    StringSplit(line, "\t ", &fields, true);
+    sentence_fields.push_back(fields);
+  }
+  if (sentence_fields.size() == 0) return NULL;
+  return sentence_reader_.CreateSentence(sentence_fields);
+}
+
 Instance *CoreferenceReader::GetNext() {
   int num_sentences = 0;
   std::string line;
@@ -35,28 +115,7 @@ Instance *CoreferenceReader::GetNext() {
       getline(is_, line);
       // E.g. "#begin document (nw/wsj/02/wsj_0242); part 000"
       if (0 == line.substr(0, 6).compare("#begin")) {
-        name = line;
-        part_number = 0;
-        // Extract name.
-        size_t start = line.find("(");
-        size_t end = line.find(")");
-        CHECK_NE(start, std::string::npos);
-        CHECK_NE(end, std::string::npos);
-        CHECK_LT(start, end);
-        CHECK_LT(end + 1, line.size());
-        CHECK_EQ(line[end + 1], ';');
-        name = line.substr(start + 1, end - start - 1); // Document id.
-        // Extract part number.
-        start = line.find("part ");
-        CHECK_NE(start, std::string::npos);
-        start += 5;
-        end = line.find_first_not_of("0123456789", start);
-        if (end == std::string::npos) end = line.length();
-        CHECK_LT(start, end);
-        std::string part_name = line.substr(start, end - start);
-        std::stringstream ss(part_name);
-        ss >> part_number; // Document part number.
-
+        ParseDocumentHeader(line, &name, &part_number);
         //LOG(INFO) << "Document: " << name << " Part: " << part_number;
         CHECK(!found_begin);
         CHECK(!found_end);
@@ -98,8 +157,6 @@ Instance *CoreferenceReader::GetNext() {
 
 Instance *CoreferenceSentenceReader::GetNext() {
   // Fill all fields for the entire sentence.
-  std::string name = "";
-  //int part_number = 0;
   std::vector<std::vector<std::string> > sentence_fields;
   std::string line;
 
@@ -119,6 +176,14 @@ Instance *CoreferenceSentenceReader::GetNext() {
 
   bool read_next_sentence = false;
   if (!is_.eof()) read_next_sentence = true;
+  if (!read_next_sentence) return NULL;
+
+  return static_cast<Instance*>(CreateSentence(sentence_fields));
+}
+
+CoreferenceSentence *CoreferenceSentenceReader::CreateSentence(
+  const std::vector<std::vector<std::string> > &sentence_fields) {
+  std::string name = "";
 
   // Sentence length.
   int length = sentence_fields.size();
@@ -301,16 +366,13 @@ Instance *CoreferenceSentenceReader::GetNext() {
   }
 #endif
 
-  CoreferenceSentence *instance = NULL;
-  if (read_next_sentence && length >= 0) {
-    instance = new CoreferenceSentence;
-    instance->Initialize(name, forms, lemmas, cpos, pos, feats, deprels, heads,
-                         predicate_names, predicate_indices, argument_roles,
-                         argument_indices, author_info, entity_spans,
-                         constituent_spans, coreference_spans);
-  }
+  CoreferenceSentence *instance = new CoreferenceSentence;
+  instance->Initialize(name, forms, lemmas, cpos, pos, feats, deprels, heads,
+                       predicate_names, predicate_indices, argument_roles,
+                       argument_indices, author_info, entity_spans,
+                       constituent_spans, coreference_spans);
 
-  return static_cast<Instance*>(instance);
+  return instance;
 }
 
 void CoreferenceSentenceReader::ConstructSpansFromText(
@@ -42,6 +42,10 @@ public:
   Instance *GetNext();
   void set_options(Options *options) { options_ = options; }
 
+  // Build a sentence from the fields of its lines (one vector per token).
+  CoreferenceSentence *CreateSentence(
+    const std::vector<std::vector<std::string> > &sentence_fields);
+
 protected:
   void ConstructSpansFromText(const std::vector<std::string> &span_lines,
                               std::vector<NamedSpan*> *spans);
@@ -57,10 +61,14 @@ class CoreferenceReader : public Reader {
 public:
   CoreferenceReader() {
     options_ = NULL;
+    document_ended_ = false;
+    has_pending_line_ = false;
   }
   CoreferenceReader(Options *options) {
     options_ = options;
     sentence_reader_.set_options(options);
+    document_ended_ = false;
+    has_pending_line_ = false;
   }
   virtual ~CoreferenceReader() {}
 
@@ -68,6 +76,8 @@ public:
   void Open(const string &filepath) {
     Reader::Open(filepath);
     sentence_reader_.Open(filepath);
+    document_ended_ = false;
+    has_pending_line_ = false;
   }
   void Close() {
     Reader::Close();
@@ -75,11 +85,39 @@ public:
   }
   Instance *GetNext();
 
+  // Incremental (streaming) interface, which only uses the main stream.
+  // BeginDocument skips to the next "#begin document" line and returns false
+  // if there are no more documents; GetNextSentence returns the next sentence
+  // in the current document, or NULL when the document ends (at an
+  // "#end document" line, or at the "#begin document" line of the next
+  // document, which is left for BeginDocument), until BeginDocument is called
+  // again.
+  bool BeginDocument(std::string *name, int *part_number);
+  CoreferenceSentence *GetNextSentence();
+
   CoreferenceSentenceReader *GetSentenceReader() { return &sentence_reader_; }
 
+protected:
+  // Extract the document name and part number from a header line, e.g.
+  // "#begin document (nw/wsj/02/wsj_0242); part 000".
+  void ParseDocumentHeader(const std::string &line, std::string *name,
+                           int *part_number);
+
+  // Read the next line of the main stream, or the line put back by
+  // PutBackLine. Returns false at the end of the stream.
+  bool ReadLine(std::string *line);
+  void PutBackLine(const std::string &line) {
+    CHECK(!has_pending_line_);
+    pending_line_ = line;
+    has_pending_line_ = true;
+  }
+
 protected:
   CoreferenceSentenceReader sentence_reader_;
   Options *options_;
+  bool document_ended_; // True after the end of the current document.
+  bool has_pending_line_; // True if pending_line_ was put back.
+  std::string pending_line_;
 };
 
 #endif /* COREFERENCEREADER_H_ */
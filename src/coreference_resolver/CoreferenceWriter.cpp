@@ -23,23 +23,39 @@
 
 void CoreferenceWriter::Write(Instance *instance) {
   CoreferenceDocument *document = static_cast<CoreferenceDocument*>(instance);
-  char part_number[4];
-
-#ifdef _WIN32
-  _snprintf(part_number, sizeof(part_number), "%03d", document->part_number());
-#else
-  snprintf(part_number, sizeof(part_number), "%03d", document->part_number());
-#endif
 
   //std::cout << "Document: " << document->name() << std::endl;
 
-  os_ << "#begin document (" << document->name() << "); part "
-    << part_number << std::endl;
+  BeginDocument(document->name(), document->part_number());
   for (int i = 0; i < document->GetNumSentences(); ++i) {
     // Start writing sentences.
     CoreferenceSentence *sentence = document->GetSentence(i);
-    sentence_writer_.Write(sentence);
+    WriteSentence(sentence);
   }
+  EndDocument();
+}
+
+void CoreferenceWriter::BeginDocument(const std::string &name,
+                                      int part_number) {
+  char part_number_string[4];
+
+#ifdef _WIN32
+  _snprintf(part_number_string, sizeof(part_number_string), "%03d",
+            part_number);
+#else
+  snprintf(part_number_string, sizeof(part_number_string), "%03d",
+           part_number);
+#endif
+
+  os_ << "#begin document (" << name << "); part "
+    << part_number_string << std::endl;
+}
+
+void CoreferenceWriter::WriteSentence(CoreferenceSentence *sentence) {
+  sentence_writer_.Write(sentence);
+}
+
+void CoreferenceWriter::EndDocument() {
   os_ << "#end document" << std::endl;
 }
 
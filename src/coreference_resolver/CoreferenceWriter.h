@@ -21,6 +21,7 @@
 
 #include "SemanticWriter.h"
 #include "EntitySpan.h"
+#include "CoreferenceSentence.h"
 
 class CoreferenceSentenceWriter : public SemanticWriter {
 public:
@@ -72,6 +73,12 @@ public:
   }
   void Write(Instance *instance);
 
+  // Incremental (streaming) interface: documents are written one sentence
+  // at a time, between BeginDocument and EndDocument.
+  void BeginDocument(const std::string &name, int part_number);
+  void WriteSentence(CoreferenceSentence *sentence);
+  void EndDocument();
+
   CoreferenceSentenceWriter *GetSentenceWriter() { return &sentence_writer_; }
 
 protected:
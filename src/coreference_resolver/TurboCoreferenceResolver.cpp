@@ -88,7 +88,11 @@ void TestCoreferenceResolver() {
   CoreferencePipe *pipe = new CoreferencePipe(options);
   pipe->Initialize();
   pipe->LoadModelFile();
-  pipe->Run();
+  if (options->streaming()) {
+    pipe->RunStreaming();
+  } else {
+    pipe->Run();
+  }
 
   delete pipe;
   delete options;
@@ -83,173 +83,112 @@ void DependencyLabelerDecoder::Decode(Instance *instance, Parts *parts,
       static_cast<DependencyInstanceNumeric*>(instance)->size();
     const std::vector<std::vector<int> > &siblings =
       dependency_parts->siblings();
+    int num_labels =
+      pipe_->GetDependencyDictionary()->GetLabelAlphabet().size();
 
     predicted_output->clear();
     predicted_output->resize(parts->size(), 0.0);
 
+    // Position of each label among the candidate arcs of each modifier (-1
+    // if the label is not a candidate).
+    label_positions_.assign(instance_length * num_labels, -1);
+    for (int m = 1; m < instance_length; ++m) {
+      const std::vector<int> &arcs = dependency_parts->FindArcs(m);
+      for (int k = 0; k < arcs.size(); ++k) {
+        DependencyLabelerPartArc *arc =
+          static_cast<DependencyLabelerPartArc*>((*parts)[arcs[k]]);
+        label_positions_[m * num_labels + arc->label()] = k;
+      }
+    }
+
     for (int h = 0; h < instance_length; ++h) {
-      if (siblings[h].size() == 0) continue;
-      std::vector<std::vector<double> > node_scores(
-        siblings[h].size(), std::vector<double>(0));
-      std::vector<std::vector<std::vector<double> > > edge_scores(
-        siblings[h].size() - 1, std::vector<std::vector<double> >(0));
-      for (int i = 0; i < siblings[h].size() + 1; ++i) {
+      int num_siblings = siblings[h].size();
+      if (num_siblings == 0) continue;
+
+      // Build the lattice of the modifiers of h: the states of the i-th
+      // modifier are its candidate arcs, and the transitions between
+      // consecutive modifiers are the sibling parts.
+      node_offsets_.resize(num_siblings + 1);
+      edge_offsets_.resize(num_siblings);
+      node_offsets_[0] = 0;
+      edge_offsets_[0] = 0;
+      for (int i = 0; i < num_siblings; ++i) {
+        int num_states = dependency_parts->FindArcs(siblings[h][i]).size();
+        node_offsets_[i + 1] = node_offsets_[i] + num_states;
+        if (i > 0) {
+          int num_previous_states = node_offsets_[i] - node_offsets_[i - 1];
+          edge_offsets_[i] = edge_offsets_[i - 1] +
+            num_states * num_previous_states;
+        }
+      }
+      node_scores_.resize(node_offsets_[num_siblings]);
+      edge_scores_.assign(edge_offsets_[num_siblings - 1], 0.0);
+      for (int i = 0; i < num_siblings; ++i) {
+        const std::vector<int> &current_arcs =
+          dependency_parts->FindArcs(siblings[h][i]);
+        for (int k = 0; k < current_arcs.size(); ++k) {
+          node_scores_[node_offsets_[i] + k] = scores[current_arcs[k]];
+        }
+      }
+
+      for (int i = 0; i < num_siblings + 1; ++i) {
         const std::vector<int> &sibling_parts =
           dependency_parts->FindSiblings(h, i);
-        int m = (i < siblings[h].size()) ? siblings[h][i] : -1;
+        int m = (i < num_siblings) ? siblings[h][i] : -1;
         int s = (i > 0) ? siblings[h][i - 1] : -1;
-        if (m >= 0) {
-          const std::vector<int> &current_arcs = dependency_parts->FindArcs(m);
-          node_scores[i].resize(current_arcs.size());
-          for (int k = 0; k < current_arcs.size(); ++k) {
-            int r = current_arcs[k];
-            node_scores[i][k] = scores[r];
-          }
-        }
-        if (s < 0) {
-          const std::vector<int> &current_arcs = dependency_parts->FindArcs(m);
-          for (int j = 0; j < sibling_parts.size(); ++j) {
-            int r = sibling_parts[j];
-            DependencyLabelerPartSibling *sibling =
-              static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
-            int modifier_label = sibling->modifier_label();
-            CHECK_EQ(sibling->sibling_label(), -1);
-            int k = -1;
-            for (k = 0; k < current_arcs.size(); ++k) {
-              DependencyLabelerPartArc *arc =
-                static_cast<DependencyLabelerPartArc*>(
-                  (*parts)[current_arcs[k]]);
-              if (modifier_label == arc->label()) break;
-            }
+        for (int j = 0; j < sibling_parts.size(); ++j) {
+          int r = sibling_parts[j];
+          DependencyLabelerPartSibling *sibling =
+            static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
+          int k = (m >= 0) ?
+            label_positions_[m * num_labels + sibling->modifier_label()] : -1;
+          int l = (s >= 0) ?
+            label_positions_[s * num_labels + sibling->sibling_label()] : -1;
+          if (s < 0) {
             CHECK_GE(k, 0);
-            node_scores[i][k] += scores[r];
-          }
-        } else if (m < 0) {
-          const std::vector<int> &previous_arcs = dependency_parts->FindArcs(s);
-          for (int j = 0; j < sibling_parts.size(); ++j) {
-            int r = sibling_parts[j];
-            DependencyLabelerPartSibling *sibling =
-              static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
-            CHECK_EQ(sibling->modifier_label(), -1);
-            int sibling_label = sibling->sibling_label();
-            // This is very inefficient...
-            int l = -1;
-            for (l = 0; l < previous_arcs.size(); ++l) {
-              DependencyLabelerPartArc *arc =
-                static_cast<DependencyLabelerPartArc*>(
-                  (*parts)[previous_arcs[l]]);
-              if (sibling_label == arc->label()) break;
-            }
+            node_scores_[node_offsets_[i] + k] += scores[r];
+          } else if (m < 0) {
             CHECK_GE(l, 0);
-            node_scores[i - 1][l] += scores[r];
-          }
-        } else if (m >= 0 && s >= 0) {
-          const std::vector<int> &current_arcs = dependency_parts->FindArcs(m);
-          const std::vector<int> &previous_arcs = dependency_parts->FindArcs(s);
-          edge_scores[i - 1].resize(current_arcs.size(),
-                                    std::vector<double>(previous_arcs.size(),
-                                                        0.0));
-          for (int j = 0; j < sibling_parts.size(); ++j) {
-            int r = sibling_parts[j];
-            DependencyLabelerPartSibling *sibling =
-              static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
-            int modifier_label = sibling->modifier_label();
-            int sibling_label = sibling->sibling_label();
-            // This is very inefficient...
-            int k = -1;
-            for (k = 0; k < current_arcs.size(); ++k) {
-              DependencyLabelerPartArc *arc =
-                static_cast<DependencyLabelerPartArc*>(
-                  (*parts)[current_arcs[k]]);
-              if (modifier_label == arc->label()) break;
-            }
+            node_scores_[node_offsets_[i - 1] + l] += scores[r];
+          } else {
             CHECK_GE(k, 0);
-            int l = -1;
-            for (l = 0; l < previous_arcs.size(); ++l) {
-              DependencyLabelerPartArc *arc =
-                static_cast<DependencyLabelerPartArc*>(
-                  (*parts)[previous_arcs[l]]);
-              if (sibling_label == arc->label()) break;
-            }
             CHECK_GE(l, 0);
-            edge_scores[i - 1][k][l] = scores[r];
+            int num_previous_states = node_offsets_[i] - node_offsets_[i - 1];
+            edge_scores_[edge_offsets_[i - 1] + k * num_previous_states + l] =
+              scores[r];
           }
         }
       }
 
-      std::vector<int> best_path(node_scores.size(), -1);
-      RunViterbi(node_scores, edge_scores, &best_path);
+      RunViterbi(node_offsets_, node_scores_, edge_offsets_, edge_scores_,
+                 &best_path_);
 
-      for (int i = 0; i < siblings[h].size() + 1; ++i) {
+      for (int i = 0; i < num_siblings + 1; ++i) {
         const std::vector<int> &sibling_parts =
           dependency_parts->FindSiblings(h, i);
-        int m = (i < siblings[h].size()) ? siblings[h][i] : -1;
+        int m = (i < num_siblings) ? siblings[h][i] : -1;
         int s = (i > 0) ? siblings[h][i - 1] : -1;
         if (m >= 0) {
           const std::vector<int> &current_arcs = dependency_parts->FindArcs(m);
-          int best_label = best_path[i];
+          int best_label = best_path_[i];
           CHECK_GE(best_label, 0);
           (*predicted_output)[current_arcs[best_label]] = 1.0;
         }
-
-        if (s < 0) {
-          const std::vector<int> &current_arcs = dependency_parts->FindArcs(m);
-          for (int j = 0; j < sibling_parts.size(); ++j) {
-            int r = sibling_parts[j];
-            DependencyLabelerPartSibling *sibling =
-              static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
-            int modifier_label = sibling->modifier_label();
-            CHECK_EQ(sibling->sibling_label(), -1);
-            int best_current_label = best_path[i];
-            DependencyLabelerPartArc *current_arc =
-              static_cast<DependencyLabelerPartArc*>(
-                (*parts)[current_arcs[best_current_label]]);
-
-            if (modifier_label == current_arc->label()) {
-              (*predicted_output)[r] = 1.0;
-            }
-          }
-        } else if (m < 0) {
-          const std::vector<int> &previous_arcs = dependency_parts->FindArcs(s);
-          for (int j = 0; j < sibling_parts.size(); ++j) {
-            int r = sibling_parts[j];
-            DependencyLabelerPartSibling *sibling =
-              static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
-            int sibling_label = sibling->sibling_label();
-            CHECK_EQ(sibling->modifier_label(), -1);
-            int best_previous_label = best_path[i - 1];
-            DependencyLabelerPartArc *previous_arc =
-              static_cast<DependencyLabelerPartArc*>(
-                (*parts)[previous_arcs[best_previous_label]]);
-
-            if (sibling_label == previous_arc->label()) {
-              (*predicted_output)[r] = 1.0;
-            }
+        for (int j = 0; j < sibling_parts.size(); ++j) {
+          int r = sibling_parts[j];
+          DependencyLabelerPartSibling *sibling =
+            static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
+          if (m >= 0 && label_positions_[m * num_labels +
+                                         sibling->modifier_label()] !=
+              best_path_[i]) {
+            continue;
           }
-        } else if (m >= 0 && s >= 0) {
-          const std::vector<int> &current_arcs = dependency_parts->FindArcs(m);
-          const std::vector<int> &previous_arcs = dependency_parts->FindArcs(s);
-          for (int j = 0; j < sibling_parts.size(); ++j) {
-            int r = sibling_parts[j];
-            DependencyLabelerPartSibling *sibling =
-              static_cast<DependencyLabelerPartSibling*>((*parts)[r]);
-            int modifier_label = sibling->modifier_label();
-            int sibling_label = sibling->sibling_label();
-
-            int best_current_label = best_path[i];
-            int best_previous_label = best_path[i - 1];
-            DependencyLabelerPartArc *current_arc =
-              static_cast<DependencyLabelerPartArc*>(
-                (*parts)[current_arcs[best_current_label]]);
-            DependencyLabelerPartArc *previous_arc =
-              static_cast<DependencyLabelerPartArc*>(
-                (*parts)[previous_arcs[best_previous_label]]);
-
-            if (modifier_label == current_arc->label() &&
-                sibling_label == previous_arc->label()) {
-              (*predicted_output)[r] = 1.0;
-            }
+          if (s >= 0 && label_positions_[s * num_labels +
+                                         sibling->sibling_label()] !=
+              best_path_[i - 1]) {
+            continue;
           }
+          (*predicted_output)[r] = 1.0;
         }
       }
     }
@@ -266,8 +205,6 @@ void DependencyLabelerDecoder::DecodeBasic(
   int instance_length =
     static_cast<DependencyInstanceNumeric*>(instance)->size();
 
-  // Create copy of the scores.
-  vector<double> copied_scores(scores);
   vector<int> best_labels(instance_length, -1);
   int offset_arcs, num_arcs;
   dependency_parts->GetOffsetArc(&offset_arcs, &num_arcs);
@@ -299,56 +236,57 @@ void DependencyLabelerDecoder::DecodeBasic(
 }
 
 double DependencyLabelerDecoder::RunViterbi(
-  const std::vector<std::vector<double> > &node_scores,
-  const std::vector<std::vector<std::vector<double> > > &edge_scores,
+  const std::vector<int> &node_offsets,
+  const std::vector<double> &node_scores,
+  const std::vector<int> &edge_offsets,
+  const std::vector<double> &edge_scores,
   std::vector<int> *best_path) {
-  int length = node_scores.size(); // Length of the sequence.
-  // To accommodate the partial scores.
-  std::vector<std::vector<double> > deltas(length);
-  std::vector<std::vector<int> > backtrack(length); // To backtrack.
+  int length = node_offsets.size() - 1; // Length of the sequence.
+  // To accommodate the partial scores, with the same layout as node_scores.
+  deltas_.resize(node_scores.size());
+  backtrack_.resize(node_scores.size()); // To backtrack.
 
   // Initialization.
-  int num_current_labels = node_scores[0].size();
-  deltas[0].resize(num_current_labels);
-  backtrack[0].resize(num_current_labels);
+  int num_current_labels = node_offsets[1] - node_offsets[0];
   for (int l = 0; l < num_current_labels; ++l) {
     // The score of the first node absorbs the score of a start transition.
-    deltas[0][l] = node_scores[0][l];
-    backtrack[0][l] = -1; // This won't be used.
+    deltas_[l] = node_scores[l];
+    backtrack_[l] = -1; // This won't be used.
   }
 
   // Recursion.
   for (int i = 0; i < length - 1; ++i) {
-    int num_current_labels = node_scores[i + 1].size();
-    deltas[i + 1].resize(num_current_labels);
-    backtrack[i + 1].resize(num_current_labels);
+    int num_current_labels = node_offsets[i + 2] - node_offsets[i + 1];
+    int num_previous_labels = node_offsets[i + 1] - node_offsets[i];
+    const double *previous_deltas = &deltas_[node_offsets[i]];
     for (int k = 0; k < num_current_labels; ++k) {
       double best_value = -1e-12;
       int best = -1;
       // Edges from the previous position.
-      int num_previous_labels = node_scores[i].size();
+      const double *current_edge_scores =
+        &edge_scores[edge_offsets[i] + k * num_previous_labels];
       for (int l = 0; l < num_previous_labels; ++l) {
-        double edge_score = edge_scores[i][k][l];
-        double value = deltas[i][l] + edge_score;
+        double value = previous_deltas[l] + current_edge_scores[l];
         if (best < 0 || value > best_value) {
           best_value = value;
           best = l;
         }
       }
-      CHECK_GE(best, 0) << node_scores[i].size() << " possible tags.";
+      CHECK_GE(best, 0) << num_previous_labels << " possible tags.";
 
-      deltas[i + 1][k] = best_value + node_scores[i + 1][k];
-      backtrack[i + 1][k] = best;
+      deltas_[node_offsets[i + 1] + k] =
+        best_value + node_scores[node_offsets[i + 1] + k];
+      backtrack_[node_offsets[i + 1] + k] = best;
     }
   }
 
   // Termination.
   double best_value = -1e12;
   int best = -1;
-  for (int l = 0; l < node_scores[length - 1].size(); ++l) {
+  for (int l = 0; l < node_offsets[length] - node_offsets[length - 1]; ++l) {
     // The score of the last node had already absorbed the score of a final
     // transition.
-    double value = deltas[length - 1][l];
+    double value = deltas_[node_offsets[length - 1] + l];
     if (best < 0 || value > best_value) {
       best_value = value;
       best = l;
@@ -360,7 +298,7 @@ double DependencyLabelerDecoder::RunViterbi(
   best_path->resize(length);
   (*best_path)[length - 1] = best;
   for (int i = length - 1; i > 0; --i) {
-    (*best_path)[i - 1] = backtrack[i][(*best_path)[i]];
+    (*best_path)[i - 1] = backtrack_[node_offsets[i] + (*best_path)[i]];
   }
 
   return best_value;
@@ -65,13 +65,30 @@ public:
   }
 
 protected:
-  double RunViterbi(
-    const std::vector<std::vector<double> > &node_scores,
-    const std::vector<std::vector<std::vector<double> > > &edge_scores,
-    std::vector<int> *best_path);
+  // Viterbi on a lattice stored in flat arrays. The scores of the states of
+  // position i are node_scores[node_offsets[i]], ...,
+  // node_scores[node_offsets[i+1]-1] (node_offsets has one more element than
+  // the number of positions); the score of the transition from state l of
+  // position i to state k of position i+1 is
+  // edge_scores[edge_offsets[i] + k * (number of states of i) + l].
+  double RunViterbi(const std::vector<int> &node_offsets,
+                    const std::vector<double> &node_scores,
+                    const std::vector<int> &edge_offsets,
+                    const std::vector<double> &edge_scores,
+                    std::vector<int> *best_path);
 
 protected:
   DependencyLabelerPipe *pipe_;
+  // Buffers of Decode and RunViterbi, kept to avoid allocations in each
+  // sentence.
+  std::vector<int> label_positions_;
+  std::vector<int> node_offsets_;
+  std::vector<double> node_scores_;
+  std::vector<int> edge_offsets_;
+  std::vector<double> edge_scores_;
+  std::vector<double> deltas_;
+  std::vector<int> backtrack_;
+  std::vector<int> best_path_;
 };
 
 #endif /* DEPENDENCYLABELERDECODER_H_ */
@@ -77,6 +77,21 @@ public:
     return NULL;
   };
 
+  int64_t GetNumFeatures() const {
+    int64_t num_features = CountFeatures(input_arc_features_);
+    for (int h = 0; h < input_sibling_features_.size(); ++h) {
+      num_features += CountFeatures(input_sibling_features_[h]);
+    }
+    return num_features;
+  }
+  int64_t GetNumBytes() const {
+    int64_t num_bytes = CountFeatureBytes(input_arc_features_);
+    for (int h = 0; h < input_sibling_features_.size(); ++h) {
+      num_bytes += CountFeatureBytes(input_sibling_features_[h]);
+    }
+    return num_bytes;
+  }
+
 public:
   void AddArcFeatures(DependencyInstanceNumeric *sentence,
                       const std::vector<std::vector<int> > &descendents,
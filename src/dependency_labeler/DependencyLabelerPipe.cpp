@@ -64,6 +64,20 @@ void DependencyLabelerPipe::LoadModel(FILE* fs) {
   //pruner_parameters_->Load(fs);
 }
 
+void DependencyLabelerPipe::SaveDictionaries(FILE *fs) {
+  token_dictionary_->Save(fs);
+  Pipe::SaveDictionaries(fs);
+}
+
+void DependencyLabelerPipe::LoadDictionaries(FILE *fs) {
+  delete token_dictionary_;
+  CreateTokenDictionary();
+  static_cast<DependencyDictionary*>(dictionary_)->
+    SetTokenDictionary(token_dictionary_);
+  token_dictionary_->Load(fs);
+  Pipe::LoadDictionaries(fs);
+}
+
 void DependencyLabelerPipe::PreprocessData() {
   delete token_dictionary_;
   CreateTokenDictionary();
@@ -88,26 +102,38 @@ void DependencyLabelerPipe::ComputeScores(Instance *instance, Parts *parts,
   const std::vector<int> &heads = sentence->GetHeads();
   const std::vector<std::vector<int> > &siblings = dependency_parts->siblings();
 
+  int num_labels = GetDependencyDictionary()->GetLabelAlphabet().size();
+
+  // Score the arc features of all the modifiers into a dense
+  // modifier-by-label matrix, and read the scores of the candidate arcs
+  // from it.
+  arc_label_scores_.assign(sentence->size() * num_labels, 0.0);
   for (int m = 1; m < sentence->size(); ++m) {
     // Conjoin arc features with the label.
     const BinaryFeatures &arc_features = dependency_features->GetArcFeatures(m);
     const std::vector<int> &index_arc_parts =
       dependency_parts->FindArcs(m);
-    std::vector<int> allowed_labels(index_arc_parts.size());
+    double *label_scores = &arc_label_scores_[m * num_labels];
+    score_labels_.resize(index_arc_parts.size());
     for (int k = 0; k < index_arc_parts.size(); ++k) {
       DependencyLabelerPartArc *arc =
         static_cast<DependencyLabelerPartArc*>((*parts)[index_arc_parts[k]]);
-      allowed_labels[k] = arc->label();
+      score_labels_[k] = arc->label();
     }
-    std::vector<double> label_scores;
-    parameters_->ComputeLabelScores(arc_features, allowed_labels,
-                                    &label_scores);
+    parameters_->AddLabelScores(arc_features, score_labels_, num_labels,
+                                label_scores);
     for (int k = 0; k < index_arc_parts.size(); ++k) {
-      (*scores)[index_arc_parts[k]] = label_scores[k];
+      (*scores)[index_arc_parts[k]] = label_scores[score_labels_[k]];
     }
   }
 
   if (dependency_options->use_sibling_parts()) {
+    // The scores of each sibling slot are computed into the same dense
+    // vector of sibling labels. Only the entries of the labels of the slot
+    // are reset; the other entries are scratch.
+    int num_sibling_labels = (1 + num_labels) * (1 + num_labels);
+    sibling_label_scores_.resize(num_sibling_labels);
+    double *label_scores = &sibling_label_scores_[0];
     for (int h = 0; h < sentence->size(); ++h) {
       if (siblings[h].size() == 0) continue;
       for (int i = 0; i < siblings[h].size() + 1; ++i) {
@@ -115,19 +141,19 @@ void DependencyLabelerPipe::ComputeScores(Instance *instance, Parts *parts,
           dependency_features->GetSiblingFeatures(h, i);
         const std::vector<int> &index_sibling_parts =
           dependency_parts->FindSiblings(h, i);
-        std::vector<int> sibling_labels(index_sibling_parts.size());
+        score_labels_.resize(index_sibling_parts.size());
         for (int k = 0; k < index_sibling_parts.size(); ++k) {
           DependencyLabelerPartSibling *sibling =
             static_cast<DependencyLabelerPartSibling*>(
               (*parts)[index_sibling_parts[k]]);
-          sibling_labels[k] = GetSiblingLabel(sibling->sibling_label(),
-                                              sibling->modifier_label());
+          score_labels_[k] = GetSiblingLabel(sibling->sibling_label(),
+                                             sibling->modifier_label());
+          label_scores[score_labels_[k]] = 0.0;
         }
-        std::vector<double> label_scores;
-        parameters_->ComputeLabelScores(sibling_features, sibling_labels,
-                                        &label_scores);
+        parameters_->AddLabelScores(sibling_features, score_labels_,
+                                    num_sibling_labels, label_scores);
         for (int k = 0; k < index_sibling_parts.size(); ++k) {
-          (*scores)[index_sibling_parts[k]] = label_scores[k];
+          (*scores)[index_sibling_parts[k]] = label_scores[score_labels_[k]];
         }
       }
     }
@@ -99,9 +99,24 @@ protected:
     return instance_numeric;
   }
 
+  // The labeler is trained on parser corpora (see TurboCorpusConverter).
+  bool SupportsBinaryCorpus() { return true; }
+
+  Instance *CreateFormattedInstance() {
+    return new DependencyInstanceNumeric;
+  }
+
+  // Number of words of a sentence (including the root).
+  int GetInstanceLength(Instance *formatted_instance) {
+    return static_cast<DependencyInstanceNumeric*>(formatted_instance)->size();
+  }
+
   void SaveModel(FILE* fs);
   void LoadModel(FILE* fs);
 
+  void SaveDictionaries(FILE *fs);
+  void LoadDictionaries(FILE *fs);
+
   //void LoadPrunerModel(FILE* fs);
   //void LoadPrunerModelByName(const string &model_name);
 
@@ -231,6 +246,12 @@ protected:
   int num_heads_after_pruning_;
   int num_tokens_;
   timeval start_clock_;
+  // Buffers of ComputeScores, kept to avoid allocations in each sentence:
+  // the scores of each modifier (rows) and label (columns), the scores of
+  // the sibling labels of a sibling slot, and the labels to score.
+  std::vector<double> arc_label_scores_;
+  std::vector<double> sibling_label_scores_;
+  std::vector<int> score_labels_;
 };
 
 #endif /* DEPENDENCYLABELERPIPE_H_ */
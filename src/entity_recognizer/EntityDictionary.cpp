@@ -127,91 +127,161 @@ void EntityDictionary::ReadGazetteerFiles() {
   EntityOptions *options =
     static_cast<EntityOptions*>(pipe_->GetOptions());
 
+  gazetteer_phrases_ = options->gazetteer_phrases();
   gazetteer_word_alphabet_.AllowGrowth();
   gazetteer_entity_tag_alphabet_.AllowGrowth();
+  gazetteer_word_entity_tags_.clear();
+  gazetteer_trie_.Clear();
 
   if (options->file_gazetteer() != "") {
     LOG(INFO) << "Loading gazetteer file "
       << options->file_gazetteer() << "...";
     std::ifstream is;
     std::string line;
+    std::vector<std::string> fields;
+    // Word ids and labels of the entries, if they are matched as phrases
+    // (see GazetteerTrie::Build).
+    std::vector<int> entry_words;
+    std::vector<int> entry_offsets(1, 0);
+    std::vector<int> entry_labels;
 
-    // Do a first pass just to count the words and create the
-    // dictionaries.
+    // Read the file in a single pass, creating the dictionaries as we go.
     is.open(options->file_gazetteer().c_str(), ifstream::in);
     CHECK(is.good()) << "Could not open "
       << options->file_gazetteer() << ".";
-    if (is.is_open()) {
-      while (!is.eof()) {
-        getline(is, line);
-        if (line == "") continue; // Ignore blank lines.
-        std::vector<std::string> fields;
-        StringSplit(line, " \t", &fields, true); // Break on tabs or spaces.
-        if (fields.size() < 2) continue;
-        const std::string &entity_type = fields[0];
+    while (getline(is, line)) {
+      if (line == "") continue; // Ignore blank lines.
+      fields.clear();
+      StringSplit(line, " \t", &fields, true); // Break on tabs or spaces.
+      if (fields.size() < 2) continue;
+      const std::string &entity_type = fields[0];
+      int entity_type_begin_id =
         gazetteer_entity_tag_alphabet_.Insert("B-" + entity_type);
+      int entity_type_inside_id =
         gazetteer_entity_tag_alphabet_.Insert("I-" + entity_type);
+      int entity_type_last_id =
         gazetteer_entity_tag_alphabet_.Insert("L-" + entity_type);
+      int entity_type_unique_id =
         gazetteer_entity_tag_alphabet_.Insert("U-" + entity_type);
-        for (int k = 1; k < fields.size(); ++k) {
-          const std::string &word = fields[k];
-          gazetteer_word_alphabet_.Insert(word);
+      CHECK_EQ(entity_type_inside_id,
+               entity_type_begin_id + GAZETTEER_TAG_INSIDE);
+      CHECK_EQ(entity_type_last_id,
+               entity_type_begin_id + GAZETTEER_TAG_LAST);
+      CHECK_EQ(entity_type_unique_id,
+               entity_type_begin_id + GAZETTEER_TAG_UNIQUE);
+
+      for (int k = 1; k < fields.size(); ++k) {
+        const std::string &word = fields[k];
+        int word_id = gazetteer_word_alphabet_.Insert(word);
+        CHECK_GE(word_id, 0);
+        if (gazetteer_phrases_) {
+          entry_words.push_back(word_id);
+          continue;
+        }
+        if (word_id >= gazetteer_word_entity_tags_.size()) {
+          gazetteer_word_entity_tags_.resize(word_id + 1);
         }
+        int entity_type_id = -1;
+        if (fields.size() == 2) {
+          entity_type_id = entity_type_unique_id;
+        } else if (k == 1) {
+          entity_type_id = entity_type_begin_id;
+        } else if (k == fields.size() - 1) {
+          entity_type_id = entity_type_last_id;
+        } else {
+          entity_type_id = entity_type_inside_id;
+        }
+        int l = -1;
+        for (l = 0; l < gazetteer_word_entity_tags_[word_id].size(); ++l) {
+          if (gazetteer_word_entity_tags_[word_id][l] == entity_type_id) {
+            break;
+          }
+        }
+        if (l == gazetteer_word_entity_tags_[word_id].size()) {
+          gazetteer_word_entity_tags_[word_id].
+            push_back(entity_type_id);
+        }
+      }
+      if (gazetteer_phrases_) {
+        entry_offsets.push_back(entry_words.size());
+        entry_labels.push_back(entity_type_begin_id);
       }
     }
     is.close();
 
-    // Now do the second pass to actually fill in the data.
-    gazetteer_word_entity_tags_.clear();
-    gazetteer_word_entity_tags_.resize(gazetteer_word_alphabet_.size());
-    is.open(options->file_gazetteer().c_str(), ifstream::in);
-    CHECK(is.good()) << "Could not open "
-      << options->file_gazetteer() << ".";
-    if (is.is_open()) {
-      while (!is.eof()) {
-        getline(is, line);
-        if (line == "") continue; // Ignore blank lines.
-        std::vector<std::string> fields;
-        StringSplit(line, " \t", &fields, true); // Break on tabs or spaces.
-        if (fields.size() < 2) continue;
-        const std::string &entity_type = fields[0];
-        int entity_type_begin_id =
-          gazetteer_entity_tag_alphabet_.Lookup("B-" + entity_type);
-        int entity_type_inside_id =
-          gazetteer_entity_tag_alphabet_.Lookup("I-" + entity_type);
-        int entity_type_last_id =
-          gazetteer_entity_tag_alphabet_.Lookup("L-" + entity_type);
-        int entity_type_unique_id =
-          gazetteer_entity_tag_alphabet_.Lookup("U-" + entity_type);
-        for (int k = 1; k < fields.size(); ++k) {
-          const std::string &word = fields[k];
-          int word_id = gazetteer_word_alphabet_.Lookup(word);
-          CHECK_GE(word_id, 0);
-          CHECK_LT(word_id, gazetteer_word_entity_tags_.size());
-          int entity_type_id = -1;
-          if (fields.size() == 2) {
-            entity_type_id = entity_type_unique_id;
-          } else if (k == 1) {
-            entity_type_id = entity_type_begin_id;
-          } else if (k == fields.size() - 1) {
-            entity_type_id = entity_type_last_id;
-          } else {
-            entity_type_id = entity_type_inside_id;
-          }
-          int l = -1;
-          for (l = 0; l < gazetteer_word_entity_tags_[word_id].size(); ++l) {
-            if (gazetteer_word_entity_tags_[word_id][l] == entity_type_id) {
-              break;
-            }
-          }
-          if (l == gazetteer_word_entity_tags_[word_id].size()) {
-            gazetteer_word_entity_tags_[word_id].
-              push_back(entity_type_id);
-          }
-        }
+    if (gazetteer_phrases_) {
+      LOG(INFO) << "Building trie of " << entry_labels.size()
+        << " gazetteer entries...";
+      gazetteer_trie_.Build(entry_words, entry_offsets, entry_labels);
+    }
+  }
+
+  gazetteer_word_alphabet_.StopGrowth();
+  gazetteer_entity_tag_alphabet_.StopGrowth();
+  LOG(INFO) << "Number of gazetteer words: "
+    << gazetteer_word_alphabet_.size();
+  LOG(INFO) << "Number of gazetteer entity tags: "
+    << gazetteer_entity_tag_alphabet_.size();
+  if (gazetteer_phrases_) {
+    LOG(INFO) << "Number of gazetteer trie nodes: "
+      << gazetteer_trie_.GetNumNodes();
+  }
+}
+
+void EntityDictionary::SaveGazetteer(FILE *fs) {
+  if (0 > gazetteer_word_alphabet_.Save(fs)) CHECK(false);
+  if (0 > gazetteer_entity_tag_alphabet_.Save(fs)) CHECK(false);
+
+  bool success;
+  if (gazetteer_phrases_) {
+    success = WriteInteger(fs, kGazetteerTrieMarker);
+    CHECK(success);
+    gazetteer_trie_.Save(fs);
+    return;
+  }
+
+  int length = gazetteer_word_entity_tags_.size();
+  success = WriteInteger(fs, length);
+  CHECK(success);
+  for (int j = 0; j < gazetteer_word_entity_tags_.size(); ++j) {
+    length = gazetteer_word_entity_tags_[j].size();
+    success = WriteInteger(fs, length);
+    CHECK(success);
+    for (int k = 0; k < gazetteer_word_entity_tags_[j].size(); ++k) {
+      int id = gazetteer_word_entity_tags_[j][k];
+      success = WriteInteger(fs, id);
+      CHECK(success);
+    }
+  }
+}
+
+void EntityDictionary::LoadGazetteer(FILE *fs) {
+  if (0 > gazetteer_word_alphabet_.Load(fs)) CHECK(false);
+  if (0 > gazetteer_entity_tag_alphabet_.Load(fs)) CHECK(false);
+
+  int length;
+  bool success = ReadInteger(fs, &length);
+  CHECK(success);
+  gazetteer_word_entity_tags_.clear();
+  gazetteer_trie_.Clear();
+  if (length == kGazetteerTrieMarker) {
+    gazetteer_phrases_ = true;
+    gazetteer_trie_.Load(fs);
+  } else {
+    gazetteer_phrases_ = false;
+    CHECK_GE(length, 0);
+    gazetteer_word_entity_tags_.resize(length);
+    for (int j = 0; j < gazetteer_word_entity_tags_.size(); ++j) {
+      success = ReadInteger(fs, &length);
+      CHECK(success);
+      gazetteer_word_entity_tags_[j].resize(length);
+      for (int k = 0; k < gazetteer_word_entity_tags_[j].size(); ++k) {
+        int id;
+        success = ReadInteger(fs, &id);
+        CHECK(success);
+        gazetteer_word_entity_tags_[j][k] = id;
       }
     }
-    is.close();
   }
 
   gazetteer_word_alphabet_.StopGrowth();
@@ -220,6 +290,83 @@ void EntityDictionary::ReadGazetteerFiles() {
     << gazetteer_word_alphabet_.size();
   LOG(INFO) << "Number of gazetteer entity tags: "
     << gazetteer_entity_tag_alphabet_.size();
+  if (gazetteer_phrases_) {
+    LOG(INFO) << "Number of gazetteer trie nodes: "
+      << gazetteer_trie_.GetNumNodes();
+  }
+}
+
+// Add a gazetteer tag to a word, unless the word already has it.
+static void AddGazetteerId(int id, std::vector<int> *gazetteer_ids) {
+  for (int l = 0; l < gazetteer_ids->size(); ++l) {
+    if ((*gazetteer_ids)[l] == id) return;
+  }
+  gazetteer_ids->push_back(id);
+}
+
+// Give the B/I/L/U tags of each occurrence of a gazetteer entry to the words
+// it spans. The labels of the occurrences are the ids of the B-tags.
+static void AddGazetteerMatchIds(
+    const std::vector<GazetteerMatch> &matches,
+    std::vector<std::vector<int> > *gazetteer_ids) {
+  for (int k = 0; k < matches.size(); ++k) {
+    const GazetteerMatch &match = matches[k];
+    int begin_id = match.label;
+    if (match.start == match.end) {
+      AddGazetteerId(begin_id + GAZETTEER_TAG_UNIQUE,
+                     &(*gazetteer_ids)[match.start]);
+      continue;
+    }
+    AddGazetteerId(begin_id + GAZETTEER_TAG_BEGIN,
+                   &(*gazetteer_ids)[match.start]);
+    for (int i = match.start + 1; i < match.end; ++i) {
+      AddGazetteerId(begin_id + GAZETTEER_TAG_INSIDE, &(*gazetteer_ids)[i]);
+    }
+    AddGazetteerId(begin_id + GAZETTEER_TAG_LAST,
+                   &(*gazetteer_ids)[match.end]);
+  }
+}
+
+void EntityDictionary::GetSentenceGazetteerIds(
+    EntityInstance *instance,
+    std::vector<std::vector<int> > *gazetteer_ids) const {
+  int length = instance->size();
+  gazetteer_ids->resize(length);
+  if (!gazetteer_phrases_) {
+    for (int i = 0; i < length; ++i) {
+      GetWordGazetteerIds(instance->GetForm(i), &(*gazetteer_ids)[i]);
+    }
+    return;
+  }
+
+  std::vector<int> word_ids(length);
+  for (int i = 0; i < length; ++i) {
+    word_ids[i] = gazetteer_word_alphabet_.Lookup(instance->GetForm(i));
+    (*gazetteer_ids)[i].clear();
+  }
+  std::vector<GazetteerMatch> matches;
+  gazetteer_trie_.FindMatches(word_ids, &matches);
+  AddGazetteerMatchIds(matches, gazetteer_ids);
+}
+
+void EntityDictionary::GetSentenceGazetteerIdsNaive(
+    EntityInstance *instance,
+    std::vector<std::vector<int> > *gazetteer_ids) const {
+  if (!gazetteer_phrases_) {
+    GetSentenceGazetteerIds(instance, gazetteer_ids);
+    return;
+  }
+
+  int length = instance->size();
+  gazetteer_ids->resize(length);
+  std::vector<int> word_ids(length);
+  for (int i = 0; i < length; ++i) {
+    word_ids[i] = gazetteer_word_alphabet_.Lookup(instance->GetForm(i));
+    (*gazetteer_ids)[i].clear();
+  }
+  std::vector<GazetteerMatch> matches;
+  gazetteer_trie_.FindMatchesNaive(word_ids, &matches);
+  AddGazetteerMatchIds(matches, gazetteer_ids);
 }
 
 void EntityTokenDictionary::Initialize(EntityReader *reader) {
@@ -22,11 +22,28 @@
 #include "SequenceDictionary.h"
 #include "TokenDictionary.h"
 #include "EntityReader.h"
+#include "GazetteerTrie.h"
+
+// Offsets of the gazetteer tags of an entity type with respect to the id of
+// its B-tag (the four tags of each type are inserted in this order).
+enum {
+  GAZETTEER_TAG_BEGIN = 0,
+  GAZETTEER_TAG_INSIDE,
+  GAZETTEER_TAG_LAST,
+  GAZETTEER_TAG_UNIQUE,
+  NUM_GAZETTEER_TAGS
+};
+
+// Written in the model file in place of the size of the table of tags of
+// each word, when the gazetteer is stored as a trie of entries.
+const int kGazetteerTrieMarker = -1;
 
 class EntityDictionary : public SequenceDictionary {
 public:
-  EntityDictionary() {}
-  EntityDictionary(Pipe* pipe) : SequenceDictionary(pipe) {}
+  EntityDictionary() { gazetteer_phrases_ = false; }
+  EntityDictionary(Pipe* pipe) : SequenceDictionary(pipe) {
+    gazetteer_phrases_ = false;
+  }
   virtual ~EntityDictionary() {}
 
   void Clear() {
@@ -35,31 +52,16 @@ public:
     gazetteer_word_alphabet_.clear();
     gazetteer_entity_tag_alphabet_.clear();
     gazetteer_word_entity_tags_.clear();
+    gazetteer_trie_.Clear();
   }
 
   void Save(FILE *fs) {
     SequenceDictionary::Save(fs);
 
-    if (0 > gazetteer_word_alphabet_.Save(fs)) CHECK(false);
-    if (0 > gazetteer_entity_tag_alphabet_.Save(fs)) CHECK(false);
-
-    bool success;
-    int length = gazetteer_word_entity_tags_.size();
-    success = WriteInteger(fs, length);
-    CHECK(success);
-    for (int j = 0; j < gazetteer_word_entity_tags_.size(); ++j) {
-      length = gazetteer_word_entity_tags_[j].size();
-      success = WriteInteger(fs, length);
-      CHECK(success);
-      for (int k = 0; k < gazetteer_word_entity_tags_[j].size(); ++k) {
-        int id = gazetteer_word_entity_tags_[j][k];
-        success = WriteInteger(fs, id);
-        CHECK(success);
-      }
-    }
+    SaveGazetteer(fs);
 
-    length = allowed_bigrams_.size();
-    success = WriteInteger(fs, length);
+    int length = allowed_bigrams_.size();
+    bool success = WriteInteger(fs, length);
     CHECK(success);
     for (int j = 0; j < allowed_bigrams_.size(); ++j) {
       length = allowed_bigrams_[j].size();
@@ -76,34 +78,11 @@ public:
   void Load(FILE *fs) {
     SequenceDictionary::Load(fs);
 
-    if (0 > gazetteer_word_alphabet_.Load(fs)) CHECK(false);
-    if (0 > gazetteer_entity_tag_alphabet_.Load(fs)) CHECK(false);
+    LoadGazetteer(fs);
 
     int length;
     bool success = ReadInteger(fs, &length);
     CHECK(success);
-    gazetteer_word_entity_tags_.resize(length);
-    for (int j = 0; j < gazetteer_word_entity_tags_.size(); ++j) {
-      success = ReadInteger(fs, &length);
-      CHECK(success);
-      gazetteer_word_entity_tags_[j].resize(length);
-      for (int k = 0; k < gazetteer_word_entity_tags_[j].size(); ++k) {
-        int id;
-        success = ReadInteger(fs, &id);
-        CHECK(success);
-        gazetteer_word_entity_tags_[j][k] = id;
-      }
-    }
-
-    gazetteer_word_alphabet_.StopGrowth();
-    gazetteer_entity_tag_alphabet_.StopGrowth();
-    LOG(INFO) << "Number of gazetteer words: "
-      << gazetteer_word_alphabet_.size();
-    LOG(INFO) << "Number of gazetteer entity tags: "
-      << gazetteer_entity_tag_alphabet_.size();
-
-    success = ReadInteger(fs, &length);
-    CHECK(success);
     allowed_bigrams_.resize(length);
     for (int j = 0; j < allowed_bigrams_.size(); ++j) {
       success = ReadInteger(fs, &length);
@@ -122,6 +101,32 @@ public:
 
   void ReadGazetteerFiles();
 
+  // Save/load the gazetteer: the alphabets of words and tags, followed by
+  // either the trie of entries (preceded by kGazetteerTrieMarker) or the
+  // table of tags of each word.
+  void SaveGazetteer(FILE *fs);
+  void LoadGazetteer(FILE *fs);
+
+  // True if the gazetteer entries are matched as phrases.
+  bool gazetteer_phrases() const { return gazetteer_phrases_; }
+
+  int GetNumGazetteerWords() const { return gazetteer_word_alphabet_.size(); }
+
+  // Compute the gazetteer tags of each word of a sentence. If the gazetteer
+  // entries are matched as phrases, each occurrence of an entry of length 1
+  // gives a U-tag to its word, and each occurrence of a longer entry gives a
+  // B-tag to its first word, I-tags to the words inside and an L-tag to its
+  // last word.
+  void GetSentenceGazetteerIds(EntityInstance *instance,
+                               std::vector<std::vector<int> > *gazetteer_ids)
+    const;
+
+  // Same as above, but finds the occurrences of the entries by matching the
+  // trie at every position of the sentence. Used for benchmarking.
+  void GetSentenceGazetteerIdsNaive(
+    EntityInstance *instance,
+    std::vector<std::vector<int> > *gazetteer_ids) const;
+
   void GetWordGazetteerIds(const std::string &word,
                            std::vector<int> *gazetteer_ids) const {
     gazetteer_ids->clear();
@@ -142,6 +147,13 @@ protected:
   std::vector<std::vector<bool> > allowed_bigrams_;
   Alphabet gazetteer_word_alphabet_;
   Alphabet gazetteer_entity_tag_alphabet_;
+  // True if the gazetteer entries are matched as phrases (with
+  // gazetteer_trie_); false if each word gets the tags in
+  // gazetteer_word_entity_tags_ (older models).
+  bool gazetteer_phrases_;
+  // Trie of the entries (as sequences of word ids), labeled by the ids of the
+  // B-tags of their entity types.
+  GazetteerTrie gazetteer_trie_;
   std::vector<std::vector<int> > gazetteer_word_entity_tags_;
 };
 
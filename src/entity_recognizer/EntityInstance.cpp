@@ -19,6 +19,7 @@
 #include "EntityInstance.h"
 #include <glog/logging.h>
 #include "EntityOptions.h"
+#include "SerializationUtils.h"
 
 void EntityInstance::Initialize(const std::vector<std::string> &forms,
                                 const std::vector<std::string> &pos,
@@ -28,6 +29,20 @@ void EntityInstance::Initialize(const std::vector<std::string> &forms,
   tags_ = tags;
 }
 
+void EntityInstance::Save(FILE *fs) {
+  bool success;
+  SequenceInstance::Save(fs);
+  success = WriteStringVector(fs, pos_);
+  CHECK(success);
+}
+
+void EntityInstance::Load(FILE *fs) {
+  bool success;
+  SequenceInstance::Load(fs);
+  success = ReadStringVector(fs, &pos_);
+  CHECK(success);
+}
+
 void EntityInstance::ConvertToTaggingScheme(int tagging_scheme) {
   std::vector<EntitySpan*> spans;
   CreateSpansFromTags(tags_, &spans);
@@ -37,6 +37,9 @@ public:
                   const std::vector<std::string> &pos,
                   const std::vector<std::string> &tags);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   void ConvertToTaggingScheme(int tagging_scheme);
 
   const std::string &GetPosTag(int i) const { return pos_[i]; }
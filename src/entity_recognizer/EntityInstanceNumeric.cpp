@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "EntityInstanceNumeric.h"
+#include "SerializationUtils.h"
 #include <iostream>
 #include <algorithm>
 
@@ -28,16 +29,35 @@ void EntityInstanceNumeric::Initialize(const EntityDictionary &dictionary,
   int length = instance->size();
 
   pos_ids_.resize(length);
-  gazetteer_ids_.clear();
-  gazetteer_ids_.resize(length);
   for (int i = 0; i < length; i++) {
     int id = token_dictionary->GetPosTagId(instance->GetPosTag(i));
     CHECK_LT(id, 0xff);
     if (id < 0) id = TOKEN_UNKNOWN;
     pos_ids_[i] = id;
+  }
+
+  dictionary.GetSentenceGazetteerIds(instance, &gazetteer_ids_);
+}
+
+void EntityInstanceNumeric::Save(FILE *fs) {
+  bool success;
+  SequenceInstanceNumeric::Save(fs);
+  success = WriteCompactIntegerVector(fs, pos_ids_);
+  CHECK(success);
+  for (int i = 0; i < size(); ++i) {
+    success = WriteCompactIntegerVector(fs, gazetteer_ids_[i]);
+    CHECK(success);
+  }
+}
 
-    dictionary.GetWordGazetteerIds(instance->GetForm(i),
-                                   &gazetteer_ids_[i]);
-    //LOG(INFO) << instance->GetForm(i) << ": " << gazetteer_ids_[i].size();
+void EntityInstanceNumeric::Load(FILE *fs) {
+  bool success;
+  SequenceInstanceNumeric::Load(fs);
+  success = ReadCompactIntegerVector(fs, &pos_ids_);
+  CHECK(success);
+  gazetteer_ids_.resize(size());
+  for (int i = 0; i < size(); ++i) {
+    success = ReadCompactIntegerVector(fs, &gazetteer_ids_[i]);
+    CHECK(success);
   }
 }
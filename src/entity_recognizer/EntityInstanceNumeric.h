@@ -37,6 +37,9 @@ public:
   void Initialize(const EntityDictionary &dictionary,
                   EntityInstance *instance);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   const std::vector<int> &GetPosIds() const { return pos_ids_; }
 
   int GetPosId(int i) { return pos_ids_[i]; }
@@ -34,6 +34,12 @@ DEFINE_string(entity_tagging_scheme, "bio",
 DEFINE_string(entity_file_gazetteer, "",
               "Path to a gazetteer file (one entity per line with the "
               "corresponding class, separated by tabs.");
+DEFINE_bool(entity_gazetteer_phrases, true,
+            "True for matching the gazetteer entries as whole phrases, so "
+            "that a word gets the B/I/L/U gazetteer tags of the entries that "
+            "actually occur around it. If false, a word gets the tags of all "
+            "the positions where it occurs in any entry (as in older models). "
+            "Only used at training time; the model keeps the choice.");
 
 // Save current option flags to the model file.
 void EntityOptions::Save(FILE* fs) {
@@ -63,6 +69,7 @@ void EntityOptions::Initialize() {
 
   file_format_ = FLAGS_entity_file_format;
   file_gazetteer_ = FLAGS_entity_file_gazetteer;
+  gazetteer_phrases_ = FLAGS_entity_gazetteer_phrases;
   tagging_scheme_name_ = FLAGS_entity_tagging_scheme;
   if (tagging_scheme_name_ == "io") {
     tagging_scheme_ = EntityTaggingSchemes::IO;
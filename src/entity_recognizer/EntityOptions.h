@@ -44,11 +44,13 @@ public:
   // Get option flags.
   int tagging_scheme() { return tagging_scheme_; }
   const std::string &file_gazetteer() { return file_gazetteer_; }
+  bool gazetteer_phrases() { return gazetteer_phrases_; }
 
 protected:
   std::string file_format_;
   std::string tagging_scheme_name_;
   std::string file_gazetteer_;
+  bool gazetteer_phrases_;
   int tagging_scheme_;
 };
 
@@ -37,3 +37,19 @@ void EntityPipe::PreprocessData() {
   static_cast<SequenceDictionary*>(dictionary_)->
     CreateTagDictionary(GetSequenceReader());
 }
+
+// The tagging scheme determines the tags of the numeric instances and the
+// allowed bigrams of the dictionary.
+void EntityPipe::SaveCorpusOptions(FILE *fs) {
+  bool success = WriteInteger(fs, GetEntityOptions()->tagging_scheme());
+  CHECK(success);
+}
+
+void EntityPipe::LoadCorpusOptions(FILE *fs) {
+  int tagging_scheme;
+  bool success = ReadInteger(fs, &tagging_scheme);
+  CHECK(success);
+  CHECK_EQ(tagging_scheme, GetEntityOptions()->tagging_scheme())
+    << "The training corpus was converted with another "
+    << "--entity_tagging_scheme.";
+}
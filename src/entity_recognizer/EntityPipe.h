@@ -53,6 +53,9 @@ protected:
 
   void PreprocessData();
 
+  void SaveCorpusOptions(FILE *fs);
+  void LoadCorpusOptions(FILE *fs);
+
   Instance *GetFormattedInstance(Instance *instance) {
     EntityInstanceNumeric *instance_numeric = new EntityInstanceNumeric;
     instance_numeric->Initialize(*GetEntityDictionary(),
@@ -60,6 +63,12 @@ protected:
     return instance_numeric;
   }
 
+  Instance *CreateFormattedInstance() {
+    return new EntityInstanceNumeric;
+  }
+
+  Instance *CreateInstance() { return new EntityInstance; }
+
 protected:
   //void SaveModel(FILE* fs);
   //void LoadModel(FILE* fs);
@@ -0,0 +1,254 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "GazetteerTrie.h"
+#include "SerializationUtils.h"
+#include <glog/logging.h>
+
+// Lexicographic order of entries (by their word ids, then by label), so that
+// the entries below each node of the trie are contiguous and the shorter
+// ones come first.
+class GazetteerEntryComparator {
+public:
+  GazetteerEntryComparator(const vector<int> &entry_words,
+                           const vector<int> &entry_offsets,
+                           const vector<int> &entry_labels) :
+    entry_words_(entry_words),
+    entry_offsets_(entry_offsets),
+    entry_labels_(entry_labels) {}
+
+  bool operator()(int first, int second) const {
+    int i = entry_offsets_[first];
+    int j = entry_offsets_[second];
+    int first_end = entry_offsets_[first + 1];
+    int second_end = entry_offsets_[second + 1];
+    for (; i < first_end && j < second_end; ++i, ++j) {
+      if (entry_words_[i] != entry_words_[j]) {
+        return entry_words_[i] < entry_words_[j];
+      }
+    }
+    if (i < first_end) return false;
+    if (j < second_end) return true;
+    return entry_labels_[first] < entry_labels_[second];
+  }
+
+protected:
+  const vector<int> &entry_words_;
+  const vector<int> &entry_offsets_;
+  const vector<int> &entry_labels_;
+};
+
+void GazetteerTrie::Clear() {
+  first_child_.assign(2, 1);
+  words_.assign(1, -1);
+  depths_.assign(1, 0);
+  failures_.assign(1, 0);
+  output_links_.assign(1, -1);
+  first_label_.assign(2, 0);
+  labels_.clear();
+  root_children_.clear();
+}
+
+void GazetteerTrie::Build(const vector<int> &entry_words,
+                          const vector<int> &entry_offsets,
+                          const vector<int> &entry_labels) {
+  int num_entries = entry_labels.size();
+  CHECK_EQ(entry_offsets.size(), num_entries + 1);
+
+  vector<int> entries(num_entries);
+  for (int k = 0; k < num_entries; ++k) {
+    CHECK_LT(entry_offsets[k], entry_offsets[k + 1]);
+    entries[k] = k;
+  }
+  GazetteerEntryComparator comparator(entry_words, entry_offsets,
+                                      entry_labels);
+  sort(entries.begin(), entries.end(), comparator);
+
+  // Create the nodes in breadth-first order. Node n is the common prefix of
+  // length depths_[n] of the (sorted) entries entries[begins[n]], ...,
+  // entries[ends[n]-1].
+  first_child_.clear();
+  words_.assign(1, -1);
+  depths_.assign(1, 0);
+  first_label_.clear();
+  labels_.clear();
+  vector<int> begins(1, 0);
+  vector<int> ends(1, num_entries);
+  for (int node = 0; node < depths_.size(); ++node) {
+    int depth = depths_[node];
+    int k = begins[node];
+    // Entries of length "depth" end in this node.
+    first_label_.push_back(labels_.size());
+    for (; k < ends[node]; ++k) {
+      int entry = entries[k];
+      int length = entry_offsets[entry + 1] - entry_offsets[entry];
+      if (length > depth) break;
+      int label = entry_labels[entry];
+      if (labels_.size() == first_label_.back() || labels_.back() != label) {
+        labels_.push_back(label);
+      }
+    }
+    // Each distinct word in position "depth" of the remaining entries leads
+    // to a child.
+    first_child_.push_back(depths_.size());
+    while (k < ends[node]) {
+      int word_id = entry_words[entry_offsets[entries[k]] + depth];
+      CHECK_GE(word_id, 0);
+      int l = k + 1;
+      while (l < ends[node] &&
+             entry_words[entry_offsets[entries[l]] + depth] == word_id) {
+        ++l;
+      }
+      words_.push_back(word_id);
+      depths_.push_back(depth + 1);
+      begins.push_back(k);
+      ends.push_back(l);
+      k = l;
+    }
+  }
+  first_child_.push_back(depths_.size());
+  first_label_.push_back(labels_.size());
+
+  ComputeRootChildren();
+  ComputeLinks();
+}
+
+void GazetteerTrie::ComputeRootChildren() {
+  root_children_.clear();
+  for (int child = first_child_[0]; child < first_child_[1]; ++child) {
+    int word_id = words_[child];
+    if (word_id >= root_children_.size()) {
+      root_children_.resize(word_id + 1, -1);
+    }
+    root_children_[word_id] = child;
+  }
+}
+
+void GazetteerTrie::ComputeLinks() {
+  int num_nodes = depths_.size();
+  failures_.assign(num_nodes, 0);
+  output_links_.assign(num_nodes, -1);
+  // Since nodes are in breadth-first order, the links of a node only depend
+  // on the links of nodes with smaller numbers.
+  for (int node = 0; node < num_nodes; ++node) {
+    for (int child = first_child_[node]; child < first_child_[node + 1];
+         ++child) {
+      int failure = 0;
+      if (node != 0) {
+        int state = failures_[node];
+        while (true) {
+          failure = FindChild(state, words_[child]);
+          if (failure >= 0) break;
+          failure = 0;
+          if (state == 0) break;
+          state = failures_[state];
+        }
+      }
+      failures_[child] = failure;
+      output_links_[child] = HasLabels(failure) ? failure :
+        output_links_[failure];
+    }
+  }
+}
+
+void GazetteerTrie::Save(FILE *fs) const {
+  bool success;
+  success = WriteIntegerVector(fs, first_child_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, words_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, depths_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, failures_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, output_links_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, first_label_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, labels_);
+  CHECK(success);
+}
+
+void GazetteerTrie::Load(FILE *fs) {
+  bool success;
+  success = ReadIntegerVector(fs, &first_child_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &words_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &depths_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &failures_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &output_links_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &first_label_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &labels_);
+  CHECK(success);
+
+  int num_nodes = depths_.size();
+  CHECK_GT(num_nodes, 0);
+  CHECK_EQ(first_child_.size(), num_nodes + 1);
+  CHECK_EQ(words_.size(), num_nodes);
+  CHECK_EQ(failures_.size(), num_nodes);
+  CHECK_EQ(output_links_.size(), num_nodes);
+  CHECK_EQ(first_label_.size(), num_nodes + 1);
+
+  ComputeRootChildren();
+}
+
+void GazetteerTrie::FindMatches(const vector<int> &word_ids,
+                                vector<GazetteerMatch> *matches) const {
+  matches->clear();
+  int state = 0;
+  for (int j = 0; j < word_ids.size(); ++j) {
+    int word_id = word_ids[j];
+    if (word_id < 0) {
+      // No entry contains this word.
+      state = 0;
+      continue;
+    }
+    while (true) {
+      int child = FindChild(state, word_id);
+      if (child >= 0) {
+        state = child;
+        break;
+      }
+      if (state == 0) break;
+      state = failures_[state];
+    }
+    int node = HasLabels(state) ? state : output_links_[state];
+    for (; node >= 0; node = output_links_[node]) {
+      AddMatches(node, j, matches);
+    }
+  }
+}
+
+void GazetteerTrie::FindMatchesNaive(const vector<int> &word_ids,
+                                     vector<GazetteerMatch> *matches) const {
+  matches->clear();
+  for (int i = 0; i < word_ids.size(); ++i) {
+    int node = 0;
+    for (int j = i; j < word_ids.size(); ++j) {
+      if (word_ids[j] < 0) break;
+      node = FindChild(node, word_ids[j]);
+      if (node < 0) break;
+      AddMatches(node, j, matches);
+    }
+  }
+}
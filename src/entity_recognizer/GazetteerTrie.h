@@ -0,0 +1,136 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GAZETTEERTRIE_H_
+#define GAZETTEERTRIE_H_
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+// Occurrence of a gazetteer entry in a sentence, spanning the tokens from
+// start to end (both inclusive).
+struct GazetteerMatch {
+  int start;
+  int end;
+  int label;
+};
+
+// Trie of gazetteer entries (sequences of word ids, each with a label, e.g.
+// an entity type), with the links of an Aho-Corasick automaton, so that all
+// the occurrences of all the entries in a sentence are found in a single
+// left-to-right pass.
+// The nodes are numbered in breadth-first order and the children of each
+// node have consecutive numbers, sorted by word id. Hence the trie is stored
+// in a few flat arrays (which are saved and loaded as they are) and the child
+// of a node with a given word is found by binary search.
+class GazetteerTrie {
+public:
+  GazetteerTrie() { Clear(); }
+  virtual ~GazetteerTrie() {}
+
+  // Leave only the root.
+  void Clear();
+
+  // Build the trie from a list of entries. The words of the k-th entry are
+  // entry_words[entry_offsets[k]], ..., entry_words[entry_offsets[k+1]-1]
+  // (entry_offsets has one more element than entry_labels). Entries
+  // must be non-empty and word ids must be non-negative. Repeated entries
+  // with the same label are stored once.
+  void Build(const vector<int> &entry_words,
+             const vector<int> &entry_offsets,
+             const vector<int> &entry_labels);
+
+  void Save(FILE *fs) const;
+  void Load(FILE *fs);
+
+  int GetNumNodes() const { return depths_.size(); }
+  int GetNumLabels() const { return labels_.size(); }
+
+  // Find all the occurrences of the entries in a sequence of word ids
+  // (negative ids are words that do not occur in any entry), in a single
+  // pass using the failure links.
+  void FindMatches(const vector<int> &word_ids,
+                   vector<GazetteerMatch> *matches) const;
+
+  // Same as above, but walks down the trie from every position of the
+  // sentence. Slower for long entries; used for benchmarking and testing.
+  void FindMatchesNaive(const vector<int> &word_ids,
+                        vector<GazetteerMatch> *matches) const;
+
+protected:
+  // Child of a node with a given word id, or -1 if there is none.
+  int FindChild(int node, int word_id) const {
+    if (node == 0) {
+      if (word_id >= root_children_.size()) return -1;
+      return root_children_[word_id];
+    }
+    vector<int>::const_iterator begin = words_.begin() + first_child_[node];
+    vector<int>::const_iterator end = words_.begin() + first_child_[node + 1];
+    vector<int>::const_iterator it = lower_bound(begin, end, word_id);
+    if (it == end || *it != word_id) return -1;
+    return it - words_.begin();
+  }
+
+  bool HasLabels(int node) const {
+    return first_label_[node + 1] > first_label_[node];
+  }
+
+  // Add the matches of the entries ending in a node (without following
+  // output links) which ends at position "end".
+  void AddMatches(int node, int end, vector<GazetteerMatch> *matches) const {
+    for (int k = first_label_[node]; k < first_label_[node + 1]; ++k) {
+      GazetteerMatch match;
+      match.start = end - depths_[node] + 1;
+      match.end = end;
+      match.label = labels_[k];
+      matches->push_back(match);
+    }
+  }
+
+  // Compute the failure and output links from the children arrays.
+  void ComputeLinks();
+
+  // Fill root_children_ from the children arrays.
+  void ComputeRootChildren();
+
+protected:
+  // Children of node n: first_child_[n], ..., first_child_[n+1]-1.
+  vector<int> first_child_;
+  // Word id of the edge that leads to each node (-1 for the root).
+  vector<int> words_;
+  // Number of words of the path from the root to each node.
+  vector<int> depths_;
+  // Node of the longest proper suffix of the path of each node that is
+  // also a path in the trie.
+  vector<int> failures_;
+  // Nearest node following failure links which ends an entry (-1 if none).
+  vector<int> output_links_;
+  // Labels of the entries ending in node n: labels_[first_label_[n]], ...,
+  // labels_[first_label_[n+1]-1].
+  vector<int> first_label_;
+  vector<int> labels_;
+  // Child of the root with each word id (or -1). The root has a child for
+  // most words, so this table avoids a binary search for each word of a
+  // sentence. It is not saved, since it is cheap to compute.
+  vector<int> root_children_;
+};
+
+#endif /* GAZETTEERTRIE_H_ */
@@ -19,6 +19,7 @@
 #include "MorphologicalInstance.h"
 #include <glog/logging.h>
 #include "MorphologicalOptions.h"
+#include "SerializationUtils.h"
 
 void MorphologicalInstance::Initialize(const std::vector<std::string> &forms,
                                        const std::vector<std::string> &lemmas,
@@ -29,3 +30,21 @@ void MorphologicalInstance::Initialize(const std::vector<std::string> &forms,
   cpostags_ = cpostags;
   tags_ = tags;
 }
+
+void MorphologicalInstance::Save(FILE *fs) {
+  bool success;
+  SequenceInstance::Save(fs);
+  success = WriteStringVector(fs, lemmas_);
+  CHECK(success);
+  success = WriteStringVector(fs, cpostags_);
+  CHECK(success);
+}
+
+void MorphologicalInstance::Load(FILE *fs) {
+  bool success;
+  SequenceInstance::Load(fs);
+  success = ReadStringVector(fs, &lemmas_);
+  CHECK(success);
+  success = ReadStringVector(fs, &cpostags_);
+  CHECK(success);
+}
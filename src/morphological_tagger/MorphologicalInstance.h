@@ -40,6 +40,9 @@ public:
                   const std::vector<std::string> &cpostags,
                   const std::vector<std::string> &tags);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   const std::string &GetLemma(int i) const { return lemmas_[i]; }
   const std::string &GetCoarsePosTag(int i) const { return cpostags_[i]; }
 
@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "MorphologicalInstanceNumeric.h"
+#include "SerializationUtils.h"
 #include <iostream>
 #include <algorithm>
 
@@ -43,3 +44,21 @@ void MorphologicalInstanceNumeric::Initialize(const MorphologicalDictionary &dic
     cpostags_ids_[i] = id;
   }
 }
+
+void MorphologicalInstanceNumeric::Save(FILE *fs) {
+  bool success;
+  SequenceInstanceNumeric::Save(fs);
+  success = WriteCompactIntegerVector(fs, lemmas_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, cpostags_ids_);
+  CHECK(success);
+}
+
+void MorphologicalInstanceNumeric::Load(FILE *fs) {
+  bool success;
+  SequenceInstanceNumeric::Load(fs);
+  success = ReadCompactIntegerVector(fs, &lemmas_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &cpostags_ids_);
+  CHECK(success);
+}
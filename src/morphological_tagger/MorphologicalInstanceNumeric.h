@@ -37,6 +37,9 @@ public:
   void Initialize(const MorphologicalDictionary &dictionary,
                   MorphologicalInstance *instance);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   const std::vector<int> &GetCPosTagIds() const { return cpostags_ids_; }
   const std::vector<int> &GetLemmaIds(int i) const { return lemmas_ids_; }
 
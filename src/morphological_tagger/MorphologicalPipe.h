@@ -62,6 +62,12 @@ protected:
     return instance_numeric;
   }
 
+  Instance *CreateFormattedInstance() {
+    return new MorphologicalInstanceNumeric;
+  }
+
+  Instance *CreateInstance() { return new MorphologicalInstance; }
+
   void GetAllowedTags(Instance *instance, int i, vector<int> *allowed_tags) {
     // Make word-tag dictionary pruning.
     allowed_tags->clear();
@@ -9,6 +9,7 @@
 #include <gflags/gflags.h>
 #include "Utils.h"
 #include "MorphologicalPipe.h"
+#include "JackknifePipe.h"
 
 using namespace std;
 
@@ -47,10 +48,16 @@ void TrainMorphologicalTagger() {
   MorphologicalOptions *options = new MorphologicalOptions;
   options->Initialize();
 
-  MorphologicalPipe *pipe = new MorphologicalPipe(options);
-  pipe->Initialize();
-  pipe->Train();
-  pipe->SaveModelFile();
+  if (options->jackknife_folds() > 0) {
+    RunJackknife<MorphologicalPipe, MorphologicalOptions, MorphologicalReader,
+                 MorphologicalWriter>(options);
+  } else {
+    MorphologicalPipe *pipe = new MorphologicalPipe(options);
+    pipe->Initialize();
+    pipe->Train();
+    pipe->SaveModelFile();
+    delete pipe;
+  }
 
   gettimeofday(&end, NULL);
   time = diff_ms(end, start);
@@ -58,7 +65,6 @@ void TrainMorphologicalTagger() {
   LOG(INFO) << "Training took " << static_cast<double>(time) / 1000.0
     << " sec." << endl;
 
-  delete pipe;
   delete options;
 }
 
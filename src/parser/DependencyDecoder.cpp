@@ -87,8 +87,6 @@ void DependencyDecoder::DecodeMarginals(Instance *instance, Parts *parts,
   // Right now, only allow marginal inference for arc-factored models.
   CHECK(dependency_parts->IsArcFactored());
 
-  // Create copy of the scores.
-  vector<double> copied_scores(scores);
   vector<double> total_scores;
   vector<double> label_marginals;
   int offset_arcs, num_arcs;
@@ -97,12 +95,19 @@ void DependencyDecoder::DecodeMarginals(Instance *instance, Parts *parts,
   dependency_parts->GetOffsetLabeledArc(&offset_labeled_arcs,
                                         &num_labeled_arcs);
 
+  // Only the arc scores are modified, so they are kept in an overlay
+  // instead of copying all the scores.
+  vector<double> arc_scores(scores.begin() + offset_arcs,
+                            scores.begin() + offset_arcs + num_arcs);
+  ScoreView decoder_scores(scores);
+  decoder_scores.AddOverlay(offset_arcs, &arc_scores);
+
   // If labeled parsing, decode the labels and update the scores.
   if (pipe_->GetDependencyOptions()->labeled()) {
-    DecodeLabelMarginals(instance, parts, copied_scores, &total_scores,
+    DecodeLabelMarginals(instance, parts, scores, &total_scores,
                          &label_marginals);
     for (int r = 0; r < total_scores.size(); ++r) {
-      copied_scores[offset_arcs + r] += total_scores[r];
+      arc_scores[r] += total_scores[r];
     }
   }
 
@@ -111,10 +116,10 @@ void DependencyDecoder::DecodeMarginals(Instance *instance, Parts *parts,
 
   double log_partition_function;
   if (pipe_->GetDependencyOptions()->projective()) {
-    DecodeInsideOutside(instance, parts, copied_scores, predicted_output,
+    DecodeInsideOutside(instance, parts, decoder_scores, predicted_output,
                         &log_partition_function, entropy);
   } else {
-    DecodeMatrixTree(instance, parts, copied_scores, predicted_output,
+    DecodeMatrixTree(instance, parts, decoder_scores, predicted_output,
                      &log_partition_function, entropy);
   }
 
@@ -171,7 +176,7 @@ void DependencyDecoder::DecodeLabels(Instance *instance, Parts *parts,
   for (int r = 0; r < num_arcs; ++r) {
     DependencyPartArc *arc =
       static_cast<DependencyPartArc*>((*parts)[offset + r]);
-    const vector<int> &index_labeled_parts =
+    DependencyPartIndexRange index_labeled_parts =
       dependency_parts->FindLabeledArcs(arc->head(), arc->modifier());
     // Find the best label for each candidate arc.
     int best_label = -1;
@@ -208,7 +213,7 @@ void DependencyDecoder::DecodeLabelMarginals(Instance *instance, Parts *parts,
   for (int r = 0; r < num_arcs; ++r) {
     DependencyPartArc *arc =
       static_cast<DependencyPartArc*>((*parts)[offset + r]);
-    const vector<int> &index_labeled_parts =
+    DependencyPartIndexRange index_labeled_parts =
       dependency_parts->FindLabeledArcs(arc->head(), arc->modifier());
     // Find the best label for each candidate arc.
     LogValD total_score = LogValD::Zero();
@@ -230,50 +235,110 @@ void DependencyDecoder::DecodeLabelMarginals(Instance *instance, Parts *parts,
   }
 }
 
+// Minimum number of AD3 iterations when there is a time budget.
+// AD3 only updates its solution every 50 iterations, so the iteration
+// limits are of the form 50 * k + 1.
+const int kAD3InitialIterationsWithBudget = 51;
+
+void DependencyDecoder::ResetDecodingStatistics() {
+  decoding_time_histogram_.Initialize(0.125, 20);
+  ad3_iterations_histogram_.Initialize(1.0, 16);
+  num_unconverged_sentences_ = 0;
+  num_over_budget_sentences_ = 0;
+  num_first_order_sentences_ = 0;
+  ad3_time_ms_ = 0.0;
+  ad3_part_iterations_ = 0.0;
+}
+
+void DependencyDecoder::LogDecodingStatistics() {
+  if (decoding_time_histogram_.GetNumValues() == 0) return;
+  LOG(INFO) << "Decoding time (ms): mean "
+    << decoding_time_histogram_.GetMean() << ", p99 <= "
+    << decoding_time_histogram_.GetQuantileUpperBound(0.99) << ", max "
+    << decoding_time_histogram_.GetMax() << ".";
+  LOG(INFO) << "Decoding time histogram (ms): "
+    << decoding_time_histogram_.ToString();
+  if (ad3_iterations_histogram_.GetNumValues() > 0) {
+    LOG(INFO) << "AD3 iteration limit histogram: "
+      << ad3_iterations_histogram_.ToString();
+  }
+  LOG(INFO) << "Sentences where AD3 did not converge: "
+    << num_unconverged_sentences_ << "; sentences decoded with the "
+    << "first-order decoder because of the time budget: "
+    << num_first_order_sentences_ << "; sentences over the time budget: "
+    << num_over_budget_sentences_ << ".";
+}
+
 void DependencyDecoder::Decode(Instance *instance, Parts *parts,
                                const vector<double> &scores,
                                vector<double> *predicted_output) {
   DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+  bool test = pipe_->GetDependencyOptions()->test();
+  timeval start;
+  if (test) gettimeofday(&start, NULL);
 
-  // Create copy of the scores.
-  vector<double> copied_scores(scores);
   vector<int> best_labeled_parts;
   int offset_arcs, num_arcs;
   dependency_parts->GetOffsetArc(&offset_arcs, &num_arcs);
 
+  // Only the arc scores are modified, so they are kept in an overlay
+  // instead of copying all the scores.
+  vector<double> arc_scores(scores.begin() + offset_arcs,
+                            scores.begin() + offset_arcs + num_arcs);
+  ScoreView decoder_scores(scores);
+  decoder_scores.AddOverlay(offset_arcs, &arc_scores);
+
   // If labeled parsing, decode the labels and update the scores.
   if (pipe_->GetDependencyOptions()->labeled()) {
-    DecodeLabels(instance, parts, copied_scores, &best_labeled_parts);
+    DecodeLabels(instance, parts, scores, &best_labeled_parts);
     for (int r = 0; r < best_labeled_parts.size(); ++r) {
-      copied_scores[offset_arcs + r] += copied_scores[best_labeled_parts[r]];
+      arc_scores[r] += scores[best_labeled_parts[r]];
     }
   }
 
-  predicted_output->clear();
-  predicted_output->resize(parts->size(), 0.0);
+  predicted_output->assign(parts->size(), 0.0);
+
+  bool first_order = dependency_parts->IsArcFactored() ||
+    dependency_parts->IsLabeledArcFactored();
+  double time_budget_ms =
+    test ? pipe_->GetDependencyOptions()->GetDecodingTimeBudget() : 0.0;
+  if (!first_order && time_budget_ms > 0.0 && ad3_part_iterations_ > 0.0) {
+    // If not even the first AD3 run is expected to fit in the time budget
+    // (estimated from the previous runs), use only the arc scores.
+    double expected_time_ms = ad3_time_ms_ / ad3_part_iterations_ *
+      static_cast<double>(kAD3InitialIterationsWithBudget * parts->size());
+    if (expected_time_ms > time_budget_ms) {
+      first_order = true;
+      ++num_first_order_sentences_;
+    }
+  }
 
-  if (dependency_parts->IsArcFactored() ||
-      dependency_parts->IsLabeledArcFactored()) {
+  if (first_order) {
     double value;
-    DecodeBasic(instance, parts, copied_scores, predicted_output, &value);
+    DecodeBasic(instance, parts, decoder_scores, predicted_output, &value);
   } else {
 #ifdef USE_CPLEX
-    DecodeCPLEX(instance, parts, copied_scores, false, true, predicted_output);
+    DecodeCPLEX(instance, parts, decoder_scores, false, true, predicted_output);
 #else
-    DecodeFactorGraph(instance, parts, copied_scores, false, true,
-                      predicted_output);
+    int num_iterations;
+    int status = DecodeFactorGraph(instance, parts, decoder_scores, false,
+                                   true, predicted_output, &num_iterations);
+    if (test) {
+      ad3_iterations_histogram_.Add(num_iterations);
+      if (status == AD3::STATUS_UNSOLVED) ++num_unconverged_sentences_;
+    }
 #endif
     // At test time, run Chu-Liu-Edmonds on top of the outcome of AD3
     // as a rounding heuristic to make sure we get a valid tree.
     // TODO: maybe change the interface to AD3 to let us implement
     // a primal rounding heuristic - in this case just getting the output
     // coming from the TREE factor should work well enough.
-    if (pipe_->GetDependencyOptions()->test()) {
+    if (test) {
       for (int r = 0; r < num_arcs; ++r) {
-        copied_scores[offset_arcs + r] = (*predicted_output)[offset_arcs + r];
+        arc_scores[r] = (*predicted_output)[offset_arcs + r];
       }
       double value;
-      DecodeBasic(instance, parts, copied_scores, predicted_output, &value);
+      DecodeBasic(instance, parts, decoder_scores, predicted_output, &value);
     }
   }
 
@@ -285,17 +350,90 @@ void DependencyDecoder::Decode(Instance *instance, Parts *parts,
         (*predicted_output)[offset_arcs + r];
     }
   }
+
+  if (test) RecordDecodingTime(instance, start, time_budget_ms);
+}
+
+void DependencyDecoder::DecodeSparse(Instance *instance, Parts *parts,
+                                     const vector<double> &scores,
+                                     vector<int> *active_parts) {
+  DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+  if (!dependency_parts->IsArcFactored() &&
+      !dependency_parts->IsLabeledArcFactored()) {
+    // The factor graph decoder fills a dense output.
+    Decoder::DecodeSparse(instance, parts, scores, active_parts);
+    return;
+  }
+
+  bool test = pipe_->GetDependencyOptions()->test();
+  timeval start;
+  if (test) gettimeofday(&start, NULL);
+
+  vector<int> best_labeled_parts;
+  int offset_arcs, num_arcs;
+  dependency_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+
+  // As in Decode, the best label score of each arc is added to its score.
+  vector<double> arc_scores(scores.begin() + offset_arcs,
+                            scores.begin() + offset_arcs + num_arcs);
+  ScoreView decoder_scores(scores);
+  decoder_scores.AddOverlay(offset_arcs, &arc_scores);
+  bool labeled = pipe_->GetDependencyOptions()->labeled();
+  if (labeled) {
+    DecodeLabels(instance, parts, scores, &best_labeled_parts);
+    for (int r = 0; r < best_labeled_parts.size(); ++r) {
+      arc_scores[r] += scores[best_labeled_parts[r]];
+    }
+  }
+
+  vector<int> heads;
+  double value;
+  DecodeBasicHeads(instance, parts, decoder_scores, &heads, &value);
+
+  // The active parts are the arcs of the tree and their best labeled arcs.
+  active_parts->clear();
+  for (int m = 1; m < heads.size(); ++m) {
+    int r = dependency_parts->FindArc(heads[m], m);
+    if (r < 0) {
+      LOG(INFO) << "No arc " << heads[m] << " -> " << m;
+      continue;
+    }
+    active_parts->push_back(offset_arcs + r);
+    if (labeled) active_parts->push_back(best_labeled_parts[r]);
+  }
+
+  if (test) {
+    RecordDecodingTime(instance, start,
+                       pipe_->GetDependencyOptions()->GetDecodingTimeBudget());
+  }
+}
+
+void DependencyDecoder::RecordDecodingTime(Instance *instance,
+                                           const timeval &start,
+                                           double time_budget_ms) {
+  timeval end;
+  gettimeofday(&end, NULL);
+  double elapsed_ms = static_cast<double>(diff_us(end, start)) / 1000.0;
+  decoding_time_histogram_.Add(elapsed_ms);
+  if (time_budget_ms > 0.0 && elapsed_ms > time_budget_ms) {
+    ++num_over_budget_sentences_;
+    LOG(INFO) << "Sentence with "
+      << static_cast<DependencyInstanceNumeric*>(instance)->size() - 1
+      << " words exceeded the decoding time budget (" << elapsed_ms
+      << " ms).";
+  }
 }
 
 void DependencyDecoder::DecodePruner(Instance *instance, Parts *parts,
                                      const vector<double> &scores,
-                                     vector<double> *predicted_output) {
+                                     vector<double> *predicted_output,
+                                     double *min_margin) {
   int sentence_length =
     static_cast<DependencyInstanceNumeric*>(instance)->size();
   DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
   double posterior_threshold =
     pipe_->GetDependencyOptions()->GetPrunerPosteriorThreshold();
-  int max_heads = pipe_->GetDependencyOptions()->GetPrunerMaxHeads();
+  int max_heads = pipe_->GetPrunerMaxHeads();
   if (max_heads < 0) max_heads = sentence_length;
   predicted_output->clear();
   predicted_output->resize(parts->size(), 0.0);
@@ -308,23 +446,49 @@ void DependencyDecoder::DecodePruner(Instance *instance, Parts *parts,
   if (pipe_->GetDependencyOptions()->projective()) {
     DecodeInsideOutside(instance, parts, scores, &posteriors,
                         &log_partition_function, &entropy);
-  } else {
+  } else if (!DecodeMatrixTreePosteriors(instance, parts, scores,
+                                         &posteriors)) {
+    // Fall back to the log-domain computation if the rescaled one was not
+    // numerically stable.
+    VLOG(2) << "Falling back to log-domain marginals in the pruner.";
     DecodeMatrixTree(instance, parts, scores, &posteriors,
                      &log_partition_function, &entropy);
   }
 
+  // Only the best max_heads candidates of each modifier are needed, so
+  // sort them partially.
   int num_used_parts = 0;
+  if (min_margin) *min_margin = 1.0;
+  vector<pair<double, int> > scores_heads;
+  scores_heads.reserve(sentence_length);
   for (int m = 1; m < sentence_length; ++m) {
-    vector<pair<double, int> > scores_heads;
+    scores_heads.clear();
     for (int h = 0; h < sentence_length; ++h) {
       int r = dependency_parts->FindArc(h, m);
       if (r < 0) continue;
       scores_heads.push_back(pair<double, int>(-posteriors[r], r));
     }
     if (scores_heads.size() == 0) continue;
-    sort(scores_heads.begin(), scores_heads.end());
+    int num_heads = (max_heads < scores_heads.size()) ?
+      max_heads : scores_heads.size();
+    partial_sort(scores_heads.begin(), scores_heads.begin() + num_heads,
+                 scores_heads.end());
     double max_posterior = -scores_heads[0].first;
-    for (int k = 0; k < max_heads && k < scores_heads.size(); ++k) {
+    if (min_margin) {
+      double second_posterior = 0.0;
+      if (num_heads > 1) {
+        second_posterior = -scores_heads[1].first;
+      } else {
+        for (int k = 1; k < scores_heads.size(); ++k) {
+          if (-scores_heads[k].first > second_posterior) {
+            second_posterior = -scores_heads[k].first;
+          }
+        }
+      }
+      double margin = max_posterior - second_posterior;
+      if (margin < *min_margin) *min_margin = margin;
+    }
+    for (int k = 0; k < num_heads; ++k) {
       int r = scores_heads[k].second;
       // Note: better to put k == 0 because things could have gone
       // wrong with the marginal decoder and all parents could
@@ -381,7 +545,7 @@ void DependencyDecoder::DecodePrunerNaive(Instance *instance, Parts *parts,
 // using Edmonds' algorithm (which runs in O(n^2)) or, if the --projective
 // option is set, Eisner's algorithm (O(n^3)).
 void DependencyDecoder::DecodeBasic(Instance *instance, Parts *parts,
-                                    const vector<double> &scores,
+                                    const ScoreView &scores,
                                     vector<double> *predicted_output,
                                     double *value) {
   int sentence_length =
@@ -389,19 +553,9 @@ void DependencyDecoder::DecodeBasic(Instance *instance, Parts *parts,
   DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
   int offset_arcs, num_arcs;
   dependency_parts->GetOffsetArc(&offset_arcs, &num_arcs);
-  vector<DependencyPartArc*> arcs(num_arcs);
-  vector<double> scores_arcs(num_arcs);
-  for (int r = 0; r < num_arcs; ++r) {
-    arcs[r] = static_cast<DependencyPartArc*>((*parts)[offset_arcs + r]);
-    scores_arcs[r] = scores[offset_arcs + r];
-  }
 
   vector<int> heads;
-  if (pipe_->GetDependencyOptions()->projective()) {
-    RunEisner(sentence_length, arcs, scores_arcs, &heads, value);
-  } else {
-    RunChuLiuEdmonds(sentence_length, arcs, scores_arcs, &heads, value);
-  }
+  DecodeBasicHeads(instance, parts, scores, &heads, value);
 
   predicted_output->resize(parts->size());
   for (int r = 0; r < num_arcs; ++r) {
@@ -418,6 +572,29 @@ void DependencyDecoder::DecodeBasic(Instance *instance, Parts *parts,
   }
 }
 
+void DependencyDecoder::DecodeBasicHeads(Instance *instance, Parts *parts,
+                                         const ScoreView &scores,
+                                         vector<int> *heads,
+                                         double *value) {
+  int sentence_length =
+    static_cast<DependencyInstanceNumeric*>(instance)->size();
+  DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+  int offset_arcs, num_arcs;
+  dependency_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+  vector<DependencyPartArc*> arcs(num_arcs);
+  vector<double> scores_arcs(num_arcs);
+  for (int r = 0; r < num_arcs; ++r) {
+    arcs[r] = static_cast<DependencyPartArc*>((*parts)[offset_arcs + r]);
+    scores_arcs[r] = scores[offset_arcs + r];
+  }
+
+  if (pipe_->GetDependencyOptions()->projective()) {
+    RunEisner(sentence_length, arcs, scores_arcs, heads, value);
+  } else {
+    RunChuLiuEdmonds(sentence_length, arcs, scores_arcs, heads, value);
+  }
+}
+
 // Decoder for the basic model; it finds a maximum weighted arborescence
 // using Edmonds' algorithm (which runs in O(n^2)).
 void DependencyDecoder::RunChuLiuEdmondsIteration(
@@ -503,6 +680,7 @@ void DependencyDecoder::RunChuLiuEdmondsIteration(
   }
 
   // Contract the cycle.
+  IncrementProfilerCount(PROFILER_COUNTER_CLE_CONTRACTIONS, 1);
   // 1) Update the score of each child to the maximum score achieved by a parent
   // node in the cycle.
   vector<int> best_heads_cycle(length);
@@ -1015,7 +1193,7 @@ void DependencyDecoder::RunEisnerOutside(
 // Marginal decoder for the projective basic model; it runs Eisner's
 // inside-outside algorithm.
 void DependencyDecoder::DecodeInsideOutside(Instance *instance, Parts *parts,
-                                            const vector<double> &scores,
+                                            const ScoreView &scores,
                                             vector<double> *predicted_output,
                                             double *log_partition_function,
                                             double *entropy) {
@@ -1093,7 +1271,7 @@ void DependencyDecoder::DecodeInsideOutside(Instance *instance, Parts *parts,
 
 // Marginal decoder for the basic model; it invokes the matrix-tree theorem.
 void DependencyDecoder::DecodeMatrixTree(Instance *instance, Parts *parts,
-                                         const vector<double> &scores,
+                                         const ScoreView &scores,
                                          vector<double> *predicted_output,
                                          double *log_partition_function,
                                          double *entropy) {
@@ -1186,12 +1364,89 @@ void DependencyDecoder::DecodeMatrixTree(Instance *instance, Parts *parts,
   }
 }
 
+// Compute the arc marginals of a non-projective arc-factored model with the
+// matrix-tree theorem, as in DecodeMatrixTree, but using plain doubles rather
+// than log-domain values, so that Eigen can use its vectorized LU
+// decomposition. To avoid overflows, the scores of the arcs of each modifier
+// are shifted by their maximum; this scales a column of the Kirchhoff matrix
+// and therefore leaves the marginals unchanged. Neither the partition
+// function nor the entropy are computed, which is all the pruner needs.
+// Returns false if the result is not finite (e.g. the Kirchhoff matrix is
+// numerically singular), in which case DecodeMatrixTree should be used.
+bool DependencyDecoder::DecodeMatrixTreePosteriors(Instance *instance,
+                                                   Parts *parts,
+                                                   const vector<double> &scores,
+                                                   vector<double> *posteriors) {
+  int sentence_length =
+    static_cast<DependencyInstanceNumeric*>(instance)->size();
+  DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+  int offset_arcs, num_arcs;
+  dependency_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+  posteriors->assign(parts->size(), 0.0);
+  if (sentence_length <= 1) return true;
+
+  // Largest score of the candidate heads of each modifier.
+  vector<double> max_scores(sentence_length, 0.0);
+  vector<bool> has_heads(sentence_length, false);
+  for (int r = 0; r < num_arcs; ++r) {
+    DependencyPartArc *arc =
+      static_cast<DependencyPartArc*>((*parts)[offset_arcs + r]);
+    int m = arc->modifier();
+    if (!has_heads[m] || scores[offset_arcs + r] > max_scores[m]) {
+      max_scores[m] = scores[offset_arcs + r];
+      has_heads[m] = true;
+    }
+  }
+
+  // Kirchhoff matrix, with rows indexed by heads and columns by modifiers
+  // (both excluding the root). The potentials of the arcs from the root only
+  // appear in the diagonal.
+  Eigen::MatrixXd kirchhoff =
+    Eigen::MatrixXd::Zero(sentence_length - 1, sentence_length - 1);
+  Eigen::VectorXd root_potentials = Eigen::VectorXd::Zero(sentence_length);
+  for (int r = 0; r < num_arcs; ++r) {
+    DependencyPartArc *arc =
+      static_cast<DependencyPartArc*>((*parts)[offset_arcs + r]);
+    int h = arc->head();
+    int m = arc->modifier();
+    double potential = exp(scores[offset_arcs + r] - max_scores[m]);
+    kirchhoff(m - 1, m - 1) += potential;
+    if (h == 0) {
+      root_potentials(m) = potential;
+    } else {
+      kirchhoff(h - 1, m - 1) -= potential;
+    }
+  }
+
+  Eigen::PartialPivLU<Eigen::MatrixXd> lu(kirchhoff);
+  Eigen::MatrixXd inverted_kirchhoff = lu.inverse();
+
+  for (int r = 0; r < num_arcs; ++r) {
+    DependencyPartArc *arc =
+      static_cast<DependencyPartArc*>((*parts)[offset_arcs + r]);
+    int h = arc->head();
+    int m = arc->modifier();
+    double marginal;
+    if (h == 0) {
+      marginal = root_potentials(m) * inverted_kirchhoff(m - 1, m - 1);
+    } else {
+      double potential = exp(scores[offset_arcs + r] - max_scores[m]);
+      marginal = potential * (inverted_kirchhoff(m - 1, m - 1) -
+                              inverted_kirchhoff(m - 1, h - 1));
+    }
+    if (std::isnan(marginal) || std::isinf(marginal)) return false;
+    (*posteriors)[offset_arcs + r] = marginal;
+  }
+  return true;
+}
+
 // Decode building a factor graph and calling the AD3 algorithm.
-void DependencyDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
-                                          const vector<double> &scores,
-                                          bool single_root,
-                                          bool relax,
-                                          vector<double> *predicted_output) {
+int DependencyDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
+                                         const ScoreView &scores,
+                                         bool single_root,
+                                         bool relax,
+                                         vector<double> *predicted_output,
+                                         int *num_iterations) {
   DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
   DependencyInstanceNumeric* sentence =
     static_cast<DependencyInstanceNumeric*>(instance);
@@ -2544,24 +2799,80 @@ void DependencyDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   double value_ref;
   double *value = &value_ref;
 
-  factor_graph->SetMaxIterationsAD3(500);
-  //factor_graph->SetMaxIterationsAD3(200);
+  int max_iterations = pipe_->GetDependencyOptions()->GetAD3MaxIterations();
+  double time_budget_ms = 0.0;
+  if (pipe_->GetDependencyOptions()->test()) {
+    time_budget_ms = pipe_->GetDependencyOptions()->GetDecodingTimeBudget();
+  }
   factor_graph->SetEtaAD3(0.05);
   factor_graph->AdaptEtaAD3(true);
   factor_graph->SetResidualThresholdAD3(1e-3);
   //factor_graph->SetResidualThresholdAD3(1e-6);
 
-  // Run AD3.
+  // Run AD3. With a time budget, the iteration limit is set from the cost of
+  // the previous runs (or to a small number if that is unknown), and
+  // doubled (restarting AD3) while AD3 does not converge and the next run is
+  // expected to fit in the budget. The solution of the last run is then
+  // rounded by the caller.
   timeval start, end;
   gettimeofday(&start, NULL);
+  int status = AD3::STATUS_OPTIMAL_INTEGER;
+  *num_iterations = 0;
   if (!solved) {
-    factor_graph->SolveLPMAPWithAD3(&posteriors, &additional_posteriors, value);
+    int num_parts = parts->size();
+    int iterations = max_iterations;
+    if (time_budget_ms > 0.0) {
+      iterations = kAD3InitialIterationsWithBudget;
+      if (ad3_part_iterations_ > 0.0) {
+        // Start directly with as many iterations as are expected to fit in
+        // the budget, to avoid restarting AD3.
+        double expected_iterations = time_budget_ms * ad3_part_iterations_ /
+          (ad3_time_ms_ * static_cast<double>(num_parts));
+        int num_blocks = static_cast<int>((expected_iterations - 1.0) / 50.0);
+        if (50 * num_blocks + 1 > iterations) iterations = 50 * num_blocks + 1;
+      }
+      if (iterations > max_iterations) iterations = max_iterations;
+    }
+    while (true) {
+      timeval start_run;
+      gettimeofday(&start_run, NULL);
+      factor_graph->SetMaxIterationsAD3(iterations);
+      status = factor_graph->SolveLPMAPWithAD3(&posteriors,
+                                               &additional_posteriors,
+                                               value);
+      *num_iterations = iterations;
+      IncrementProfilerCount(PROFILER_COUNTER_AD3_ITERATIONS, iterations);
+      gettimeofday(&end, NULL);
+      double elapsed_ms = static_cast<double>(diff_us(end, start)) / 1000.0;
+      double run_ms = static_cast<double>(diff_us(end, start_run)) / 1000.0;
+      if (status == AD3::STATUS_UNSOLVED) {
+        // Keep track of the cost of AD3 per part and iteration (this is
+        // only exact if AD3 did not converge).
+        ad3_time_ms_ += run_ms;
+        ad3_part_iterations_ += static_cast<double>(iterations) *
+          static_cast<double>(num_parts);
+      }
+      if (status != AD3::STATUS_UNSOLVED || iterations >= max_iterations) {
+        break;
+      }
+      if (elapsed_ms + 2.0 * run_ms > time_budget_ms) {
+        VLOG(2) << "AD3 stopped after " << iterations
+          << " iterations because of the time budget.";
+        break;
+      }
+      iterations = 2 * (iterations - 1) + 1;
+      if (iterations > max_iterations) iterations = max_iterations;
+    }
   }
   gettimeofday(&end, NULL);
   double elapsed_time = diff_ms(end, start);
   VLOG(2) << "Elapsed time (AD3) = " << elapsed_time
     << " (" << sentence->size() << ") ";
 
+  if (ProfilesMemory()) {
+    RecordProfilerMemory(PROFILER_MEMORY_FACTOR_GRAPH,
+                         EstimateFactorGraphBytes(factor_graph));
+  }
   delete factor_graph;
 
   *value = 0.0;
@@ -2593,6 +2904,8 @@ void DependencyDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   }
 
   VLOG(2) << "Solution value (AD3) = " << *value;
+
+  return status;
 }
 
 #ifdef USE_CPLEX
@@ -2603,7 +2916,7 @@ void DependencyDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
 ILOSTLBEGIN
 
 void DependencyDecoder::DecodeCPLEX(Instance *instance, Parts *parts,
-                                    const vector<double> &scores,
+                                    const ScoreView &scores,
                                     bool single_root,
                                     bool relax,
                                     vector<double> *predicted_output) {
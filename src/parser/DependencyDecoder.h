@@ -20,24 +20,58 @@
 #define DEPENDENCYDECODER_H_
 
 #include "Decoder.h"
+#include "ScoreView.h"
 #include "DependencyPart.h"
 #include "ad3/FactorGraph.h"
+#include "Histogram.h"
+#include "TimeUtils.h"
 
 class DependencyPipe;
 
 class DependencyDecoder : public Decoder {
 public:
-  DependencyDecoder() {};
-  DependencyDecoder(DependencyPipe *pipe) : pipe_(pipe) {};
+  DependencyDecoder() { ResetDecodingStatistics(); };
+  DependencyDecoder(DependencyPipe *pipe) : pipe_(pipe) {
+    ResetDecodingStatistics();
+  };
   virtual ~DependencyDecoder() {};
 
+  // Statistics of the sentences decoded at test time: histograms of the
+  // decoding time (in milliseconds) and of the AD3 iteration limit of the
+  // last AD3 run (the actual number of iterations if AD3 did not converge,
+  // an upper bound otherwise), and number of sentences for
+  // which AD3 did not converge, which were decoded with the first-order
+  // decoder because AD3 was not expected to fit in the time budget, or
+  // which exceeded the time budget.
+  void ResetDecodingStatistics();
+  void LogDecodingStatistics();
+  const Histogram &GetDecodingTimeHistogram() {
+    return decoding_time_histogram_;
+  }
+  const Histogram &GetAD3IterationsHistogram() {
+    return ad3_iterations_histogram_;
+  }
+  int GetNumUnconvergedSentences() { return num_unconverged_sentences_; }
+  int GetNumOverBudgetSentences() { return num_over_budget_sentences_; }
+  int GetNumFirstOrderSentences() { return num_first_order_sentences_; }
+
   void Decode(Instance *instance, Parts *parts,
               const vector<double> &scores,
               vector<double> *predicted_output);
 
+  // For arc-factored models, the active parts are read from the tree found
+  // by the basic decoder. Other models are decoded with Decode.
+  void DecodeSparse(Instance *instance, Parts *parts,
+                    const vector<double> &scores,
+                    vector<int> *active_parts);
+
+  // If min_margin is not NULL, it receives the smallest difference, over
+  // all words, between the posteriors of their two most likely heads (a
+  // measure of the confidence of the pruner about the sentence).
   void DecodePruner(Instance *instance, Parts *parts,
                     const vector<double> &scores,
-                    vector<double> *predicted_output);
+                    vector<double> *predicted_output,
+                    double *min_margin);
 
   void DecodePrunerNaive(Instance *instance, Parts *parts,
                          const vector<double> &scores,
@@ -90,27 +124,45 @@ protected:
                             vector<double> *label_marginals);
 
   void DecodeBasic(Instance *instance, Parts *parts,
-                   const vector<double> &scores,
+                   const ScoreView &scores,
                    vector<double> *predicted_output,
                    double *value);
 
+  // Find the head of each word with the basic decoder.
+  void DecodeBasicHeads(Instance *instance, Parts *parts,
+                        const ScoreView &scores,
+                        vector<int> *heads,
+                        double *value);
+
+  // Add the time spent decoding an instance at test time, since start, to
+  // the decoding statistics.
+  void RecordDecodingTime(Instance *instance, const timeval &start,
+                          double time_budget_ms);
+
   void DecodeMatrixTree(Instance *instance, Parts *parts,
-                        const vector<double> &scores,
+                        const ScoreView &scores,
                         vector<double> *predicted_output,
                         double *log_partition_function,
                         double *entropy);
 
+  bool DecodeMatrixTreePosteriors(Instance *instance, Parts *parts,
+                                  const vector<double> &scores,
+                                  vector<double> *posteriors);
+
   void DecodeInsideOutside(Instance *instance, Parts *parts,
-                           const vector<double> &scores,
+                           const ScoreView &scores,
                            vector<double> *predicted_output,
                            double *log_partition_function,
                            double *entropy);
 
-  void DecodeFactorGraph(Instance *instance, Parts *parts,
-                         const vector<double> &scores,
-                         bool single_root,
-                         bool relax,
-                         vector<double> *predicted_output);
+  // Returns the AD3 status, and the iteration limit of the last AD3 run in
+  // num_iterations.
+  int DecodeFactorGraph(Instance *instance, Parts *parts,
+                        const ScoreView &scores,
+                        bool single_root,
+                        bool relax,
+                        vector<double> *predicted_output,
+                        int *num_iterations);
 
   void RunChuLiuEdmondsIteration(vector<bool> *disabled,
                                  vector<vector<int> > *candidate_heads,
@@ -140,13 +192,22 @@ protected:
 
 #ifdef USE_CPLEX
   void DecodeCPLEX(Instance *instance, Parts *parts,
-                   const vector<double> &scores,
+                   const ScoreView &scores,
                    bool single_root,
                    bool relax,
                    vector<double> *predicted_output);
 #endif
 protected:
   DependencyPipe *pipe_;
+  Histogram decoding_time_histogram_;
+  Histogram ad3_iterations_histogram_;
+  int num_unconverged_sentences_;
+  int num_over_budget_sentences_;
+  int num_first_order_sentences_;
+  // Total time (in milliseconds) and number of parts times iterations of
+  // the AD3 runs that did not converge, to estimate the cost of AD3.
+  double ad3_time_ms_;
+  double ad3_part_iterations_;
 };
 
 #endif /* DEPENDENCYDECODER_H_ */
@@ -91,6 +91,65 @@ void DependencyFeatures::AddArcFeatures(DependencyInstanceNumeric* sentence,
                       head, modifier, true, true, features);
 }
 
+void DependencyFeatures::ComputeArcScoresLight(
+  DependencyInstanceNumeric* sentence,
+  Parts *parts,
+  Parameters *parameters,
+  vector<double> *scores) {
+  DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+  int sentence_length = sentence->size();
+  int offset, num_arcs;
+  dependency_parts->GetOffsetArc(&offset, &num_arcs);
+  scores->assign(parts->size(), 0.0);
+
+  // Partial scores of each word as a head (or modifier) attaching to the
+  // left (direction 0) or to the right (direction 1).
+  vector<double> head_scores(2 * sentence_length, 0.0);
+  vector<double> modifier_scores(2 * sentence_length, 0.0);
+  vector<bool> computed_head_scores(2 * sentence_length, false);
+  vector<bool> computed_modifier_scores(2 * sentence_length, false);
+  BinaryFeatures features;
+  int num_misses = 0;
+  for (int r = 0; r < num_arcs; ++r) {
+    DependencyPartArc *arc =
+      static_cast<DependencyPartArc*>((*parts)[offset + r]);
+    int h = arc->head();
+    int m = arc->modifier();
+    int direction = (m < h) ? 0 : 1;
+    int k = 2 * h + direction;
+    if (!computed_head_scores[k]) {
+      ++num_misses;
+      features.clear();
+      AddWordPairFeaturesBySide(sentence, DependencyFeatureTemplateParts::ARC,
+                                h, m, false, false, WORDPAIR_HEAD_SIDE,
+                                &features);
+      head_scores[k] = parameters->ComputeScore(features);
+      computed_head_scores[k] = true;
+    }
+    int l = 2 * m + direction;
+    if (!computed_modifier_scores[l]) {
+      ++num_misses;
+      features.clear();
+      AddWordPairFeaturesBySide(sentence, DependencyFeatureTemplateParts::ARC,
+                                h, m, false, false, WORDPAIR_MODIFIER_SIDE,
+                                &features);
+      modifier_scores[l] = parameters->ComputeScore(features);
+      computed_modifier_scores[l] = true;
+    }
+    features.clear();
+    AddWordPairFeaturesBySide(sentence, DependencyFeatureTemplateParts::ARC,
+                              h, m, false, false, WORDPAIR_PAIR_SIDE,
+                              &features);
+    (*scores)[offset + r] = head_scores[k] + modifier_scores[l] +
+      parameters->ComputeScore(features);
+  }
+
+  // Each arc looks up a head and a modifier partial score.
+  Profiler *profiler = pipe_->GetProfiler();
+  profiler->Increment(PROFILER_COUNTER_CACHE_MISSES, num_misses);
+  profiler->Increment(PROFILER_COUNTER_CACHE_HITS, 2 * num_arcs - num_misses);
+}
+
 // Add features for arbitrary siblings.
 void DependencyFeatures::AddArbitrarySiblingFeatures(
   DependencyInstanceNumeric* sentence,
@@ -936,6 +995,28 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
                                              bool use_lemma_features,
                                              bool use_morphological_features,
                                              BinaryFeatures *features) {
+  AddWordPairFeaturesBySide(sentence, pair_type, head, modifier,
+                            use_lemma_features, use_morphological_features,
+                            WORDPAIR_ALL_SIDES, features);
+}
+
+// Same as above, but only adds the features of the given sides (a bitmask of
+// WORDPAIR_HEAD_SIDE, WORDPAIR_MODIFIER_SIDE and WORDPAIR_PAIR_SIDE).
+// Head-side features only depend on the head word, its context and the
+// direction of the pair (likewise for modifier-side features); pair-side
+// features depend on both words or on their distance. The relative order of
+// the features is the same as when adding all of them.
+void DependencyFeatures::AddWordPairFeaturesBySide(
+  DependencyInstanceNumeric* sentence,
+  int pair_type,
+  int head,
+  int modifier,
+  bool use_lemma_features,
+  bool use_morphological_features,
+  int sides,
+  BinaryFeatures *features) {
+  bool head_side = (sides & WORDPAIR_HEAD_SIDE);
+  bool modifier_side = (sides & WORDPAIR_MODIFIER_SIDE);
   int sentence_length = sentence->size();
   // True if labeled dependency parsing.
   bool labeled =
@@ -1007,7 +1088,8 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
   int num_between_verb = 0;
   int num_between_punc = 0;
   int num_between_coord = 0;
-  for (int i = left_position + 1; i < right_position; ++i) {
+  for (int i = left_position + 1;
+       (sides & WORDPAIR_PAIR_SIDE) && i < right_position; ++i) {
     if (sentence->IsVerb(i)) {
       ++num_between_verb;
     } else if (sentence->IsPunctuation(i)) {
@@ -1103,55 +1185,57 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
   flags = feature_type; // 4 bits.
   flags |= (direction_code << 4); // 1 more bit.
 
-  // Bias feature (not in EGSTRA).
-  fkey = encoder_.CreateFKey_NONE(DependencyFeatureTemplateArc::BIAS, flags);
-  AddFeature(fkey, features);
+  if (head_side) {
+    // Bias feature (not in EGSTRA).
+    fkey = encoder_.CreateFKey_NONE(DependencyFeatureTemplateArc::BIAS, flags);
+    AddFeature(fkey, features);
 
-  /////////////////////////////////////////////////////////////////////////////
-  // Token features.
-  /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////
+    // Token features.
+    /////////////////////////////////////////////////////////////////////////////
 
-  // Note: in EGSTRA (but not here), token and token contextual features go
-  // without direction flags.
-  // Coarse POS features.
-  fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::HP, flags, HPID);
-  AddFeature(fkey, features);
-  // Fine POS features.
-  fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::HQ, flags, HQID);
-  AddFeature(fkey, features);
-  // Lexical features.
-  fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::HW, flags, HWID);
-  AddFeature(fkey, features);
-  if (use_lemma_features) {
-    fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::HL, flags, HLID);
+    // Note: in EGSTRA (but not here), token and token contextual features go
+    // without direction flags.
+    // Coarse POS features.
+    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::HP, flags, HPID);
     AddFeature(fkey, features);
-  }
-  // Features involving words and POS.
-  fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::HWP, flags, HWID, HPID);
-  AddFeature(fkey, features);
-  // Morpho-syntactic features.
-  // Technically should add context here too to match egstra, but I don't think it
-  // would add much relevant information.
-  if (use_morphological_features) {
-    for (int j = 0; j < sentence->GetNumMorphFeatures(head); ++j) {
-      HFID = sentence->GetMorphFeature(head, j);
-      CHECK_LT(HFID, 0xfff);
-      if (j >= 0xf) {
-        LOG(WARNING) << "Too many morphological features (" << j << ")";
-        HFID = (HFID << 4) | ((uint16_t)0xf);
-      } else {
-        HFID = (HFID << 4) | ((uint16_t)j);
-      }
-      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::HF, flags, HFID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WW(DependencyFeatureTemplateArc::HWF, flags, HWID, HFID);
+    // Fine POS features.
+    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::HQ, flags, HQID);
+    AddFeature(fkey, features);
+    // Lexical features.
+    fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::HW, flags, HWID);
+    AddFeature(fkey, features);
+    if (use_lemma_features) {
+      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::HL, flags, HLID);
       AddFeature(fkey, features);
     }
+    // Features involving words and POS.
+    fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::HWP, flags, HWID, HPID);
+    AddFeature(fkey, features);
+    // Morpho-syntactic features.
+    // Technically should add context here too to match egstra, but I don't think it
+    // would add much relevant information.
+    if (use_morphological_features) {
+      for (int j = 0; j < sentence->GetNumMorphFeatures(head); ++j) {
+        HFID = sentence->GetMorphFeature(head, j);
+        CHECK_LT(HFID, 0xfff);
+        if (j >= 0xf) {
+          LOG(WARNING) << "Too many morphological features (" << j << ")";
+          HFID = (HFID << 4) | ((uint16_t)0xf);
+        } else {
+          HFID = (HFID << 4) | ((uint16_t)j);
+        }
+        fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::HF, flags, HFID);
+        AddFeature(fkey, features);
+        fkey = encoder_.CreateFKey_WW(DependencyFeatureTemplateArc::HWF, flags, HWID, HFID);
+        AddFeature(fkey, features);
+      }
+    }
   }
 
   // If labeled parsing, features involving the modifier only are still useful,
   // since they will be conjoined with the label.
-  if (labeled) {
+  if (labeled && modifier_side) {
     fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::MP, flags, MPID);
     AddFeature(fkey, features);
     fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::MQ, flags, MQID);
@@ -1185,32 +1269,34 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
   /////////////////////////////////////////////////////////////////////////////
 
   if (max_token_context >= 1) {
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::pHP, flags, pHPID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nHP, flags, nHPID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::pHQ, flags, pHQID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nHQ, flags, nHQID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::pHW, flags, pHWID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nHW, flags, nHWID);
-    AddFeature(fkey, features);
-    if (use_lemma_features) {
-      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::pHL, flags, pHLID);
+    if (head_side) {
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::pHP, flags, pHPID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nHP, flags, nHPID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::pHQ, flags, pHQID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nHQ, flags, nHQID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::pHW, flags, pHWID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nHW, flags, nHWID);
+      AddFeature(fkey, features);
+      if (use_lemma_features) {
+        fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::pHL, flags, pHLID);
+        AddFeature(fkey, features);
+        fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nHL, flags, nHLID);
+        AddFeature(fkey, features);
+      }
+      fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::pHWP, flags, pHWID, pHPID);
       AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nHL, flags, nHLID);
+      fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::nHWP, flags, nHWID, nHPID);
       AddFeature(fkey, features);
     }
-    fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::pHWP, flags, pHWID, pHPID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::nHWP, flags, nHWID, nHPID);
-    AddFeature(fkey, features);
 
     // If labeled parsing, features involving the modifier only are still useful,
     // since they will be conjoined with the label.
-    if (labeled) {
+    if (labeled && modifier_side) {
       fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::pMP, flags, pMPID);
       AddFeature(fkey, features);
       fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nMP, flags, nMPID);
@@ -1237,32 +1323,34 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
   }
 
   if (max_token_context >= 2) {
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::ppHP, flags, ppHPID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nnHP, flags, nnHPID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::ppHQ, flags, ppHQID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nnHQ, flags, nnHQID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::ppHW, flags, ppHWID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nnHW, flags, nnHWID);
-    AddFeature(fkey, features);
-    if (use_lemma_features) {
-      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::ppHL, flags, ppHLID);
+    if (head_side) {
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::ppHP, flags, ppHPID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nnHP, flags, nnHPID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::ppHQ, flags, ppHQID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nnHQ, flags, nnHQID);
       AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nnHL, flags, nnHLID);
+      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::ppHW, flags, ppHWID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nnHW, flags, nnHWID);
+      AddFeature(fkey, features);
+      if (use_lemma_features) {
+        fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::ppHL, flags, ppHLID);
+        AddFeature(fkey, features);
+        fkey = encoder_.CreateFKey_W(DependencyFeatureTemplateArc::nnHL, flags, nnHLID);
+        AddFeature(fkey, features);
+      }
+      fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::ppHWP, flags, ppHWID, ppHPID);
+      AddFeature(fkey, features);
+      fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::nnHWP, flags, nnHWID, nnHPID);
       AddFeature(fkey, features);
     }
-    fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::ppHWP, flags, ppHWID, ppHPID);
-    AddFeature(fkey, features);
-    fkey = encoder_.CreateFKey_WP(DependencyFeatureTemplateArc::nnHWP, flags, nnHWID, nnHPID);
-    AddFeature(fkey, features);
 
     // If labeled parsing, features involving the modifier only are still useful,
     // since they will be conjoined with the label.
-    if (labeled) {
+    if (labeled && modifier_side) {
       fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::ppMP, flags, ppMPID);
       AddFeature(fkey, features);
       fkey = encoder_.CreateFKey_P(DependencyFeatureTemplateArc::nnMP, flags, nnMPID);
@@ -1289,18 +1377,20 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
   }
 
   // Contextual bigram and trigram features involving POS.
-  fkey = encoder_.CreateFKey_PP(DependencyFeatureTemplateArc::HP_pHP, flags, HPID, pHPID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_pHP_ppHP, flags, HPID, pHPID, ppHPID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_PP(DependencyFeatureTemplateArc::HP_nHP, flags, HPID, nHPID);
-  AddFeature(fkey, features);
-  fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_nHP_nnHP, flags, HPID, nHPID, nnHPID);
-  AddFeature(fkey, features);
+  if (head_side) {
+    fkey = encoder_.CreateFKey_PP(DependencyFeatureTemplateArc::HP_pHP, flags, HPID, pHPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_pHP_ppHP, flags, HPID, pHPID, ppHPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_PP(DependencyFeatureTemplateArc::HP_nHP, flags, HPID, nHPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_nHP_nnHP, flags, HPID, nHPID, nnHPID);
+    AddFeature(fkey, features);
+  }
 
   // If labeled parsing, features involving the modifier only are still useful,
   // since they will be conjoined with the label.
-  if (labeled) {
+  if (labeled && modifier_side) {
     fkey = encoder_.CreateFKey_PP(DependencyFeatureTemplateArc::MP_pMP, flags, MPID, pMPID);
     AddFeature(fkey, features);
     fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::MP_pMP_ppMP, flags, MPID, pMPID, ppMPID);
@@ -1311,6 +1401,8 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
     AddFeature(fkey, features);
   }
 
+  if (!(sides & WORDPAIR_PAIR_SIDE)) return;
+
   /////////////////////////////////////////////////////////////////////////////
   // Dependency features.
   // Everything goes with direction flags and with coarse POS.
@@ -1452,24 +1544,21 @@ void DependencyFeatures::AddWordPairFeatures(DependencyInstanceNumeric* sentence
   fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_MP_BFLAG, flags, HPID, MPID, flag_between_coord);
   AddFeature(fkey, features);
 
-  set<int> BPIDs;
-  set<int> BWIDs;
+  // Note: these features are added once per word in between (rather than
+  // once per distinct POS tag), as in previous versions, which kept a set of
+  // the POS tags already seen but cleared it at every position.
   for (int i = left_position + 1; i < right_position; ++i) {
     BPID = sentence->GetCoarsePosId(i);
-    if (BPIDs.find(BPID) == BPIDs.end()) {
-      BPIDs.insert(BPID);
 
-      // POS in the middle.
-      fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_MP_BP, flags, HPID, MPID, BPID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WWP(DependencyFeatureTemplateArc::HW_MW_BP, flags, HWID, MWID, BPID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WPP(DependencyFeatureTemplateArc::HW_MP_BP, flags, HWID, MPID, BPID);
-      AddFeature(fkey, features);
-      fkey = encoder_.CreateFKey_WPP(DependencyFeatureTemplateArc::HP_MW_BP, flags, MWID, HPID, BPID);
-      AddFeature(fkey, features);
-    }
-    BPIDs.clear();
+    // POS in the middle.
+    fkey = encoder_.CreateFKey_PPP(DependencyFeatureTemplateArc::HP_MP_BP, flags, HPID, MPID, BPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WWP(DependencyFeatureTemplateArc::HW_MW_BP, flags, HWID, MWID, BPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WPP(DependencyFeatureTemplateArc::HW_MP_BP, flags, HWID, MPID, BPID);
+    AddFeature(fkey, features);
+    fkey = encoder_.CreateFKey_WPP(DependencyFeatureTemplateArc::HP_MW_BP, flags, MWID, HPID, BPID);
+    AddFeature(fkey, features);
   }
 }
 
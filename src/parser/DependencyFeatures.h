@@ -22,9 +22,19 @@
 #include "Features.h"
 #include "DependencyInstanceNumeric.h"
 #include "FeatureEncoder.h"
+#include "Parameters.h"
 
 class DependencyOptions;
 
+// Sides of the features of a pair of words, used to add only some of them
+// (see DependencyFeatures::AddWordPairFeaturesBySide).
+enum {
+  WORDPAIR_HEAD_SIDE = 0x1,
+  WORDPAIR_MODIFIER_SIDE = 0x2,
+  WORDPAIR_PAIR_SIDE = 0x4,
+  WORDPAIR_ALL_SIDES = 0x7
+};
+
 // This class implements the features for dependency parsing.
 // The feature templates are largely inspired by the ones used in MSTParser
 // (http://sourceforge.net/projects/mstparser/) and egstra
@@ -79,6 +89,15 @@ public:
     return input_features_[r];
   };
 
+  int64_t GetNumFeatures() const { return CountFeatures(input_features_); }
+  int64_t GetNumBytes() const { return CountFeatureBytes(input_features_); }
+
+  void Save(FILE *fs) const { SaveFeatureVectors(fs, input_features_); }
+  void Load(FILE *fs) {
+    Clear();
+    LoadFeatureVectors(fs, &input_features_);
+  }
+
 public:
   void AddArcFeaturesLight(DependencyInstanceNumeric *sentence,
                            int r,
@@ -145,6 +164,16 @@ public:
                              int modifier,
                              int previous_head);
 
+  // Compute the scores of the arcs with the features of AddArcFeaturesLight
+  // (the ones used by the pruner), without storing any features. The scores
+  // of the head-side and modifier-side features are computed once per word
+  // and attachment direction, so that only the pair-side features are
+  // extracted for each arc.
+  void ComputeArcScoresLight(DependencyInstanceNumeric* sentence,
+                             Parts *parts,
+                             Parameters *parameters,
+                             vector<double> *scores);
+
 protected:
   void AddWordPairFeatures(DependencyInstanceNumeric* sentence,
                            int pair_type,
@@ -154,6 +183,15 @@ protected:
                            bool use_morphological_features,
                            BinaryFeatures *features);
 
+  void AddWordPairFeaturesBySide(DependencyInstanceNumeric* sentence,
+                                 int pair_type,
+                                 int head,
+                                 int modifier,
+                                 bool use_lemma_features,
+                                 bool use_morphological_features,
+                                 int sides,
+                                 BinaryFeatures *features);
+
   void AddWordPairFeaturesMST(DependencyInstanceNumeric* sentence,
                               int pair_type,
                               int head,
@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DependencyInstance.h"
+#include "SerializationUtils.h"
 
 void DependencyInstance::Initialize(const vector<string> &forms,
                                     const vector<string> &lemmas,
@@ -33,3 +34,44 @@ void DependencyInstance::Initialize(const vector<string> &forms,
   deprels_ = deprels;
   heads_ = heads;
 }
+
+void DependencyInstance::Save(FILE *fs) {
+  bool success;
+  success = WriteStringVector(fs, forms_);
+  CHECK(success);
+  success = WriteStringVector(fs, lemmas_);
+  CHECK(success);
+  success = WriteStringVector(fs, cpostags_);
+  CHECK(success);
+  success = WriteStringVector(fs, postags_);
+  CHECK(success);
+  for (int i = 0; i < size(); ++i) {
+    success = WriteStringVector(fs, feats_[i]);
+    CHECK(success);
+  }
+  success = WriteStringVector(fs, deprels_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, heads_);
+  CHECK(success);
+}
+
+void DependencyInstance::Load(FILE *fs) {
+  bool success;
+  success = ReadStringVector(fs, &forms_);
+  CHECK(success);
+  success = ReadStringVector(fs, &lemmas_);
+  CHECK(success);
+  success = ReadStringVector(fs, &cpostags_);
+  CHECK(success);
+  success = ReadStringVector(fs, &postags_);
+  CHECK(success);
+  feats_.resize(size());
+  for (int i = 0; i < size(); ++i) {
+    success = ReadStringVector(fs, &feats_[i]);
+    CHECK(success);
+  }
+  success = ReadStringVector(fs, &deprels_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &heads_);
+  CHECK(success);
+}
@@ -43,6 +43,9 @@ public:
                   const vector<string> &deprels,
                   const vector<int> &heads);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   int size() { return forms_.size(); };
 
   const vector<int> &GetHeads() { return heads_; }
@@ -57,6 +60,10 @@ public:
   int GetHead(int i) { return heads_[i]; };
   const string &GetDependencyRelation(int i) { return deprels_[i]; };
 
+  void SetLemma(int i, const string &lemma) { lemmas_[i] = lemma; }
+  void SetCoarsePosTag(int i, const string &tag) { cpostags_[i] = tag; }
+  void SetPosTag(int i, const string &tag) { postags_[i] = tag; }
+  void ClearMorphFeatures(int i) { feats_[i].clear(); }
   void SetHead(int i, int head) { heads_[i] = head; }
   void SetDependencyRelation(int i, const string &dependency_relation) {
     deprels_[i] = dependency_relation;
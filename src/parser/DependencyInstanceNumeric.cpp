@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DependencyInstanceNumeric.h"
+#include "SerializationUtils.h"
 #include <iostream>
 #include <algorithm>
 
@@ -30,7 +31,7 @@ void DependencyInstanceNumeric::Initialize(
 
   int prefix_length = FLAGS_prefix_length;
   int suffix_length = FLAGS_suffix_length;
-  bool form_case_sensitive = FLAGS_form_case_sensitive;
+  WordType word_type;
 
   Clear();
 
@@ -51,17 +52,14 @@ void DependencyInstanceNumeric::Initialize(
   relations_.resize(length);
 
   for (i = 0; i < length; i++) {
-    std::string form = instance->GetForm(i);
-    std::string form_lower(form);
-    transform(form_lower.begin(), form_lower.end(), form_lower.begin(),
-              ::tolower);
-    if (!form_case_sensitive) form = form_lower;
-    id = token_dictionary->GetFormId(form);
+    // Ids of the form, lower-cased form, prefix and suffix.
+    token_dictionary->GetWordType(instance->GetForm(i), &word_type);
+    id = word_type.form_id();
     CHECK_LT(id, 0xffff);
     if (id < 0) id = TOKEN_UNKNOWN;
     form_ids_[i] = id;
 
-    id = token_dictionary->GetFormLowerId(form_lower);
+    id = word_type.form_lower_id();
     CHECK_LT(id, 0xffff);
     if (id < 0) id = TOKEN_UNKNOWN;
     form_lower_ids_[i] = id;
@@ -71,16 +69,12 @@ void DependencyInstanceNumeric::Initialize(
     if (id < 0) id = TOKEN_UNKNOWN;
     lemma_ids_[i] = id;
 
-    std::string prefix = form.substr(0, prefix_length);
-    id = token_dictionary->GetPrefixId(prefix);
+    id = word_type.prefix_id(prefix_length);
     CHECK_LT(id, 0xffff);
     if (id < 0) id = TOKEN_UNKNOWN;
     prefix_ids_[i] = id;
 
-    int start = form.length() - suffix_length;
-    if (start < 0) start = 0;
-    std::string suffix = form.substr(start, suffix_length);
-    id = token_dictionary->GetSuffixId(suffix);
+    id = word_type.suffix_id(suffix_length);
     CHECK_LT(id, 0xffff);
     if (id < 0) id = TOKEN_UNKNOWN;
     suffix_ids_[i] = id;
@@ -144,3 +138,89 @@ void DependencyInstanceNumeric::Initialize(
       instance->GetDependencyRelation(i));
   }
 }
+
+// Flags of a word in a saved instance.
+enum {
+  DEPENDENCYWORD_NOUN = 0x1,
+  DEPENDENCYWORD_VERB = 0x2,
+  DEPENDENCYWORD_PUNCTUATION = 0x4,
+  DEPENDENCYWORD_COORDINATION = 0x8
+};
+
+void DependencyInstanceNumeric::Save(FILE *fs) {
+  bool success;
+  success = WriteCompactIntegerVector(fs, form_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, form_lower_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, lemma_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, prefix_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, suffix_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, pos_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, cpos_ids_);
+  CHECK(success);
+  for (int i = 0; i < size(); ++i) {
+    success = WriteCompactIntegerVector(fs, feats_ids_[i]);
+    CHECK(success);
+  }
+  vector<int> flags(size(), 0);
+  for (int i = 0; i < size(); ++i) {
+    if (is_noun_[i]) flags[i] |= DEPENDENCYWORD_NOUN;
+    if (is_verb_[i]) flags[i] |= DEPENDENCYWORD_VERB;
+    if (is_punc_[i]) flags[i] |= DEPENDENCYWORD_PUNCTUATION;
+    if (is_coord_[i]) flags[i] |= DEPENDENCYWORD_COORDINATION;
+  }
+  success = WriteCompactIntegerVector(fs, flags);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, heads_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, relations_);
+  CHECK(success);
+}
+
+void DependencyInstanceNumeric::Load(FILE *fs) {
+  bool success;
+  Clear();
+  success = ReadCompactIntegerVector(fs, &form_ids_);
+  CHECK(success);
+  int length = form_ids_.size();
+  success = ReadCompactIntegerVector(fs, &form_lower_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &lemma_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &prefix_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &suffix_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &pos_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &cpos_ids_);
+  CHECK(success);
+  feats_ids_.resize(length);
+  for (int i = 0; i < length; ++i) {
+    success = ReadCompactIntegerVector(fs, &feats_ids_[i]);
+    CHECK(success);
+  }
+  vector<int> flags;
+  success = ReadCompactIntegerVector(fs, &flags);
+  CHECK(success);
+  CHECK_EQ(flags.size(), length);
+  is_noun_.resize(length);
+  is_verb_.resize(length);
+  is_punc_.resize(length);
+  is_coord_.resize(length);
+  for (int i = 0; i < length; ++i) {
+    is_noun_[i] = (flags[i] & DEPENDENCYWORD_NOUN) != 0;
+    is_verb_[i] = (flags[i] & DEPENDENCYWORD_VERB) != 0;
+    is_punc_[i] = (flags[i] & DEPENDENCYWORD_PUNCTUATION) != 0;
+    is_coord_[i] = (flags[i] & DEPENDENCYWORD_COORDINATION) != 0;
+  }
+  success = ReadCompactIntegerVector(fs, &heads_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &relations_);
+  CHECK(success);
+}
@@ -62,6 +62,9 @@ public:
   void Initialize(const DependencyDictionary &dictionary,
                   DependencyInstance *instance);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   void GetAllAncestors(const std::vector<int> &heads,
                        int descend,
                        std::vector<int>* ancestors) const {
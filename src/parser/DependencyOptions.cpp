@@ -84,6 +84,55 @@ DEFINE_double(pruner_posterior_threshold, 0.0001,
 DEFINE_int32(pruner_max_heads, 10,
              "Maximum number of possible head words for a given word, in basic "
              "pruning.");
+DEFINE_bool(pruner_token_scores, true,
+            "True for scoring the arcs in basic pruning from precomputed "
+            "per-word partial scores, without storing their features. False "
+            "for extracting and scoring the full features of each arc (slower; "
+            "only useful for comparison).");
+DEFINE_int32(ad3_max_iterations, 500,
+             "Maximum number of AD3 iterations for decoding a sentence (in "
+             "models that are not arc-factored).");
+DEFINE_double(decoding_time_budget_ms, 0.0,
+              "Time budget for decoding a sentence at test time, in "
+              "milliseconds. AD3 is run with an increasing number of "
+              "iterations (up to --ad3_max_iterations) and stopped early if "
+              "the budget would be exceeded; its current solution is then "
+              "rounded to a tree with the Chu-Liu-Edmonds algorithm. "
+              "Sentences above the budget are reported. 0 for no budget.");
+DEFINE_double(sentence_memory_budget_megabytes, 0.0,
+              "Memory budget for the parts and features of a sentence, in "
+              "megabytes. Sentences expected to exceed it (estimated from the "
+              "parts and the average size of the features of a part in the "
+              "previous sentences) are pruned again keeping half as many "
+              "heads per word (see --pruner_max_heads), down to one head. "
+              "Requires --prune_basic. 0 for no budget.");
+DEFINE_string(file_cascade_model, "",
+              "Path to the file containing a second (typically more expensive) "
+              "parser model, for a cascade at test time. Sentences are parsed "
+              "with the model in --file_model, and escalated to this one if "
+              "they are short enough (--cascade_length_budget) or if the "
+              "pruner is not confident enough about them "
+              "(--cascade_margin_threshold). Both models must have been "
+              "trained on the same data (so that they share the same "
+              "dictionary). Empty for no cascade.");
+DEFINE_int32(cascade_length_budget, 0,
+             "Sentences with at most this number of words are always parsed "
+             "with the cascade model.");
+DEFINE_double(cascade_margin_threshold, 0.5,
+              "Sentences are escalated to the cascade model if, for some "
+              "word, the difference between the pruner posteriors of its two "
+              "most likely heads is below this threshold. Requires a model "
+              "with a basic pruner; 0 for not using this criterion.");
+DEFINE_string(file_tagger_model, "",
+              "Path to the file containing a tagger model (trained with "
+              "TurboTagger), to tag and parse each test sentence in a single "
+              "pass. The coarse and fine POS tags of the input are replaced "
+              "by the predicted tags, and the lemmas and morphological "
+              "features are dropped, as in the corpora created by "
+              "scripts/create_conll_predicted_tags_corpus.sh. The time spent "
+              "tagging is profiled as part of the convert stage. Both models "
+              "must have been trained with the same --form_case_sensitive, "
+              "--prefix_length and --suffix_length. Empty for no tagger.");
 
 // Options for pruner training.
 // TODO: implement these options.
@@ -214,6 +263,14 @@ void DependencyOptions::Initialize() {
   file_pruner_model_ = FLAGS_file_pruner_model;
   pruner_posterior_threshold_ = FLAGS_pruner_posterior_threshold;
   pruner_max_heads_ = FLAGS_pruner_max_heads;
+  pruner_token_scores_ = FLAGS_pruner_token_scores;
+  ad3_max_iterations_ = FLAGS_ad3_max_iterations;
+  decoding_time_budget_ms_ = FLAGS_decoding_time_budget_ms;
+  sentence_memory_budget_megabytes_ = FLAGS_sentence_memory_budget_megabytes;
+  file_cascade_model_ = FLAGS_file_cascade_model;
+  cascade_length_budget_ = FLAGS_cascade_length_budget;
+  cascade_margin_threshold_ = FLAGS_cascade_margin_threshold;
+  file_tagger_model_ = FLAGS_file_tagger_model;
 
   use_arbitrary_siblings_ = false;
   use_consecutive_siblings_ = false;
@@ -49,6 +49,16 @@ public:
   const string &GetPrunerModelFilePath() { return file_pruner_model_; }
   double GetPrunerPosteriorThreshold() { return pruner_posterior_threshold_; }
   double GetPrunerMaxHeads() { return pruner_max_heads_; }
+  bool pruner_token_scores() { return pruner_token_scores_; }
+  int GetAD3MaxIterations() { return ad3_max_iterations_; }
+  double GetDecodingTimeBudget() { return decoding_time_budget_ms_; }
+  double GetSentenceMemoryBudget() {
+    return sentence_memory_budget_megabytes_;
+  }
+  const string &GetCascadeModelFilePath() { return file_cascade_model_; }
+  int GetCascadeLengthBudget() { return cascade_length_budget_; }
+  double GetCascadeMarginThreshold() { return cascade_margin_threshold_; }
+  const string &GetTaggerModelFilePath() { return file_tagger_model_; }
 
   bool use_arbitrary_siblings() { return use_arbitrary_siblings_; }
   bool use_consecutive_siblings() { return use_consecutive_siblings_; }
@@ -72,6 +82,14 @@ protected:
   string file_pruner_model_;
   double pruner_posterior_threshold_;
   int pruner_max_heads_;
+  bool pruner_token_scores_;
+  int ad3_max_iterations_;
+  double decoding_time_budget_ms_;
+  double sentence_memory_budget_megabytes_;
+  string file_cascade_model_;
+  int cascade_length_budget_;
+  double cascade_margin_threshold_;
+  string file_tagger_model_;
   bool use_arbitrary_siblings_;
   bool use_consecutive_siblings_;
   bool use_grandparents_;
@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DependencyPart.h"
+#include "SerializationUtils.h"
 
 void DependencyParts::DeleteAll() {
   for (int i = 0; i < NUM_DEPENDENCYPARTS; ++i) {
@@ -36,29 +37,18 @@ void DependencyParts::DeleteAll() {
 }
 
 void DependencyParts::DeleteIndices() {
-  for (int i = 0; i < index_.size(); ++i) {
-    index_[i].clear();
-  }
+  // Keep the capacity of the arrays so that they can be reused.
+  index_length_ = 0;
   index_.clear();
-
-  for (int i = 0; i < index_labeled_.size(); ++i) {
-    for (int j = 0; j < index_labeled_[i].size(); ++j) {
-      index_labeled_[i][j].clear();
-    }
-    index_labeled_[i].clear();
-  }
+  index_labeled_offsets_.clear();
   index_labeled_.clear();
 }
 
 void DependencyParts::BuildIndices(int sentence_length, bool labeled) {
   DeleteIndices();
-  index_.resize(sentence_length);
-  for (int h = 0; h < sentence_length; ++h) {
-    index_[h].resize(sentence_length);
-    for (int m = 0; m < sentence_length; ++m) {
-      index_[h][m] = -1;
-    }
-  }
+  index_length_ = sentence_length;
+  int num_pairs = sentence_length * sentence_length;
+  index_.assign(num_pairs, -1);
 
   int offset, num_basic_parts;
   GetOffsetArc(&offset, &num_basic_parts);
@@ -67,26 +57,121 @@ void DependencyParts::BuildIndices(int sentence_length, bool labeled) {
     CHECK(part->type() == DEPENDENCYPART_ARC);
     int h = static_cast<DependencyPartArc*>(part)->head();
     int m = static_cast<DependencyPartArc*>(part)->modifier();
-    index_[h][m] = offset + r;
+    index_[h * sentence_length + m] = offset + r;
   }
 
+  // Without labels, every (head, modifier) pair has an empty range.
+  index_labeled_offsets_.assign(num_pairs + 1, 0);
   if (labeled) {
-    index_labeled_.resize(sentence_length);
-    for (int h = 0; h < sentence_length; ++h) {
-      index_labeled_[h].resize(sentence_length);
-      for (int m = 0; m < sentence_length; ++m) {
-        index_labeled_[h][m].clear();
-      }
-    }
-
     int offset, num_labeled_arcs;
     GetOffsetLabeledArc(&offset, &num_labeled_arcs);
+    // Count the labeled arcs of each pair, then place them in order.
     for (int r = 0; r < num_labeled_arcs; ++r) {
       Part *part = (*this)[offset + r];
       CHECK(part->type() == DEPENDENCYPART_LABELEDARC);
       int h = static_cast<DependencyPartLabeledArc*>(part)->head();
       int m = static_cast<DependencyPartLabeledArc*>(part)->modifier();
-      index_labeled_[h][m].push_back(offset + r);
+      ++index_labeled_offsets_[h * sentence_length + m + 1];
+    }
+    for (int k = 0; k < num_pairs; ++k) {
+      index_labeled_offsets_[k + 1] += index_labeled_offsets_[k];
+    }
+    // Use the offset of each pair as its insertion position; afterwards it
+    // points to the start of the next pair, so shift the offsets back.
+    index_labeled_.resize(num_labeled_arcs);
+    for (int r = 0; r < num_labeled_arcs; ++r) {
+      Part *part = (*this)[offset + r];
+      int h = static_cast<DependencyPartLabeledArc*>(part)->head();
+      int m = static_cast<DependencyPartLabeledArc*>(part)->modifier();
+      index_labeled_[index_labeled_offsets_[h * sentence_length + m]++] =
+        offset + r;
+    }
+    for (int k = num_pairs; k > 0; --k) {
+      index_labeled_offsets_[k] = index_labeled_offsets_[k - 1];
     }
+    index_labeled_offsets_[0] = 0;
+  }
+}
+
+void DependencyParts::Save(FILE *fs) {
+  bool success;
+  success = WriteInteger(fs, size());
+  CHECK(success);
+  for (int r = 0; r < size(); ++r) {
+    success = WriteInteger(fs, (*this)[r]->type());
+    CHECK(success);
+    (*this)[r]->Save(fs);
+  }
+  for (int i = 0; i < NUM_DEPENDENCYPARTS; ++i) {
+    success = WriteInteger(fs, offsets_[i]);
+    CHECK(success);
+  }
+  // The labeled index is empty if it was not built or if there are no
+  // labeled arcs; both cases give the same index.
+  success = WriteInteger(fs, index_length_);
+  CHECK(success);
+  success = WriteBool(fs, !index_labeled_.empty());
+  CHECK(success);
+}
+
+void DependencyParts::Load(FILE *fs) {
+  bool success;
+  int num_parts;
+  Initialize();
+  success = ReadInteger(fs, &num_parts);
+  CHECK(success);
+  resize(num_parts, static_cast<Part*>(NULL));
+  for (int r = 0; r < num_parts; ++r) {
+    int type;
+    success = ReadInteger(fs, &type);
+    CHECK(success);
+    Part *part = NULL;
+    switch (type) {
+    case DEPENDENCYPART_ARC:
+      part = new DependencyPartArc;
+      break;
+    case DEPENDENCYPART_LABELEDARC:
+      part = new DependencyPartLabeledArc;
+      break;
+    case DEPENDENCYPART_SIBL:
+      part = new DependencyPartSibl;
+      break;
+    case DEPENDENCYPART_NEXTSIBL:
+      part = new DependencyPartNextSibl;
+      break;
+    case DEPENDENCYPART_GRANDPAR:
+      part = new DependencyPartGrandpar;
+      break;
+    case DEPENDENCYPART_GRANDSIBL:
+      part = new DependencyPartGrandSibl;
+      break;
+    case DEPENDENCYPART_TRISIBL:
+      part = new DependencyPartTriSibl;
+      break;
+    case DEPENDENCYPART_NONPROJ:
+      part = new DependencyPartNonproj;
+      break;
+    case DEPENDENCYPART_PATH:
+      part = new DependencyPartPath;
+      break;
+    case DEPENDENCYPART_HEADBIGRAM:
+      part = new DependencyPartHeadBigram;
+      break;
+    default:
+      CHECK(false) << "Unknown part type: " << type;
+    }
+    part->Load(fs);
+    (*this)[r] = part;
+  }
+  for (int i = 0; i < NUM_DEPENDENCYPARTS; ++i) {
+    success = ReadInteger(fs, &offsets_[i]);
+    CHECK(success);
   }
+  int index_length;
+  bool labeled;
+  success = ReadInteger(fs, &index_length);
+  CHECK(success);
+  success = ReadBool(fs, &labeled);
+  CHECK(success);
+  if (index_length > 0) BuildIndices(index_length, labeled);
 }
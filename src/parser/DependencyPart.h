@@ -401,9 +401,25 @@ private:
   int hp_; // Index of the head of the previous word (m_ - 1).
 };
 
+// Read-only range of part indices (e.g. the labeled arcs of a given arc),
+// stored contiguously in a larger array. It has the same interface as a
+// constant vector of indices.
+class DependencyPartIndexRange {
+public:
+  DependencyPartIndexRange(const int *indices, int size) :
+    indices_(indices), size_(size) {};
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  int operator[](int k) const { return indices_[k]; }
+
+private:
+  const int *indices_;
+  int size_;
+};
+
 class DependencyParts : public Parts {
 public:
-  DependencyParts() {};
+  DependencyParts() { index_length_ = 0; };
   virtual ~DependencyParts() { DeleteAll(); };
 
   void Initialize() {
@@ -444,22 +460,37 @@ public:
     return new DependencyPartHeadBigram(head, modifier, previous_head);
   }
 
-  void Save(FILE* fs) {
-    CHECK(false) << "To be implemented.";
-  }
-  void Load(FILE* fs) {
-    CHECK(false) << "To be implemented.";
-  }
+  // Save/load the parts and their offsets. The indices, if built, are
+  // rebuilt when loading.
+  void Save(FILE* fs);
+  void Load(FILE* fs);
 
 public:
   void DeleteAll();
 
 public:
+  // Build the indices of the arcs (and labeled arcs, if labeled is true).
+  // The index of the arcs is a flat sentence_length x sentence_length matrix,
+  // and the one of the labeled arcs is stored in compressed sparse row
+  // format. The underlying arrays keep their capacity across sentences, so
+  // rebuilding them does not allocate memory in general.
   void BuildIndices(int sentence_length, bool labeled);
   void DeleteIndices();
-  int FindArc(int head, int modifier) { return index_[head][modifier]; };
-  const vector<int> &FindLabeledArcs(int head, int modifier) {
-    return index_labeled_[head][modifier];
+  int FindArc(int head, int modifier) {
+    return index_[head * index_length_ + modifier];
+  };
+  DependencyPartIndexRange FindLabeledArcs(int head, int modifier) {
+    int k = head * index_length_ + modifier;
+    return DependencyPartIndexRange(
+      index_labeled_.data() + index_labeled_offsets_[k],
+      index_labeled_offsets_[k + 1] - index_labeled_offsets_[k]);
+  }
+
+  // Estimate the memory (in bytes) taken by the parts and their indices.
+  int64_t GetNumBytes() const {
+    return Parts::GetNumBytes() +
+      (index_.capacity() + index_labeled_offsets_.capacity() +
+       index_labeled_.capacity()) * sizeof(int);
   }
 
   // True is model is arc-factored, i.e., all parts are unlabeled arcs.
@@ -564,8 +595,10 @@ private:
   }
 
 private:
-  vector<vector<int> >  index_;
-  vector<vector<vector<int> > > index_labeled_;
+  int index_length_; // Sentence length used to build the indices.
+  vector<int> index_; // Arc index of each (head, modifier) pair, or -1.
+  vector<int> index_labeled_offsets_; // Row offsets in index_labeled_.
+  vector<int> index_labeled_; // Labeled arcs of each (head, modifier) pair.
   int offsets_[NUM_DEPENDENCYPARTS];
 };
 
@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DependencyPipe.h"
+#include "TaggerPipe.h"
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -34,6 +35,16 @@ const uint64_t kParserModelVersion = 200030000;
 const uint64_t kOldestCompatibleParserModelVersion = 200030000;
 const uint64_t kParserModelCheck = 1234567890;
 
+DependencyPipe::~DependencyPipe() {
+  delete token_dictionary_;
+  delete pruner_parameters_;
+  delete cascade_features_;
+  delete cascade_pipe_;
+  delete cascade_options_;
+  delete tagger_pipe_;
+  delete tagger_options_;
+}
+
 void DependencyPipe::SaveModel(FILE* fs) {
   bool success;
   success = WriteUINT64(fs, kParserModelCheck);
@@ -42,7 +53,7 @@ void DependencyPipe::SaveModel(FILE* fs) {
   CHECK(success);
   token_dictionary_->Save(fs);
   Pipe::SaveModel(fs);
-  pruner_parameters_->Save(fs);
+  pruner_parameters_->Save(fs, options_->parameters_float());
 }
 
 void DependencyPipe::LoadModel(FILE* fs) {
@@ -63,7 +74,21 @@ void DependencyPipe::LoadModel(FILE* fs) {
     SetTokenDictionary(token_dictionary_);
   token_dictionary_->Load(fs);
   Pipe::LoadModel(fs);
-  pruner_parameters_->Load(fs);
+  pruner_parameters_->Load(fs, options_->parameters_float());
+}
+
+void DependencyPipe::SaveDictionaries(FILE *fs) {
+  token_dictionary_->Save(fs);
+  Pipe::SaveDictionaries(fs);
+}
+
+void DependencyPipe::LoadDictionaries(FILE *fs) {
+  delete token_dictionary_;
+  CreateTokenDictionary();
+  static_cast<DependencyDictionary*>(dictionary_)->
+    SetTokenDictionary(token_dictionary_);
+  token_dictionary_->Load(fs);
+  Pipe::LoadDictionaries(fs);
 }
 
 void DependencyPipe::LoadPrunerModel(FILE* fs) {
@@ -77,7 +102,7 @@ void DependencyPipe::LoadPrunerModel(FILE* fs) {
   pipe->Initialize();
   pipe->LoadModel(fs);
   delete pruner_parameters_;
-  pruner_parameters_ = pipe->parameters_;
+  SetPrunerParameters(pipe->parameters_);
   pipe->parameters_ = NULL;
   delete pipe;
   LOG(INFO) << "Done.";
@@ -90,6 +115,206 @@ void DependencyPipe::LoadPrunerModelByName(const string &model_name) {
   fclose(fs);
 }
 
+void DependencyPipe::LoadCascadeModelByName(const string &model_name) {
+  LOG(INFO) << "Loading cascade model...";
+  FILE *fs = fopen(model_name.c_str(), "rb");
+  CHECK(fs) << "Could not open cascade model file for reading: "
+    << model_name;
+  delete cascade_features_;
+  delete cascade_pipe_;
+  delete cascade_options_;
+  // The cascade model has its own options, which are read from its model
+  // file. Note that this overwrites the flags, but not the options of the
+  // main model, which must have been loaded before.
+  cascade_options_ = new DependencyOptions;
+  cascade_pipe_ = new DependencyPipe(cascade_options_);
+  cascade_pipe_->Initialize();
+  cascade_pipe_->GetProfiler()->SetEnabled(profiler_.enabled());
+  cascade_pipe_->LoadModel(fs);
+  fclose(fs);
+  cascade_features_ = cascade_pipe_->CreateFeatures();
+
+  // The output of the cascade model is labeled and evaluated by this pipe,
+  // so the two models must agree on the labels.
+  CHECK_EQ(cascade_options_->labeled(), GetDependencyOptions()->labeled())
+    << "The cascade model must be labeled iff the main model is.";
+  DependencyDictionary *dictionary = GetDependencyDictionary();
+  DependencyDictionary *cascade_dictionary =
+    cascade_pipe_->GetDependencyDictionary();
+  CHECK_EQ(cascade_dictionary->GetLabelAlphabet().size(),
+           dictionary->GetLabelAlphabet().size())
+    << "The cascade model was trained with a different set of labels.";
+  for (int l = 0; l < dictionary->GetLabelAlphabet().size(); ++l) {
+    CHECK_EQ(cascade_dictionary->GetLabelName(l), dictionary->GetLabelName(l))
+      << "The cascade model was trained with a different set of labels.";
+  }
+  if (!GetDependencyOptions()->prune_basic() &&
+      GetDependencyOptions()->GetCascadeMarginThreshold() > 0.0) {
+    LOG(WARNING) << "The main model has no basic pruner: sentences will "
+      << "only be escalated because of their length.";
+  }
+  ResetCascadeStatistics();
+  LOG(INFO) << "Done.";
+}
+
+void DependencyPipe::LoadTaggerModelByName(const string &model_name) {
+  LOG(INFO) << "Loading tagger model...";
+  delete tagger_pipe_;
+  delete tagger_options_;
+  // The word types of both token dictionaries are computed with the flags
+  // below, which are overwritten when loading the tagger model.
+  bool form_case_sensitive = FLAGS_form_case_sensitive;
+  int prefix_length = FLAGS_prefix_length;
+  int suffix_length = FLAGS_suffix_length;
+  tagger_options_ = new TaggerOptions;
+  tagger_options_->Initialize();
+  tagger_options_->SetModelFilePath(model_name);
+  tagger_pipe_ = new TaggerPipe(tagger_options_);
+  tagger_pipe_->Initialize();
+  tagger_pipe_->LoadModelFile();
+  // The tagging accuracy is evaluated by this pipe (see TagInstance).
+  tagger_options_->SetEvaluate(false);
+  CHECK_EQ(FLAGS_form_case_sensitive, form_case_sensitive)
+    << "The tagger and parser models must have the same "
+    << "--form_case_sensitive.";
+  CHECK_EQ(FLAGS_prefix_length, prefix_length)
+    << "The tagger and parser models must have the same --prefix_length.";
+  CHECK_EQ(FLAGS_suffix_length, suffix_length)
+    << "The tagger and parser models must have the same --suffix_length.";
+  LOG(INFO) << "Done.";
+}
+
+void DependencyPipe::TagInstance(DependencyInstance *instance) {
+  // The first token is the root, which is not tagged.
+  int length = instance->size();
+  vector<string> forms(length - 1);
+  vector<string> tags(length - 1);
+  for (int i = 1; i < length; ++i) {
+    forms[i - 1] = instance->GetForm(i);
+    tags[i - 1] = instance->GetPosTag(i);
+  }
+  SequenceInstance sentence;
+  sentence.Initialize(forms, tags);
+  tagger_pipe_->ClassifyInstance(&sentence);
+
+  for (int i = 1; i < length; ++i) {
+    const string &tag = sentence.GetTag(i - 1);
+    if (options_->evaluate()) {
+      if (tag != instance->GetPosTag(i)) ++num_tag_mistakes_;
+      ++num_tagged_tokens_;
+    }
+    // Same format as scripts/create_conll_predicted_tags_corpus.pl.
+    instance->SetLemma(i, "_");
+    instance->SetCoarsePosTag(i, tag);
+    instance->SetPosTag(i, tag);
+    instance->ClearMorphFeatures(i);
+  }
+}
+
+void DependencyPipe::ResetCascadeStatistics() {
+  for (int k = 0; k < 2; ++k) {
+    cascade_num_sentences_[k] = 0;
+    cascade_num_tokens_[k] = 0;
+    cascade_time_us_[k] = 0;
+  }
+  cascade_num_escalated_length_ = 0;
+  cascade_num_escalated_margin_ = 0;
+}
+
+void DependencyPipe::LogCascadeStatistics() {
+  if (!cascade_pipe_) return;
+  const char *tier_names[2] = { "Main model", "Cascade model" };
+  for (int k = 0; k < 2; ++k) {
+    double num_seconds = static_cast<double>(cascade_time_us_[k]) / 1e6;
+    double ms_per_sentence = (cascade_num_sentences_[k] > 0) ?
+      1000.0 * num_seconds / static_cast<double>(cascade_num_sentences_[k]) :
+      0.0;
+    LOG(INFO) << tier_names[k] << ": " << cascade_num_sentences_[k]
+      << " sentences, " << cascade_num_tokens_[k] << " tokens, "
+      << num_seconds << " sec (" << ms_per_sentence << " ms per sentence).";
+  }
+  LOG(INFO) << "Escalated sentences: " << cascade_num_escalated_length_
+    << " because of their length, " << cascade_num_escalated_margin_
+    << " because of the pruner margin.";
+}
+
+void DependencyPipe::DecodeInstance(Instance *instance,
+                                    Instance *formatted_instance,
+                                    Parts *parts,
+                                    Features *features,
+                                    vector<double> *scores,
+                                    vector<double> *gold_outputs,
+                                    vector<double> *predicted_outputs,
+                                    vector<int> *active_parts) {
+  if (!cascade_pipe_) {
+    Pipe::DecodeInstance(instance, formatted_instance, parts, features,
+                         scores, gold_outputs, predicted_outputs,
+                         active_parts);
+    return;
+  }
+
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
+  int num_words =
+    static_cast<DependencyInstanceNumeric*>(formatted_instance)->size() - 1;
+  bool escalate = false;
+  if (num_words <= GetDependencyOptions()->GetCascadeLengthBudget()) {
+    // Short sentences go straight to the cascade model.
+    escalate = true;
+    ++cascade_num_escalated_length_;
+  } else {
+    // The parts of the main model are pruned with the basic pruner, which
+    // tells how confident it is about the sentence. In that case escalate
+    // before computing the features of the main model.
+    pruner_margin_ = 1.0;
+    int64_t start_stage = profiler_.StartTimer();
+    MakeParts(formatted_instance, parts, gold_outputs);
+    profiler_.StopTimer(PROFILER_TIMER_MAKE_PARTS, start_stage);
+    ProfileParts(parts);
+    if (pruner_margin_ < GetDependencyOptions()->GetCascadeMarginThreshold()) {
+      escalate = true;
+      ++cascade_num_escalated_margin_;
+    } else {
+      start_stage = profiler_.StartTimer();
+      Pipe::MakeFeatures(formatted_instance, parts, features);
+      profiler_.StopTimer(PROFILER_TIMER_MAKE_FEATURES, start_stage);
+      ProfileFeatures(features);
+
+      start_stage = profiler_.StartTimer();
+      ComputeScores(formatted_instance, parts, features, scores);
+      profiler_.StopTimer(PROFILER_TIMER_COMPUTE_SCORES, start_stage);
+
+      start_stage = profiler_.StartTimer();
+      if (active_parts) {
+        decoder_->DecodeSparse(formatted_instance, parts, *scores,
+                               active_parts);
+      } else {
+        decoder_->Decode(formatted_instance, parts, *scores,
+                         predicted_outputs);
+      }
+      profiler_.StopTimer(PROFILER_TIMER_DECODE, start_stage);
+    }
+  }
+
+  if (escalate) {
+    // The cascade model has its own dictionary, so it needs its own
+    // formatted instance.
+    // The stages of the cascade model are profiled by the cascade pipe.
+    Instance *cascade_instance = cascade_pipe_->GetFormattedInstance(instance);
+    cascade_pipe_->DecodeInstance(instance, cascade_instance, parts,
+                                  cascade_features_, scores, gold_outputs,
+                                  predicted_outputs, active_parts);
+    if (cascade_instance != instance) delete cascade_instance;
+  }
+
+  gettimeofday(&end, NULL);
+  int tier = escalate ? 1 : 0;
+  ++cascade_num_sentences_[tier];
+  cascade_num_tokens_[tier] += num_words;
+  cascade_time_us_[tier] += diff_us(end, start);
+}
+
 void DependencyPipe::PreprocessData() {
   delete token_dictionary_;
   CreateTokenDictionary();
@@ -120,7 +345,7 @@ void DependencyPipe::ComputeScores(Instance *instance, Parts *parts,
         GetDependencyOptions()->labeled()) {
       (*scores)[r] = 0.0;
       DependencyPartArc *arc = static_cast<DependencyPartArc*>((*parts)[r]);
-      const vector<int> &index_labeled_parts =
+      DependencyPartIndexRange index_labeled_parts =
         dependency_parts->FindLabeledArcs(arc->head(), arc->modifier());
       vector<int> allowed_labels(index_labeled_parts.size());
       for (int k = 0; k < index_labeled_parts.size(); ++k) {
@@ -305,16 +530,57 @@ void DependencyPipe::MakeParts(Instance *instance,
     dependency_parts->BuildOffsets();
     dependency_parts->BuildIndices(sentence_length, false);
   } else {
-    // Make arc-factored parts and compute indices.
-    MakePartsBasic(instance, parts, gold_outputs);
-    dependency_parts->BuildOffsets();
-    dependency_parts->BuildIndices(sentence_length,
-                                   GetDependencyOptions()->labeled());
+    // If the parts and features of the sentence are expected to exceed the
+    // memory budget, make the parts again with a pruner that keeps half as
+    // many heads per word.
+    double budget_megabytes =
+      GetDependencyOptions()->GetSentenceMemoryBudget();
+    bool use_budget = budget_megabytes > 0.0 &&
+      GetDependencyOptions()->prune_basic();
+    budget_max_heads_ = -1;
+    while (true) {
+      // Make arc-factored parts and compute indices.
+      MakePartsBasic(instance, parts, gold_outputs);
+      dependency_parts->BuildOffsets();
+      dependency_parts->BuildIndices(sentence_length,
+                                     GetDependencyOptions()->labeled());
+
+      // Make global parts.
+      MakePartsGlobal(instance, parts, gold_outputs);
+      dependency_parts->BuildOffsets();
+
+      if (!use_budget) break;
+      double megabytes = static_cast<double>(EstimateSentenceBytes(parts)) /
+        (1024.0 * 1024.0);
+      if (megabytes <= budget_megabytes) break;
+      int max_heads = GetPrunerMaxHeads();
+      if (max_heads < 0 || max_heads > sentence_length) {
+        max_heads = sentence_length;
+      }
+      if (max_heads <= 1) {
+        LOG(WARNING) << "Sentence with " << sentence_length - 1
+          << " words exceeds the memory budget (" << megabytes
+          << " MB) with one head per word.";
+        break;
+      }
+      budget_max_heads_ = max_heads / 2;
+      LOG(INFO) << "Sentence with " << sentence_length - 1
+        << " words exceeded the memory budget (" << megabytes
+        << " MB); pruning with at most " << budget_max_heads_
+        << " heads per word.";
+      dependency_parts->Initialize();
+      if (make_gold) gold_outputs->clear();
+    }
+    budget_max_heads_ = -1;
+  }
+}
 
-    // Make global parts.
-    MakePartsGlobal(instance, parts, gold_outputs);
-    dependency_parts->BuildOffsets();
+int64_t DependencyPipe::EstimateSentenceBytes(Parts *parts) {
+  int64_t num_bytes = parts->GetNumBytes();
+  if (feature_bytes_num_parts_ > 0) {
+    num_bytes += parts->size() * feature_bytes_ / feature_bytes_num_parts_;
   }
+  return num_bytes;
 }
 
 void DependencyPipe::MakePartsBasic(Instance *instance,
@@ -1441,6 +1707,13 @@ void DependencyPipe::MakeSelectedFeatures(Instance *instance,
     dependency_features->AddHeadBigramFeatures(sentence, r,
                                                part->head(), part->modifier(), part->previous_head());
   }
+
+  // Keep track of the size of the features per part, to estimate the memory
+  // of the next sentences (see --sentence_memory_budget_megabytes).
+  if (!pruner && GetDependencyOptions()->GetSentenceMemoryBudget() > 0.0) {
+    feature_bytes_ += features->GetNumBytes();
+    feature_bytes_num_parts_ += parts->size();
+  }
 }
 
 // Prune basic parts (arcs and labeled arcs) using a first-order model.
@@ -1455,13 +1728,22 @@ void DependencyPipe::Prune(Instance *instance, Parts *parts,
   vector<double> scores;
   vector<double> predicted_outputs;
 
+  timeval start, end;
+  gettimeofday(&start, NULL);
+
   // Make sure gold parts are only preserved at training time.
   CHECK(!preserve_gold || options_->train());
 
-  MakeFeatures(instance, parts, true, features);
-  ComputeScores(instance, parts, features, true, &scores);
+  if (GetDependencyOptions()->pruner_token_scores()) {
+    static_cast<DependencyFeatures*>(features)->ComputeArcScoresLight(
+      static_cast<DependencyInstanceNumeric*>(instance), parts,
+      pruner_parameters_, &scores);
+  } else {
+    MakeFeatures(instance, parts, true, features);
+    ComputeScores(instance, parts, features, true, &scores);
+  }
   GetDependencyDecoder()->DecodePruner(instance, parts, scores,
-                                       &predicted_outputs);
+                                       &predicted_outputs, &pruner_margin_);
 
   double threshold = 0.5;
   int r0 = 0;
@@ -1483,11 +1765,33 @@ void DependencyPipe::Prune(Instance *instance, Parts *parts,
   dependency_parts->SetOffsetArc(0, parts->size());
 
   delete features;
+
+  gettimeofday(&end, NULL);
+  pruner_time_us_ += diff_us(end, start);
 }
 
 void DependencyPipe::LabelInstance(Parts *parts, const vector<double> &output,
                                    Instance *instance) {
   DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+  double threshold = 0.5;
+  // Collect the arcs (or labeled arcs) in the output.
+  int offset, num_arcs;
+  if (GetDependencyOptions()->labeled()) {
+    dependency_parts->GetOffsetLabeledArc(&offset, &num_arcs);
+  } else {
+    dependency_parts->GetOffsetArc(&offset, &num_arcs);
+  }
+  vector<int> active_parts;
+  for (int r = 0; r < num_arcs; ++r) {
+    if (output[offset + r] >= threshold) active_parts.push_back(offset + r);
+  }
+  LabelInstanceSparse(parts, active_parts, instance);
+}
+
+void DependencyPipe::LabelInstanceSparse(Parts *parts,
+                                         const vector<int> &active_parts,
+                                         Instance *instance) {
+  DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
   DependencyInstance *dependency_instance =
     static_cast<DependencyInstance*>(instance);
   int instance_length = dependency_instance->size();
@@ -1497,29 +1801,20 @@ void DependencyPipe::LabelInstance(Parts *parts, const vector<double> &output,
       dependency_instance->SetDependencyRelation(m, "NULL");
     }
   }
-  double threshold = 0.5;
 
-  if (GetDependencyOptions()->labeled()) {
-    int offset, num_labeled_arcs;
-    dependency_parts->GetOffsetLabeledArc(&offset, &num_labeled_arcs);
-    for (int r = 0; r < num_labeled_arcs; ++r) {
+  for (int k = 0; k < active_parts.size(); ++k) {
+    Part *part = (*dependency_parts)[active_parts[k]];
+    if (GetDependencyOptions()->labeled()) {
+      if (part->type() != DEPENDENCYPART_LABELEDARC) continue;
       DependencyPartLabeledArc *arc =
-        static_cast<DependencyPartLabeledArc*>((*dependency_parts)[offset + r]);
-      if (output[offset + r] >= threshold) {
-        dependency_instance->SetHead(arc->modifier(), arc->head());
-        dependency_instance->SetDependencyRelation(arc->modifier(),
-                                                   GetDependencyDictionary()->GetLabelName(arc->label()));
-      }
-    }
-  } else {
-    int offset, num_basic_parts;
-    dependency_parts->GetOffsetArc(&offset, &num_basic_parts);
-    for (int r = 0; r < num_basic_parts; ++r) {
-      DependencyPartArc *arc =
-        static_cast<DependencyPartArc*>((*dependency_parts)[offset + r]);
-      if (output[offset + r] >= threshold) {
-        dependency_instance->SetHead(arc->modifier(), arc->head());
-      }
+        static_cast<DependencyPartLabeledArc*>(part);
+      dependency_instance->SetHead(arc->modifier(), arc->head());
+      dependency_instance->SetDependencyRelation(arc->modifier(),
+                                                 GetDependencyDictionary()->GetLabelName(arc->label()));
+    } else {
+      if (part->type() != DEPENDENCYPART_ARC) continue;
+      DependencyPartArc *arc = static_cast<DependencyPartArc*>(part);
+      dependency_instance->SetHead(arc->modifier(), arc->head());
     }
   }
   for (int m = 1; m < instance_length; ++m) {
@@ -30,17 +30,30 @@
 #include "DependencyFeatures.h"
 #include "DependencyDecoder.h"
 
+class TaggerOptions;
+class TaggerPipe;
+
 class DependencyPipe : public Pipe {
 public:
   DependencyPipe(Options* options) : Pipe(options) {
     token_dictionary_ = NULL;
     pruner_parameters_ = NULL;
     train_pruner_ = false;
+    pruner_time_us_ = 0;
+    pruner_margin_ = 1.0;
+    budget_max_heads_ = -1;
+    feature_bytes_ = 0;
+    feature_bytes_num_parts_ = 0;
+    cascade_options_ = NULL;
+    cascade_pipe_ = NULL;
+    cascade_features_ = NULL;
+    ResetCascadeStatistics();
+    tagger_options_ = NULL;
+    tagger_pipe_ = NULL;
+    num_tag_mistakes_ = 0;
+    num_tagged_tokens_ = 0;
   }
-  virtual ~DependencyPipe() {
-    delete token_dictionary_;
-    delete pruner_parameters_;
-  }
+  virtual ~DependencyPipe();
 
   DependencyReader *GetDependencyReader() {
     return static_cast<DependencyReader*>(reader_);
@@ -57,16 +70,64 @@ public:
 
   void Initialize() {
     Pipe::Initialize();
-    pruner_parameters_ = new Parameters;
+    SetPrunerParameters(new Parameters);
   }
 
   void SetPrunerParameters(Parameters *pruner_parameters) {
     pruner_parameters_ = pruner_parameters;
+    if (pruner_parameters_) pruner_parameters_->SetProfiler(&profiler_);
   }
   void LoadPrunerModelFile() {
     LoadPrunerModelByName(GetDependencyOptions()->GetPrunerModelFilePath());
   }
 
+  // Maximum number of heads per word kept by the pruner: --pruner_max_heads,
+  // unless it was reduced for the current sentence to fit the memory budget.
+  int GetPrunerMaxHeads() {
+    if (budget_max_heads_ > 0) return budget_max_heads_;
+    return GetDependencyOptions()->GetPrunerMaxHeads();
+  }
+
+  // Share the token dictionary along with the other training data.
+  void ShareTrainingData(Pipe *pipe) {
+    Pipe::ShareTrainingData(pipe);
+    delete token_dictionary_;
+    token_dictionary_ = static_cast<DependencyPipe*>(pipe)->token_dictionary_;
+  }
+  void ReleaseTrainingData() {
+    Pipe::ReleaseTrainingData();
+    token_dictionary_ = NULL;
+  }
+
+  // Load the second model of a cascade (flag --file_cascade_model). This
+  // must be called after loading the main model.
+  void LoadCascadeModelFile() {
+    LoadCascadeModelByName(GetDependencyOptions()->GetCascadeModelFilePath());
+  }
+  void LoadCascadeModelByName(const string &model_name);
+
+  // Load a tagger model (flag --file_tagger_model), with which each
+  // sentence is tagged before being parsed. This must be called after
+  // loading the main model.
+  void LoadTaggerModelFile() {
+    LoadTaggerModelByName(GetDependencyOptions()->GetTaggerModelFilePath());
+  }
+  void LoadTaggerModelByName(const string &model_name);
+
+  // Statistics of the cascade: number of sentences and tokens parsed with
+  // each model, and the time spent on them.
+  void ResetCascadeStatistics();
+  void LogCascadeStatistics();
+
+  // Log the decoding statistics of this pipe and of the cascade model.
+  void LogDecodingStatistics() {
+    GetDependencyDecoder()->LogDecodingStatistics();
+    if (cascade_pipe_) {
+      LOG(INFO) << "Cascade model:";
+      cascade_pipe_->GetDependencyDecoder()->LogDecodingStatistics();
+    }
+  }
+
   // Check if a tree is projective.
   // TODO(atm): This function should probably be moved to another class.
   bool IsProjectiveTree(const vector<int> &heads) const {
@@ -96,9 +157,17 @@ protected:
     return parameters_;
   }
 
+  // The parts only depend on the pruner parameters, which are fixed while
+  // training the parser.
+  bool CanPrefetchParts() { return true; }
+
+  // The parts and features can be saved to the training cache file.
+  bool CanSpillTrainingCache() { return true; }
+
   void PreprocessData();
 
   Instance *GetFormattedInstance(Instance *instance) {
+    if (tagger_pipe_) TagInstance(static_cast<DependencyInstance*>(instance));
     DependencyInstanceNumeric *instance_numeric =
       new DependencyInstanceNumeric;
     instance_numeric->Initialize(*GetDependencyDictionary(),
@@ -106,9 +175,29 @@ protected:
     return instance_numeric;
   }
 
+  bool SupportsBinaryCorpus() { return true; }
+
+  Instance *CreateFormattedInstance() {
+    return new DependencyInstanceNumeric;
+  }
+
+  Instance *CreateInstance() { return new DependencyInstance; }
+
+  // Replace the POS tags of a sentence by the ones predicted by the tagger
+  // model, counting the tagging mistakes if 'evaluate' is set.
+  void TagInstance(DependencyInstance *instance);
+
+  // Number of words of a sentence (including the root).
+  int GetInstanceLength(Instance *formatted_instance) {
+    return static_cast<DependencyInstanceNumeric*>(formatted_instance)->size();
+  }
+
   void SaveModel(FILE* fs);
   void LoadModel(FILE* fs);
 
+  void SaveDictionaries(FILE *fs);
+  void LoadDictionaries(FILE *fs);
+
   void LoadPrunerModel(FILE* fs);
   void LoadPrunerModelByName(const string &model_name);
 
@@ -127,6 +216,9 @@ protected:
 
   void MakeParts(Instance *instance, Parts *parts,
                  vector<double> *gold_outputs);
+  // Estimate the memory (in bytes) of the parts of a sentence and of the
+  // features that will be made for them.
+  int64_t EstimateSentenceBytes(Parts *parts);
   void MakePartsBasic(Instance *instance, Parts *parts,
                       vector<double> *gold_outputs);
   void MakePartsBasic(Instance *instance, bool add_labeled_parts, Parts *parts,
@@ -215,14 +307,40 @@ protected:
   void LabelInstance(Parts *parts, const vector<double> &output,
                      Instance *instance);
 
+  // The arcs and labeled arcs are integral at test time (see
+  // DependencyDecoder::Decode), so the outputs can be sparse.
+  bool UsesSparseOutputs() { return true; }
+  void LabelInstanceSparse(Parts *parts, const vector<int> &active_parts,
+                           Instance *instance);
+
   void Prune(Instance *instance, Parts *parts, vector<double> *gold_outputs,
              bool preserve_gold);
 
+  // If a cascade model is loaded, decide for each sentence whether to parse
+  // it with the main model or with the cascade model.
+  void DecodeInstance(Instance *instance,
+                      Instance *formatted_instance,
+                      Parts *parts,
+                      Features *features,
+                      vector<double> *scores,
+                      vector<double> *gold_outputs,
+                      vector<double> *predicted_outputs,
+                      vector<int> *active_parts);
+
+  // Include the profile of the cascade model, if any.
+  void CollectProfile(Profiler *profile) {
+    Pipe::CollectProfile(profile);
+    if (cascade_pipe_) cascade_pipe_->CollectProfile(profile);
+  }
+
   virtual void BeginEvaluation() {
     num_head_mistakes_ = 0;
     num_head_pruned_mistakes_ = 0;
     num_heads_after_pruning_ = 0;
     num_tokens_ = 0;
+    pruner_time_us_ = 0;
+    num_tag_mistakes_ = 0;
+    num_tagged_tokens_ = 0;
     gettimeofday(&start_clock_, NULL);
   }
   virtual void EvaluateInstance(Instance *instance,
@@ -258,7 +376,50 @@ protected:
       num_heads_after_pruning_ += num_possible_heads;
     }
   }
+  virtual void EvaluateInstanceSparse(Instance *instance,
+                                      Instance *output_instance,
+                                      Parts *parts,
+                                      const vector<double> &gold_outputs,
+                                      const vector<int> &active_parts) {
+    DependencyInstance *dependency_instance =
+      static_cast<DependencyInstance*>(instance);
+    DependencyParts *dependency_parts = static_cast<DependencyParts*>(parts);
+    // Predicted head of each word.
+    vector<int> heads(dependency_instance->size(), -1);
+    for (int k = 0; k < active_parts.size(); ++k) {
+      Part *part = (*dependency_parts)[active_parts[k]];
+      if (part->type() != DEPENDENCYPART_ARC) continue;
+      DependencyPartArc *arc = static_cast<DependencyPartArc*>(part);
+      heads[arc->modifier()] = arc->head();
+    }
+    for (int m = 1; m < dependency_instance->size(); ++m) {
+      int head = -1;
+      int num_possible_heads = 0;
+      for (int h = 0; h < dependency_instance->size(); ++h) {
+        int r = dependency_parts->FindArc(h, m);
+        if (r < 0) continue;
+        ++num_possible_heads;
+        if (gold_outputs[r] >= 0.5) {
+          CHECK_EQ(gold_outputs[r], 1.0);
+          if (heads[m] != h) ++num_head_mistakes_;
+          head = h;
+        }
+      }
+      if (head < 0) {
+        VLOG(2) << "Pruned gold part...";
+        ++num_head_mistakes_;
+        ++num_head_pruned_mistakes_;
+      }
+      ++num_tokens_;
+      num_heads_after_pruning_ += num_possible_heads;
+    }
+  }
   virtual void EndEvaluation() {
+    if (tagger_pipe_ && num_tagged_tokens_ > 0) {
+      LOG(INFO) << "Tagging accuracy: " <<
+        static_cast<double>(num_tagged_tokens_ - num_tag_mistakes_) /
+        static_cast<double>(num_tagged_tokens_);
+    }
     LOG(INFO) << "Parsing accuracy: " <<
       static_cast<double>(num_tokens_ - num_head_mistakes_) /
       static_cast<double>(num_tokens_);
@@ -276,6 +437,12 @@ protected:
     double tokens_per_second = static_cast<double>(num_tokens_) / num_seconds;
     LOG(INFO) << "Parsing speed: "
       << tokens_per_second << " tokens per second.";
+    if (GetDependencyOptions()->prune_basic()) {
+      double pruner_seconds = static_cast<double>(pruner_time_us_) / 1e6;
+      LOG(INFO) << "Pruning time: " << pruner_seconds << " sec ("
+        << static_cast<double>(num_tokens_) / pruner_seconds
+        << " tokens per second).";
+    }
   }
 
 #if 0
@@ -296,6 +463,39 @@ protected:
   int num_head_pruned_mistakes_;
   int num_heads_after_pruning_;
   int num_tokens_;
+  int64_t pruner_time_us_; // Time spent in Prune, in microseconds.
+  // Smallest margin between the posteriors of the two best heads of a word,
+  // computed by the pruner in the last call to Prune.
+  double pruner_margin_;
+  // Maximum number of heads per word kept by the pruner in the current
+  // sentence if it was reduced to fit --sentence_memory_budget_megabytes,
+  // or -1.
+  int budget_max_heads_;
+  // Memory taken by the features of the sentences made so far, and their
+  // number of parts (used to estimate the memory of a sentence from its
+  // parts).
+  int64_t feature_bytes_;
+  int64_t feature_bytes_num_parts_;
+  // Cascade model (NULL if there is none), with its own options and
+  // features.
+  DependencyOptions *cascade_options_;
+  DependencyPipe *cascade_pipe_;
+  Features *cascade_features_;
+  // Number of sentences, number of tokens, and time spent (in microseconds)
+  // in each tier of the cascade (0 for the main model, 1 for the cascade
+  // model), and number of sentences escalated because of their length or
+  // because of the pruner margin.
+  int cascade_num_sentences_[2];
+  int cascade_num_tokens_[2];
+  int64_t cascade_time_us_[2];
+  int cascade_num_escalated_length_;
+  int cascade_num_escalated_margin_;
+  // Tagger model (NULL if there is none), with its own options, and
+  // number of tagging mistakes and of tagged tokens.
+  TaggerOptions *tagger_options_;
+  TaggerPipe *tagger_pipe_;
+  int num_tag_mistakes_;
+  int num_tagged_tokens_;
   timeval start_clock_;
 };
 
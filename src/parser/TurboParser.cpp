@@ -65,34 +65,41 @@ void TrainParser() {
   DependencyPipe *pipe = new DependencyPipe(options);
   pipe->Initialize();
 
-  if (options->prune_basic()) {
-    if (options->use_pretrained_pruner()) {
-      pipe->LoadPrunerModelFile();
-    } else {
-      // Train the pruner.
-      LOG(INFO) << "Training the pruner...";
-      DependencyOptions *pruner_options = new DependencyOptions;
-      *pruner_options = *options;
-      // Transform things such as pruner_train_algorithm
-      // in train_algorithm.
-      pruner_options->CopyPrunerFlags();
-      pruner_options->Initialize();
-      DependencyPipe *pruner_pipe = new DependencyPipe(pruner_options);
-      pruner_pipe->Initialize();
-
-      pruner_pipe->Train();
-      pipe->SetPrunerParameters(pruner_pipe->GetParameters());
-      // This is necessary so that the pruner parameters are not
-      // destroyed when deleting the pruner pipe.
-      pruner_pipe->SetParameters(NULL);
-
-      delete pruner_pipe;
-      delete pruner_options;
-    }
+  if (options->prune_basic() && options->use_pretrained_pruner()) {
+    pipe->LoadPrunerModelFile();
+  }
+
+  // Read the training data once; the pruner is trained on the same
+  // dictionaries and instances.
+  pipe->ReadTrainingData();
+
+  if (options->prune_basic() && !options->use_pretrained_pruner()) {
+    // Train the pruner.
+    LOG(INFO) << "Training the pruner...";
+    DependencyOptions *pruner_options = new DependencyOptions;
+    *pruner_options = *options;
+    // Transform things such as pruner_train_algorithm
+    // in train_algorithm.
+    pruner_options->CopyPrunerFlags();
+    pruner_options->Initialize();
+    DependencyPipe *pruner_pipe = new DependencyPipe(pruner_options);
+    pruner_pipe->Initialize();
+
+    pruner_pipe->ShareTrainingData(pipe);
+    pruner_pipe->TrainInstances();
+    pipe->SetPrunerParameters(pruner_pipe->GetParameters());
+    // This is necessary so that the pruner parameters are not
+    // destroyed when deleting the pruner pipe.
+    pruner_pipe->SetParameters(NULL);
+    // The training data belongs to the main pipe.
+    pruner_pipe->ReleaseTrainingData();
+
+    delete pruner_pipe;
+    delete pruner_options;
   }
 
   LOG(INFO) << "Training the parser...";
-  pipe->Train();
+  pipe->TrainInstances();
   pipe->SaveModelFile();
 
   delete pipe;
@@ -116,7 +123,15 @@ void TestParser() {
   DependencyPipe *pipe = new DependencyPipe(options);
   pipe->Initialize();
   pipe->LoadModelFile();
+  if (options->GetCascadeModelFilePath() != "") {
+    pipe->LoadCascadeModelFile();
+  }
+  if (options->GetTaggerModelFilePath() != "") {
+    pipe->LoadTaggerModelFile();
+  }
   pipe->Run();
+  pipe->LogCascadeStatistics();
+  pipe->LogDecodingStatistics();
 
   delete pipe;
   delete options;
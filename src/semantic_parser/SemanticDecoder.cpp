@@ -19,6 +19,7 @@
 #include "SemanticDecoder.h"
 #include "SemanticPart.h"
 #include "SemanticPipe.h"
+#include "SemanticScoreMatrix.h"
 #include "AlgUtils.h"
 #include <iostream>
 #include <Eigen/Dense>
@@ -27,6 +28,8 @@
 #include "FactorSemanticGraph.h"
 #include "FactorPredicateAutomaton.h"
 #include "FactorArgumentAutomaton.h"
+#include <atomic>
+#include <thread>
 
 // Define a matrix of doubles using Eigen.
 typedef LogVal<double> LogValD;
@@ -186,8 +189,6 @@ void SemanticDecoder::DecodeMarginals(Instance *instance, Parts *parts,
   // Right now, only allow marginal inference for arc-factored models.
   CHECK(semantic_parts->IsArcFactored());
 
-  // Create copy of the scores.
-  vector<double> copied_scores(scores);
   vector<double> total_scores;
   vector<double> label_marginals;
   int offset_predicate_parts, num_predicate_parts;
@@ -199,22 +200,28 @@ void SemanticDecoder::DecodeMarginals(Instance *instance, Parts *parts,
   semantic_parts->GetOffsetLabeledArc(&offset_labeled_arcs,
                                       &num_labeled_arcs);
 
+  // Only the arc scores are modified, so they are kept in an overlay
+  // instead of copying all the scores.
+  vector<double> arc_scores(scores.begin() + offset_arcs,
+                            scores.begin() + offset_arcs + num_arcs);
+  ScoreView decoder_scores(scores);
+  decoder_scores.AddOverlay(offset_arcs, &arc_scores);
+
   // If labeled parsing, decode the labels and update the scores.
   if (pipe_->GetSemanticOptions()->labeled()) {
-    DecodeLabelMarginals(instance, parts, copied_scores, &total_scores,
+    DecodeLabelMarginals(instance, parts, scores, &total_scores,
                          &label_marginals);
     for (int r = 0; r < total_scores.size(); ++r) {
       // Sum the "labeled" scores to the (eventually) already existing
       // "unlabeled" scores.
-      copied_scores[offset_arcs + r] += total_scores[r];
+      arc_scores[r] += total_scores[r];
     }
   }
 
-  predicted_output->clear();
-  predicted_output->resize(parts->size(), 0.0);
+  predicted_output->assign(parts->size(), 0.0);
 
   double log_partition_function;
-  DecodeBasicMarginals(instance, parts, copied_scores, predicted_output,
+  DecodeBasicMarginals(instance, parts, decoder_scores, predicted_output,
                        &log_partition_function, entropy);
 
   // If labeled parsing, write the components of the predicted output that
@@ -266,7 +273,7 @@ void SemanticDecoder::DecodeMarginals(Instance *instance, Parts *parts,
 // best_labeled_parts, indexed by the unlabeled arcs, contains the indices
 // of the best labeled part for each arc.
 void SemanticDecoder::DecodeLabels(Instance *instance, Parts *parts,
-                                   const vector<double> &scores,
+                                   const ScoreView &scores,
                                    vector<int> *best_labeled_parts) {
   SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
 
@@ -344,8 +351,6 @@ void SemanticDecoder::Decode(Instance *instance, Parts *parts,
                              vector<double> *predicted_output) {
   SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
 
-  // Create copy of the scores.
-  vector<double> copied_scores(scores);
   vector<int> best_labeled_parts;
   int offset_labeled_arcs, num_labeled_arcs;
   semantic_parts->GetOffsetLabeledArc(&offset_labeled_arcs,
@@ -356,6 +361,21 @@ void SemanticDecoder::Decode(Instance *instance, Parts *parts,
   semantic_parts->GetOffsetPredicate(&offset_predicate_parts,
                                      &num_predicate_parts);
 
+  // Only the scores of the predicate parts, arcs and labeled arcs are
+  // modified, so they are kept in overlays instead of copying all the scores.
+  vector<double> predicate_scores(
+    scores.begin() + offset_predicate_parts,
+    scores.begin() + offset_predicate_parts + num_predicate_parts);
+  vector<double> arc_scores(scores.begin() + offset_arcs,
+                            scores.begin() + offset_arcs + num_arcs);
+  vector<double> labeled_arc_scores(
+    scores.begin() + offset_labeled_arcs,
+    scores.begin() + offset_labeled_arcs + num_labeled_arcs);
+  ScoreView decoder_scores(scores);
+  decoder_scores.AddOverlay(offset_predicate_parts, &predicate_scores);
+  decoder_scores.AddOverlay(offset_arcs, &arc_scores);
+  decoder_scores.AddOverlay(offset_labeled_arcs, &labeled_arc_scores);
+
   bool labeled_decoding = false;
   // TODO: change this test.
   int offset_labeled_siblings, num_labeled_siblings;
@@ -367,10 +387,9 @@ void SemanticDecoder::Decode(Instance *instance, Parts *parts,
   }
 
   if (labeled_decoding) {
-    predicted_output->clear();
-    predicted_output->resize(parts->size(), 0.0);
+    predicted_output->assign(parts->size(), 0.0);
 
-    DecodeFactorGraph(instance, parts, copied_scores, labeled_decoding, true,
+    DecodeFactorGraph(instance, parts, decoder_scores, labeled_decoding, true,
                       predicted_output);
 
     // At test time, run a basic decoder on top of the outcome of AD3
@@ -380,26 +399,26 @@ void SemanticDecoder::Decode(Instance *instance, Parts *parts,
     if (pipe_->GetSemanticOptions()->test()) {
       double threshold = 0.5;
       for (int r = 0; r < num_arcs; ++r) {
-        copied_scores[offset_arcs + r] = 0.0;
+        arc_scores[r] = 0.0;
       }
       for (int r = 0; r < num_predicate_parts; ++r) {
-        copied_scores[offset_predicate_parts + r] = 0.0;
+        predicate_scores[r] = 0.0;
       }
       for (int r = 0; r < num_labeled_arcs; ++r) {
-        copied_scores[offset_labeled_arcs + r] =
+        labeled_arc_scores[r] =
           (*predicted_output)[offset_labeled_arcs + r] - threshold;
       }
 
-      DecodeLabels(instance, parts, copied_scores, &best_labeled_parts);
+      DecodeLabels(instance, parts, decoder_scores, &best_labeled_parts);
       for (int r = 0; r < best_labeled_parts.size(); ++r) {
         // Sum the "labeled" scores to the (eventually) already existing
         // "unlabeled" scores.
-        copied_scores[offset_arcs + r] += copied_scores[best_labeled_parts[r]];
+        arc_scores[r] += decoder_scores[best_labeled_parts[r]];
       }
 
       double value;
       predicted_output->assign(parts->size(), 0.0);
-      DecodeBasic(instance, parts, copied_scores, predicted_output, &value);
+      DecodeBasic(instance, parts, decoder_scores, predicted_output, &value);
 
       // Write the components of the predicted output that
       // correspond to the labeled parts.
@@ -412,23 +431,22 @@ void SemanticDecoder::Decode(Instance *instance, Parts *parts,
   } else {
     // If labeled parsing, decode the labels and update the scores.
     if (pipe_->GetSemanticOptions()->labeled()) {
-      DecodeLabels(instance, parts, copied_scores, &best_labeled_parts);
+      DecodeLabels(instance, parts, decoder_scores, &best_labeled_parts);
       for (int r = 0; r < best_labeled_parts.size(); ++r) {
         // Sum the "labeled" scores to the (eventually) already existing
         // "unlabeled" scores.
-        copied_scores[offset_arcs + r] += copied_scores[best_labeled_parts[r]];
+        arc_scores[r] += decoder_scores[best_labeled_parts[r]];
       }
     }
 
-    predicted_output->clear();
-    predicted_output->resize(parts->size(), 0.0);
+    predicted_output->assign(parts->size(), 0.0);
 
     if (semantic_parts->IsArcFactored() ||
         semantic_parts->IsLabeledArcFactored()) {
       double value;
-      DecodeBasic(instance, parts, copied_scores, predicted_output, &value);
+      DecodeBasic(instance, parts, decoder_scores, predicted_output, &value);
     } else {
-      DecodeFactorGraph(instance, parts, copied_scores, labeled_decoding, true,
+      DecodeFactorGraph(instance, parts, decoder_scores, labeled_decoding, true,
                         predicted_output);
 
       // At test time, run a basic decoder on top of the outcome of AD3
@@ -438,20 +456,20 @@ void SemanticDecoder::Decode(Instance *instance, Parts *parts,
       if (pipe_->GetSemanticOptions()->test()) {
         double threshold = 0.5;
         for (int r = 0; r < num_arcs; ++r) {
-          copied_scores[offset_arcs + r] =
+          arc_scores[r] =
             (*predicted_output)[offset_arcs + r] - threshold;
         }
         for (int r = 0; r < num_predicate_parts; ++r) {
-          copied_scores[offset_predicate_parts + r] = 0.0;
+          predicate_scores[r] = 0.0;
         }
         // This is not strictly necessary (since labeled arcs are not used by
         // DecodeBasic), but should not harm.
         for (int r = 0; r < num_labeled_arcs; ++r) {
-          copied_scores[offset_labeled_arcs + r] = 0.0;
+          labeled_arc_scores[r] = 0.0;
         }
         predicted_output->assign(parts->size(), 0.0);
         double value;
-        DecodeBasic(instance, parts, copied_scores, predicted_output, &value);
+        DecodeBasic(instance, parts, decoder_scores, predicted_output, &value);
       }
     }
 
@@ -643,8 +661,11 @@ void SemanticDecoder::DecodePrunerNaive(Instance *instance, Parts *parts,
 
 // Decoder for the basic model. For each predicate, choose the best
 // sense and the best set of arcs independently.
+// This works on a flat, predicate-major layout of the scores (see
+// SemanticScoreMatrix); DecodeBasicNaive is the equivalent decoder on the
+// nested indices.
 void SemanticDecoder::DecodeBasic(Instance *instance, Parts *parts,
-                                  const vector<double> &scores,
+                                  const ScoreView &scores,
                                   vector<double> *predicted_output,
                                   double *value) {
   int sentence_length =
@@ -656,6 +677,186 @@ void SemanticDecoder::DecodeBasic(Instance *instance, Parts *parts,
                                      &num_predicate_parts);
   semantic_parts->GetOffsetArc(&offset_arcs, &num_arcs);
 
+  SemanticScoreMatrix score_matrix;
+  BuildScoreMatrix(sentence_length, parts, scores, &score_matrix);
+  const vector<double> &row_scores = score_matrix.row_scores();
+  const vector<double> &arc_scores = score_matrix.arc_scores();
+
+  predicted_output->resize(parts->size());
+  for (int r = 0; r < num_predicate_parts; ++r) {
+    (*predicted_output)[offset_predicate_parts + r] = 0.0;
+  }
+  for (int r = 0; r < num_arcs; ++r) {
+    (*predicted_output)[offset_arcs + r] = 0.0;
+  }
+
+  *value = 0.0;
+  for (int p = 0; p < sentence_length; ++p) {
+    int best_row = -1;
+    double best_score = 0.0;
+    for (int row = score_matrix.GetFirstRow(p);
+         row < score_matrix.GetFirstRow(p + 1); ++row) {
+      int begin = score_matrix.GetFirstArc(row);
+      int end = score_matrix.GetFirstArc(row + 1);
+      double score = row_scores[row] +
+        SumPositiveScores(&arc_scores[begin], end - begin);
+      // Note: we're allowing a non-null sense (!= -1) without outgoing arcs.
+      if (score > best_score) {
+        best_row = row;
+        best_score = score;
+      }
+    }
+    if (best_row < 0) continue;
+    *value += best_score;
+    int r = score_matrix.GetRowPredicatePart(best_row);
+    (*predicted_output)[offset_predicate_parts + r] = 1.0;
+    for (int k = score_matrix.GetFirstArc(best_row);
+         k < score_matrix.GetFirstArc(best_row + 1); ++k) {
+      if (arc_scores[k] <= 0.0) continue;
+      (*predicted_output)[offset_arcs + score_matrix.GetArcPart(k)] = 1.0;
+    }
+  }
+}
+
+// Marginal decoder for the basic model, on a flat, predicate-major layout of
+// the scores. The arc log-partition functions and marginals are computed
+// with batched kernels over the contiguous arc scores of each predicate.
+// DecodeBasicMarginalsNaive is the equivalent decoder on the nested indices.
+void SemanticDecoder::DecodeBasicMarginals(Instance *instance, Parts *parts,
+                                           const ScoreView &scores,
+                                           vector<double> *predicted_output,
+                                           double *log_partition_function,
+                                           double *entropy) {
+  int sentence_length =
+    static_cast<SemanticInstanceNumeric*>(instance)->size();
+  SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
+  int offset_predicate_parts, num_predicate_parts;
+  int offset_arcs, num_arcs;
+  semantic_parts->GetOffsetPredicate(&offset_predicate_parts,
+                                     &num_predicate_parts);
+  semantic_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+
+  SemanticScoreMatrix score_matrix;
+  BuildScoreMatrix(sentence_length, parts, scores, &score_matrix);
+  const vector<double> &row_scores = score_matrix.row_scores();
+  const vector<double> &arc_scores = score_matrix.arc_scores();
+  int num_rows = score_matrix.GetNumRows();
+  int num_matrix_arcs = score_matrix.GetNumArcs();
+
+  // Log-partition function of each arc, log(1 + exp(score)), to account for
+  // the event that the arc does not exist.
+  vector<double> log_partition_arcs(num_matrix_arcs);
+  if (num_matrix_arcs > 0) {
+    ComputeLogOnePlusExp(&arc_scores[0], num_matrix_arcs,
+                         &log_partition_arcs[0]);
+  }
+  // Log-partition function of each (predicate, sense).
+  vector<double> log_partition_rows(num_rows);
+  for (int row = 0; row < num_rows; ++row) {
+    double score = row_scores[row];
+    for (int k = score_matrix.GetFirstArc(row);
+         k < score_matrix.GetFirstArc(row + 1); ++k) {
+      score += log_partition_arcs[k];
+    }
+    log_partition_rows[row] = score;
+  }
+
+  predicted_output->resize(parts->size());
+  for (int r = 0; r < num_predicate_parts; ++r) {
+    (*predicted_output)[offset_predicate_parts + r] = 0.0;
+  }
+  for (int r = 0; r < num_arcs; ++r) {
+    (*predicted_output)[offset_arcs + r] = 0.0;
+  }
+
+  vector<double> arc_marginals(num_matrix_arcs);
+  *log_partition_function = 0.0;
+  *entropy = 0.0;
+  for (int p = 0; p < sentence_length; ++p) {
+    int first_row = score_matrix.GetFirstRow(p);
+    int last_row = score_matrix.GetFirstRow(p + 1);
+    // This makes sure the log partition function does not become -infty for
+    // predicates that do not have any sense.
+    if (first_row == last_row) continue;
+
+    // Log-sum-exp over the senses, including the null sense (score 0.0)
+    // which implies there are no outgoing arcs.
+    double max_score = 0.0;
+    for (int row = first_row; row < last_row; ++row) {
+      if (log_partition_rows[row] > max_score) {
+        max_score = log_partition_rows[row];
+      }
+    }
+    double sum = exp(-max_score);
+    for (int row = first_row; row < last_row; ++row) {
+      sum += exp(log_partition_rows[row] - max_score);
+    }
+    double log_partition_all_senses = max_score + log(sum);
+    *log_partition_function += log_partition_all_senses;
+
+    for (int row = first_row; row < last_row; ++row) {
+      int r = score_matrix.GetRowPredicatePart(row);
+      double predicate_marginal =
+        exp(log_partition_rows[row] - log_partition_all_senses);
+      (*predicted_output)[offset_predicate_parts + r] = predicate_marginal;
+      *entropy -= row_scores[row] * predicate_marginal;
+      int begin = score_matrix.GetFirstArc(row);
+      int end = score_matrix.GetFirstArc(row + 1);
+      if (begin == end) continue;
+      ComputeScaledSigmoid(&arc_scores[begin], &log_partition_arcs[begin],
+                           end - begin, predicate_marginal,
+                           &arc_marginals[begin]);
+      for (int k = begin; k < end; ++k) {
+        (*predicted_output)[offset_arcs + score_matrix.GetArcPart(k)] =
+          arc_marginals[k];
+        *entropy -= arc_scores[k] * arc_marginals[k];
+      }
+    }
+  }
+
+  *entropy += *log_partition_function;
+}
+
+// Build the flat score matrix from the predicate and arc parts.
+void SemanticDecoder::BuildScoreMatrix(int sentence_length,
+                                       Parts *parts,
+                                       const ScoreView &scores,
+                                       SemanticScoreMatrix *score_matrix) {
+  SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
+  int offset_predicate_parts, num_predicate_parts;
+  int offset_arcs, num_arcs;
+  semantic_parts->GetOffsetPredicate(&offset_predicate_parts,
+                                     &num_predicate_parts);
+  semantic_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+
+  vector<SemanticPartPredicate*> predicate_parts(num_predicate_parts);
+  for (int r = 0; r < num_predicate_parts; ++r) {
+    predicate_parts[r] =
+      static_cast<SemanticPartPredicate*>((*parts)[offset_predicate_parts + r]);
+  }
+  vector<SemanticPartArc*> arcs(num_arcs);
+  for (int r = 0; r < num_arcs; ++r) {
+    arcs[r] = static_cast<SemanticPartArc*>((*parts)[offset_arcs + r]);
+  }
+  score_matrix->Initialize(sentence_length, predicate_parts, arcs, scores,
+                           offset_predicate_parts, offset_arcs);
+}
+
+// Decoder for the basic model. For each predicate, choose the best
+// sense and the best set of arcs independently.
+void SemanticDecoder::DecodeBasicNaive(Instance *instance, Parts *parts,
+                                       const ScoreView &scores,
+                                       vector<double> *predicted_output,
+                                       double *value) {
+  int sentence_length =
+    static_cast<SemanticInstanceNumeric*>(instance)->size();
+  SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
+  int offset_predicate_parts, num_predicate_parts;
+  int offset_arcs, num_arcs;
+  semantic_parts->GetOffsetPredicate(&offset_predicate_parts,
+                                     &num_predicate_parts);
+  semantic_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+
   vector<SemanticPartArc*> arcs(num_arcs);
   vector<double> scores_arcs(num_arcs);
   for (int r = 0; r < num_arcs; ++r) {
@@ -779,11 +980,13 @@ void SemanticDecoder::DecodeBasic(Instance *instance, Parts *parts,
 
 // Decoder for the basic model. For each predicate, choose the best
 // sense and the best set of arcs independently.
-void SemanticDecoder::DecodeBasicMarginals(Instance *instance, Parts *parts,
-                                           const vector<double> &scores,
-                                           vector<double> *predicted_output,
-                                           double *log_partition_function,
-                                           double *entropy) {
+void SemanticDecoder::DecodeBasicMarginalsNaive(
+  Instance *instance,
+  Parts *parts,
+  const ScoreView &scores,
+  vector<double> *predicted_output,
+  double *log_partition_function,
+  double *entropy) {
   int sentence_length =
     static_cast<SemanticInstanceNumeric*>(instance)->size();
   SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
@@ -971,18 +1174,126 @@ void SemanticDecoder::DecodeSemanticGraph(
   *value = total_score;
 }
 
+// Arguments of a worker thread decoding factor graph components.
+struct SemanticDecoderWorker {
+  SemanticDecoder *decoder;
+  Instance *instance;
+  Parts *parts;
+  const ScoreView *scores;
+  bool labeled_decoding;
+  const vector<SemanticFactorGraphComponent> *components;
+  std::atomic<int> *next_component;
+  vector<double> *predicted_output;
+  vector<double> *values;
+  vector<int64_t> *factor_graph_bytes;
+  vector<int> *variable_indices;
+};
+
+static void RunSemanticDecoderWorker(SemanticDecoderWorker *worker) {
+  int num_components = worker->components->size();
+  while (true) {
+    int i = (*worker->next_component)++;
+    if (i >= num_components) break;
+    worker->decoder->DecodeFactorGraphComponent(
+      worker->instance, worker->parts, *worker->scores,
+      worker->labeled_decoding, (*worker->components)[i],
+      worker->predicted_output, worker->variable_indices,
+      &(*worker->values)[i], &(*worker->factor_graph_bytes)[i]);
+  }
+}
+
 // Decode building a factor graph and calling the AD3 algorithm.
+// If there are no parts linking different predicates (grandparents and
+// co-parents), the factor graph has one connected component per predicate
+// word; in that case each component is solved separately, and components are
+// distributed among num_threads_ threads (--srl_decoder_num_threads).
 void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
-                                        const vector<double> &scores,
+                                        const ScoreView &scores,
                                         bool labeled_decoding,
                                         bool relax,
                                         vector<double> *predicted_output) {
   SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
-  SemanticInstanceNumeric* sentence =
-    static_cast<SemanticInstanceNumeric*>(instance);
   CHECK(relax);
 
-  // Get the offsets for the different parts.
+  int offset_grandparents, num_grandparents;
+  semantic_parts->GetOffsetGrandparent(&offset_grandparents, &num_grandparents);
+  int offset_coparents, num_coparents;
+  semantic_parts->GetOffsetCoparent(&offset_coparents, &num_coparents);
+  int offset_consecutive_coparents, num_consecutive_coparents;
+  semantic_parts->GetOffsetConsecutiveCoparent(&offset_consecutive_coparents,
+                                               &num_consecutive_coparents);
+  bool decompose_by_predicate = (num_grandparents == 0 &&
+                                 num_coparents == 0 &&
+                                 num_consecutive_coparents == 0);
+
+  vector<SemanticFactorGraphComponent> components;
+  BuildFactorGraphComponents(instance, parts, decompose_by_predicate,
+                             &components);
+
+  predicted_output->assign(parts->size(), 0.0);
+  vector<double> values(components.size(), 0.0);
+  vector<int64_t> factor_graph_bytes(components.size(), 0);
+  // Shared by all the components, which touch disjoint entries.
+  vector<int> variable_indices(parts->size(), -1);
+  int num_threads = std::min(num_threads_,
+                             static_cast<int>(components.size()));
+  if (num_threads <= 1) {
+    for (int i = 0; i < components.size(); ++i) {
+      DecodeFactorGraphComponent(instance, parts, scores, labeled_decoding,
+                                 components[i], predicted_output,
+                                 &variable_indices, &values[i],
+                                 &factor_graph_bytes[i]);
+    }
+  } else {
+    // Components touch disjoint parts, so the workers can write their
+    // posteriors directly into predicted_output.
+    std::atomic<int> next_component(0);
+    SemanticDecoderWorker worker;
+    worker.decoder = this;
+    worker.instance = instance;
+    worker.parts = parts;
+    worker.scores = &scores;
+    worker.labeled_decoding = labeled_decoding;
+    worker.components = &components;
+    worker.next_component = &next_component;
+    worker.predicted_output = predicted_output;
+    worker.values = &values;
+    worker.factor_graph_bytes = &factor_graph_bytes;
+    worker.variable_indices = &variable_indices;
+    vector<std::thread> threads;
+    for (int t = 1; t < num_threads; ++t) {
+      threads.push_back(std::thread(RunSemanticDecoderWorker, &worker));
+    }
+    RunSemanticDecoderWorker(&worker);
+    for (int t = 0; t < threads.size(); ++t) {
+      threads[t].join();
+    }
+  }
+
+  // The workers do not update the profiler; the memory of the components
+  // is added up here.
+  double value = 0.0;
+  int64_t num_bytes = 0;
+  for (int i = 0; i < values.size(); ++i) {
+    value += values[i];
+    num_bytes += factor_graph_bytes[i];
+  }
+  if (ProfilesMemory()) {
+    RecordProfilerMemory(PROFILER_MEMORY_FACTOR_GRAPH, num_bytes);
+  }
+  VLOG(2) << "Solution value (AD3) = " << value
+    << " (" << components.size() << " components)";
+}
+
+void SemanticDecoder::BuildFactorGraphComponents(
+  Instance *instance,
+  Parts *parts,
+  bool decompose_by_predicate,
+  vector<SemanticFactorGraphComponent> *components) {
+  SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
+  int sentence_length =
+    static_cast<SemanticInstanceNumeric*>(instance)->size();
+
   int offset_predicate_parts, num_predicate_parts;
   semantic_parts->GetOffsetPredicate(&offset_predicate_parts,
                                      &num_predicate_parts);
@@ -1007,27 +1318,139 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   semantic_parts->GetOffsetConsecutiveCoparent(&offset_consecutive_coparents,
                                                &num_consecutive_coparents);
 
-#if 0
-  int offset_grandsiblings, num_grandsiblings;
-  semantic_parts->GetOffsetGrandSibling(&offset_grandsiblings, &num_grandsiblings);
-  int offset_trisiblings, num_trisiblings;
-  dependency_parts->GetOffsetTriSibling(&offset_trisiblings, &num_trisiblings);
-#endif
+  components->clear();
+  if (!decompose_by_predicate) {
+    // A single component with all the parts.
+    components->resize(1);
+    SemanticFactorGraphComponent *component = &(*components)[0];
+    for (int r = 0; r < num_predicate_parts; ++r) {
+      component->predicate_parts.push_back(offset_predicate_parts + r);
+    }
+    for (int r = 0; r < num_arcs; ++r) {
+      component->arcs.push_back(offset_arcs + r);
+    }
+    for (int r = 0; r < num_labeled_arcs; ++r) {
+      component->labeled_arcs.push_back(offset_labeled_arcs + r);
+    }
+    for (int r = 0; r < num_siblings; ++r) {
+      component->siblings.push_back(offset_siblings + r);
+    }
+    for (int r = 0; r < num_labeled_siblings; ++r) {
+      component->labeled_siblings.push_back(offset_labeled_siblings + r);
+    }
+    for (int r = 0; r < num_consecutive_siblings; ++r) {
+      component->consecutive_siblings.push_back(
+        offset_consecutive_siblings + r);
+    }
+    for (int r = 0; r < num_grandparents; ++r) {
+      component->grandparents.push_back(offset_grandparents + r);
+    }
+    for (int r = 0; r < num_coparents; ++r) {
+      component->coparents.push_back(offset_coparents + r);
+    }
+    for (int r = 0; r < num_consecutive_coparents; ++r) {
+      component->consecutive_coparents.push_back(
+        offset_consecutive_coparents + r);
+    }
+    return;
+  }
+
+  CHECK_EQ(num_grandparents, 0);
+  CHECK_EQ(num_coparents, 0);
+  CHECK_EQ(num_consecutive_coparents, 0);
+
+  // One component per predicate word, created in order of appearance of
+  // the predicate parts.
+  vector<int> component_indices(sentence_length, -1);
+  for (int r = 0; r < num_predicate_parts; ++r) {
+    SemanticPartPredicate *predicate_part =
+      static_cast<SemanticPartPredicate*>((*parts)[offset_predicate_parts + r]);
+    int p = predicate_part->predicate();
+    if (component_indices[p] < 0) {
+      component_indices[p] = components->size();
+      components->push_back(SemanticFactorGraphComponent());
+    }
+    (*components)[component_indices[p]].predicate_parts.push_back(
+      offset_predicate_parts + r);
+  }
+  for (int r = 0; r < num_arcs; ++r) {
+    SemanticPartArc *arc =
+      static_cast<SemanticPartArc*>((*parts)[offset_arcs + r]);
+    int k = component_indices[arc->predicate()];
+    CHECK_GE(k, 0);
+    (*components)[k].arcs.push_back(offset_arcs + r);
+  }
+  for (int r = 0; r < num_labeled_arcs; ++r) {
+    SemanticPartLabeledArc *labeled_arc =
+      static_cast<SemanticPartLabeledArc*>((*parts)[offset_labeled_arcs + r]);
+    int k = component_indices[labeled_arc->predicate()];
+    CHECK_GE(k, 0);
+    (*components)[k].labeled_arcs.push_back(offset_labeled_arcs + r);
+  }
+  for (int r = 0; r < num_siblings; ++r) {
+    SemanticPartSibling *sibling =
+      static_cast<SemanticPartSibling*>((*parts)[offset_siblings + r]);
+    int k = component_indices[sibling->predicate()];
+    CHECK_GE(k, 0);
+    (*components)[k].siblings.push_back(offset_siblings + r);
+  }
+  for (int r = 0; r < num_labeled_siblings; ++r) {
+    SemanticPartLabeledSibling *sibling =
+      static_cast<SemanticPartLabeledSibling*>(
+        (*parts)[offset_labeled_siblings + r]);
+    int k = component_indices[sibling->predicate()];
+    CHECK_GE(k, 0);
+    (*components)[k].labeled_siblings.push_back(offset_labeled_siblings + r);
+  }
+  for (int r = 0; r < num_consecutive_siblings; ++r) {
+    SemanticPartConsecutiveSibling *sibling =
+      static_cast<SemanticPartConsecutiveSibling*>(
+        (*parts)[offset_consecutive_siblings + r]);
+    int k = component_indices[sibling->predicate()];
+    CHECK_GE(k, 0);
+    (*components)[k].consecutive_siblings.push_back(
+      offset_consecutive_siblings + r);
+  }
+}
+
+// Build and solve the factor graph for one component.
+void SemanticDecoder::DecodeFactorGraphComponent(
+  Instance *instance,
+  Parts *parts,
+  const ScoreView &scores,
+  bool labeled_decoding,
+  const SemanticFactorGraphComponent &component,
+  vector<double> *predicted_output,
+  vector<int> *variable_indices,
+  double *value,
+  int64_t *num_bytes) {
+  SemanticParts *semantic_parts = static_cast<SemanticParts*>(parts);
+  SemanticInstanceNumeric* sentence =
+    static_cast<SemanticInstanceNumeric*>(instance);
+
+  // Get the offsets for the different parts.
+  int offset_predicate_parts, num_predicate_parts;
+  semantic_parts->GetOffsetPredicate(&offset_predicate_parts,
+                                     &num_predicate_parts);
+  int offset_arcs, num_arcs;
+  semantic_parts->GetOffsetArc(&offset_arcs, &num_arcs);
+  int offset_labeled_arcs, num_labeled_arcs;
+  semantic_parts->GetOffsetLabeledArc(&offset_labeled_arcs,
+                                      &num_labeled_arcs);
 
   // Define what parts are used.
-  bool use_arbitrary_sibling_parts = (num_siblings > 0);
-  bool use_labeled_arbitrary_sibling_parts = (num_labeled_siblings > 0);
-  bool use_consecutive_sibling_parts = (num_consecutive_siblings > 0);
-  bool use_grandparent_parts = (num_grandparents > 0);
-  bool use_coparent_parts = (num_coparents > 0);
-  bool use_consecutive_coparent_parts = (num_consecutive_coparents > 0);
-#if 0
-  bool use_grandsibling_parts = (num_grandsiblings > 0);
-  bool use_trisibling_parts = (num_trisiblings > 0);
-#endif
+  bool use_arbitrary_sibling_parts = (component.siblings.size() > 0);
+  bool use_labeled_arbitrary_sibling_parts =
+    (component.labeled_siblings.size() > 0);
+  bool use_consecutive_sibling_parts =
+    (component.consecutive_siblings.size() > 0);
+  bool use_grandparent_parts = (component.grandparents.size() > 0);
+  bool use_coparent_parts = (component.coparents.size() > 0);
+  bool use_consecutive_coparent_parts =
+    (component.consecutive_coparents.size() > 0);
 
   if (!labeled_decoding) {
-    CHECK_EQ(num_labeled_siblings, 0);
+    CHECK_EQ(component.labeled_siblings.size(), 0);
     CHECK(!pipe_->GetSemanticOptions()->deterministic_labels());
   }
 
@@ -1048,47 +1471,56 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   factor_graph->SetVerbosity(verbosity);
 
   // Build predicate part variables.
-  int offset_predicate_variables = variables.size();
-  for (int r = 0; r < num_predicate_parts; ++r) {
+  for (int k = 0; k < component.predicate_parts.size(); ++k) {
+    int r = component.predicate_parts[k];
     AD3::BinaryVariable* variable = factor_graph->CreateBinaryVariable();
-    variable->SetLogPotential(scores[offset_predicate_parts + r]);
+    variable->SetLogPotential(scores[r]);
+    (*variable_indices)[r] = variables.size();
     variables.push_back(variable);
-    part_indices_.push_back(offset_predicate_parts + r);
+    part_indices_.push_back(r);
   }
 
   // Build arc variables.
-  int offset_arc_variables = variables.size();
-  for (int r = 0; r < num_arcs; ++r) {
+  for (int k = 0; k < component.arcs.size(); ++k) {
+    int r = component.arcs[k];
     AD3::BinaryVariable* variable = factor_graph->CreateBinaryVariable();
-    variable->SetLogPotential(scores[offset_arcs + r]);
+    variable->SetLogPotential(scores[r]);
+    (*variable_indices)[r] = variables.size();
     variables.push_back(variable);
-    part_indices_.push_back(offset_arcs + r);
+    part_indices_.push_back(r);
   }
 
-  int offset_labeled_arc_variables = variables.size();
   if (labeled_decoding) {
     // Build labeled arc variables.
-    for (int r = 0; r < num_labeled_arcs; ++r) {
+    for (int k = 0; k < component.labeled_arcs.size(); ++k) {
+      int r = component.labeled_arcs[k];
       AD3::BinaryVariable* variable = factor_graph->CreateBinaryVariable();
-      variable->SetLogPotential(scores[offset_labeled_arcs + r]);
+      variable->SetLogPotential(scores[r]);
+      (*variable_indices)[r] = variables.size();
       variables.push_back(variable);
-      part_indices_.push_back(offset_labeled_arcs + r);
+      part_indices_.push_back(r);
     }
   }
 
   // Build basic semantic graph factor.
-  vector<AD3::BinaryVariable*> local_variables(num_predicate_parts + num_arcs);
-  vector<SemanticPartPredicate*> predicate_parts(num_predicate_parts);
-  for (int r = 0; r < num_predicate_parts; ++r) {
-    local_variables[r] = variables[offset_predicate_variables + r];
-    predicate_parts[r] =
-      static_cast<SemanticPartPredicate*>((*parts)[offset_predicate_parts + r]);
+  int num_component_predicate_parts = component.predicate_parts.size();
+  int num_component_arcs = component.arcs.size();
+  vector<AD3::BinaryVariable*> local_variables(num_component_predicate_parts +
+                                               num_component_arcs);
+  vector<SemanticPartPredicate*>
+    predicate_parts(num_component_predicate_parts);
+  for (int k = 0; k < num_component_predicate_parts; ++k) {
+    int r = component.predicate_parts[k];
+    local_variables[k] =
+      variables[(*variable_indices)[r]];
+    predicate_parts[k] = static_cast<SemanticPartPredicate*>((*parts)[r]);
   }
-  vector<SemanticPartArc*> arcs(num_arcs);
-  for (int r = 0; r < num_arcs; ++r) {
-    local_variables[num_predicate_parts + r] =
-      variables[offset_arc_variables + r];
-    arcs[r] = static_cast<SemanticPartArc*>((*parts)[offset_arcs + r]);
+  vector<SemanticPartArc*> arcs(num_component_arcs);
+  for (int k = 0; k < num_component_arcs; ++k) {
+    int r = component.arcs[k];
+    local_variables[num_component_predicate_parts + k] =
+      variables[(*variable_indices)[r]];
+    arcs[k] = static_cast<SemanticPartArc*>((*parts)[r]);
   }
   AD3::FactorSemanticGraph *factor = new AD3::FactorSemanticGraph;
   factor->Initialize(sentence->size(), predicate_parts, arcs, this);
@@ -1097,23 +1529,23 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
 
   if (labeled_decoding) {
     // Build XOR-OUT factors to impose that each arc has a unique label.
-    for (int r = 0; r < num_arcs; ++r) {
+    for (int k = 0; k < component.arcs.size(); ++k) {
+      int r = component.arcs[k];
       const vector<int> &index_labeled_parts =
-        semantic_parts->GetLabeledParts(offset_arcs + r);
+        semantic_parts->GetLabeledParts(r);
       vector<AD3::BinaryVariable*>
         local_variables(index_labeled_parts.size() + 1);
-      for (int k = 0; k < index_labeled_parts.size(); ++k) {
-        int index_part = index_labeled_parts[k];
+      for (int l = 0; l < index_labeled_parts.size(); ++l) {
+        int index_part = index_labeled_parts[l];
         CHECK_GE(index_part, 0);
-        CHECK_LT(offset_labeled_arc_variables + index_part - offset_labeled_arcs,
-                 variables.size());
-        local_variables[k] = variables[offset_labeled_arc_variables +
-          index_part - offset_labeled_arcs];
+        int index =
+          (*variable_indices)[index_part];
+        CHECK_GE(index, 0);
+        local_variables[l] = variables[index];
       }
-      CHECK_GE(offset_arc_variables + r, 0);
-      CHECK_LT(offset_arc_variables + r, variables.size());
-      local_variables[index_labeled_parts.size()] =
-        variables[offset_arc_variables + r];
+      int index = (*variable_indices)[r];
+      CHECK_GE(index, 0);
+      local_variables[index_labeled_parts.size()] = variables[index];
       factor_graph->CreateFactorXOROUT(local_variables);
       factor_part_indices_.push_back(-1);
     }
@@ -1121,14 +1553,13 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
     // If some labels are deterministic, make sure the same role is not filled
     // more than once for each predicate.
     if (pipe_->GetSemanticOptions()->deterministic_labels()) {
-      int sentence_length =
-        static_cast<SemanticInstanceNumeric*>(instance)->size();
+      int sentence_length = sentence->size();
       vector<vector<vector<int> > >
         labeled_arcs_by_predicate_role(sentence_length);
-      for (int r = 0; r < num_labeled_arcs; ++r) {
+      for (int k = 0; k < component.labeled_arcs.size(); ++k) {
+        int r = component.labeled_arcs[k];
         SemanticPartLabeledArc *labeled_arc =
-          static_cast<SemanticPartLabeledArc*>(
-            (*semantic_parts)[offset_labeled_arcs + r]);
+          static_cast<SemanticPartLabeledArc*>((*semantic_parts)[r]);
         int p = labeled_arc->predicate();
         int l = labeled_arc->role();
         // Skip if role l is not deterministic.
@@ -1146,7 +1577,8 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
           for (int k = 0; k < labeled_arcs_by_predicate_role[p][l].size();
           ++k) {
             int r = labeled_arcs_by_predicate_role[p][l][k];
-            local_variables[k] = variables[offset_labeled_arc_variables + r];
+            int index = (*variable_indices)[r];
+            local_variables[k] = variables[index];
           }
           factor_graph->CreateFactorAtMostOne(local_variables);
           factor_part_indices_.push_back(-1);
@@ -1159,9 +1591,10 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   // Build sibling factors.
   //////////////////////////////////////////////////////////////////////
   if (use_arbitrary_sibling_parts) {
-    for (int r = 0; r < num_siblings; ++r) {
-      SemanticPartSibling *part = static_cast<SemanticPartSibling*>(
-        (*semantic_parts)[offset_siblings + r]);
+    for (int k = 0; k < component.siblings.size(); ++k) {
+      int r = component.siblings[k];
+      SemanticPartSibling *part =
+        static_cast<SemanticPartSibling*>((*semantic_parts)[r]);
       int r1 = semantic_parts->FindArc(part->predicate(),
                                        part->first_argument(),
                                        part->sense());
@@ -1171,18 +1604,17 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       CHECK_GE(r1, 0);
       CHECK_GE(r2, 0);
       vector<AD3::BinaryVariable*> local_variables;
-      local_variables.push_back(variables[r1 - offset_arcs +
-                                offset_arc_variables]);
-      local_variables.push_back(variables[r2 - offset_arcs +
-                                offset_arc_variables]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r1]]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r2]]);
 
-      factor_graph->CreateFactorPAIR(local_variables,
-                                     scores[offset_siblings + r]);
+      factor_graph->CreateFactorPAIR(local_variables, scores[r]);
       // TODO: set these global indices at the end after all variables/factors
       // are created.
       //factor->SetGlobalIndex(...);
-      additional_part_indices.push_back(offset_siblings + r);
-      factor_part_indices_.push_back(offset_siblings + r);
+      additional_part_indices.push_back(r);
+      factor_part_indices_.push_back(r);
     }
   }
 
@@ -1191,10 +1623,10 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   //////////////////////////////////////////////////////////////////////
   if (use_labeled_arbitrary_sibling_parts) {
     CHECK(labeled_decoding);
-    for (int r = 0; r < num_labeled_siblings; ++r) {
+    for (int k = 0; k < component.labeled_siblings.size(); ++k) {
+      int r = component.labeled_siblings[k];
       SemanticPartLabeledSibling *part =
-        static_cast<SemanticPartLabeledSibling*>(
-          (*semantic_parts)[offset_labeled_siblings + r]);
+        static_cast<SemanticPartLabeledSibling*>((*semantic_parts)[r]);
       int r1 = semantic_parts->FindLabeledArc(part->predicate(),
                                               part->first_argument(),
                                               part->sense(),
@@ -1206,18 +1638,17 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       CHECK_GE(r1, 0);
       CHECK_GE(r2, 0);
       vector<AD3::BinaryVariable*> local_variables;
-      local_variables.push_back(variables[r1 - offset_labeled_arcs +
-                                offset_labeled_arc_variables]);
-      local_variables.push_back(variables[r2 - offset_labeled_arcs +
-                                offset_labeled_arc_variables]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r1]]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r2]]);
 
-      factor_graph->CreateFactorPAIR(local_variables,
-                                     scores[offset_labeled_siblings + r]);
+      factor_graph->CreateFactorPAIR(local_variables, scores[r]);
       // TODO: set these global indices at the end after all variables/factors
       // are created.
       //factor->SetGlobalIndex(...);
-      additional_part_indices.push_back(offset_labeled_siblings + r);
-      factor_part_indices_.push_back(offset_labeled_siblings + r);
+      additional_part_indices.push_back(r);
+      factor_part_indices_.push_back(r);
     }
   }
 
@@ -1227,23 +1658,22 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   if (use_consecutive_sibling_parts) {
     // Get all the consecutive siblings, indices, etc.
     vector<vector<int> > predicate_part_indices(sentence->size());
-    for (int r = 0; r < num_predicate_parts; ++r) {
+    for (int k = 0; k < component.predicate_parts.size(); ++k) {
+      int r = component.predicate_parts[k];
       SemanticPartPredicate* predicate_part =
-        static_cast<SemanticPartPredicate*>(
-          (*parts)[offset_predicate_parts + r]);
-      predicate_part_indices[predicate_part->predicate()].
-        push_back(offset_predicate_parts + r);
+        static_cast<SemanticPartPredicate*>((*parts)[r]);
+      predicate_part_indices[predicate_part->predicate()].push_back(r);
     }
     vector<vector<int> > left_arc_indices(sentence->size());
     vector<vector<int> > right_arc_indices(sentence->size());
-    for (int r = 0; r < num_arcs; ++r) {
-      SemanticPartArc* arc =
-        static_cast<SemanticPartArc*>((*parts)[offset_arcs + r]);
+    for (int k = 0; k < component.arcs.size(); ++k) {
+      int r = component.arcs[k];
+      SemanticPartArc* arc = static_cast<SemanticPartArc*>((*parts)[r]);
       // Handle self-loops (p=a) in the right side automaton.
       if (arc->predicate() > arc->argument()) {
-        left_arc_indices[arc->predicate()].push_back(offset_arcs + r);
+        left_arc_indices[arc->predicate()].push_back(r);
       } else {
-        right_arc_indices[arc->predicate()].push_back(offset_arcs + r);
+        right_arc_indices[arc->predicate()].push_back(r);
       }
     }
     vector<vector<SemanticPartConsecutiveSibling*> >
@@ -1254,21 +1684,19 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
     vector<vector<double> > right_scores(sentence->size());
     vector<vector<int> > left_indices(sentence->size());
     vector<vector<int> > right_indices(sentence->size());
-    for (int r = 0; r < num_consecutive_siblings; ++r) {
+    for (int k = 0; k < component.consecutive_siblings.size(); ++k) {
+      int r = component.consecutive_siblings[k];
       SemanticPartConsecutiveSibling *sibling =
-        static_cast<SemanticPartConsecutiveSibling*>(
-          (*parts)[offset_consecutive_siblings + r]);
+        static_cast<SemanticPartConsecutiveSibling*>((*parts)[r]);
       // TODO: Try to disable self loops on the left side?
       // Make sure no non-basic sibling part ends up in two
       // factors.
       if (sibling->predicate() > sibling->second_argument()) {
         // Left sibling.
         left_siblings[sibling->predicate()].push_back(sibling);
-        left_scores[sibling->predicate()].push_back(
-          scores[offset_consecutive_siblings + r]);
+        left_scores[sibling->predicate()].push_back(scores[r]);
         // Save the part index to get the posterior later.
-        left_indices[sibling->predicate()].
-          push_back(offset_consecutive_siblings + r);
+        left_indices[sibling->predicate()].push_back(r);
       } else {
         CHECK(sibling->predicate() < sibling->second_argument() ||
               (sibling->predicate() == sibling->second_argument() &&
@@ -1278,11 +1706,9 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
           << sibling->second_argument();
         // Right sibling.
         right_siblings[sibling->predicate()].push_back(sibling);
-        right_scores[sibling->predicate()].push_back(
-          scores[offset_consecutive_siblings + r]);
+        right_scores[sibling->predicate()].push_back(scores[r]);
         // Save the part index to get the posterior later.
-        right_indices[sibling->predicate()].
-          push_back(offset_consecutive_siblings + r);
+        right_indices[sibling->predicate()].push_back(r);
       }
     }
 
@@ -1301,7 +1727,7 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       vector<SemanticPartArc*> left_arcs;
       for (int s = 0; s < predicate_part_indices[p].size(); ++s) {
         int r = predicate_part_indices[p][s];
-        int index = offset_predicate_variables + r - offset_predicate_parts;
+        int index = (*variable_indices)[r];
         local_variables.push_back(variables[index]);
         SemanticPartPredicate *predicate =
           static_cast<SemanticPartPredicate*>((*parts)[r]);
@@ -1309,7 +1735,7 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       }
       for (int k = 0; k < left_arc_indices[p].size(); ++k) {
         int r = left_arc_indices[p][k];
-        int index = offset_arc_variables + r - offset_arcs;
+        int index = (*variable_indices)[r];
         local_variables.push_back(variables[index]);
         SemanticPartArc *arc =
           static_cast<SemanticPartArc*>((*parts)[r]);
@@ -1332,7 +1758,7 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       for (int s = 0; s < predicate_part_indices[p].size(); ++s) {
         int r = predicate_part_indices[p][s];
         CHECK_GE(r, 0);
-        int index = offset_predicate_variables + r - offset_predicate_parts;
+        int index = (*variable_indices)[r];
         local_variables.push_back(variables[index]);
         SemanticPartPredicate *predicate =
           static_cast<SemanticPartPredicate*>((*parts)[r]);
@@ -1341,7 +1767,7 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       for (int k = 0; k < right_arc_indices[p].size(); ++k) {
         int r = right_arc_indices[p][k];
         CHECK_GE(r, 0);
-        int index = offset_arc_variables + r - offset_arcs;
+        int index = (*variable_indices)[r];
         local_variables.push_back(variables[index]);
         SemanticPartArc *arc =
           static_cast<SemanticPartArc*>((*parts)[r]);
@@ -1368,13 +1794,13 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
     // whose predicate is on the left of the argument.
     vector<vector<int> > left_arc_indices(sentence->size());
     vector<vector<int> > right_arc_indices(sentence->size());
-    for (int r = 0; r < num_arcs; ++r) {
-      SemanticPartArc* arc =
-        static_cast<SemanticPartArc*>((*parts)[offset_arcs + r]);
+    for (int k = 0; k < component.arcs.size(); ++k) {
+      int r = component.arcs[k];
+      SemanticPartArc* arc = static_cast<SemanticPartArc*>((*parts)[r]);
       if (arc->predicate() < arc->argument()) {
-        left_arc_indices[arc->argument()].push_back(offset_arcs + r);
+        left_arc_indices[arc->argument()].push_back(r);
       } else {
-        right_arc_indices[arc->argument()].push_back(offset_arcs + r);
+        right_arc_indices[arc->argument()].push_back(r);
       }
     }
     vector<vector<SemanticPartConsecutiveCoparent*> >
@@ -1385,29 +1811,25 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
     vector<vector<double> > right_scores(sentence->size());
     vector<vector<int> > left_indices(sentence->size());
     vector<vector<int> > right_indices(sentence->size());
-    for (int r = 0; r < num_consecutive_coparents; ++r) {
+    for (int k = 0; k < component.consecutive_coparents.size(); ++k) {
+      int r = component.consecutive_coparents[k];
       SemanticPartConsecutiveCoparent *coparent =
-        static_cast<SemanticPartConsecutiveCoparent*>(
-          (*parts)[offset_consecutive_coparents + r]);
+        static_cast<SemanticPartConsecutiveCoparent*>((*parts)[r]);
       if (coparent->argument() > coparent->second_predicate()) {
         // Left co-parent.
         left_coparents[coparent->argument()].push_back(coparent);
-        left_scores[coparent->argument()].push_back(
-          scores[offset_consecutive_coparents + r]);
+        left_scores[coparent->argument()].push_back(scores[r]);
         // Save the part index to get the posterior later.
-        left_indices[coparent->argument()].
-          push_back(offset_consecutive_coparents + r);
+        left_indices[coparent->argument()].push_back(r);
       } else {
         CHECK(coparent->argument() < coparent->second_predicate() ||
               (coparent->argument() == coparent->second_predicate() &&
                coparent->first_predicate() < 0));
         // Right co-parent.
         right_coparents[coparent->argument()].push_back(coparent);
-        right_scores[coparent->argument()].push_back(
-          scores[offset_consecutive_coparents + r]);
+        right_scores[coparent->argument()].push_back(scores[r]);
         // Save the part index to get the posterior later.
-        right_indices[coparent->argument()].
-          push_back(offset_consecutive_coparents + r);
+        right_indices[coparent->argument()].push_back(r);
       }
     }
 
@@ -1418,7 +1840,7 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       vector<SemanticPartArc*> left_arcs;
       for (int k = 0; k < left_arc_indices[a].size(); ++k) {
         int r = left_arc_indices[a][k];
-        int index = offset_arc_variables + r - offset_arcs;
+        int index = (*variable_indices)[r];
         local_variables.push_back(variables[index]);
         SemanticPartArc *arc =
           static_cast<SemanticPartArc*>((*parts)[r]);
@@ -1439,7 +1861,7 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       vector<SemanticPartArc*> right_arcs;
       for (int k = 0; k < right_arc_indices[a].size(); ++k) {
         int r = right_arc_indices[a][k];
-        int index = offset_arc_variables + r - offset_arcs;
+        int index = (*variable_indices)[r];
         local_variables.push_back(variables[index]);
         SemanticPartArc *arc =
           static_cast<SemanticPartArc*>((*parts)[r]);
@@ -1461,9 +1883,10 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   // Build grandparent factors.
   //////////////////////////////////////////////////////////////////////
   if (use_grandparent_parts) {
-    for (int r = 0; r < num_grandparents; ++r) {
-      SemanticPartGrandparent *part = static_cast<SemanticPartGrandparent*>(
-        (*semantic_parts)[offset_grandparents + r]);
+    for (int k = 0; k < component.grandparents.size(); ++k) {
+      int r = component.grandparents[k];
+      SemanticPartGrandparent *part =
+        static_cast<SemanticPartGrandparent*>((*semantic_parts)[r]);
       int r1 = semantic_parts->FindArc(part->grandparent_predicate(),
                                        part->predicate(),
                                        part->grandparent_sense());
@@ -1473,18 +1896,17 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       CHECK_GE(r1, 0);
       CHECK_GE(r2, 0);
       vector<AD3::BinaryVariable*> local_variables;
-      local_variables.push_back(variables[r1 - offset_arcs +
-                                offset_arc_variables]);
-      local_variables.push_back(variables[r2 - offset_arcs +
-                                offset_arc_variables]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r1]]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r2]]);
 
-      factor_graph->CreateFactorPAIR(local_variables,
-                                     scores[offset_grandparents + r]);
+      factor_graph->CreateFactorPAIR(local_variables, scores[r]);
       // TODO: set these global indices at the end after all variables/factors
       // are created.
       //factor->SetGlobalIndex(...);
-      additional_part_indices.push_back(offset_grandparents + r);
-      factor_part_indices_.push_back(offset_grandparents + r);
+      additional_part_indices.push_back(r);
+      factor_part_indices_.push_back(r);
     }
   }
 
@@ -1492,9 +1914,10 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   // Build co-parent factors.
   //////////////////////////////////////////////////////////////////////
   if (use_coparent_parts) {
-    for (int r = 0; r < num_coparents; ++r) {
-      SemanticPartCoparent *part = static_cast<SemanticPartCoparent*>(
-        (*semantic_parts)[offset_coparents + r]);
+    for (int k = 0; k < component.coparents.size(); ++k) {
+      int r = component.coparents[k];
+      SemanticPartCoparent *part =
+        static_cast<SemanticPartCoparent*>((*semantic_parts)[r]);
       int r1 = semantic_parts->FindArc(part->first_predicate(),
                                        part->argument(),
                                        part->first_sense());
@@ -1504,18 +1927,17 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
       CHECK_GE(r1, 0);
       CHECK_GE(r2, 0);
       vector<AD3::BinaryVariable*> local_variables;
-      local_variables.push_back(variables[r1 - offset_arcs +
-                                offset_arc_variables]);
-      local_variables.push_back(variables[r2 - offset_arcs +
-                                offset_arc_variables]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r1]]);
+      local_variables.push_back(
+        variables[(*variable_indices)[r2]]);
 
-      factor_graph->CreateFactorPAIR(local_variables,
-                                     scores[offset_coparents + r]);
+      factor_graph->CreateFactorPAIR(local_variables, scores[r]);
       // TODO: set these global indices at the end after all variables/factors
       // are created.
       //factor->SetGlobalIndex(...);
-      additional_part_indices.push_back(offset_coparents + r);
-      factor_part_indices_.push_back(offset_coparents + r);
+      additional_part_indices.push_back(r);
+      factor_part_indices_.push_back(r);
     }
   }
 
@@ -1565,8 +1987,6 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
 
   vector<double> posteriors;
   vector<double> additional_posteriors;
-  double value_ref;
-  double *value = &value_ref;
 
   //factor_graph->SetMaxIterationsAD3(2000);
   factor_graph->SetMaxIterationsAD3(500);
@@ -1586,10 +2006,12 @@ void SemanticDecoder::DecodeFactorGraph(Instance *instance, Parts *parts,
   VLOG(2) << "Elapsed time (AD3) = " << elapsed_time
     << " (" << sentence->size() << ") ";
 
+  *num_bytes = ProfilesMemory() ? EstimateFactorGraphBytes(factor_graph) : 0;
   delete factor_graph;
 
+  // Only the entries of this component's parts are written, so that
+  // components can be decoded concurrently.
   *value = 0.0;
-  predicted_output->assign(parts->size(), 0.0);
   for (int i = 0; i < part_indices_.size(); ++i) {
     int r = part_indices_[i];
     if (r < 0) continue;
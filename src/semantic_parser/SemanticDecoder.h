@@ -21,14 +21,30 @@
 
 #include "Decoder.h"
 #include "SemanticPart.h"
+#include "ScoreView.h"
 //#include "ad3/FactorGraph.h"
 
 class SemanticPipe;
+class SemanticScoreMatrix;
+
+// Indices of the parts that form one connected component of the factor graph.
+struct SemanticFactorGraphComponent {
+  vector<int> predicate_parts;
+  vector<int> arcs;
+  vector<int> labeled_arcs;
+  vector<int> siblings;
+  vector<int> labeled_siblings;
+  vector<int> consecutive_siblings;
+  vector<int> grandparents;
+  vector<int> coparents;
+  vector<int> consecutive_coparents;
+};
 
 class SemanticDecoder : public Decoder {
 public:
-  SemanticDecoder() {};
-  SemanticDecoder(SemanticPipe *pipe) : pipe_(pipe) {};
+  SemanticDecoder() : num_threads_(1) {};
+  SemanticDecoder(SemanticPipe *pipe, int num_threads) :
+    pipe_(pipe), num_threads_(num_threads) {};
   virtual ~SemanticDecoder() {};
 
   void Decode(Instance *instance, Parts *parts,
@@ -68,11 +84,31 @@ public:
                        double *loss);
 
   void DecodeFactorGraph(Instance *instance, Parts *parts,
-                         const vector<double> &scores,
+                         const ScoreView &scores,
                          bool labeled_decoding,
                          bool relax,
                          vector<double> *predicted_output);
 
+  void BuildFactorGraphComponents(
+    Instance *instance,
+    Parts *parts,
+    bool decompose_by_predicate,
+    vector<SemanticFactorGraphComponent> *components);
+
+  // Build and solve the factor graph of a component. variable_indices,
+  // indexed by part and allocated once per sentence, gets the index of the
+  // variable of each predicate part, arc and labeled arc of the component;
+  // the entries of other parts are not touched. If the memory is profiled,
+  // num_bytes is set to the estimated size of the factor graph.
+  void DecodeFactorGraphComponent(Instance *instance, Parts *parts,
+                                  const ScoreView &scores,
+                                  bool labeled_decoding,
+                                  const SemanticFactorGraphComponent &component,
+                                  vector<double> *predicted_output,
+                                  vector<int> *variable_indices,
+                                  double *value,
+                                  int64_t *num_bytes);
+
   void BuildBasicIndices(int sentence_length,
                          const vector<SemanticPartPredicate*> &predicate_parts,
                          const vector<SemanticPartArc*> &arcs,
@@ -92,7 +128,7 @@ public:
 
 protected:
   void DecodeLabels(Instance *instance, Parts *parts,
-                    const vector<double> &scores,
+                    const ScoreView &scores,
                     vector<int> *best_labeled_parts);
 
   void DecodeLabelMarginals(Instance *instance, Parts *parts,
@@ -101,18 +137,38 @@ protected:
                             vector<double> *label_marginals);
 
   void DecodeBasic(Instance *instance, Parts *parts,
-                   const vector<double> &scores,
+                   const ScoreView &scores,
                    vector<double> *predicted_output,
                    double *value);
 
   void DecodeBasicMarginals(Instance *instance, Parts *parts,
-                            const vector<double> &scores,
+                            const ScoreView &scores,
                             vector<double> *predicted_output,
                             double *log_partition_function,
                             double *entropy);
 
+  // Reference implementations of DecodeBasic and DecodeBasicMarginals on
+  // nested predicate/arc indices.
+  void DecodeBasicNaive(Instance *instance, Parts *parts,
+                        const ScoreView &scores,
+                        vector<double> *predicted_output,
+                        double *value);
+
+  void DecodeBasicMarginalsNaive(Instance *instance, Parts *parts,
+                                 const ScoreView &scores,
+                                 vector<double> *predicted_output,
+                                 double *log_partition_function,
+                                 double *entropy);
+
+  void BuildScoreMatrix(int sentence_length,
+                        Parts *parts,
+                        const ScoreView &scores,
+                        SemanticScoreMatrix *score_matrix);
+
 protected:
   SemanticPipe *pipe_;
+  // Number of threads among which the predicates are decoded.
+  int num_threads_;
 };
 
 #endif /* SEMANTICDECODER_H_ */
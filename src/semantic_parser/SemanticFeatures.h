@@ -88,10 +88,30 @@ public:
     return input_features_[r];
   };
 
+  int64_t GetNumFeatures() const {
+    return CountFeatures(input_features_) +
+      CountFeatures(input_labeled_features_);
+  }
+  int64_t GetNumBytes() const {
+    return CountFeatureBytes(input_features_) +
+      CountFeatureBytes(input_labeled_features_);
+  }
+
   BinaryFeatures *GetMutableLabeledPartFeatures(int r) const {
     return input_labeled_features_[r];
   };
 
+  void Save(FILE *fs) const {
+    SaveFeatureVectors(fs, input_features_);
+    SaveFeatureVectors(fs, input_labeled_features_);
+  }
+  void Load(FILE *fs) {
+    Clear();
+    LoadFeatureVectors(fs, &input_features_);
+    LoadFeatureVectors(fs, &input_labeled_features_);
+    CHECK_EQ(input_features_.size(), input_labeled_features_.size());
+  }
+
 public:
   void AddPredicateFeatures(SemanticInstanceNumeric *sentence,
                             int r,
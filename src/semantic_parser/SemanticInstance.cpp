@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SemanticInstance.h"
+#include "SerializationUtils.h"
 
 void SemanticInstance::Initialize(const string &name,
                                   const vector<string> &forms,
@@ -38,3 +39,40 @@ void SemanticInstance::Initialize(const string &name,
   argument_roles_ = argument_roles;
   argument_indices_ = argument_indices;
 }
+
+void SemanticInstance::Save(FILE *fs) {
+  bool success;
+  DependencyInstance::Save(fs);
+  success = WriteString(fs, name_);
+  CHECK(success);
+  success = WriteStringVector(fs, predicate_names_);
+  CHECK(success);
+  success = WriteIntegerVector(fs, predicate_indices_);
+  CHECK(success);
+  for (int k = 0; k < GetNumPredicates(); ++k) {
+    success = WriteStringVector(fs, argument_roles_[k]);
+    CHECK(success);
+    success = WriteIntegerVector(fs, argument_indices_[k]);
+    CHECK(success);
+  }
+}
+
+void SemanticInstance::Load(FILE *fs) {
+  bool success;
+  DependencyInstance::Load(fs);
+  success = ReadString(fs, &name_);
+  CHECK(success);
+  success = ReadStringVector(fs, &predicate_names_);
+  CHECK(success);
+  success = ReadIntegerVector(fs, &predicate_indices_);
+  CHECK(success);
+  CHECK_EQ(predicate_indices_.size(), predicate_names_.size());
+  argument_roles_.resize(GetNumPredicates());
+  argument_indices_.resize(GetNumPredicates());
+  for (int k = 0; k < GetNumPredicates(); ++k) {
+    success = ReadStringVector(fs, &argument_roles_[k]);
+    CHECK(success);
+    success = ReadIntegerVector(fs, &argument_indices_[k]);
+    CHECK(success);
+  }
+}
@@ -51,6 +51,9 @@ public:
                   const vector<vector<string> > &argument_roles,
                   const vector<vector<int> > &argument_indices);
 
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   const string &GetName() { return name_; }
   int GetNumPredicates() { return predicate_names_.size(); }
   const string &GetPredicateName(int k) { return predicate_names_[k]; }
@@ -18,6 +18,7 @@
 
 #include "SemanticInstanceNumeric.h"
 #include "SemanticPipe.h"
+#include "SerializationUtils.h"
 #include <iostream>
 #include <algorithm>
 
@@ -88,27 +89,9 @@ void SemanticInstanceNumeric::ComputeDependencyInformation(
     static_cast<DependencyInstance*>(instance);
 
   int instance_length = instance->size();
-  modifiers_.resize(instance_length);
-  left_siblings_.resize(instance_length);
-  right_siblings_.resize(instance_length);
 
   // List of dependents, left and right siblings.
-  for (int h = 0; h < instance_length; ++h) {
-    modifiers_[h].clear();
-    left_siblings_[h] = -1;
-    right_siblings_[h] = -1;
-  }
-  for (int m = 1; m < instance_length; ++m) {
-    int h = instance->GetHead(m);
-    modifiers_[h].push_back(m);
-  }
-  for (int h = 0; h < instance_length; ++h) {
-    for (int k = 0; k < modifiers_[h].size(); ++k) {
-      int m = modifiers_[h][k];
-      if (k > 0) left_siblings_[m] = modifiers_[h][k - 1];
-      if (k + 1 < modifiers_[h].size()) right_siblings_[m] = modifiers_[h][k + 1];
-    }
-  }
+  ComputeModifiers();
 
   // Select passive/active voice.
   is_passive_voice_.assign(instance_length, false);
@@ -140,6 +123,29 @@ void SemanticInstanceNumeric::ComputeDependencyInformation(
   }
 }
 
+void SemanticInstanceNumeric::ComputeModifiers() {
+  int instance_length = size();
+  modifiers_.resize(instance_length);
+  left_siblings_.resize(instance_length);
+  right_siblings_.resize(instance_length);
+  for (int h = 0; h < instance_length; ++h) {
+    modifiers_[h].clear();
+    left_siblings_[h] = -1;
+    right_siblings_[h] = -1;
+  }
+  for (int m = 1; m < instance_length; ++m) {
+    int h = heads_[m];
+    modifiers_[h].push_back(m);
+  }
+  for (int h = 0; h < instance_length; ++h) {
+    for (int k = 0; k < modifiers_[h].size(); ++k) {
+      int m = modifiers_[h][k];
+      if (k > 0) left_siblings_[m] = modifiers_[h][k - 1];
+      if (k + 1 < modifiers_[h].size()) right_siblings_[m] = modifiers_[h][k + 1];
+    }
+  }
+}
+
 bool SemanticInstanceNumeric::ComputePassiveVoice(
   SemanticInstance* instance,
   int index) {
@@ -204,3 +210,68 @@ bool SemanticInstanceNumeric::ComputePassiveVoice(
 
   return false;
 }
+
+void SemanticInstanceNumeric::Save(FILE *fs) {
+  bool success;
+  DependencyInstanceNumeric::Save(fs);
+  success = WriteCompactIntegerVector(fs, predicate_ids_);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, predicate_indices_);
+  CHECK(success);
+  for (int k = 0; k < GetNumPredicates(); ++k) {
+    success = WriteCompactIntegerVector(fs, argument_role_ids_[k]);
+    CHECK(success);
+    success = WriteCompactIntegerVector(fs, argument_indices_[k]);
+    CHECK(success);
+  }
+  vector<int> passive_voice(size());
+  for (int i = 0; i < size(); ++i) {
+    passive_voice[i] = is_passive_voice_[i];
+  }
+  success = WriteCompactIntegerVector(fs, passive_voice);
+  CHECK(success);
+  for (int p = 0; p < size(); ++p) {
+    success = WriteCompactIntegerVector(fs, relation_path_ids_[p]);
+    CHECK(success);
+    success = WriteCompactIntegerVector(fs, pos_path_ids_[p]);
+    CHECK(success);
+  }
+}
+
+void SemanticInstanceNumeric::Load(FILE *fs) {
+  bool success;
+  Clear();
+  DependencyInstanceNumeric::Load(fs);
+  int length = size();
+  success = ReadCompactIntegerVector(fs, &predicate_ids_);
+  CHECK(success);
+  success = ReadCompactIntegerVector(fs, &predicate_indices_);
+  CHECK(success);
+  CHECK_EQ(predicate_indices_.size(), predicate_ids_.size());
+  argument_role_ids_.resize(GetNumPredicates());
+  argument_indices_.resize(GetNumPredicates());
+  for (int k = 0; k < GetNumPredicates(); ++k) {
+    success = ReadCompactIntegerVector(fs, &argument_role_ids_[k]);
+    CHECK(success);
+    success = ReadCompactIntegerVector(fs, &argument_indices_[k]);
+    CHECK(success);
+  }
+  vector<int> passive_voice;
+  success = ReadCompactIntegerVector(fs, &passive_voice);
+  CHECK(success);
+  CHECK_EQ(passive_voice.size(), length);
+  is_passive_voice_.resize(length);
+  for (int i = 0; i < length; ++i) {
+    is_passive_voice_[i] = (passive_voice[i] != 0);
+  }
+  relation_path_ids_.resize(length);
+  pos_path_ids_.resize(length);
+  for (int p = 0; p < length; ++p) {
+    success = ReadCompactIntegerVector(fs, &relation_path_ids_[p]);
+    CHECK(success);
+    success = ReadCompactIntegerVector(fs, &pos_path_ids_[p]);
+    CHECK(success);
+  }
+  ComputeModifiers();
+  BuildIndices();
+}
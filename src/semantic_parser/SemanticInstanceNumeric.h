@@ -78,6 +78,13 @@ public:
 
   bool ComputePassiveVoice(SemanticInstance *instance, int index);
 
+  // Compute the dependents and the left and right siblings of each word
+  // from the heads.
+  void ComputeModifiers();
+
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
   void DeleteIndices() {
     index_predicates_.clear();
     for (int p = 0; p < index_arcs_.size(); ++p) {
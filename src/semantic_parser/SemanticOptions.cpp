@@ -102,6 +102,10 @@ DEFINE_double(srl_pruner_posterior_threshold, 0.0001,
 DEFINE_int32(srl_pruner_max_arguments, 20,
              "Maximum number of possible arguments for a given word, in basic "
              "pruning.");
+DEFINE_int32(srl_decoder_num_threads, 1,
+             "Number of threads used to decode the predicates of a sentence "
+             "in parallel. Only applies to models without grandparent or "
+             "co-parent parts, where predicates are independent.");
 
 // Options for pruner training.
 // TODO: implement these options.
@@ -275,6 +279,7 @@ void SemanticOptions::Initialize() {
   file_pruner_model_ = FLAGS_srl_file_pruner_model;
   pruner_posterior_threshold_ = FLAGS_srl_pruner_posterior_threshold;
   pruner_max_arguments_ = FLAGS_srl_pruner_max_arguments;
+  decoder_num_threads_ = FLAGS_srl_decoder_num_threads;
 
   use_arbitrary_siblings_ = false;
   use_consecutive_siblings_ = false;
@@ -60,6 +60,7 @@ public:
   const string &GetPrunerModelFilePath() { return file_pruner_model_; }
   double GetPrunerPosteriorThreshold() { return pruner_posterior_threshold_; }
   double GetPrunerMaxArguments() { return pruner_max_arguments_; }
+  int decoder_num_threads() { return decoder_num_threads_; }
 
   bool use_arbitrary_siblings() { return use_arbitrary_siblings_; }
   bool use_consecutive_siblings() { return use_consecutive_siblings_; }
@@ -88,6 +89,7 @@ protected:
   string file_pruner_model_;
   double pruner_posterior_threshold_;
   int pruner_max_arguments_;
+  int decoder_num_threads_;
   bool use_arbitrary_siblings_;
   bool use_consecutive_siblings_;
   bool use_grandparents_;
@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SemanticPart.h"
+#include "SerializationUtils.h"
 
 void SemanticParts::DeleteAll() {
   for (int i = 0; i < NUM_SEMANTICPARTS; ++i) {
@@ -126,3 +127,90 @@ void SemanticParts::BuildIndices(int sentence_length, bool labeled) {
     }
   }
 }
+
+void SemanticParts::Save(FILE *fs) {
+  bool success;
+  success = WriteInteger(fs, size());
+  CHECK(success);
+  CHECK_EQ(size(), all_labeled_parts_.size());
+  for (int r = 0; r < size(); ++r) {
+    success = WriteInteger(fs, (*this)[r]->type());
+    CHECK(success);
+    (*this)[r]->Save(fs);
+    success = WriteIntegerVector(fs, all_labeled_parts_[r]);
+    CHECK(success);
+  }
+  for (int i = 0; i < NUM_SEMANTICPARTS; ++i) {
+    success = WriteInteger(fs, offsets_[i]);
+    CHECK(success);
+  }
+  success = WriteInteger(fs, index_.size());
+  CHECK(success);
+  success = WriteBool(fs, !index_labeled_.empty());
+  CHECK(success);
+}
+
+void SemanticParts::Load(FILE *fs) {
+  bool success;
+  int num_parts;
+  Initialize();
+  success = ReadInteger(fs, &num_parts);
+  CHECK(success);
+  resize(num_parts, static_cast<Part*>(NULL));
+  all_labeled_parts_.resize(num_parts);
+  for (int r = 0; r < num_parts; ++r) {
+    int type;
+    success = ReadInteger(fs, &type);
+    CHECK(success);
+    Part *part = NULL;
+    switch (type) {
+    case SEMANTICPART_ARC:
+      part = new SemanticPartArc;
+      break;
+    case SEMANTICPART_LABELEDARC:
+      part = new SemanticPartLabeledArc;
+      break;
+    case SEMANTICPART_PREDICATE:
+      part = new SemanticPartPredicate;
+      break;
+    case SEMANTICPART_ARGUMENT:
+      part = new SemanticPartArgument;
+      break;
+    case SEMANTICPART_SIBLING:
+      part = new SemanticPartSibling;
+      break;
+    case SEMANTICPART_LABELEDSIBLING:
+      part = new SemanticPartLabeledSibling;
+      break;
+    case SEMANTICPART_CONSECUTIVESIBLING:
+      part = new SemanticPartConsecutiveSibling;
+      break;
+    case SEMANTICPART_GRANDPARENT:
+      part = new SemanticPartGrandparent;
+      break;
+    case SEMANTICPART_COPARENT:
+      part = new SemanticPartCoparent;
+      break;
+    case SEMANTICPART_CONSECUTIVECOPARENT:
+      part = new SemanticPartConsecutiveCoparent;
+      break;
+    default:
+      CHECK(false) << "Unknown part type: " << type;
+    }
+    part->Load(fs);
+    (*this)[r] = part;
+    success = ReadIntegerVector(fs, &all_labeled_parts_[r]);
+    CHECK(success);
+  }
+  for (int i = 0; i < NUM_SEMANTICPARTS; ++i) {
+    success = ReadInteger(fs, &offsets_[i]);
+    CHECK(success);
+  }
+  int index_length;
+  bool labeled;
+  success = ReadInteger(fs, &index_length);
+  CHECK(success);
+  success = ReadBool(fs, &labeled);
+  CHECK(success);
+  if (index_length > 0) BuildIndices(index_length, labeled);
+}
@@ -55,6 +55,19 @@ public:
 public:
   int type() { return SEMANTICPART_ARC; }
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
 private:
   int p_; // Index of the predicate.
   int a_; // Index of the argument.
@@ -78,6 +91,21 @@ public:
 public:
   int type() { return SEMANTICPART_LABELEDARC; }
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&r_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&r_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
 private:
   int p_; // Index of the predicate.
   int a_; // Index of the argument.
@@ -100,6 +128,17 @@ public:
 public:
   int type() { return SEMANTICPART_PREDICATE; }
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
 private:
   int p_; // Index of the predicate.
   int s_; // Index of the sense.
@@ -119,6 +158,15 @@ public:
 public:
   int type() { return SEMANTICPART_ARGUMENT; }
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&a_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
+  void Load(FILE *fs) {
+    if (1 != fread(&a_, sizeof(int), 1, fs)) CHECK(false);
+  }
+
 private:
   int a_; // Index of the argument.
 };
@@ -144,6 +192,21 @@ public:
   int first_argument() { return a1_; };
   int second_argument() { return a2_; };
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a2_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a2_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
 private:
   int p_; // Index of the predicate.
   int s_; // Index of the sense.
@@ -172,6 +235,21 @@ public:
   int first_argument() { return a1_; };
   int second_argument() { return a2_; };
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a2_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a2_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
 private:
   int p_; // Index of the predicate.
   int s_; // Index of the sense.
@@ -202,6 +280,23 @@ public:
   int sense() { return s_; };
   int argument() { return a_; };
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&g_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&t_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
+  void Load(FILE *fs) {
+    if (1 != fread(&g_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&t_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
 private:
   int g_; // Index of the grandparent predicate.
   int t_; // Index of the grandparent sense.
@@ -234,6 +329,23 @@ public:
   int second_sense() { return s2_; };
   int argument() { return a_; };
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&p2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&p2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
 private:
   int p1_; // Index of the first predicate.
   int s1_; // Index of the first sense.
@@ -266,6 +378,23 @@ public:
   int second_sense() { return s2_; };
   int argument() { return a_; };
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&p2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&p2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
 private:
   int p1_; // Index of the first predicate (or -1 for p2_ being the first).
   int s1_; // Index of the first sense.
@@ -300,6 +429,25 @@ public:
   int first_role() { return r1_; };
   int second_role() { return r2_; };
 
+public:
+  void Save(FILE *fs) {
+    if (1 != fwrite(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&a2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&r1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fwrite(&r2_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
+  void Load(FILE *fs) {
+    if (1 != fread(&p_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&s_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&a2_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&r1_, sizeof(int), 1, fs)) CHECK(false);
+    if (1 != fread(&r2_, sizeof(int), 1, fs)) CHECK(false);
+  };
+
 private:
   int p_; // Index of the predicate.
   int s_; // Index of the sense.
@@ -415,6 +563,11 @@ public:
     all_labeled_parts_.resize(num_parts);
   }
 
+  // Save/load the parts, their labeled counterparts and their offsets. The
+  // indices, if built, are rebuilt when loading.
+  void Save(FILE *fs);
+  void Load(FILE *fs);
+
 public:
   void DeleteAll();
 
@@ -50,7 +50,7 @@ void SemanticPipe::SaveModel(FILE* fs) {
   token_dictionary_->Save(fs);
   dependency_dictionary_->Save(fs);
   Pipe::SaveModel(fs);
-  pruner_parameters_->Save(fs);
+  pruner_parameters_->Save(fs, options_->parameters_float());
 }
 
 void SemanticPipe::LoadModel(FILE* fs) {
@@ -76,7 +76,55 @@ void SemanticPipe::LoadModel(FILE* fs) {
     SetDependencyDictionary(dependency_dictionary_);
   dependency_dictionary_->Load(fs);
   Pipe::LoadModel(fs);
-  pruner_parameters_->Load(fs);
+  pruner_parameters_->Load(fs, options_->parameters_float());
+}
+
+void SemanticPipe::SaveDictionaries(FILE *fs) {
+  token_dictionary_->Save(fs);
+  dependency_dictionary_->Save(fs);
+  Pipe::SaveDictionaries(fs);
+}
+
+void SemanticPipe::LoadDictionaries(FILE *fs) {
+  delete token_dictionary_;
+  CreateTokenDictionary();
+  static_cast<SemanticDictionary*>(dictionary_)->
+    SetTokenDictionary(token_dictionary_);
+  token_dictionary_->Load(fs);
+  delete dependency_dictionary_;
+  CreateDependencyDictionary();
+  dependency_dictionary_->SetTokenDictionary(token_dictionary_);
+  static_cast<SemanticDictionary*>(dictionary_)->
+    SetDependencyDictionary(dependency_dictionary_);
+  dependency_dictionary_->Load(fs);
+  Pipe::LoadDictionaries(fs);
+}
+
+// The predicate senses determine the predicates of the numeric instances and
+// the predicates of the unknown lemma in the dictionary.
+void SemanticPipe::SaveCorpusOptions(FILE *fs) {
+  bool success;
+  success = WriteBool(fs, GetSemanticOptions()->use_predicate_senses());
+  CHECK(success);
+  success = WriteBool(fs, GetSemanticOptions()->allow_unseen_predicates());
+  CHECK(success);
+}
+
+void SemanticPipe::LoadCorpusOptions(FILE *fs) {
+  bool success;
+  bool use_predicate_senses;
+  bool allow_unseen_predicates;
+  success = ReadBool(fs, &use_predicate_senses);
+  CHECK(success);
+  CHECK_EQ(use_predicate_senses, GetSemanticOptions()->use_predicate_senses())
+    << "The training corpus was converted with --srl_use_predicate_senses="
+    << use_predicate_senses << ".";
+  success = ReadBool(fs, &allow_unseen_predicates);
+  CHECK(success);
+  CHECK_EQ(allow_unseen_predicates,
+           GetSemanticOptions()->allow_unseen_predicates())
+    << "The training corpus was converted with --srl_allow_unseen_predicates="
+    << allow_unseen_predicates << ".";
 }
 
 void SemanticPipe::LoadPrunerModel(FILE* fs) {
@@ -90,7 +138,7 @@ void SemanticPipe::LoadPrunerModel(FILE* fs) {
   pipe->Initialize();
   pipe->LoadModel(fs);
   delete pruner_parameters_;
-  pruner_parameters_ = pipe->parameters_;
+  SetPrunerParameters(pipe->parameters_);
   pipe->parameters_ = NULL;
   delete pipe;
   LOG(INFO) << "Done.";
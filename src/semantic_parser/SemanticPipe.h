@@ -59,16 +59,33 @@ public:
 
   void Initialize() {
     Pipe::Initialize();
-    pruner_parameters_ = new Parameters;
+    SetPrunerParameters(new Parameters);
   }
 
   void SetPrunerParameters(Parameters *pruner_parameters) {
     pruner_parameters_ = pruner_parameters;
+    if (pruner_parameters_) pruner_parameters_->SetProfiler(&profiler_);
   }
   void LoadPrunerModelFile() {
     LoadPrunerModelByName(GetSemanticOptions()->GetPrunerModelFilePath());
   }
 
+  // Share the token and dependency dictionaries along with the other
+  // training data.
+  void ShareTrainingData(Pipe *pipe) {
+    Pipe::ShareTrainingData(pipe);
+    SemanticPipe *semantic_pipe = static_cast<SemanticPipe*>(pipe);
+    delete token_dictionary_;
+    token_dictionary_ = semantic_pipe->token_dictionary_;
+    delete dependency_dictionary_;
+    dependency_dictionary_ = semantic_pipe->dependency_dictionary_;
+  }
+  void ReleaseTrainingData() {
+    Pipe::ReleaseTrainingData();
+    token_dictionary_ = NULL;
+    dependency_dictionary_ = NULL;
+  }
+
 protected:
   void CreateDictionary() {
     dictionary_ = new SemanticDictionary(this);
@@ -81,7 +98,10 @@ protected:
   void CreateWriter() {
     writer_ = new SemanticWriter(options_);
   }
-  void CreateDecoder() { decoder_ = new SemanticDecoder(this); }
+  void CreateDecoder() {
+    decoder_ = new SemanticDecoder(this,
+                                   GetSemanticOptions()->decoder_num_threads());
+  }
   Parts *CreateParts() { return new SemanticParts; }
   Features *CreateFeatures() { return new SemanticFeatures(this); }
 
@@ -98,6 +118,13 @@ protected:
     return parameters_;
   }
 
+  // The parts only depend on the pruner parameters, which are fixed while
+  // training the parser.
+  bool CanPrefetchParts() { return true; }
+
+  // The parts and features can be saved to the training cache file.
+  bool CanSpillTrainingCache() { return true; }
+
   void PreprocessData();
 
   Instance *GetFormattedInstance(Instance *instance) {
@@ -108,9 +135,28 @@ protected:
     return instance_numeric;
   }
 
+  bool SupportsBinaryCorpus() { return true; }
+
+  Instance *CreateFormattedInstance() {
+    return new SemanticInstanceNumeric;
+  }
+
+  Instance *CreateInstance() { return new SemanticInstance; }
+
+  // Number of words of a sentence (including the root).
+  int GetInstanceLength(Instance *formatted_instance) {
+    return static_cast<SemanticInstanceNumeric*>(formatted_instance)->size();
+  }
+
   void SaveModel(FILE* fs);
   void LoadModel(FILE* fs);
 
+  void SaveDictionaries(FILE *fs);
+  void LoadDictionaries(FILE *fs);
+
+  void SaveCorpusOptions(FILE *fs);
+  void LoadCorpusOptions(FILE *fs);
+
   void LoadPrunerModel(FILE* fs);
   void LoadPrunerModelByName(const string &model_name);
 
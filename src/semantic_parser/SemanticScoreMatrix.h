@@ -0,0 +1,158 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SEMANTICSCOREMATRIX_H_
+#define SEMANTICSCOREMATRIX_H_
+
+#include <cmath>
+#include <vector>
+#include "SemanticPart.h"
+#include "ScoreView.h"
+
+using namespace std;
+
+// Flat, predicate-major layout of the predicate and arc scores of an
+// arc-factored semantic graph. Each row is a (predicate, sense) pair; rows
+// are sorted by predicate word and then by sense, and the arcs of each row
+// are stored contiguously (in increasing order of part index). This replaces
+// the nested index vectors built by SemanticDecoder::BuildBasicIndices in the
+// basic decoders, and lets the per-arc computations run as tight loops over
+// contiguous arrays.
+class SemanticScoreMatrix {
+public:
+  SemanticScoreMatrix() {};
+  virtual ~SemanticScoreMatrix() {};
+
+  // Build the matrix from the predicate and arc parts of a sentence, whose
+  // scores start at the given offsets of the score view.
+  // Only the senses up to the largest one with arcs are represented for each
+  // predicate word, which matches the behavior of the nested indices.
+  void Initialize(int sentence_length,
+                  const vector<SemanticPartPredicate*> &predicate_parts,
+                  const vector<SemanticPartArc*> &arcs,
+                  const ScoreView &scores,
+                  int offset_predicate_parts,
+                  int offset_arcs) {
+    int num_predicate_parts = predicate_parts.size();
+    int num_arcs = arcs.size();
+
+    // Number of senses (rows) of each predicate word.
+    predicate_offsets_.assign(sentence_length + 1, 0);
+    for (int r = 0; r < num_arcs; ++r) {
+      int p = arcs[r]->predicate();
+      int s = arcs[r]->sense();
+      if (s + 1 > predicate_offsets_[p + 1]) predicate_offsets_[p + 1] = s + 1;
+    }
+    for (int p = 0; p < sentence_length; ++p) {
+      predicate_offsets_[p + 1] += predicate_offsets_[p];
+    }
+    int num_rows = predicate_offsets_[sentence_length];
+
+    // Predicate part of each row.
+    row_predicate_parts_.assign(num_rows, -1);
+    for (int r = 0; r < num_predicate_parts; ++r) {
+      int p = predicate_parts[r]->predicate();
+      int s = predicate_parts[r]->sense();
+      int row = predicate_offsets_[p] + s;
+      if (row >= predicate_offsets_[p + 1]) continue;
+      row_predicate_parts_[row] = r;
+    }
+    row_scores_.resize(num_rows);
+    for (int row = 0; row < num_rows; ++row) {
+      int r = row_predicate_parts_[row];
+      CHECK_GE(r, 0);
+      row_scores_[row] = scores[offset_predicate_parts + r];
+    }
+
+    // Arcs of each row.
+    row_offsets_.assign(num_rows + 1, 0);
+    for (int r = 0; r < num_arcs; ++r) {
+      ++row_offsets_[predicate_offsets_[arcs[r]->predicate()] +
+                     arcs[r]->sense() + 1];
+    }
+    for (int row = 0; row < num_rows; ++row) {
+      row_offsets_[row + 1] += row_offsets_[row];
+    }
+    arc_parts_.resize(num_arcs);
+    arc_scores_.resize(num_arcs);
+    vector<int> positions(row_offsets_.begin(), row_offsets_.end() - 1);
+    for (int r = 0; r < num_arcs; ++r) {
+      int row = predicate_offsets_[arcs[r]->predicate()] + arcs[r]->sense();
+      int k = positions[row]++;
+      arc_parts_[k] = r;
+      arc_scores_[k] = scores[offset_arcs + r];
+    }
+  }
+
+  int GetNumPredicates() const { return predicate_offsets_.size() - 1; }
+  int GetNumRows() const { return row_scores_.size(); }
+  int GetNumArcs() const { return arc_scores_.size(); }
+
+  // Rows of predicate word p are [GetFirstRow(p), GetFirstRow(p+1)).
+  int GetFirstRow(int p) const { return predicate_offsets_[p]; }
+  // Arcs of a row are [GetFirstArc(row), GetFirstArc(row+1)).
+  int GetFirstArc(int row) const { return row_offsets_[row]; }
+
+  // Index (among the predicate parts) of the predicate part of a row.
+  int GetRowPredicatePart(int row) const { return row_predicate_parts_[row]; }
+  // Index (among the arcs) of the k-th arc in the flat layout.
+  int GetArcPart(int k) const { return arc_parts_[k]; }
+
+  const vector<double> &row_scores() const { return row_scores_; }
+  const vector<double> &arc_scores() const { return arc_scores_; }
+
+protected:
+  vector<int> predicate_offsets_;
+  vector<int> row_offsets_;
+  vector<int> row_predicate_parts_;
+  vector<int> arc_parts_;
+  vector<double> row_scores_;
+  vector<double> arc_scores_;
+};
+
+// Batched kernels over contiguous score arrays.
+
+// Returns the sum of the positive entries of x[0..n-1].
+inline double SumPositiveScores(const double *x, int n) {
+  double sum = 0.0;
+  for (int k = 0; k < n; ++k) {
+    sum += (x[k] > 0.0) ? x[k] : 0.0;
+  }
+  return sum;
+}
+
+// Computes y[k] = log(1 + exp(x[k])) for k = 0..n-1, in a numerically stable
+// way.
+inline void ComputeLogOnePlusExp(const double *x, int n, double *y) {
+  for (int k = 0; k < n; ++k) {
+    double z = (x[k] > 0.0) ? x[k] : 0.0;
+    y[k] = z + log1p(exp(-fabs(x[k])));
+  }
+}
+
+// Computes y[k] = exp(x[k] - log_normalizer[k]) * scale for k = 0..n-1.
+// With log_normalizer computed by ComputeLogOnePlusExp, this is the sigmoid
+// of x scaled by a constant.
+inline void ComputeScaledSigmoid(const double *x, const double *log_normalizer,
+                                 int n, double scale, double *y) {
+  for (int k = 0; k < n; ++k) {
+    y[k] = exp(x[k] - log_normalizer[k]) * scale;
+  }
+}
+
+#endif /* SEMANTICSCOREMATRIX_H_ */
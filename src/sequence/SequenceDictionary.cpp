@@ -45,6 +45,9 @@ void SequenceDictionary::CreateTagDictionary(SequenceReader *reader) {
   }
   reader->Close();
   tag_alphabet_.StopGrowth();
+  // Build the tag names, so that instances can be labeled right after
+  // training (e.g. the held-out folds when jackknifing).
+  tag_alphabet_.BuildNames();
 
   LOG(INFO) << "Number of tags: " << tag_alphabet_.size();
 }
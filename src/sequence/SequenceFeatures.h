@@ -79,6 +79,17 @@ public:
     return NULL;
   };
 
+  int64_t GetNumFeatures() const {
+    return CountFeatures(input_features_unigrams_) +
+      CountFeatures(input_features_bigrams_) +
+      CountFeatures(input_features_trigrams_);
+  }
+  int64_t GetNumBytes() const {
+    return CountFeatureBytes(input_features_unigrams_) +
+      CountFeatureBytes(input_features_bigrams_) +
+      CountFeatureBytes(input_features_trigrams_);
+  }
+
   const BinaryFeatures &GetUnigramFeatures(int i) const {
     return *(input_features_unigrams_[i]);
   };
@@ -17,9 +17,26 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SequenceInstance.h"
+#include "SerializationUtils.h"
 
 void SequenceInstance::Initialize(const vector<string> &forms,
                                   const vector<string> &tags) {
   forms_ = forms;
   tags_ = tags;
 }
+
+void SequenceInstance::Save(FILE *fs) {
+  bool success;
+  success = WriteStringVector(fs, forms_);
+  CHECK(success);
+  success = WriteStringVector(fs, tags_);
+  CHECK(success);
+}
+
+void SequenceInstance::Load(FILE *fs) {
+  bool success;
+  success = ReadStringVector(fs, &forms_);
+  CHECK(success);
+  success = ReadStringVector(fs, &tags_);
+  CHECK(success);
+}
@@ -37,6 +37,9 @@ public:
   virtual void Initialize(const std::vector<std::string> &forms,
                           const std::vector<std::string> &tags);
 
+  virtual void Save(FILE *fs);
+  virtual void Load(FILE *fs);
+
   int size() const { return forms_.size(); };
 
   const std::string &GetForm(int i) const { return forms_[i]; }
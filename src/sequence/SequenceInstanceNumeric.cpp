@@ -17,6 +17,7 @@
 // along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SequenceInstanceNumeric.h"
+#include "SerializationUtils.h"
 #include <iostream>
 #include <algorithm>
 
@@ -32,7 +33,7 @@ void SequenceInstanceNumeric::Initialize(const SequenceDictionary &dictionary,
 
   int prefix_length = FLAGS_prefix_length;
   int suffix_length = FLAGS_suffix_length;
-  bool form_case_sensitive = FLAGS_form_case_sensitive;
+  WordType word_type;
 
   Clear();
 
@@ -50,19 +51,16 @@ void SequenceInstanceNumeric::Initialize(const SequenceDictionary &dictionary,
   tag_ids_.resize(length);
 
   for (i = 0; i < length; i++) {
-    std::string form = instance->GetForm(i);
-    if (!form_case_sensitive) {
-      transform(form.begin(), form.end(), form.begin(), ::tolower);
-    }
-    id = token_dictionary->GetFormId(form);
+    // Ids of the form, prefixes, suffixes and shape.
+    token_dictionary->GetWordType(instance->GetForm(i), &word_type);
+    id = word_type.form_id();
     CHECK_LT(id, 0xffff);
     if (id < 0) id = TOKEN_UNKNOWN;
     form_ids_[i] = id;
 
     prefix_ids_[i].resize(prefix_length);
     for (int l = 0; l < prefix_length; ++l) {
-      std::string prefix = form.substr(0, l + 1);
-      id = token_dictionary->GetPrefixId(prefix);
+      id = word_type.prefix_id(l + 1);
       CHECK_LT(id, 0xffff);
       if (id < 0) id = TOKEN_UNKNOWN;
       prefix_ids_[i][l] = id;
@@ -70,19 +68,14 @@ void SequenceInstanceNumeric::Initialize(const SequenceDictionary &dictionary,
 
     suffix_ids_[i].resize(suffix_length);
     for (int l = 0; l < suffix_length; ++l) {
-      int start = form.length() - l - 1;
-      if (start < 0) start = 0;
-      std::string suffix = form.substr(start, l + 1);
-      id = token_dictionary->GetSuffixId(suffix);
+      id = word_type.suffix_id(l + 1);
       CHECK_LT(id, 0xffff);
       if (id < 0) id = TOKEN_UNKNOWN;
       suffix_ids_[i][l] = id;
     }
 
-    // Compute and store the word shape.
-    std::string shape;
-    dictionary.GetTokenDictionary()->GetWordShape(instance->GetForm(i), &shape);
-    int shape_id = dictionary.GetTokenDictionary()->GetShapeId(shape);
+    // Store the word shape.
+    int shape_id = word_type.shape_id();
     CHECK_LT(shape_id, 0xffff);
     if (shape_id < 0) shape_id = kUnknownShape;
     shape_ids_[i] = shape_id;
@@ -121,3 +114,85 @@ bool SequenceInstanceNumeric::IsPunctuation(char c) {
   return false;
   //return (c == '\'') || (c == '-') || (c == '&') || (c == '/');
 }
+
+// Flags of a word in a saved instance.
+enum {
+  SEQUENCEWORD_HAS_DIGIT = 0x1,
+  SEQUENCEWORD_HAS_UPPER = 0x2,
+  SEQUENCEWORD_HAS_HYPHEN = 0x4,
+  SEQUENCEWORD_ALL_DIGITS = 0x8,
+  SEQUENCEWORD_ALL_DIGITS_WITH_PUNCTUATION = 0x10,
+  SEQUENCEWORD_ALL_UPPER = 0x20,
+  SEQUENCEWORD_FIRST_UPPER = 0x40
+};
+
+void SequenceInstanceNumeric::Save(FILE *fs) {
+  bool success;
+  success = WriteCompactIntegerVector(fs, form_ids_);
+  CHECK(success);
+  for (int i = 0; i < size(); ++i) {
+    success = WriteCompactIntegerVector(fs, prefix_ids_[i]);
+    CHECK(success);
+    success = WriteCompactIntegerVector(fs, suffix_ids_[i]);
+    CHECK(success);
+  }
+  success = WriteCompactIntegerVector(fs, shape_ids_);
+  CHECK(success);
+  vector<int> flags(size(), 0);
+  for (int i = 0; i < size(); ++i) {
+    if (has_digit_[i]) flags[i] |= SEQUENCEWORD_HAS_DIGIT;
+    if (has_upper_[i]) flags[i] |= SEQUENCEWORD_HAS_UPPER;
+    if (has_hyphen_[i]) flags[i] |= SEQUENCEWORD_HAS_HYPHEN;
+    if (all_digits_[i]) flags[i] |= SEQUENCEWORD_ALL_DIGITS;
+    if (all_digits_with_punctuation_[i]) {
+      flags[i] |= SEQUENCEWORD_ALL_DIGITS_WITH_PUNCTUATION;
+    }
+    if (all_upper_[i]) flags[i] |= SEQUENCEWORD_ALL_UPPER;
+    if (first_upper_[i]) flags[i] |= SEQUENCEWORD_FIRST_UPPER;
+  }
+  success = WriteCompactIntegerVector(fs, flags);
+  CHECK(success);
+  success = WriteCompactIntegerVector(fs, tag_ids_);
+  CHECK(success);
+}
+
+void SequenceInstanceNumeric::Load(FILE *fs) {
+  bool success;
+  Clear();
+  success = ReadCompactIntegerVector(fs, &form_ids_);
+  CHECK(success);
+  int length = form_ids_.size();
+  prefix_ids_.resize(length);
+  suffix_ids_.resize(length);
+  for (int i = 0; i < length; ++i) {
+    success = ReadCompactIntegerVector(fs, &prefix_ids_[i]);
+    CHECK(success);
+    success = ReadCompactIntegerVector(fs, &suffix_ids_[i]);
+    CHECK(success);
+  }
+  success = ReadCompactIntegerVector(fs, &shape_ids_);
+  CHECK(success);
+  vector<int> flags;
+  success = ReadCompactIntegerVector(fs, &flags);
+  CHECK(success);
+  CHECK_EQ(flags.size(), length);
+  has_digit_.resize(length);
+  has_upper_.resize(length);
+  has_hyphen_.resize(length);
+  all_digits_.resize(length);
+  all_digits_with_punctuation_.resize(length);
+  all_upper_.resize(length);
+  first_upper_.resize(length);
+  for (int i = 0; i < length; ++i) {
+    has_digit_[i] = (flags[i] & SEQUENCEWORD_HAS_DIGIT) != 0;
+    has_upper_[i] = (flags[i] & SEQUENCEWORD_HAS_UPPER) != 0;
+    has_hyphen_[i] = (flags[i] & SEQUENCEWORD_HAS_HYPHEN) != 0;
+    all_digits_[i] = (flags[i] & SEQUENCEWORD_ALL_DIGITS) != 0;
+    all_digits_with_punctuation_[i] =
+      (flags[i] & SEQUENCEWORD_ALL_DIGITS_WITH_PUNCTUATION) != 0;
+    all_upper_[i] = (flags[i] & SEQUENCEWORD_ALL_UPPER) != 0;
+    first_upper_[i] = (flags[i] & SEQUENCEWORD_FIRST_UPPER) != 0;
+  }
+  success = ReadCompactIntegerVector(fs, &tag_ids_);
+  CHECK(success);
+}
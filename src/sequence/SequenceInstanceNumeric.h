@@ -54,6 +54,9 @@ public:
   void Initialize(const SequenceDictionary &dictionary,
                   SequenceInstance *instance);
 
+  virtual void Save(FILE *fs);
+  virtual void Load(FILE *fs);
+
   const std::vector<int> &GetFormIds() const { return form_ids_; }
   const std::vector<int> &GetTagIds() const { return tag_ids_; }
 
@@ -64,6 +64,20 @@ void SequencePipe::LoadModel(FILE* fs) {
     SetTokenDictionary(token_dictionary_);
 }
 
+void SequencePipe::SaveDictionaries(FILE *fs) {
+  token_dictionary_->Save(fs);
+  Pipe::SaveDictionaries(fs);
+}
+
+void SequencePipe::LoadDictionaries(FILE *fs) {
+  delete token_dictionary_;
+  CreateTokenDictionary();
+  token_dictionary_->Load(fs);
+  Pipe::LoadDictionaries(fs);
+  static_cast<SequenceDictionary*>(dictionary_)->
+    SetTokenDictionary(token_dictionary_);
+}
+
 void SequencePipe::PreprocessData() {
   delete token_dictionary_;
   CreateTokenDictionary();
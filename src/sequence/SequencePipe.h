@@ -70,10 +70,26 @@ protected:
     return instance_numeric;
   }
 
+  virtual bool SupportsBinaryCorpus() { return true; }
+
+  virtual Instance *CreateFormattedInstance() {
+    return new SequenceInstanceNumeric;
+  }
+
+  virtual Instance *CreateInstance() { return new SequenceInstance; }
+
+  // Number of words of a sequence.
+  virtual int GetInstanceLength(Instance *formatted_instance) {
+    return static_cast<SequenceInstanceNumeric*>(formatted_instance)->size();
+  }
+
 protected:
   virtual void SaveModel(FILE* fs);
   virtual void LoadModel(FILE* fs);
 
+  void SaveDictionaries(FILE *fs);
+  void LoadDictionaries(FILE *fs);
+
   // Return the allowed tags for the i-th word. An empty vector means that all
   // tags are allowed.
   virtual void GetAllowedTags(Instance *instance, int i,
@@ -39,6 +39,14 @@ DEFINE_int32(suffix_length, 4,
              "Length of suffixes.");
 DEFINE_bool(form_case_sensitive, false,
             "Distinguish upper/lower case of word forms.");
+DEFINE_bool(word_type_cache, true,
+            "Cache the ids of the form, lower-cased form, shape, prefixes "
+            "and suffixes of each word type, so that converting a token to "
+            "numeric format takes a single lookup.");
+DEFINE_int32(word_type_cache_unknown_size, 100000,
+             "Maximum number of word types outside the vocabulary of the "
+             "model kept in the word type cache (the least recently used "
+             "are evicted).");
 
 void TokenDictionary::Load(FILE* fs) {
   bool success;
@@ -62,6 +70,8 @@ void TokenDictionary::Load(FILE* fs) {
   if (0 > cpos_alphabet_.Load(fs)) CHECK(false);
   if (0 > shape_alphabet_.Load(fs)) CHECK(false);
 
+  if (FLAGS_word_type_cache) BuildWordTypeCache();
+
   // TODO: Remove this (only for debugging purposes)
   //BuildNames();
 }
@@ -262,3 +272,71 @@ void TokenDictionary::Initialize(SequenceReader *reader) {
   CHECK_LT(pos_alphabet_.size(), 0xff);
   CHECK_LT(cpos_alphabet_.size(), 0xff);
 }
+
+void TokenDictionary::ComputeWordType(const std::string &form,
+                                      WordType *word_type) {
+  int prefix_length = FLAGS_prefix_length;
+  int suffix_length = FLAGS_suffix_length;
+  word_type->Initialize(prefix_length, suffix_length);
+
+  std::string form_lower(form);
+  transform(form_lower.begin(), form_lower.end(), form_lower.begin(),
+            ::tolower);
+  const std::string &form_cased = FLAGS_form_case_sensitive ? form :
+    form_lower;
+  word_type->set_form_id(form_alphabet_.Lookup(form_cased));
+  word_type->set_form_lower_id(form_lower_alphabet_.Lookup(form_lower));
+
+  std::string shape;
+  GetWordShape(form, &shape);
+  word_type->set_shape_id(shape_alphabet_.Lookup(shape));
+
+  for (int l = 0; l <= prefix_length; ++l) {
+    std::string prefix = form_cased.substr(0, l);
+    word_type->set_prefix_id(l, prefix_alphabet_.Lookup(prefix));
+  }
+  for (int l = 0; l <= suffix_length; ++l) {
+    int start = form_cased.length() - l;
+    if (start < 0) start = 0;
+    std::string suffix = form_cased.substr(start, l);
+    word_type->set_suffix_id(l, suffix_alphabet_.Lookup(suffix));
+  }
+}
+
+void TokenDictionary::BuildWordTypeCache() {
+  int record_size = WordType::GetNumIds(FLAGS_prefix_length,
+                                        FLAGS_suffix_length);
+  word_type_cache_.Clear(record_size, FLAGS_word_type_cache_unknown_size);
+  WordType word_type;
+  for (Alphabet::const_iterator iter = form_alphabet_.begin();
+       iter != form_alphabet_.end();
+       ++iter) {
+    ComputeWordType(iter->first, &word_type);
+    word_type_cache_.AddKnown(iter->first, word_type.ids());
+  }
+  for (Alphabet::const_iterator iter = form_lower_alphabet_.begin();
+       iter != form_lower_alphabet_.end();
+       ++iter) {
+    ComputeWordType(iter->first, &word_type);
+    word_type_cache_.AddKnown(iter->first, word_type.ids());
+  }
+  word_type_cache_.SetBuilt();
+  VLOG(1) << "Word type cache with " << word_type_cache_.GetNumKnownTypes()
+          << " known word types.";
+}
+
+void TokenDictionary::GetWordType(const std::string &form,
+                                  WordType *word_type) {
+  if (!FLAGS_word_type_cache) {
+    ComputeWordType(form, word_type);
+    return;
+  }
+  if (!word_type_cache_.built()) {
+    std::lock_guard<std::mutex> lock(word_type_cache_mutex_);
+    if (!word_type_cache_.built()) BuildWordTypeCache();
+  }
+  word_type->Initialize(FLAGS_prefix_length, FLAGS_suffix_length);
+  if (word_type_cache_.Find(form, word_type->mutable_ids())) return;
+  ComputeWordType(form, word_type);
+  word_type_cache_.InsertUnknown(form, word_type->ids());
+}
@@ -19,13 +19,17 @@
 #ifndef TOKENDICTIONARY_H_
 #define TOKENDICTIONARY_H_
 
+#include <mutex>
 #include "Dictionary.h"
 #include "Alphabet.h"
 #include "SequenceReader.h"
+#include "WordTypeCache.h"
 
 DECLARE_int32(prefix_length);
 DECLARE_int32(suffix_length);
 DECLARE_bool(form_case_sensitive);
+DECLARE_bool(word_type_cache);
+DECLARE_int32(word_type_cache_unknown_size);
 
 enum SpecialTokens {
   TOKEN_UNKNOWN = 0,
@@ -36,6 +40,50 @@ enum SpecialTokens {
 
 class Pipe;
 
+// Ids of the strings derived from a word form (see
+// TokenDictionary::GetWordType): the form (lower-cased unless
+// --form_case_sensitive), the lower-cased form, the word shape, and the
+// prefixes and suffixes of the form with lengths 0 to --prefix_length and
+// 0 to --suffix_length. Strings that are not in the alphabets get id -1.
+class WordType {
+public:
+  WordType() { prefix_length_ = 0; }
+  virtual ~WordType() {}
+
+  void Initialize(int prefix_length, int suffix_length) {
+    prefix_length_ = prefix_length;
+    ids_.resize(GetNumIds(prefix_length, suffix_length));
+  }
+
+  // Number of ids of a word type.
+  static int GetNumIds(int prefix_length, int suffix_length) {
+    return 5 + prefix_length + suffix_length;
+  }
+
+  int form_id() const { return ids_[0]; }
+  int form_lower_id() const { return ids_[1]; }
+  int shape_id() const { return ids_[2]; }
+  int prefix_id(int length) const { return ids_[3 + length]; }
+  int suffix_id(int length) const {
+    return ids_[4 + prefix_length_ + length];
+  }
+
+  void set_form_id(int id) { ids_[0] = id; }
+  void set_form_lower_id(int id) { ids_[1] = id; }
+  void set_shape_id(int id) { ids_[2] = id; }
+  void set_prefix_id(int length, int id) { ids_[3 + length] = id; }
+  void set_suffix_id(int length, int id) {
+    ids_[4 + prefix_length_ + length] = id;
+  }
+
+  const vector<int> &ids() const { return ids_; }
+  vector<int> *mutable_ids() { return &ids_; }
+
+protected:
+  int prefix_length_;
+  vector<int> ids_;
+};
+
 class TokenDictionary : public Dictionary {
 public:
   TokenDictionary() { pipe_ = NULL; }
@@ -46,6 +94,7 @@ public:
   void Save(FILE *fs);
 
   void Clear() {
+    ClearWordTypeCache();
     form_alphabet_.clear();
     form_lower_alphabet_.clear();
     lemma_alphabet_.clear();
@@ -58,6 +107,7 @@ public:
   }
 
   void AllowGrowth() {
+    ClearWordTypeCache();
     form_alphabet_.AllowGrowth();
     form_lower_alphabet_.AllowGrowth();
     lemma_alphabet_.AllowGrowth();
@@ -69,6 +119,7 @@ public:
     shape_alphabet_.AllowGrowth();
   }
   void StopGrowth() {
+    ClearWordTypeCache();
     form_alphabet_.StopGrowth();
     form_lower_alphabet_.StopGrowth();
     lemma_alphabet_.StopGrowth();
@@ -113,6 +164,17 @@ public:
     return shape_alphabet_.Lookup(shape);
   }
 
+  // Get the ids of the strings derived from a word form. With
+  // --word_type_cache, this is a single lookup in a cache filled with the
+  // forms of the vocabulary when the dictionary is loaded (or when first
+  // needed), and with the last --word_type_cache_unknown_size forms that
+  // are not in the vocabulary. Several threads can call this function at
+  // the same time.
+  void GetWordType(const std::string &form, WordType *word_type);
+
+  // Fill the cache of word types with the forms of the vocabulary.
+  void BuildWordTypeCache();
+
   int GetNumFeatures() {
     CHECK(false) <<
       "There is no notion of number of features in TokenDictionary.";
@@ -163,6 +225,15 @@ public:
     *shape = type;
   }
 
+protected:
+  // Compute the ids of the strings derived from a word form by looking them
+  // up in the alphabets.
+  void ComputeWordType(const std::string &form, WordType *word_type);
+
+  // Remove all the word types from the cache; it will be built again when
+  // needed. Call this whenever the alphabets may change.
+  void ClearWordTypeCache() { word_type_cache_.Clear(0, 0); }
+
 protected: //private:
   Pipe *pipe_;
   Alphabet form_alphabet_;
@@ -175,6 +246,10 @@ protected: //private:
   Alphabet cpos_alphabet_;
   Alphabet shape_alphabet_;
 
+  // Cache of word types, and mutex for building it.
+  WordTypeCache word_type_cache_;
+  std::mutex word_type_cache_mutex_;
+
   int form_cutoff;
   int form_lower_cutoff;
   int lemma_cutoff;
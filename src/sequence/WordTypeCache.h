@@ -0,0 +1,216 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WORDTYPECACHE_H_
+#define WORDTYPECACHE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glog/logging.h>
+
+using namespace std;
+
+// Cache of records of ids (e.g. the ids of the form, prefixes and suffixes
+// of a word) indexed by word form. All records have the same number of ids,
+// which are stored packed in 16 bits; ids must be smaller than 0xffff, and
+// negative ids (strings not in the alphabets) are stored as 0xffff.
+// There are two tables:
+// -- the known word types (the vocabulary of the model), which are added
+// before any lookup and never change afterwards, so they can be looked up
+// by several threads without locking;
+// -- a bounded table of unknown word types, which evicts the least recently
+// used word type when it is full, protected by a mutex.
+// Clear, AddKnown and SetBuilt must not be called concurrently with lookups.
+class WordTypeCache {
+public:
+  WordTypeCache() {
+    built_ = false;
+    record_size_ = 0;
+    max_unknown_types_ = 0;
+    head_ = -1;
+    tail_ = -1;
+  }
+  virtual ~WordTypeCache() {}
+
+  // Remove all the word types and set the number of ids of each record and
+  // the maximum number of unknown word types.
+  void Clear(int record_size, int max_unknown_types) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    built_ = false;
+    record_size_ = record_size;
+    max_unknown_types_ = max_unknown_types;
+    known_index_.clear();
+    known_records_.clear();
+    ClearUnknown();
+  }
+
+  // True after the known word types have been added (see SetBuilt).
+  bool built() const { return built_; }
+
+  // Mark the end of the known word types.
+  void SetBuilt() { built_ = true; }
+
+  int GetNumKnownTypes() const { return known_index_.size(); }
+
+  // Add a known word type. Only call this before SetBuilt.
+  void AddKnown(const std::string &form, const vector<int> &ids) {
+    CHECK(!built_);
+    if (known_index_.find(form) != known_index_.end()) return;
+    known_index_[form] = known_records_.size();
+    PackRecord(ids, &known_records_);
+  }
+
+  // Look up a word type, copying its ids to "ids". Returns false if the word
+  // type is not in the cache.
+  bool Find(const std::string &form, vector<int> *ids) {
+    std::unordered_map<std::string, int>::const_iterator iterator =
+      known_index_.find(form);
+    if (iterator != known_index_.end()) {
+      UnpackRecord(known_records_, iterator->second, ids);
+      return true;
+    }
+    if (max_unknown_types_ <= 0) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    iterator = unknown_index_.find(form);
+    if (iterator == unknown_index_.end()) return false;
+    int slot = iterator->second;
+    MoveToFront(slot);
+    UnpackRecord(unknown_records_, slot * record_size_, ids);
+    return true;
+  }
+
+  // Add an unknown word type, evicting the least recently used one if the
+  // table is full.
+  void InsertUnknown(const std::string &form, const vector<int> &ids) {
+    if (max_unknown_types_ <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (unknown_index_.find(form) != unknown_index_.end()) return;
+    int slot;
+    if (static_cast<int>(unknown_forms_.size()) < max_unknown_types_) {
+      slot = unknown_forms_.size();
+      unknown_forms_.push_back(form);
+      previous_.push_back(-1);
+      next_.push_back(-1);
+      unknown_records_.resize(unknown_records_.size() + record_size_);
+    } else {
+      // Evict the least recently used word type.
+      slot = tail_;
+      Unlink(slot);
+      unknown_index_.erase(unknown_forms_[slot]);
+      unknown_forms_[slot] = form;
+    }
+    for (int k = 0; k < record_size_; ++k) {
+      unknown_records_[slot * record_size_ + k] = PackId(ids[k]);
+    }
+    unknown_index_[form] = slot;
+    PushFront(slot);
+  }
+
+protected:
+  static uint16_t PackId(int id) {
+    if (id < 0) return 0xffff;
+    CHECK_LT(id, 0xffff);
+    return static_cast<uint16_t>(id);
+  }
+
+  static int UnpackId(uint16_t packed_id) {
+    return (packed_id == 0xffff) ? -1 : static_cast<int>(packed_id);
+  }
+
+  void PackRecord(const vector<int> &ids, vector<uint16_t> *records) {
+    CHECK_EQ(static_cast<int>(ids.size()), record_size_);
+    for (int k = 0; k < record_size_; ++k) {
+      records->push_back(PackId(ids[k]));
+    }
+  }
+
+  void UnpackRecord(const vector<uint16_t> &records, int offset,
+                    vector<int> *ids) const {
+    ids->resize(record_size_);
+    for (int k = 0; k < record_size_; ++k) {
+      (*ids)[k] = UnpackId(records[offset + k]);
+    }
+  }
+
+  void ClearUnknown() {
+    unknown_index_.clear();
+    unknown_forms_.clear();
+    unknown_records_.clear();
+    previous_.clear();
+    next_.clear();
+    head_ = -1;
+    tail_ = -1;
+  }
+
+  // Operations on the doubly-linked list of unknown word types, from the
+  // most to the least recently used.
+  void Unlink(int slot) {
+    if (previous_[slot] >= 0) {
+      next_[previous_[slot]] = next_[slot];
+    } else {
+      head_ = next_[slot];
+    }
+    if (next_[slot] >= 0) {
+      previous_[next_[slot]] = previous_[slot];
+    } else {
+      tail_ = previous_[slot];
+    }
+    previous_[slot] = -1;
+    next_[slot] = -1;
+  }
+
+  void PushFront(int slot) {
+    previous_[slot] = -1;
+    next_[slot] = head_;
+    if (head_ >= 0) previous_[head_] = slot;
+    head_ = slot;
+    if (tail_ < 0) tail_ = slot;
+  }
+
+  void MoveToFront(int slot) {
+    if (slot == head_) return;
+    Unlink(slot);
+    PushFront(slot);
+  }
+
+protected:
+  std::atomic<bool> built_;
+  int record_size_;
+  int max_unknown_types_;
+  std::mutex mutex_;
+
+  // Known word types: offset of the record of each form in known_records_.
+  std::unordered_map<std::string, int> known_index_;
+  vector<uint16_t> known_records_;
+
+  // Unknown word types: slot of each form, and form, record and neighbours
+  // in the list of each slot.
+  std::unordered_map<std::string, int> unknown_index_;
+  vector<std::string> unknown_forms_;
+  vector<uint16_t> unknown_records_;
+  vector<int> previous_;
+  vector<int> next_;
+  int head_; // Most recently used slot.
+  int tail_; // Least recently used slot.
+};
+
+#endif /* WORDTYPECACHE_H_ */
@@ -9,6 +9,7 @@
 #include <gflags/gflags.h>
 #include "Utils.h"
 #include "TaggerPipe.h"
+#include "JackknifePipe.h"
 //#include "StringUtils.h"
 
 using namespace std;
@@ -48,10 +49,16 @@ void TrainTagger() {
   TaggerOptions *options = new TaggerOptions;
   options->Initialize();
 
-  TaggerPipe *pipe = new TaggerPipe(options);
-  pipe->Initialize();
-  pipe->Train();
-  pipe->SaveModelFile();
+  if (options->jackknife_folds() > 0) {
+    RunJackknife<TaggerPipe, TaggerOptions, SequenceReader,
+                 SequenceWriter>(options);
+  } else {
+    TaggerPipe *pipe = new TaggerPipe(options);
+    pipe->Initialize();
+    pipe->Train();
+    pipe->SaveModelFile();
+    delete pipe;
+  }
 
   gettimeofday(&end, NULL);
   time = diff_ms(end, start);
@@ -59,7 +66,6 @@ void TrainTagger() {
   LOG(INFO) << "Training took " << static_cast<double>(time) / 1000.0
     << " sec." << endl;
 
-  delete pipe;
   delete options;
 }
 
@@ -0,0 +1,112 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Histogram of non-negative values with exponentially growing buckets.
+// Bucket 0 holds values in [0, first_bound), and bucket k > 0 holds values
+// in [first_bound * 2^(k-1), first_bound * 2^k). The last bucket also holds
+// all larger values.
+class Histogram {
+public:
+  Histogram() { Initialize(1.0, 20); }
+  Histogram(double first_bound, int num_buckets) {
+    Initialize(first_bound, num_buckets);
+  }
+  virtual ~Histogram() {}
+
+  void Initialize(double first_bound, int num_buckets) {
+    upper_bounds_.resize(num_buckets);
+    double bound = first_bound;
+    for (int k = 0; k < num_buckets; ++k) {
+      upper_bounds_[k] = bound;
+      bound *= 2.0;
+    }
+    Clear();
+  }
+
+  void Clear() {
+    counts_.assign(upper_bounds_.size(), 0);
+    num_values_ = 0;
+    sum_ = 0.0;
+    max_ = 0.0;
+  }
+
+  void Add(double value) {
+    int k = 0;
+    while (k < upper_bounds_.size() - 1 && value >= upper_bounds_[k]) ++k;
+    ++counts_[k];
+    ++num_values_;
+    sum_ += value;
+    if (value > max_) max_ = value;
+  }
+
+  int GetNumBuckets() const { return counts_.size(); }
+  // Upper bound of bucket k (exclusive; the last bucket is unbounded).
+  double GetUpperBound(int k) const { return upper_bounds_[k]; }
+  int GetCount(int k) const { return counts_[k]; }
+  int GetNumValues() const { return num_values_; }
+  double GetMean() const {
+    return (num_values_ > 0) ? sum_ / static_cast<double>(num_values_) : 0.0;
+  }
+  double GetMax() const { return max_; }
+
+  // Upper bound of the bucket containing the q-quantile (e.g. q = 0.99 for
+  // the 99th percentile). Returns the maximum value if this falls in the
+  // last bucket.
+  double GetQuantileUpperBound(double q) const {
+    int threshold = static_cast<int>(q * static_cast<double>(num_values_));
+    int cumulative = 0;
+    for (int k = 0; k < counts_.size() - 1; ++k) {
+      cumulative += counts_[k];
+      if (cumulative > threshold) return upper_bounds_[k];
+    }
+    return max_;
+  }
+
+  // Print the non-empty buckets as "<bound:count" pairs.
+  string ToString() const {
+    ostringstream ss;
+    for (int k = 0; k < counts_.size(); ++k) {
+      if (counts_[k] == 0) continue;
+      if (k < counts_.size() - 1) {
+        ss << "<" << upper_bounds_[k] << ":" << counts_[k] << " ";
+      } else {
+        double lower_bound = (k > 0) ? upper_bounds_[k - 1] : 0.0;
+        ss << ">=" << lower_bound << ":" << counts_[k] << " ";
+      }
+    }
+    return ss.str();
+  }
+
+protected:
+  vector<double> upper_bounds_;
+  vector<int> counts_;
+  int num_values_;
+  double sum_;
+  double max_;
+};
+
+#endif /* HISTOGRAM_H_ */
@@ -0,0 +1,270 @@
+// Copyright (c) 2012-2015 Andre Martins
+// All Rights Reserved.
+//
+// This file is part of TurboParser 2.3.
+//
+// TurboParser 2.3 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// TurboParser 2.3 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with TurboParser 2.3.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include <chrono>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Stages of a pipe whose time is measured by the profiler.
+enum {
+  PROFILER_TIMER_READ = 0,
+  PROFILER_TIMER_CONVERT,
+  PROFILER_TIMER_MAKE_PARTS,
+  PROFILER_TIMER_MAKE_FEATURES,
+  PROFILER_TIMER_COMPUTE_SCORES,
+  PROFILER_TIMER_DECODE,
+  PROFILER_TIMER_LABEL,
+  PROFILER_TIMER_WRITE,
+  PROFILER_TIMER_GRADIENT,
+  NUM_PROFILER_TIMERS
+};
+
+// Events counted by the profiler.
+// -- instances: instances processed (at training time, once per epoch).
+// -- parts: parts created by MakeParts.
+// -- features: binary features extracted by MakeFeatures.
+// -- hash_probes: feature keys looked up in the weight vector.
+// -- cache_hits/cache_misses: lookups in score caches (e.g. the per-word
+// partial scores of the dependency pruner).
+// -- ad3_iterations: iteration limits of the AD3 runs (the actual number of
+// iterations if AD3 did not converge).
+// -- cle_contractions: cycles contracted by the Chu-Liu-Edmonds algorithm.
+enum {
+  PROFILER_COUNTER_INSTANCES = 0,
+  PROFILER_COUNTER_PARTS,
+  PROFILER_COUNTER_FEATURES,
+  PROFILER_COUNTER_HASH_PROBES,
+  PROFILER_COUNTER_CACHE_HITS,
+  PROFILER_COUNTER_CACHE_MISSES,
+  PROFILER_COUNTER_AD3_ITERATIONS,
+  PROFILER_COUNTER_CLE_CONTRACTIONS,
+  NUM_PROFILER_COUNTERS
+};
+
+// Structures whose memory (in bytes) is accounted by the profiler.
+// -- parts/features: parts and binary features of an instance.
+// -- factor_graph: AD3 factor graph built to decode an instance.
+// -- training_cache: parts, features and gold outputs kept in the training
+// cache (see --train_cache_instances).
+// -- parameters/averaged_parameters: weights of the model and the running
+// sums used to average them.
+// The sizes are estimates: they include the buffers of the containers but
+// not the overhead of the allocator.
+enum {
+  PROFILER_MEMORY_PARTS = 0,
+  PROFILER_MEMORY_FEATURES,
+  PROFILER_MEMORY_FACTOR_GRAPH,
+  PROFILER_MEMORY_TRAINING_CACHE,
+  PROFILER_MEMORY_PARAMETERS,
+  PROFILER_MEMORY_AVERAGED_PARAMETERS,
+  NUM_PROFILER_MEMORY
+};
+
+// Timers (in nanoseconds, from a monotonic clock) and event counters of a
+// pipe. Each pipe owns a profiler, which it shares with its decoder and
+// parameters, so there is no synchronization: a profiler must only be
+// updated by the thread running its pipe.
+// A disabled profiler (the default) does not read the clock and ignores all
+// updates, so that the instrumentation costs a branch per call.
+// The profiler also keeps the peak memory of each structure (per instance
+// for the structures of an instance), both since the last reset and since
+// the start of the current training epoch.
+class Profiler {
+public:
+  Profiler() { enabled_ = false; Reset(); }
+  virtual ~Profiler() {}
+
+  void SetEnabled(bool enabled) { enabled_ = enabled; }
+  bool enabled() const { return enabled_; }
+
+  void Reset() {
+    for (int k = 0; k < NUM_PROFILER_TIMERS; ++k) times_[k] = 0;
+    for (int k = 0; k < NUM_PROFILER_COUNTERS; ++k) counts_[k] = 0;
+    for (int k = 0; k < NUM_PROFILER_MEMORY; ++k) peak_bytes_[k] = 0;
+    ResetEpochMemory();
+  }
+
+  // Start a training epoch: reset the peak memory of the epoch.
+  void ResetEpochMemory() {
+    for (int k = 0; k < NUM_PROFILER_MEMORY; ++k) epoch_peak_bytes_[k] = 0;
+  }
+
+  // Current time of the monotonic clock in nanoseconds.
+  static int64_t GetTimeNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Start measuring a stage. Returns the start time to pass to StopTimer,
+  // or 0 if the profiler is disabled.
+  int64_t StartTimer() const {
+    return enabled_ ? GetTimeNanoseconds() : 0;
+  }
+
+  // Add the time elapsed since start_time (returned by StartTimer) to a
+  // timer.
+  void StopTimer(int timer, int64_t start_time) {
+    if (!enabled_) return;
+    times_[timer] += GetTimeNanoseconds() - start_time;
+  }
+
+  // Add a time (in nanoseconds) measured by the caller to a timer.
+  void AddTime(int timer, int64_t time) {
+    if (enabled_) times_[timer] += time;
+  }
+
+  void Increment(int counter, int64_t amount) {
+    if (enabled_) counts_[counter] += amount;
+  }
+
+  // Record the current size (in bytes) of a structure.
+  void RecordMemory(int structure, int64_t num_bytes) {
+    if (!enabled_) return;
+    if (num_bytes > peak_bytes_[structure]) peak_bytes_[structure] = num_bytes;
+    if (num_bytes > epoch_peak_bytes_[structure]) {
+      epoch_peak_bytes_[structure] = num_bytes;
+    }
+  }
+
+  // Add the timers and counters of another profiler to this one (e.g. to
+  // aggregate the profilers of several threads). The peak memory of both
+  // profilers is added too, since their structures may coexist.
+  void Add(const Profiler &profiler) {
+    for (int k = 0; k < NUM_PROFILER_TIMERS; ++k) {
+      times_[k] += profiler.times_[k];
+    }
+    for (int k = 0; k < NUM_PROFILER_COUNTERS; ++k) {
+      counts_[k] += profiler.counts_[k];
+    }
+    for (int k = 0; k < NUM_PROFILER_MEMORY; ++k) {
+      peak_bytes_[k] += profiler.peak_bytes_[k];
+      epoch_peak_bytes_[k] += profiler.epoch_peak_bytes_[k];
+    }
+  }
+
+  // Time of a stage in nanoseconds.
+  int64_t GetTime(int timer) const { return times_[timer]; }
+  int64_t GetCount(int counter) const { return counts_[counter]; }
+
+  // Peak size of a structure in bytes, since the last reset or since the
+  // start of the current epoch.
+  int64_t GetPeakMemory(int structure) const {
+    return peak_bytes_[structure];
+  }
+  int64_t GetEpochPeakMemory(int structure) const {
+    return epoch_peak_bytes_[structure];
+  }
+
+  // Peak resident set size of the process in bytes (0 where it is not
+  // available).
+  static int64_t GetPeakResidentSetSize() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<int64_t>(usage.ru_maxrss);
+#else
+    // Linux reports the size in kilobytes.
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+  }
+
+  static const char *GetTimerName(int timer) {
+    static const char *timer_names[NUM_PROFILER_TIMERS] = {
+      "read", "convert", "make_parts", "make_features", "compute_scores",
+      "decode", "label", "write", "gradient"
+    };
+    return timer_names[timer];
+  }
+
+  static const char *GetCounterName(int counter) {
+    static const char *counter_names[NUM_PROFILER_COUNTERS] = {
+      "instances", "parts", "features", "hash_probes", "cache_hits",
+      "cache_misses", "ad3_iterations", "cle_contractions"
+    };
+    return counter_names[counter];
+  }
+
+  static const char *GetMemoryName(int structure) {
+    static const char *memory_names[NUM_PROFILER_MEMORY] = {
+      "parts", "features", "factor_graph", "training_cache", "parameters",
+      "averaged_parameters"
+    };
+    return memory_names[structure];
+  }
+
+  // Describe the peak memory of the epoch in megabytes, e.g.
+  // "parts 1.2, features 10.5, ...".
+  string EpochMemoryToString() const {
+    ostringstream ss;
+    ss.setf(ios::fixed);
+    ss.precision(1);
+    for (int k = 0; k < NUM_PROFILER_MEMORY; ++k) {
+      if (k > 0) ss << ", ";
+      ss << GetMemoryName(k) << " "
+         << static_cast<double>(epoch_peak_bytes_[k]) / (1024.0 * 1024.0);
+    }
+    return ss.str();
+  }
+
+  // Print the timers (in nanoseconds), the counters and the peak memory (in
+  // bytes) as a JSON object:
+  // {"time_ns": {"read": ..., ...}, "counts": {"instances": ..., ...},
+  //  "peak_bytes": {"parts": ..., ...}, "peak_rss_bytes": ...}.
+  string ToJson() const {
+    ostringstream ss;
+    ss << "{\"time_ns\": {";
+    for (int k = 0; k < NUM_PROFILER_TIMERS; ++k) {
+      if (k > 0) ss << ", ";
+      ss << "\"" << GetTimerName(k) << "\": " << times_[k];
+    }
+    ss << "}, \"counts\": {";
+    for (int k = 0; k < NUM_PROFILER_COUNTERS; ++k) {
+      if (k > 0) ss << ", ";
+      ss << "\"" << GetCounterName(k) << "\": " << counts_[k];
+    }
+    ss << "}, \"peak_bytes\": {";
+    for (int k = 0; k < NUM_PROFILER_MEMORY; ++k) {
+      if (k > 0) ss << ", ";
+      ss << "\"" << GetMemoryName(k) << "\": " << peak_bytes_[k];
+    }
+    ss << "}, \"peak_rss_bytes\": " << GetPeakResidentSetSize() << "}";
+    return ss.str();
+  }
+
+protected:
+  bool enabled_;
+  int64_t times_[NUM_PROFILER_TIMERS];
+  int64_t counts_[NUM_PROFILER_COUNTERS];
+  int64_t peak_bytes_[NUM_PROFILER_MEMORY];
+  int64_t epoch_peak_bytes_[NUM_PROFILER_MEMORY];
+};
+
+#endif /* PROFILER_H_ */
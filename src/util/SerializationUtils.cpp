@@ -52,12 +52,25 @@ bool WriteDouble(FILE *fs, double value) {
   return true;
 }
 
+bool WriteFloat(FILE *fs, float value) {
+  if (1 != fwrite(&value, sizeof(float), 1, fs)) return false;
+  return true;
+}
+
 bool WriteIntegerVector(FILE *fs, const std::vector<int> &values) {
+  int length = values.size();
+  if (!WriteInteger(fs, length)) return false;
+  // Write all the values at once (this matters for long vectors).
+  if (length == 0) return true;
+  if (length != fwrite(&values[0], sizeof(int), length, fs)) return false;
+  return true;
+}
+
+bool WriteStringVector(FILE *fs, const std::vector<std::string> &values) {
   int length = values.size();
   if (!WriteInteger(fs, length)) return false;
   for (int i = 0; i < length; ++i) {
-    int value = values[i];
-    if (!WriteInteger(fs, value)) return false;
+    if (!WriteString(fs, values[i])) return false;
   }
   return true;
 }
@@ -98,14 +111,80 @@ bool ReadDouble(FILE *fs, double *value) {
   return true;
 }
 
+bool ReadFloat(FILE *fs, float *value) {
+  if (1 != fread(value, sizeof(float), 1, fs)) return false;
+  return true;
+}
+
 bool ReadIntegerVector(FILE *fs, std::vector<int> *values) {
   int length;
   if (!ReadInteger(fs, &length)) return false;
+  if (length < 0) return false;
+  values->resize(length);
+  // Read all the values at once (this matters for long vectors).
+  if (length == 0) return true;
+  if (length != fread(&(*values)[0], sizeof(int), length, fs)) return false;
+  return true;
+}
+
+bool ReadStringVector(FILE *fs, std::vector<std::string> *values) {
+  int length;
+  if (!ReadInteger(fs, &length)) return false;
+  if (length < 0) return false;
+  values->resize(length);
+  for (int i = 0; i < length; ++i) {
+    if (!ReadString(fs, &(*values)[i])) return false;
+  }
+  return true;
+}
+
+// Append an unsigned integer to a buffer in base 128, least significant
+// group first, with the high bit set in all the bytes but the last.
+static void AppendVarint(uint32_t value, std::vector<unsigned char> *buffer) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<unsigned char>(value));
+}
+
+static bool ReadVarint(FILE *fs, uint32_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    int c = getc(fs);
+    if (c == EOF) return false;
+    *value |= static_cast<uint32_t>(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+bool WriteCompactIntegerVector(FILE *fs, const std::vector<int> &values) {
+  std::vector<unsigned char> buffer;
+  buffer.reserve(values.size() + 5);
+  AppendVarint(values.size(), &buffer);
+  for (int i = 0; i < values.size(); ++i) {
+    // Zigzag encoding, so that small negative values (e.g. -1) are short.
+    uint32_t value = static_cast<uint32_t>(values[i]);
+    AppendVarint((value << 1) ^ static_cast<uint32_t>(values[i] >> 31),
+                 &buffer);
+  }
+  if (buffer.size() != fwrite(&buffer[0], sizeof(unsigned char),
+                              buffer.size(), fs)) {
+    return false;
+  }
+  return true;
+}
+
+bool ReadCompactIntegerVector(FILE *fs, std::vector<int> *values) {
+  uint32_t length;
+  if (!ReadVarint(fs, &length)) return false;
+  if (length > 0x7fffffff) return false;
   values->resize(length);
   for (int i = 0; i < length; ++i) {
-    int value;
-    if (!ReadInteger(fs, &value)) return false;
-    (*values)[i] = value;
+    uint32_t value;
+    if (!ReadVarint(fs, &value)) return false;
+    (*values)[i] = static_cast<int>((value >> 1) ^ (0u - (value & 1)));
   }
   return true;
 }
@@ -30,7 +30,14 @@ extern bool WriteInteger(FILE *fs, int value);
 extern bool WriteUINT8(FILE *fs, uint8_t value);
 extern bool WriteUINT64(FILE *fs, uint64_t value);
 extern bool WriteDouble(FILE *fs, double value);
+extern bool WriteFloat(FILE *fs, float value);
 extern bool WriteIntegerVector(FILE *fs, const std::vector<int> &values);
+extern bool WriteStringVector(FILE *fs,
+                              const std::vector<std::string> &values);
+// Write a vector of integers in a variable-length encoding (zigzag and base
+// 128), which takes one byte per value for values in [-64, 64).
+extern bool WriteCompactIntegerVector(FILE *fs,
+                                      const std::vector<int> &values);
 
 extern bool ReadString(FILE *fs, std::string *data);
 extern bool ReadBool(FILE *fs, bool *value);
@@ -38,6 +45,9 @@ extern bool ReadInteger(FILE *fs, int *value);
 extern bool ReadUINT8(FILE *fs, uint8_t *value);
 extern bool ReadUINT64(FILE *fs, uint64_t *value);
 extern bool ReadDouble(FILE *fs, double *value);
+extern bool ReadFloat(FILE *fs, float *value);
 extern bool ReadIntegerVector(FILE *fs, std::vector<int> *values);
+extern bool ReadStringVector(FILE *fs, std::vector<std::string> *values);
+extern bool ReadCompactIntegerVector(FILE *fs, std::vector<int> *values);
 
 #endif // SERIALIZATIONUTILS_H_
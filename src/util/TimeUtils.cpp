@@ -73,6 +73,6 @@ int diff_ms(timeval t1, timeval t2) {
 
 // Time difference in microseconds.
 int diff_us(timeval t1, timeval t2) {
-  return (((t1.tv_sec - t2.tv_sec) * 1000000000) +
+  return (((t1.tv_sec - t2.tv_sec) * 1000000) +
           (t1.tv_usec - t2.tv_usec));
 }